@@ -265,6 +265,7 @@ SOURCES += \
   src/app/navapp.cpp \
   src/common/abstractinfobuilder.cpp \
   src/common/aircrafttrail.cpp \
+  src/common/aircrafttrailjournal.cpp \
   src/common/airportfiles.cpp \
   src/common/constants.cpp \
   src/common/coordinateconverter.cpp \
@@ -274,6 +275,7 @@ SOURCES += \
   src/common/filecheck.cpp \
   src/common/formatter.cpp \
   src/common/fueltool.cpp \
+  src/common/globereaderpool.cpp \
   src/common/htmlinfobuilder.cpp \
   src/common/jsoninfobuilder.cpp \
   src/common/jumpback.cpp \
@@ -299,6 +301,7 @@ SOURCES += \
   src/db/databasedialog.cpp \
   src/db/databaseloader.cpp \
   src/db/databasemanager.cpp \
+  src/db/databasepool.cpp \
   src/db/databaseprogressdialog.cpp \
   src/db/dbtools.cpp \
   src/db/dbtypes.cpp \
@@ -320,6 +323,7 @@ SOURCES += \
   src/gui/updatedialog.cpp \
   src/info/aircraftprogressconfig.cpp \
   src/info/infocontroller.cpp \
+  src/info/textbrowserupdater.cpp \
   src/logbook/logdatacontroller.cpp \
   src/logbook/logdataconverter.cpp \
   src/logbook/logdatadialog.cpp \
@@ -335,6 +339,7 @@ SOURCES += \
   src/mapgui/maplayersettings.cpp \
   src/mapgui/mapmarkhandler.cpp \
   src/mapgui/mappaintwidget.cpp \
+  src/mapgui/mapprefetcher.cpp \
   src/mapgui/mapscale.cpp \
   src/mapgui/mapscreenindex.cpp \
   src/mapgui/mapthemehandler.cpp \
@@ -378,6 +383,7 @@ SOURCES += \
   src/query/airwaytrackquery.cpp \
   src/query/infoquery.cpp \
   src/query/mapquery.cpp \
+  src/query/procedureprefetcher.cpp \
   src/query/procedurequery.cpp \
   src/query/querytypes.cpp \
   src/query/waypointquery.cpp \
@@ -429,7 +435,8 @@ SOURCES += \
   src/search/sqlcontroller.cpp \
   src/search/sqlmodel.cpp \
   src/search/sqlmodeltypes.cpp \
-  src/search/sqlproxymodel.cpp \
+  src/search/sqlqueryworker.cpp \
+  src/search/textsearchindex.cpp \
   src/search/userdatasearch.cpp \
   src/search/usericondelegate.cpp \
   src/track/trackcontroller.cpp \
@@ -445,6 +452,7 @@ SOURCES += \
   src/web/webapp.cpp \
   src/web/webcontroller.cpp \
   src/web/webflags.cpp \
+  src/web/webmapcache.cpp \
   src/web/webmapcontroller.cpp \
   src/web/webtools.cpp \
   src/webapi/abstractactionscontroller.cpp \
@@ -464,6 +472,7 @@ HEADERS  += \
   src/app/navapp.h \
   src/common/abstractinfobuilder.h \
   src/common/aircrafttrail.h \
+  src/common/aircrafttrailjournal.h \
   src/common/airportfiles.h \
   src/common/constants.h \
   src/common/coordinateconverter.h \
@@ -473,6 +482,7 @@ HEADERS  += \
   src/common/filecheck.h \
   src/common/formatter.h \
   src/common/fueltool.h \
+  src/common/globereaderpool.h \
   src/common/htmlinfobuilder.h \
   src/common/htmlinfobuilderflags.h \
   src/common/infobuildertypes.h \
@@ -500,6 +510,7 @@ HEADERS  += \
   src/db/databasedialog.h \
   src/db/databaseloader.h \
   src/db/databasemanager.h \
+  src/db/databasepool.h \
   src/db/databaseprogressdialog.h \
   src/db/dbtools.h \
   src/db/dbtypes.h \
@@ -521,6 +532,7 @@ HEADERS  += \
   src/gui/updatedialog.h \
   src/info/aircraftprogressconfig.h \
   src/info/infocontroller.h \
+  src/info/textbrowserupdater.h \
   src/logbook/logdatacontroller.h \
   src/logbook/logdataconverter.h \
   src/logbook/logdatadialog.h \
@@ -535,7 +547,9 @@ HEADERS  += \
   src/mapgui/maplayersettings.h \
   src/mapgui/mapmarkhandler.h \
   src/mapgui/mappaintwidget.h \
+  src/mapgui/mapprefetcher.h \
   src/mapgui/mapscale.h \
+  src/mapgui/mapscreengrid.h \
   src/mapgui/mapscreenindex.h \
   src/mapgui/mapthemehandler.h \
   src/mapgui/maptooltip.h \
@@ -578,8 +592,10 @@ HEADERS  += \
   src/query/airwaytrackquery.h \
   src/query/infoquery.h \
   src/query/mapquery.h \
+  src/query/procedureprefetcher.h \
   src/query/procedurequery.h \
   src/query/querytypes.h \
+  src/query/tilerectcache.h \
   src/query/waypointquery.h \
   src/query/waypointtrackquery.h \
   src/route/customproceduredialog.h \
@@ -630,7 +646,8 @@ HEADERS  += \
   src/search/sqlcontroller.h \
   src/search/sqlmodel.h \
   src/search/sqlmodeltypes.h \
-  src/search/sqlproxymodel.h \
+  src/search/sqlqueryworker.h \
+  src/search/textsearchindex.h \
   src/search/userdatasearch.h \
   src/search/usericondelegate.h \
   src/track/trackcontroller.h \
@@ -646,6 +663,7 @@ HEADERS  += \
   src/web/webapp.h \
   src/web/webcontroller.h \
   src/web/webflags.h \
+  src/web/webmapcache.h \
   src/web/webmapcontroller.h \
   src/web/webtools.h \
   src/webapi/abstractactionscontroller.h \
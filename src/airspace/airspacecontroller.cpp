@@ -208,7 +208,7 @@ void AirspaceController::getAirspaces(AirspaceVector& airspaces, const Marble::G
   }
 }
 
-const atools::geo::LineString *AirspaceController::getAirspaceGeometry(map::MapAirspaceId id)
+const atools::geo::LineString *AirspaceController::getAirspaceGeometry(map::MapAirspaceId id, float maxToleranceNm)
 {
   if((id.src & map::AIRSPACE_SRC_USER) && loadingUserAirspaces)
     // Avoid deadlock while loading user airspaces
@@ -216,7 +216,7 @@ const atools::geo::LineString *AirspaceController::getAirspaceGeometry(map::MapA
 
   AirspaceQuery *query = queries.value(id.src);
   if(query != nullptr)
-    return query->getAirspaceGeometryById(id.id);
+    return query->getAirspaceGeometryById(id.id, maxToleranceNm);
 
   return nullptr;
 }
@@ -26,6 +26,7 @@
 #include "common/vehicleicons.h"
 #include "connect/connectclient.h"
 #include "db/databasemanager.h"
+#include "db/databasepool.h"
 #include "exception.h"
 #include "fs/perf/aircraftperf.h"
 #include "fs/common/magdecreader.h"
@@ -73,6 +74,7 @@ AirportQuery *NavApp::airportQuerySim = nullptr;
 AirportQuery *NavApp::airportQueryNav = nullptr;
 InfoQuery *NavApp::infoQuery = nullptr;
 ProcedureQuery *NavApp::procedureQuery = nullptr;
+DatabasePool *NavApp::databasePool = nullptr;
 
 ConnectClient *NavApp::connectClient = nullptr;
 DatabaseManager *NavApp::databaseManager = nullptr;
@@ -175,7 +177,9 @@ void NavApp::init(MainWindow *mainWindowParam)
   // Clear temporary userpoints
   userdataController->clearTemporary();
 
-  onlinedataController = new OnlinedataController(databaseManager->getOnlinedataManager(), mainWindow);
+  onlinedataController = new OnlinedataController(databaseManager->getOnlinedataManager(),
+                                                   databaseManager->getOnlineStagingDatabaseFile(),
+                                                   databaseManager->getDatabaseUserAirspace()->databaseName(), mainWindow);
 
   trackController = new TrackController(databaseManager->getTrackManager(), mainWindow);
 
@@ -197,6 +201,8 @@ void NavApp::init(MainWindow *mainWindowParam)
 
   procedureQuery = new ProcedureQuery(databaseManager->getDatabaseNav());
 
+  databasePool = new DatabasePool;
+
   connectClient = new ConnectClient(mainWindow);
 
   updateHandler = new UpdateHandler(mainWindow);
@@ -214,6 +220,7 @@ void NavApp::initQueries()
   airportQueryNav->initQueries();
   infoQuery->initQueries();
   procedureQuery->initQueries();
+  databasePool->open();
 }
 
 void NavApp::showElevationProviderErrors()
@@ -251,6 +258,7 @@ void NavApp::deInit()
   ATOOLS_DELETE_LOG(airportQueryNav);
   ATOOLS_DELETE_LOG(infoQuery);
   ATOOLS_DELETE_LOG(procedureQuery);
+  ATOOLS_DELETE_LOG(databasePool);
   ATOOLS_DELETE_LOG(databaseManager);
   ATOOLS_DELETE_LOG(databaseMetaSim);
   ATOOLS_DELETE_LOG(databaseMetaNav);
@@ -356,6 +364,9 @@ void NavApp::preDatabaseLoad()
   qDebug() << Q_FUNC_INFO;
 
   loadingDatabase = true;
+
+  // Wait for background tasks and close connections
+  databasePool->close();
   infoQuery->deInitQueries();
   airportQuerySim->deInitQueries();
   airportQueryNav->deInitQueries();
@@ -385,6 +396,7 @@ void NavApp::postDatabaseLoad()
   airportQueryNav->initQueries();
   infoQuery->initQueries();
   procedureQuery->initQueries();
+  databasePool->open();
   moraReader->readFromTable(getDatabaseNav(), getDatabaseSim());
   airspaceController->postDatabaseLoad();
   logdataController->postDatabaseLoad();
@@ -551,6 +563,11 @@ ProcedureQuery *NavApp::getProcedureQuery()
   return procedureQuery;
 }
 
+DatabasePool *NavApp::getDatabasePool()
+{
+  return databasePool;
+}
+
 const Route& NavApp::getRouteConst()
 {
   return mainWindow->getRouteController()->getRouteConst();
@@ -1204,6 +1221,14 @@ MapPaintWidget *NavApp::getMapPaintWidgetWeb()
     return nullptr;
 }
 
+QVector<MapPaintWidget *> NavApp::getMapPaintWidgetsWeb()
+{
+  if(webController != nullptr && webController->getWebMapController() != nullptr)
+    return webController->getWebMapController()->getMapPaintWidgets();
+  else
+    return QVector<MapPaintWidget *>();
+}
+
 DatabaseManager *NavApp::getDatabaseManager()
 {
   return databaseManager;
@@ -32,6 +32,7 @@ class TrackController;
 class AirspaceController;
 class ConnectClient;
 class DatabaseManager;
+class DatabasePool;
 class ElevationProvider;
 class InfoController;
 class InfoQuery;
@@ -224,6 +225,9 @@ public:
 
   static InfoQuery *getInfoQuery();
   static ProcedureQuery *getProcedureQuery();
+
+  /* Read only connections and queries for running database work in background threads */
+  static DatabasePool *getDatabasePool();
   static const Route& getRouteConst();
   static Route& getRoute();
   static void updateRouteCycleMetadata();
@@ -423,6 +427,9 @@ public:
   static WebController *getWebController();
   static MapPaintWidget *getMapPaintWidgetWeb();
 
+  /* All hidden map widgets used by the web server. Empty if server is not running. */
+  static QVector<MapPaintWidget *> getMapPaintWidgetsWeb();
+
   static MapMarkHandler *getMapMarkHandler();
   static MapAirportHandler *getMapAirportHandler();
   static MapDetailHandler *getMapDetailHandler();
@@ -466,6 +473,7 @@ private:
   static AirportQuery *airportQuerySim, *airportQueryNav;
   static InfoQuery *infoQuery;
   static ProcedureQuery *procedureQuery;
+  static DatabasePool *databasePool;
   static ElevationProvider *elevationProvider;
 
   /* Most important handlers */
@@ -18,6 +18,7 @@
 #include "common/aircrafttrail.h"
 
 #include "atools.h"
+#include "common/aircrafttrailjournal.h"
 #include "common/constants.h"
 #include "common/maptypes.h"
 #include "fs/gpx/gpxtypes.h"
@@ -30,6 +31,8 @@
 #include <QDataStream>
 #include <QDateTime>
 #include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <marble/GeoDataLatLonAltBox.h>
 
@@ -43,6 +46,19 @@ static const float MAX_POINT_DISTANCE_NM = 5.f;
 /* Number of entries to remove at once */
 static const int PRUNE_TRACK_ENTRIES = 200;
 
+/* Write the whole trail and start a new journal if the journal has more records */
+static const int MAX_JOURNAL_RECORDS = 10000;
+
+/* Wait this time before trying to write the whole trail again after a failed snapshot */
+static const qint64 SNAPSHOT_RETRY_MS = 60000L;
+
+/* Maximum number of points in a drawing chunk */
+static const int CHUNK_SIZE = 256;
+
+/* Minimum distance between points for each drawing level. First level uses all points. */
+static const float CHUNK_LEVEL_DIST_METER[] = {0.f, 50.f, 200.f, 800.f, 3200.f, 12800.f};
+static const int CHUNK_LEVELS = sizeof(CHUNK_LEVEL_DIST_METER) / sizeof(CHUNK_LEVEL_DIST_METER[0]);
+
 static const quint32 FILE_MAGIC_NUMBER = 0x5B6C1A2B;
 
 /* Version 2 to adds timstamp and single floating point precision. Uses 32-bit second timestamps */
@@ -135,6 +151,8 @@ AircraftTrail::AircraftTrail()
 
 AircraftTrail::~AircraftTrail()
 {
+  finishSnapshot(true /* wait */);
+  delete journal;
   delete lastUserAircraft;
 }
 
@@ -149,6 +167,12 @@ AircraftTrail& AircraftTrail::operator=(const AircraftTrail& other)
 {
   clear();
   append(other);
+  resetChunks();
+
+  // Journal is not copied
+  if(journal != nullptr)
+    journal->invalidate();
+
   maxTrackEntries = other.maxTrackEntries;
   *lastUserAircraft = *other.lastUserAircraft;
   return *this;
@@ -289,11 +313,16 @@ atools::fs::gpx::GpxData AircraftTrail::toGpxData(const atools::fs::pln::Flightp
 void AircraftTrail::fillTrailFromGpxData(const atools::fs::gpx::GpxData& gpxData)
 {
   clear();
+  resetChunks();
   appendTrailFromGpxData(gpxData);
 }
 
 void AircraftTrail::appendTrailFromGpxData(const atools::fs::gpx::GpxData& gpxData)
 {
+  // Not recorded in journal - written with the next snapshot
+  if(journal != nullptr)
+    journal->invalidate();
+
   // Add separator
   if(!isEmpty())
     append(AircraftTrailPos());
@@ -313,57 +342,161 @@ void AircraftTrail::appendTrailFromGpxData(const atools::fs::gpx::GpxData& gpxDa
 
 void AircraftTrail::saveState(const QString& suffix, int numBackupFiles)
 {
-  QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
-
-  if(numBackupFiles > 0)
-    atools::io::FileRoller(numBackupFiles).rollFile(trackFile.fileName());
-
-  if(trackFile.open(QIODevice::WriteOnly))
+  if(journal != nullptr)
   {
-    QDataStream out(&trackFile);
-    saveToStream(out);
-    trackFile.close();
+    finishSnapshot(true /* wait */);
+
+    // Journal contains all changes since the last snapshot - write all only if needed
+    if(!journal->isValid() || journal->getNumRecords() > MAX_JOURNAL_RECORDS)
+    {
+      beginSnapshot();
+      finishSnapshot(true /* wait */);
+    }
   }
   else
-    qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+    writeSnapshot(atools::settings::Settings::getConfigFilename(suffix), numBackupFiles, *this, snapshotId);
 }
 
 void AircraftTrail::restoreState(const QString& suffix)
 {
   clear();
+  resetChunks();
 
   QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
   if(trackFile.exists())
   {
     if(trackFile.open(QIODevice::ReadOnly))
     {
-      QDataStream in(&trackFile);
-      readFromStream(in);
+      // Read from memory mapped file if possible
+      qint64 size = trackFile.size();
+      uchar *data = size > 0 ? trackFile.map(0, size) : nullptr;
+      if(data != nullptr)
+      {
+        QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(size)));
+        readFromStream(in);
+        trackFile.unmap(data);
+      }
+      else
+      {
+        QDataStream in(&trackFile);
+        readFromStream(in);
+      }
       trackFile.close();
     }
     else
       qWarning() << "Cannot read track" << trackFile.fileName() << ":" << trackFile.errorString();
   }
+
+  if(journal != nullptr)
+  {
+    // Add positions recorded after the file was written
+    int records = journal->restore(snapshotId, [this](const AircraftTrailPos& pos) -> void {
+      append(pos);
+    }, [this](int numEntries) -> void {
+      erase(begin(), begin() + std::min(numEntries, size()));
+    });
+    qDebug() << Q_FUNC_INFO << "Restored" << records << "journal records";
+  }
+
   calculateBoundaries();
 }
 
+void AircraftTrail::enableJournal(const QString& suffix, int numBackupFiles)
+{
+  journalSnapshotFilename = atools::settings::Settings::getConfigFilename(suffix);
+  journalNumBackupFiles = numBackupFiles;
+
+  if(journal == nullptr)
+    journal = new AircraftTrailJournal(journalSnapshotFilename);
+}
+
+void AircraftTrail::beginSnapshot()
+{
+  snapshotId = std::max(snapshotId + 1, static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()));
+
+  // Positions appended from now on go into the new journal too
+  journal->beginSnapshot(snapshotId);
+
+  // Implicitly shared copy which is detached when appending positions
+  const QList<AircraftTrailPos> positions(*this);
+  QString filename = journalSnapshotFilename;
+  int numBackupFiles = journalNumBackupFiles;
+  quint64 id = snapshotId;
+
+  snapshotFuture = QtConcurrent::run([positions, filename, numBackupFiles, id]() -> bool {
+    return writeSnapshot(filename, numBackupFiles, positions, id);
+  });
+  snapshotRunning = true;
+}
+
+void AircraftTrail::finishSnapshot(bool wait)
+{
+  if(snapshotRunning)
+  {
+    if(!wait && !snapshotFuture.isFinished())
+      return;
+
+    snapshotFuture.waitForFinished();
+    bool snapshotOk = snapshotFuture.result();
+    snapshotRunning = false;
+
+    // Retry later instead of letting the journal grow if writing failed
+    snapshotRetryMs = snapshotOk ? 0L : QDateTime::currentMSecsSinceEpoch() + SNAPSHOT_RETRY_MS;
+
+    if(journal != nullptr)
+      journal->finishSnapshot(snapshotOk);
+  }
+}
+
+bool AircraftTrail::writeSnapshot(const QString& filename, int numBackupFiles, const QList<AircraftTrailPos>& positions,
+                                  quint64 snapshotIdParam)
+{
+  // Copy instead of rename to keep the current file until the new one is committed.
+  // Otherwise a crash while writing leaves no file and the journal cannot be matched on restore.
+  if(numBackupFiles > 0)
+    atools::io::FileRoller(numBackupFiles, "${base}.${ext}.${num}", true /* keepOriginalFile */).rollFile(filename);
+
+  // Replaces file atomically and only if written completely
+  QSaveFile trackFile(filename);
+  if(trackFile.open(QIODevice::WriteOnly))
+  {
+    QDataStream out(&trackFile);
+    writeToStream(out, positions, snapshotIdParam);
+    if(out.status() == QDataStream::Ok && trackFile.commit())
+      return true;
+  }
+
+  qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+  return false;
+}
+
 void AircraftTrail::saveToStream(QDataStream& out)
+{
+  writeToStream(out, *this, snapshotId);
+}
+
+void AircraftTrail::writeToStream(QDataStream& out, const QList<AircraftTrailPos>& positions, quint64 snapshotIdParam)
 {
   out.setVersion(QDataStream::Qt_5_5);
 
 #ifdef DEBUG_SAVE_TRACK_OLD
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
-  out << FILE_MAGIC_NUMBER << FILE_VERSION_64BIT_TS << *this;
+  out << FILE_MAGIC_NUMBER << FILE_VERSION_64BIT_TS << positions;
 #else
   out.setFloatingPointPrecision(QDataStream::DoublePrecision);
-  out << FILE_MAGIC_NUMBER << FILE_VERSION_64BIT_COORDS << *this;
+  out << FILE_MAGIC_NUMBER << FILE_VERSION_64BIT_COORDS << positions;
 #endif
+
+  // Id to find the journal - ignored by older versions
+  out << snapshotIdParam;
 }
 
 bool AircraftTrail::readFromStream(QDataStream& in)
 {
   bool retval = false;
   clear();
+  resetChunks();
+  snapshotId = 0;
 
   quint32 magic;
   in.setVersion(QDataStream::Qt_5_5);
@@ -388,6 +521,10 @@ bool AircraftTrail::readFromStream(QDataStream& in)
     }
     else
       qWarning() << "Cannot read track. Invalid version number:" << AircraftTrail::version;
+
+    // Optional id added by newer versions
+    if(retval && !in.atEnd())
+      in >> snapshotId;
   }
   else
     qWarning() << "Cannot read track. Invalid magic number:" << magic;
@@ -421,7 +558,7 @@ bool AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
   if(isEmpty() && userAircraft.isValid())
   {
     // First point
-    append(AircraftTrailPos(posD, timestampMs, onGround));
+    appendPos(AircraftTrailPos(posD, timestampMs, onGround));
     *lastUserAircraft = userAircraft;
   }
   else
@@ -488,23 +625,26 @@ bool AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
 #endif
 
         // Add an invalid position before indicating a break
-        append(AircraftTrailPos(timestampMs, onGround));
-        append(AircraftTrailPos(posD, timestampMs, onGround));
+        appendPos(AircraftTrailPos(timestampMs, onGround));
+        appendPos(AircraftTrailPos(posD, timestampMs, onGround));
       }
       else
       {
         if(size() > maxTrackEntries)
         {
-          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++)
-            removeFirst();
+          int oldSize = size();
+          erase(begin(), begin() + std::min(PRUNE_TRACK_ENTRIES, oldSize));
 
           // Remove invalid segments
           while(!isEmpty() && !constFirst().isValid())
             removeFirst();
 
+          pruneChunks(oldSize - size());
+          if(journal != nullptr)
+            journal->appendPrune(oldSize - size());
           pruned = true;
         }
-        append(AircraftTrailPos(posD, timestampMs, onGround));
+        appendPos(AircraftTrailPos(posD, timestampMs, onGround));
       }
       *lastUserAircraft = userAircraft;
     } // if(maxDistanceExceeded || maxTimeExceeded || speedChanged || altChanged || headingChanged)
@@ -514,13 +654,34 @@ bool AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
     // Last one is always valid
     calculateBoundary(constLast());
 
+  if(journal != nullptr)
+  {
+    finishSnapshot(false /* wait */);
+
+    // Write all in background if the journal got too large or is not valid after loading or deleting the trail
+    if(!snapshotRunning && QDateTime::currentMSecsSinceEpoch() >= snapshotRetryMs &&
+       (!journal->isValid() || journal->getNumRecords() > MAX_JOURNAL_RECORDS))
+      beginSnapshot();
+  }
+
   return pruned;
 }
 
+void AircraftTrail::appendPos(const AircraftTrailPos& pos)
+{
+  append(pos);
+  if(journal != nullptr)
+    journal->appendPos(pos);
+}
+
 void AircraftTrail::clearTrail()
 {
   clear();
+  resetChunks();
   clearBoundaries();
+
+  if(journal != nullptr)
+    journal->invalidate();
 }
 
 void AircraftTrail::clearBoundaries()
@@ -581,6 +742,164 @@ const QVector<atools::geo::LineString> AircraftTrail::getLineStrings(const atool
   return linestrings;
 }
 
+const QVector<atools::geo::LineString> AircraftTrail::getLineStrings(const atools::geo::Pos& aircraftPos,
+                                                                     const atools::geo::Rect& viewportRect,
+                                                                     float minDistanceMeter) const
+{
+  updateChunks();
+
+  // Use the level with the largest distance below the requested one
+  int level = 0;
+  while(level < CHUNK_LEVELS - 1 && CHUNK_LEVEL_DIST_METER[level + 1] <= minDistanceMeter)
+    level++;
+
+  QVector<atools::geo::LineString> linestrings;
+  bool continueLine = false;
+  for(int i = 0; i < chunks.size(); i++)
+  {
+    const AircraftTrailChunk& chunk = chunks.at(i);
+    bool last = i == chunks.size() - 1;
+
+    if(last || chunk.bounding.overlaps(viewportRect))
+    {
+      const atools::geo::LineString& line = chunk.levels.at(level);
+      if(continueLine)
+      {
+        // Leave out the first point which is the same as the last one of the previous chunk
+        atools::geo::LineString& lastLine = linestrings.last();
+        for(int j = 1; j < line.size(); j++)
+          lastLine.append(line.at(j));
+      }
+      else
+        linestrings.append(line);
+
+      continueLine = !chunk.lineEnd;
+    }
+    else
+      // Invisible - start a new line for the next visible chunk
+      continueLine = false;
+  }
+
+  // Add aircraft position to avoid gap
+  if(aircraftPos.isValid() && !linestrings.isEmpty() && !linestrings.constLast().isEmpty())
+    linestrings.last().append(aircraftPos);
+
+  return linestrings;
+}
+
+void AircraftTrail::updateChunks() const
+{
+  if(chunkedSize > size())
+  {
+    // Should not happen - rebuild all
+    chunks.clear();
+    chunkedSize = 0;
+  }
+
+  if(chunkedSize == size())
+    return;
+
+  // Index of first chunk which needs an update of the geometry
+  int updateIndex = chunks.size();
+
+  for(int i = chunkedSize; i < size(); i++)
+  {
+    if(!at(i).isValid())
+    {
+      // Break in the trail - next point starts a new line
+      if(!chunks.isEmpty())
+        chunks.last().closed = chunks.last().lineEnd = true;
+      continue;
+    }
+
+    if(chunks.isEmpty() || chunks.constLast().closed)
+    {
+      AircraftTrailChunk chunk;
+
+      // Overlap by one point if the line continues
+      chunk.start = !chunks.isEmpty() && !chunks.constLast().lineEnd ? chunks.constLast().end - 1 : i;
+      chunks.append(chunk);
+    }
+    else
+      // Last chunk gets more points
+      updateIndex = std::min(updateIndex, chunks.size() - 1);
+
+    AircraftTrailChunk& chunk = chunks.last();
+    chunk.end = i + 1;
+    chunk.closed = chunk.end - chunk.start >= CHUNK_SIZE;
+  }
+  chunkedSize = size();
+
+  for(int i = updateIndex; i < chunks.size(); i++)
+    buildChunk(chunks[i]);
+}
+
+void AircraftTrail::buildChunk(AircraftTrailChunk& chunk) const
+{
+  chunk.bounding = atools::geo::Rect();
+  chunk.levels.clear();
+
+  atools::geo::LineString line;
+  for(int i = chunk.start; i < chunk.end; i++)
+  {
+    Pos pos = at(i).getPosition();
+    line.append(pos);
+    chunk.bounding.extend(pos);
+  }
+  chunk.levels.append(line);
+
+  // Leave out points closer than the level distance to the last used one but keep first and last point
+  for(int level = 1; level < CHUNK_LEVELS; level++)
+  {
+    atools::geo::LineString reduced;
+    Pos lastPos;
+    for(int i = 0; i < line.size(); i++)
+    {
+      const Pos& pos = line.at(i);
+      if(i == 0 || i == line.size() - 1 || pos.distanceMeterTo(lastPos) >= CHUNK_LEVEL_DIST_METER[level])
+      {
+        reduced.append(pos);
+        lastPos = pos;
+      }
+    }
+    chunk.levels.append(reduced);
+  }
+}
+
+void AircraftTrail::pruneChunks(int numRemoved)
+{
+  if(numRemoved > chunkedSize)
+  {
+    // Chunks not up to date - rebuild all later
+    resetChunks();
+    return;
+  }
+
+  // Drop chunks which are completely removed
+  while(!chunks.isEmpty() && chunks.constFirst().end <= numRemoved)
+    chunks.removeFirst();
+
+  for(AircraftTrailChunk& chunk : chunks)
+  {
+    chunk.start -= numRemoved;
+    chunk.end -= numRemoved;
+  }
+  chunkedSize -= numRemoved;
+
+  // Partially removed chunk - trail starts with a valid point
+  if(!chunks.isEmpty() && chunks.constFirst().start < 0)
+  {
+    chunks.first().start = 0;
+    buildChunk(chunks.first());
+  }
+}
+
+void AircraftTrail::resetChunks()
+{
+  chunks.clear();
+  chunkedSize = 0;
+}
+
 const QVector<QVector<atools::geo::PosD> > AircraftTrail::getPositionsD() const
 {
   QVector<QVector<atools::geo::PosD> > linestrings;
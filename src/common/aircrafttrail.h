@@ -18,12 +18,17 @@
 #ifndef LITTLENAVMAP_AIRCRAFTTRACK_H
 #define LITTLENAVMAP_AIRCRAFTTRACK_H
 
+#include "geo/linestring.h"
 #include "geo/pos.h"
 #include "geo/rect.h"
 
+#include <QFuture>
+
 namespace Marble {
 class GeoDataLatLonAltBox;
 }
+class AircraftTrailJournal;
+
 namespace map {
 struct AircraftTrailSegment;
 }
@@ -43,7 +48,6 @@ class SimConnectUserAircraft;
 }
 namespace geo {
 class Rect;
-class LineString;
 }
 }
 
@@ -117,6 +121,25 @@ QDataStream& operator<<(QDataStream& dataStream, const AircraftTrailPos& obj);
 Q_DECLARE_TYPEINFO(AircraftTrailPos, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(AircraftTrailPos);
 
+/*
+ * Part of the trail having a limited number of points and precomputed geometry for drawing.
+ * Used to skip invisible parts of the trail and to draw fewer points when zoomed out.
+ */
+struct AircraftTrailChunk
+{
+  /* Range of trail indexes. start is inclusive and end exclusive.
+   * A chunk continuing the line of the previous one starts with the last point of the previous. */
+  int start = 0, end = 0;
+
+  /* closed if full or followed by a break. lineEnd if followed by a break. */
+  bool closed = false, lineEnd = false;
+
+  atools::geo::Rect bounding;
+
+  /* Index zero contains all points. Higher levels leave out points closer than the distances for the level. */
+  QVector<atools::geo::LineString> levels;
+};
+
 /*
  * Stores the trail points of the flight simulator user aircraft.
  *
@@ -149,10 +172,15 @@ public:
   /* Appends the given gpxData as new track segment without deleting the current one. */
   void appendTrailFromGpxData(const atools::fs::gpx::GpxData& gpxData);
 
-  /* Saves and restores track into a separate file (little_navmap.track). Creates two additional backup files. */
+  /* Saves and restores track into a separate file (little_navmap.track). Creates two additional backup files.
+   * saveState() writes the file only if the journal is not enabled, not valid or too large. */
   void saveState(const QString& suffix, int numBackupFiles);
   void restoreState(const QString& suffix);
 
+  /* Enable the append only journal which records all new positions right away. The full trail file is written
+   * in the background once the journal gets too large. Call before restoreState() to replay the journal. */
+  void enableJournal(const QString& suffix, int numBackupFiles);
+
   void clearTrail();
 
   /*
@@ -182,6 +210,11 @@ public:
    * More than one linestring might be returned if the trail is interrupted. */
   const QVector<atools::geo::LineString> getLineStrings(const atools::geo::Pos& aircraftPos) const;
 
+  /* Get linestrings for drawing from cached chunks. Only parts overlapping the viewport are returned and
+   * points closer than minDistanceMeter are left out. The part at the aircraft is always returned. */
+  const QVector<atools::geo::LineString> getLineStrings(const atools::geo::Pos& aircraftPos, const atools::geo::Rect& viewportRect,
+                                                        float minDistanceMeter) const;
+
   /* Track will be pruned if it contains more track entries than this value. Default is 20000. */
   void setMaxTrackEntries(int value)
   {
@@ -211,6 +244,31 @@ private:
   void calculateBoundaries();
   void calculateBoundary(const AircraftTrailPos& trackPos);
 
+  /* Add chunks for all points appended since the last call */
+  void updateChunks() const;
+
+  /* Fill bounding and geometry for all levels */
+  void buildChunk(AircraftTrailChunk& chunk) const;
+
+  /* Adjust chunks after removing entries from the beginning of the trail */
+  void pruneChunks(int numRemoved);
+
+  /* Drop all chunks. They are built again on the next call of getLineStrings() */
+  void resetChunks();
+
+  /* Append to list and journal */
+  void appendPos(const AircraftTrailPos& pos);
+
+  /* Start writing the whole trail in a background thread together with a new journal */
+  void beginSnapshot();
+
+  /* Passes the result of a finished snapshot to the journal. Returns if still running and wait is false. */
+  void finishSnapshot(bool wait);
+
+  static bool writeSnapshot(const QString& filename, int numBackupFiles, const QList<AircraftTrailPos>& positions,
+                            quint64 snapshotIdParam);
+  static void writeToStream(QDataStream& out, const QList<AircraftTrailPos>& positions, quint64 snapshotIdParam);
+
   /* Accurate positions for drawing */
   const QVector<QVector<atools::geo::PosD> > getPositionsD() const;
 
@@ -229,6 +287,25 @@ private:
 
   atools::fs::sc::SimConnectUserAircraft *lastUserAircraft;
 
+  /* Drawing cache built lazily from the trail points. chunkedSize is the number of entries covered by the chunks. */
+  mutable QList<AircraftTrailChunk> chunks;
+  mutable int chunkedSize = 0;
+
+  /* Journal and snapshot file. Null if not enabled. */
+  AircraftTrailJournal *journal = nullptr;
+  QString journalSnapshotFilename;
+  int journalNumBackupFiles = 0;
+
+  /* Writes the trail in background */
+  QFuture<bool> snapshotFuture;
+  bool snapshotRunning = false;
+
+  /* Earliest time in milliseconds since Epoch for the next background snapshot after a failed one. Zero if last one succeeded. */
+  qint64 snapshotRetryMs = 0L;
+
+  /* Id of last read or written trail file used to find the matching journal. Zero for files without id. */
+  quint64 snapshotId = 0;
+
   /* Needed in RouteExportFormat stream operators to read different formats */
   static quint16 version;
 };
@@ -0,0 +1,260 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/aircrafttrailjournal.h"
+
+#include "common/aircrafttrail.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QtEndian>
+
+#include <cstring>
+
+static const quint32 JOURNAL_MAGIC_NUMBER = 0x5B6C1A2C;
+static const quint16 JOURNAL_VERSION = 1;
+
+/* Magic number, version, reserved and snapshot id */
+static const int HEADER_SIZE = 16;
+
+/* Type, ground flag, three coordinates, timestamp and checksum */
+static const int RECORD_DATA_SIZE = 34;
+static const int RECORD_SIZE = RECORD_DATA_SIZE + 2;
+
+/* Record types */
+static const char RECORD_POS = 1;
+static const char RECORD_BREAK = 2;
+static const char RECORD_PRUNE = 3;
+
+static void writeDouble(char *data, double value)
+{
+  quint64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  qToLittleEndian(bits, data);
+}
+
+static double readDouble(const uchar *data)
+{
+  quint64 bits = qFromLittleEndian<quint64>(data);
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+AircraftTrailJournal::AircraftTrailJournal(const QString& basenameParam)
+  : basename(basenameParam)
+{
+}
+
+AircraftTrailJournal::~AircraftTrailJournal()
+{
+  delete current;
+  delete next;
+}
+
+QString AircraftTrailJournal::journalFilename(int slot) const
+{
+  return basename + QString(".journal%1").arg(slot + 1);
+}
+
+int AircraftTrailJournal::restore(quint64 snapshotId, AppendFunc appendFunc, PruneFunc pruneFunc)
+{
+  invalidate();
+
+  if(snapshotId == 0)
+    // Old snapshot file without id
+    return 0;
+
+  for(int slot = 0; slot < 2; slot++)
+  {
+    QFile *file = new QFile(journalFilename(slot));
+    if(!file->exists() || !file->open(QIODevice::ReadWrite))
+    {
+      delete file;
+      continue;
+    }
+
+    qint64 size = file->size();
+    const uchar *data = size >= HEADER_SIZE ? file->map(0, size) : nullptr;
+    if(data == nullptr || qFromLittleEndian<quint32>(data) != JOURNAL_MAGIC_NUMBER ||
+       qFromLittleEndian<quint16>(data + 4) != JOURNAL_VERSION || qFromLittleEndian<quint64>(data + 8) != snapshotId)
+    {
+      // Not existing, damaged or belongs to another snapshot
+      delete file;
+      continue;
+    }
+
+    // Read records until end or first damaged one =============================
+    qint64 offset = HEADER_SIZE;
+    int records = 0;
+    for(; offset + RECORD_SIZE <= size; offset += RECORD_SIZE)
+    {
+      const uchar *record = data + offset;
+      if(qChecksum(reinterpret_cast<const char *>(record), RECORD_DATA_SIZE) != qFromLittleEndian<quint16>(record + RECORD_DATA_SIZE))
+      {
+        qWarning() << Q_FUNC_INFO << "Damaged record in" << file->fileName() << "at" << offset;
+        break;
+      }
+
+      bool onGround = record[1] > 0;
+      qint64 timestampMs = qFromLittleEndian<qint64>(record + 26);
+      if(record[0] == RECORD_POS)
+        appendFunc(AircraftTrailPos(atools::geo::PosD(readDouble(record + 2), readDouble(record + 10), readDouble(record + 18)),
+                                    timestampMs, onGround));
+      else if(record[0] == RECORD_BREAK)
+        appendFunc(AircraftTrailPos(timestampMs, onGround));
+      else if(record[0] == RECORD_PRUNE)
+        pruneFunc(static_cast<int>(timestampMs));
+      records++;
+    }
+    file->unmap(const_cast<uchar *>(data));
+
+    // Cut off any partially written record and continue appending
+    if(file->resize(offset) && file->seek(offset))
+    {
+      current = file;
+      currentSlot = slot;
+      numRecords = records;
+    }
+    else
+      delete file;
+
+    qDebug() << Q_FUNC_INFO << journalFilename(slot) << "records" << records;
+    return records;
+  }
+
+  return 0;
+}
+
+void AircraftTrailJournal::beginSnapshot(quint64 snapshotId)
+{
+  // Drop any unfinished snapshot
+  removeFile(next);
+
+  nextSlot = currentSlot == 0 ? 1 : 0;
+  next = createFile(nextSlot, snapshotId);
+  numRecordsNext = 0;
+}
+
+void AircraftTrailJournal::finishSnapshot(bool success)
+{
+  if(success)
+  {
+    // Snapshot is on disk - old journal not needed anymore
+    removeFile(current);
+    current = next;
+    currentSlot = nextSlot;
+    numRecords = numRecordsNext;
+  }
+  else
+    removeFile(next);
+
+  next = nullptr;
+  nextSlot = -1;
+  numRecordsNext = 0;
+}
+
+void AircraftTrailJournal::appendPos(const AircraftTrailPos& pos)
+{
+  writeRecord(pos.isValid() ? RECORD_POS : RECORD_BREAK, pos, pos.getTimestampMs());
+}
+
+void AircraftTrailJournal::appendPrune(int numEntries)
+{
+  writeRecord(RECORD_PRUNE, AircraftTrailPos(), numEntries);
+}
+
+void AircraftTrailJournal::invalidate()
+{
+  removeFile(current);
+  removeFile(next);
+  currentSlot = nextSlot = -1;
+  numRecords = numRecordsNext = 0;
+}
+
+QFile *AircraftTrailJournal::createFile(int slot, quint64 snapshotId)
+{
+  QFile *file = new QFile(journalFilename(slot));
+  if(file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    char header[HEADER_SIZE];
+    qToLittleEndian(JOURNAL_MAGIC_NUMBER, header);
+    qToLittleEndian(JOURNAL_VERSION, header + 4);
+    qToLittleEndian(quint16(0), header + 6);
+    qToLittleEndian(snapshotId, header + 8);
+
+    if(file->write(header, HEADER_SIZE) == HEADER_SIZE && file->flush())
+      return file;
+  }
+
+  qWarning() << Q_FUNC_INFO << "Cannot write journal" << file->fileName() << file->errorString();
+  delete file;
+  return nullptr;
+}
+
+void AircraftTrailJournal::writeRecord(char type, const AircraftTrailPos& pos, qint64 value)
+{
+  if(current == nullptr && next == nullptr)
+    return;
+
+  char record[RECORD_SIZE];
+  record[0] = type;
+  record[1] = type == RECORD_PRUNE ? 0 : pos.isOnGround();
+
+  const atools::geo::PosD& posD = pos.getPosD();
+  bool valid = type == RECORD_POS;
+  writeDouble(record + 2, valid ? posD.getLonX() : 0.);
+  writeDouble(record + 10, valid ? posD.getLatY() : 0.);
+  writeDouble(record + 18, valid ? posD.getAltitude() : 0.);
+  qToLittleEndian(value, record + 26);
+  qToLittleEndian(qChecksum(record, RECORD_DATA_SIZE), record + RECORD_DATA_SIZE);
+
+  // Flush to the operating system right away to survive a crash of the program
+  if(current != nullptr)
+  {
+    if(current->write(record, RECORD_SIZE) == RECORD_SIZE && current->flush())
+      numRecords++;
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot write journal" << current->fileName() << current->errorString();
+      removeFile(current);
+    }
+  }
+
+  if(next != nullptr)
+  {
+    if(next->write(record, RECORD_SIZE) == RECORD_SIZE && next->flush())
+      numRecordsNext++;
+    else
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot write journal" << next->fileName() << next->errorString();
+      removeFile(next);
+    }
+  }
+}
+
+void AircraftTrailJournal::removeFile(QFile *& file)
+{
+  if(file != nullptr)
+  {
+    file->close();
+    file->remove();
+    delete file;
+    file = nullptr;
+  }
+}
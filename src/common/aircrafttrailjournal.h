@@ -0,0 +1,101 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_AIRCRAFTTRAILJOURNAL_H
+#define LNM_AIRCRAFTTRAILJOURNAL_H
+
+#include <QString>
+
+#include <functional>
+
+class QFile;
+struct AircraftTrailPos;
+
+/*
+ * Append only journal for the user aircraft trail which complements the snapshot file written by AircraftTrail.
+ * Each added trail position and each pruning is written as a small checksummed record and flushed immediately.
+ * A crash therefore loses at most the last record.
+ *
+ * A journal belongs to exactly one snapshot which is identified by an id stored in both files. Two journal files
+ * are used alternately: While a new snapshot is written in the background records go into both files. The journal
+ * of the old snapshot is deleted once the new snapshot is complete.
+ *
+ * File layout: header with magic number, version and snapshot id followed by fixed size records.
+ * All values are little endian. Reading stops at the first damaged record.
+ *
+ * Not thread safe. Use only in the GUI thread.
+ */
+class AircraftTrailJournal
+{
+public:
+  /* Callbacks for restore() */
+  typedef std::function<void (const AircraftTrailPos& pos)> AppendFunc;
+  typedef std::function<void (int numEntries)> PruneFunc;
+
+  /* basename is the filename of the snapshot. Journal files use the same name with a suffix. */
+  explicit AircraftTrailJournal(const QString& basename);
+  ~AircraftTrailJournal();
+
+  AircraftTrailJournal(const AircraftTrailJournal& other) = delete;
+  AircraftTrailJournal& operator=(const AircraftTrailJournal& other) = delete;
+
+  /* Replays all records from the journal file belonging to snapshotId using a memory mapped file and opens
+   * this file for appending. Journal is invalid if no file matches. Returns number of records read. */
+  int restore(quint64 snapshotId, AppendFunc appendFunc, PruneFunc pruneFunc);
+
+  /* Start of a snapshot with a new id. Records are written to both files until finishSnapshot() is called. */
+  void beginSnapshot(quint64 snapshotId);
+
+  /* Snapshot is written. Removes the old journal if successful or the new one otherwise. */
+  void finishSnapshot(bool success);
+
+  /* Add records. Ignored if the journal is not valid. */
+  void appendPos(const AircraftTrailPos& pos);
+  void appendPrune(int numEntries);
+
+  /* Trail was changed in a way not covered by records. Stops writing until the next snapshot is finished. */
+  void invalidate();
+
+  /* true if the snapshot on disk and journal contain the current trail */
+  bool isValid() const
+  {
+    return current != nullptr;
+  }
+
+  /* Number of records in the journal of the last finished snapshot */
+  int getNumRecords() const
+  {
+    return numRecords;
+  }
+
+private:
+  QString journalFilename(int slot) const;
+
+  /* Create a new file with header. Returns null on error. */
+  QFile *createFile(int slot, quint64 snapshotId);
+  void writeRecord(char type, const AircraftTrailPos& pos, qint64 value);
+  void removeFile(QFile *& file);
+
+  QString basename;
+
+  /* File for the last written snapshot and file for the snapshot in progress. Both can be null. */
+  QFile *current = nullptr, *next = nullptr;
+  int currentSlot = -1, nextSlot = -1, numRecords = 0, numRecordsNext = 0;
+};
+
+#endif // LNM_AIRCRAFTTRAILJOURNAL_H
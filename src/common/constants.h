@@ -284,6 +284,7 @@ const QLatin1String AIRSPACE_CONTROLLER_WIDGETS("AirspaceController/Widget");
 const QLatin1String SETTINGS_INFOQUERY("Settings/InfoQuery");
 const QLatin1String SETTINGS_MAPQUERY("Settings/MapQuery1");
 const QLatin1String SETTINGS_DATABASE("Settings/Database");
+const QLatin1String SETTINGS_ROUTE("Settings/Route");
 
 /* Aircraft trail densisity settings */
 const QLatin1String SETTINGS_AIRCRAFT_TRAIL("Settings/AircraftTrail");
@@ -367,8 +368,17 @@ const QLatin1String OPTIONS_DATAREADER_RECONNECT_SOCKET("Options/DataReaderRecon
 const QLatin1String OPTIONS_WEATHER_DEBUG("Options/WeatherDebug");
 const QLatin1String OPTIONS_MAP_JUMP_BACK_DEBUG("Options/MapJumpBackDebug");
 const QLatin1String OPTIONS_PROFILE_JUMP_BACK_DEBUG("Options/ProfileJumpBackDebug");
+const QLatin1String OPTIONS_PROFILE_PARALLEL_ELEVATION("Options/ProfileParallelElevation");
+const QLatin1String OPTIONS_PROFILE_ELEVATION_DEBUG("Options/ProfileElevationDebug");
 const QLatin1String OPTIONS_MAP_LAYER_DEBUG("Options/MapLayerDebug");
 const QLatin1String OPTIONS_MAP_LAYER_DEBUG_DRAW("Options/MapLayerDebugDraw");
+const QLatin1String OPTIONS_MAP_STATIC_LAYER_CACHE("Options/MapStaticLayerCache");
+const QLatin1String OPTIONS_MAP_PREFETCH("Options/MapPrefetch");
+const QLatin1String OPTIONS_MAP_PREFETCH_DEBUG("Options/MapPrefetchDebug");
+const QLatin1String OPTIONS_PROCEDURE_PREFETCH("Options/ProcedurePrefetch");
+const QLatin1String OPTIONS_SEARCH_TEXT_INDEX("Options/SearchTextIndex");
+const QLatin1String OPTIONS_INFO_INCREMENTAL_UPDATE("Options/InfoIncrementalUpdate");
+const QLatin1String OPTIONS_INFO_INCREMENTAL_UPDATE_DEBUG("Options/InfoIncrementalUpdateDebug");
 
 const QLatin1String OPTIONS_ONLINE_NETWORK_DEBUG("Options/OnlineNetworkDebug");
 const QLatin1String OPTIONS_ONLINE_NETWORK_MAX_SHADOW_DIST_NM("Options/MaxShadowDistNm");
@@ -379,6 +389,8 @@ const QLatin1String OPTIONS_ONLINE_NETWORK_MAX_SHADOW_HDG_DIFF_DEG("Options/MaxS
 const QLatin1String OPTIONS_TRACK_DEBUG("Options/TrackDebug");
 const QLatin1String OPTIONS_WIND_DEBUG("Options/WindDebug");
 const QLatin1String OPTIONS_WEBSERVER_DEBUG("Options/WebserverDebug");
+const QLatin1String OPTIONS_WEB_MAP_RENDER_POOL_SIZE("Options/WebMapRenderPoolSize");
+const QLatin1String OPTIONS_WEB_MAP_CACHE_MEMORY_KB("Options/WebMapCacheMemoryKb");
 const QLatin1String OPTIONS_STORAGE_DEBUG("Options/StorageDebug");
 const QLatin1String OPTIONS_VERSION("Options/Version");
 const QLatin1String OPTIONS_NO_USER_AGENT("Options/NoUserAgent");
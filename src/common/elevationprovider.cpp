@@ -17,6 +17,7 @@
 
 #include "common/elevationprovider.h"
 
+#include "common/globereaderpool.h"
 #include "common/constants.h"
 #include "geo/calculations.h"
 #include "app/navapp.h"
@@ -39,6 +40,15 @@ static Q_DECL_CONSTEXPR float ALTITUDE_LIMIT_METER = 8800.f;
 /* Point removal equality tolerance in meter */
 static Q_DECL_CONSTEXPR float SAME_ONLINE_ELEVATION_EPSILON = 1.f;
 
+/* Reset GLOBE ocean and invalid indicators to 0 and limit altitude */
+static float fixGlobeElevation(float elevation)
+{
+  if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
+    return 0.f;
+  else
+    return std::min(elevation, ALTITUDE_LIMIT_METER);
+}
+
 using atools::geo::Pos;
 using atools::geo::Line;
 using atools::geo::LineString;
@@ -53,7 +63,7 @@ ElevationProvider::ElevationProvider(QObject *parent)
 
 ElevationProvider::~ElevationProvider()
 {
-  delete globeReader;
+  std::atomic_store(&globeReader, std::shared_ptr<const GlobeReaderPool>());
 }
 
 void ElevationProvider::marbleUpdateAvailable()
@@ -64,15 +74,9 @@ void ElevationProvider::marbleUpdateAvailable()
 
 float ElevationProvider::getElevationMeter(const atools::geo::Pos& pos, float sampleRadiusMeter)
 {
-  if(isGlobeOfflineProvider())
-  {
-    QMutexLocker locker(&mutex);
-    float elevation = globeReader->getElevation(pos, sampleRadiusMeter);
-    if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
-      return 0.f;
-    else
-      return elevation;
-  }
+  std::shared_ptr<const GlobeReaderPool> reader = getGlobeReader();
+  if(reader != nullptr)
+    return fixGlobeElevation(reader->getElevation(pos, sampleRadiusMeter));
   else
     return 0.f;
 }
@@ -87,20 +91,20 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   if(!line.isValid())
     return;
 
-  QMutexLocker locker(&mutex);
-
-  if(isGlobeOfflineProvider())
+  std::shared_ptr<const GlobeReaderPool> reader = getGlobeReader();
+  if(reader != nullptr)
   {
-    globeReader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()), sampleRadiusMeter);
-    for(Pos& pos : elevations)
-    {
-      float alt = pos.getAltitude();
-      if(!(alt > atools::fs::common::OCEAN && alt < atools::fs::common::INVALID))
-        // Reset all invalid and ocean indicators to 0
-        pos.setAltitude(0.f);
-    }
+    // Offline data does not need the Marble lock
+    int first = elevations.size();
+    reader->getElevations(elevations, line, sampleRadiusMeter);
+    for(int i = first; i < elevations.size(); i++)
+      elevations[i].setAltitude(fixGlobeElevation(elevations.at(i).getAltitude()));
+    return;
   }
-  else if(marbleModel != nullptr)
+
+  QMutexLocker locker(&mutex);
+
+  if(marbleModel != nullptr)
   {
     // Get altitude points for the line segment
     // The might not be complete and will be more complete on further iterations when we get a signal
@@ -149,6 +153,11 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
     }
   }
 
+  fixElevations(elevations);
+}
+
+void ElevationProvider::fixElevations(atools::geo::LineString& elevations)
+{
   for(Pos& pos : elevations)
     // Limit ground altitude
     pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
@@ -156,7 +165,8 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
 
 bool ElevationProvider::isGlobeOfflineProvider() const
 {
-  return globeReader != nullptr && globeReader->isValid();
+  // Reader is only stored if valid
+  return getGlobeReader() != nullptr;
 }
 
 bool ElevationProvider::isGlobeDirValid()
@@ -193,41 +203,28 @@ void ElevationProvider::updateReader(bool startupParam)
   bool useOffline = OptionData::instance().getFlags().testFlag(opts::CACHE_USE_OFFLINE_ELEVATION);
   const QString& path = OptionData::instance().getOfflineElevationPath();
 
+  // Threads still using the old reader keep it alive until they are done
+  std::shared_ptr<const GlobeReaderPool> reader;
+  if(useOffline)
   {
-    // Make sure to wait for other methods to finish before changing the reader
-    QMutexLocker locker(&mutex);
-
-    if(useOffline)
+    if(!GlobeReader::isDirValid(path))
+      warnWrongGlobePath = true;
+    else
     {
-      if(!GlobeReader::isDirValid(path))
-      {
-        warnWrongGlobePath = true;
-        delete globeReader;
-        globeReader = nullptr;
-      }
-      else
-      {
-        delete globeReader;
-        globeReader = new GlobeReader(path);
+      std::shared_ptr<GlobeReaderPool> newReader = std::make_shared<GlobeReaderPool>(path);
 
-        qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
+      qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
 
-        if(!globeReader->openFiles())
-        {
-          delete globeReader;
-          globeReader = nullptr;
-          warnOpenFiles = true;
-        }
-        else
-          qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
+      if(!newReader->openFiles())
+        warnOpenFiles = true;
+      else
+      {
+        reader = newReader;
+        qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
       }
     }
-    else
-    {
-      delete globeReader;
-      globeReader = nullptr;
-    }
   }
+  std::atomic_store(&globeReader, reader);
 
   emit updateAvailable();
 }
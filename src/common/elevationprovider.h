@@ -21,17 +21,15 @@
 #include <QMutex>
 #include <QObject>
 
+#include <memory>
+
 namespace Marble {
 class ElevationModel;
 }
 
-namespace atools {
-namespace fs {
-namespace common {
-class GlobeReader;
-}
-}
+class GlobeReaderPool;
 
+namespace atools {
 namespace geo {
 class Pos;
 class LineString;
@@ -43,7 +41,9 @@ class Line;
  * Wraps the slow Marble online elevation provider and the fast offline GLOBE data provider.
  * Use GLOBE data if all paramters are set properly in settings.
  *
- * Class is thread safe.
+ * Class is thread safe. GLOBE data is read by a pool of readers which allows concurrent access. The pool is
+ * replaced atomically on options changes while threads using the old one can finish their work.
+ * Only the Marble provider is protected by a mutex.
  */
 class ElevationProvider :
   public QObject
@@ -98,12 +98,23 @@ private:
   void marbleUpdateAvailable();
   void updateReader(bool startupParam);
 
+  /* Get current GLOBE reader or null. Reader stays valid as long as the pointer is held. */
+  std::shared_ptr<const GlobeReaderPool> getGlobeReader() const
+  {
+    return std::atomic_load(&globeReader);
+  }
+
+  /* Limit altitude of online data */
+  static void fixElevations(atools::geo::LineString& elevations);
+
   const Marble::ElevationModel *marbleModel = nullptr;
-  atools::fs::common::GlobeReader *globeReader = nullptr;
+
+  /* Accessed only with std::atomic_load and std::atomic_store */
+  std::shared_ptr<const GlobeReaderPool> globeReader;
 
   bool warnWrongGlobePath = false, warnOpenFiles = false, startup = false;
 
-  /* Need to synchronize here since it is called from profile widget thread */
+  /* Need to synchronize Marble model access since it is called from profile widget thread */
   mutable QMutex mutex;
 
 };
@@ -0,0 +1,102 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "common/globereaderpool.h"
+
+#include "fs/common/globereader.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+#include "geo/pos.h"
+
+#include <QDebug>
+
+using atools::fs::common::GlobeReader;
+using atools::geo::Pos;
+using atools::geo::Line;
+using atools::geo::LineString;
+
+GlobeReaderPool::GlobeReaderPool(const QString& dataDirParam)
+  : dataDir(dataDirParam)
+{
+}
+
+GlobeReaderPool::~GlobeReaderPool()
+{
+  // All readers are returned since the pool is held by a shared pointer while in use
+  QMutexLocker locker(&mutex);
+  qDeleteAll(readers);
+  readers.clear();
+}
+
+bool GlobeReaderPool::openFiles()
+{
+  GlobeReader *reader = takeReader();
+  if(reader != nullptr)
+  {
+    returnReader(reader);
+    return true;
+  }
+  else
+    return false;
+}
+
+GlobeReader *GlobeReaderPool::takeReader() const
+{
+  {
+    QMutexLocker locker(&mutex);
+    if(!readers.isEmpty())
+      return readers.takeLast();
+  }
+
+  // Open files outside of the lock - all readers are in use
+  GlobeReader *reader = new GlobeReader(dataDir);
+  if(!reader->openFiles())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open GLOBE files in" << dataDir;
+    delete reader;
+    return nullptr;
+  }
+  return reader;
+}
+
+void GlobeReaderPool::returnReader(GlobeReader *reader) const
+{
+  QMutexLocker locker(&mutex);
+  readers.append(reader);
+}
+
+float GlobeReaderPool::getElevation(const Pos& pos, float sampleRadiusMeter) const
+{
+  float elevation = 0.f;
+  GlobeReader *reader = takeReader();
+  if(reader != nullptr)
+  {
+    elevation = reader->getElevation(pos, sampleRadiusMeter);
+    returnReader(reader);
+  }
+  return elevation;
+}
+
+void GlobeReaderPool::getElevations(LineString& elevations, const Line& line, float sampleRadiusMeter) const
+{
+  GlobeReader *reader = takeReader();
+  if(reader != nullptr)
+  {
+    reader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()), sampleRadiusMeter);
+    returnReader(reader);
+  }
+}
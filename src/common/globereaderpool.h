@@ -0,0 +1,80 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_GLOBEREADERPOOL_H
+#define LITTLENAVMAP_GLOBEREADERPOOL_H
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace atools {
+namespace fs {
+namespace common {
+class GlobeReader;
+}
+}
+
+namespace geo {
+class Pos;
+class Line;
+class LineString;
+}
+}
+
+/*
+ * Pool of GLOBE readers for concurrent access to the offline elevation data.
+ *
+ * Each GlobeReader uses its own file handles and is therefore only used by one thread at a time.
+ * A reader is taken from the pool for each call and returned afterwards. New readers are opened on demand
+ * if all are in use. The mutex is only held for taking and returning readers and not while reading.
+ *
+ * Tile lookup and sampling is done by GlobeReader. Values are returned unchanged in meter including
+ * ocean and invalid indicators.
+ */
+class GlobeReaderPool
+{
+public:
+  explicit GlobeReaderPool(const QString& dataDirParam);
+  ~GlobeReaderPool();
+
+  GlobeReaderPool(const GlobeReaderPool& other) = delete;
+  GlobeReaderPool& operator=(const GlobeReaderPool& other) = delete;
+
+  /* Open files for the first reader. Returns false if files cannot be opened. */
+  bool openFiles();
+
+  /* Elevation in meter. sampleRadiusMeter defines a rectangle where five points are sampled and the maximum is used. */
+  float getElevation(const atools::geo::Pos& pos, float sampleRadiusMeter = 0.f) const;
+
+  /* Get elevations along a great circle line. Elevations are appended to elevations. */
+  void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line, float sampleRadiusMeter = 0.f) const;
+
+private:
+  /* Get an unused reader or open a new one. Returns null if files cannot be opened. */
+  atools::fs::common::GlobeReader *takeReader() const;
+
+  /* Return reader to the pool */
+  void returnReader(atools::fs::common::GlobeReader *reader) const;
+
+  /* Unused readers */
+  mutable QVector<atools::fs::common::GlobeReader *> readers;
+  mutable QMutex mutex;
+  QString dataDir;
+};
+
+#endif // LITTLENAVMAP_GLOBEREADERPOOL_H
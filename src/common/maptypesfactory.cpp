@@ -22,43 +22,433 @@
 #include "geo/calculations.h"
 #include "io/binaryutil.h"
 #include "sql/sqlrecord.h"
+#include "sql/sqlquery.h"
 #include "fs/util/fsutil.h"
 
+#include <QHash>
+
 using namespace atools::geo;
 using atools::sql::SqlRecord;
+using atools::sql::SqlQuery;
 using namespace map;
 
-void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airport, bool complete, bool nav, bool xplane)
+// ==========================================================================================================
+// Column ordinals and fill code shared by the record and the query row based methods
+
+/* Column indexes into MapTypesColumns::indexes. Order has to match the name arrays below. */
+enum AirportColumn
+{
+  AP_COL_AIRPORT_ID, AP_COL_RATING, AP_COL_TOWER_FREQUENCY, AP_COL_IDENT, AP_COL_ICAO, AP_COL_IATA, AP_COL_FAA, AP_COL_LOCAL,
+  AP_COL_NAME, AP_COL_TYPE, AP_COL_LONGEST_RUNWAY_LENGTH, AP_COL_LONGEST_RUNWAY_HEADING, AP_COL_MAG_VAR,
+  AP_COL_TRANSITION_ALTITUDE, AP_COL_TRANSITION_LEVEL, AP_COL_FLATTEN, AP_COL_LEFT_LONX, AP_COL_TOP_LATY, AP_COL_RIGHT_LONX,
+  AP_COL_BOTTOM_LATY, AP_COL_NUM_HELIPAD, AP_COL_HAS_AVGAS, AP_COL_HAS_JETFUEL, AP_COL_IS_CLOSED, AP_COL_IS_MILITARY,
+  AP_COL_IS_ADDON, AP_COL_IS_3D, AP_COL_NUM_RUNWAY_HARD, AP_COL_NUM_RUNWAY_SOFT, AP_COL_NUM_RUNWAY_WATER, AP_COL_NUM_APPROACH,
+  AP_COL_NUM_RUNWAY_LIGHT, AP_COL_NUM_RUNWAY_END_ILS, AP_COL_NUM_APRON, AP_COL_NUM_TAXI_PATH, AP_COL_HAS_TOWER_OBJECT,
+  AP_COL_NUM_PARKING_GATE, AP_COL_NUM_PARKING_GA_RAMP, AP_COL_NUM_PARKING_CARGO, AP_COL_NUM_PARKING_MIL_CARGO,
+  AP_COL_NUM_PARKING_MIL_COMBAT, AP_COL_NUM_RUNWAY_END_VASI, AP_COL_NUM_RUNWAY_END_ALS, AP_COL_NUM_RUNWAY_END_CLOSED,
+  AP_COL_TOWER_LONX, AP_COL_TOWER_LATY, AP_COL_ATIS_FREQUENCY, AP_COL_AWOS_FREQUENCY, AP_COL_ASOS_FREQUENCY,
+  AP_COL_UNICOM_FREQUENCY, AP_COL_LONX, AP_COL_LATY, AP_COL_ALTITUDE, AP_COL_REGION, AP_COL_SIZE
+};
+
+static const char *AIRPORT_COLUMNS[AP_COL_SIZE] =
+{
+  "airport_id", "rating", "tower_frequency", "ident", "icao", "iata", "faa", "local",
+  "name", "type", "longest_runway_length", "longest_runway_heading", "mag_var",
+  "transition_altitude", "transition_level", "flatten", "left_lonx", "top_laty", "right_lonx",
+  "bottom_laty", "num_helipad", "has_avgas", "has_jetfuel", "is_closed", "is_military",
+  "is_addon", "is_3d", "num_runway_hard", "num_runway_soft", "num_runway_water", "num_approach",
+  "num_runway_light", "num_runway_end_ils", "num_apron", "num_taxi_path", "has_tower_object",
+  "num_parking_gate", "num_parking_ga_ramp", "num_parking_cargo", "num_parking_mil_cargo",
+  "num_parking_mil_combat", "num_runway_end_vasi", "num_runway_end_als", "num_runway_end_closed",
+  "tower_lonx", "tower_laty", "atis_frequency", "awos_frequency", "asos_frequency",
+  "unicom_frequency", "lonx", "laty", "altitude", "region"
+};
+
+/* Same for VOR and NDB */
+enum NavaidColumn
+{
+  NAV_COL_ID, NAV_COL_IDENT, NAV_COL_REGION, NAV_COL_NAME, NAV_COL_TYPE, NAV_COL_CHANNEL, NAV_COL_FREQUENCY, NAV_COL_RANGE,
+  NAV_COL_MAG_VAR, NAV_COL_LONX, NAV_COL_LATY, NAV_COL_ALTITUDE, NAV_COL_DME_ONLY, NAV_COL_DME_ALTITUDE, NAV_COL_SIZE
+};
+
+static const char *VOR_COLUMNS[NAV_COL_SIZE] =
+{
+  "vor_id", "ident", "region", "name", "type", "channel", "frequency", "range",
+  "mag_var", "lonx", "laty", "altitude", "dme_only", "dme_altitude"
+};
+
+static const char *NDB_COLUMNS[NAV_COL_SIZE] =
+{
+  "ndb_id", "ident", "region", "name", "type", "channel", "frequency", "range",
+  "mag_var", "lonx", "laty", "altitude", "dme_only", "dme_altitude"
+};
+
+enum WaypointColumn
+{
+  WP_COL_ID, WP_COL_IDENT, WP_COL_REGION, WP_COL_TYPE, WP_COL_ARINC_TYPE, WP_COL_MAG_VAR, WP_COL_NUM_VICTOR_AIRWAY,
+  WP_COL_NUM_JET_AIRWAY, WP_COL_ARTIFICIAL, WP_COL_LONX, WP_COL_LATY, WP_COL_SIZE
+};
+
+static const char *WAYPOINT_COLUMNS[WP_COL_SIZE] =
+{
+  "waypoint_id", "ident", "region", "type", "arinc_type", "mag_var", "num_victor_airway",
+  "num_jet_airway", "artificial", "lonx", "laty"
+};
+
+enum AirspaceColumn
+{
+  AS_COL_BOUNDARY_ID, AS_COL_ATC_ID, AS_COL_TYPE, AS_COL_NAME, AS_COL_CALLSIGN, AS_COL_COM_TYPE, AS_COL_COM_FREQUENCY,
+  AS_COL_FREQUENCY, AS_COL_COM_NAME, AS_COL_MULTIPLE_CODE, AS_COL_RESTRICTIVE_DESIGNATION, AS_COL_RESTRICTIVE_TYPE,
+  AS_COL_TIME_CODE, AS_COL_MIN_ALTITUDE_TYPE, AS_COL_MAX_ALTITUDE_TYPE, AS_COL_MAX_ALTITUDE, AS_COL_MIN_ALTITUDE,
+  AS_COL_MIN_LONX, AS_COL_MAX_LATY, AS_COL_MAX_LONX, AS_COL_MIN_LATY, AS_COL_SIZE
+};
+
+static const char *AIRSPACE_COLUMNS[AS_COL_SIZE] =
+{
+  "boundary_id", "atc_id", "type", "name", "callsign", "com_type", "com_frequency",
+  "frequency", "com_name", "multiple_code", "restrictive_designation", "restrictive_type",
+  "time_code", "min_altitude_type", "max_altitude_type", "max_altitude", "min_altitude",
+  "min_lonx", "max_laty", "max_lonx", "min_laty"
+};
+
+/* Airport flags and their columns */
+struct AirportFlagColumn
+{
+  AirportColumn column;
+  map::MapAirportFlag flag;
+};
+
+/* Flags used for overview and normal airports */
+static const AirportFlagColumn AIRPORT_FLAG_COLUMNS[] =
+{
+  {AP_COL_NUM_HELIPAD, AP_HELIPAD}, {AP_COL_HAS_AVGAS, AP_AVGAS}, {AP_COL_HAS_JETFUEL, AP_JETFUEL},
+  {AP_COL_TOWER_FREQUENCY, AP_TOWER}, {AP_COL_IS_CLOSED, AP_CLOSED}, {AP_COL_IS_MILITARY, AP_MIL},
+  {AP_COL_IS_ADDON, AP_ADDON}, {AP_COL_IS_3D, AP_3D}, {AP_COL_NUM_RUNWAY_HARD, AP_HARD},
+  {AP_COL_NUM_RUNWAY_SOFT, AP_SOFT}, {AP_COL_NUM_RUNWAY_WATER, AP_WATER}
+};
+
+/* Additional flags for normal airports */
+static const AirportFlagColumn AIRPORT_FLAG_COLUMNS_COMPLETE[] =
+{
+  {AP_COL_NUM_APPROACH, AP_PROCEDURE}, {AP_COL_NUM_RUNWAY_LIGHT, AP_LIGHT}, {AP_COL_NUM_RUNWAY_END_ILS, AP_ILS},
+  {AP_COL_NUM_APRON, AP_APRON}, {AP_COL_NUM_TAXI_PATH, AP_TAXIWAY}, {AP_COL_HAS_TOWER_OBJECT, AP_TOWER_OBJ},
+  {AP_COL_NUM_PARKING_GATE, AP_PARKING}, {AP_COL_NUM_PARKING_GA_RAMP, AP_PARKING}, {AP_COL_NUM_PARKING_CARGO, AP_PARKING},
+  {AP_COL_NUM_PARKING_MIL_CARGO, AP_PARKING}, {AP_COL_NUM_PARKING_MIL_COMBAT, AP_PARKING},
+  {AP_COL_NUM_RUNWAY_END_VASI, AP_VASI}, {AP_COL_NUM_RUNWAY_END_ALS, AP_ALS}, {AP_COL_NUM_RUNWAY_END_CLOSED, AP_RW_CLOSED}
+};
+
+/* Resolve ordinals for all names once from the record of a query or from a single record */
+static void resolveColumns(QVector<int>& indexes, const SqlRecord& record, const char *const names[], int size)
+{
+  QHash<QString, int> fieldIndexes;
+  for(int i = 0; i < record.count(); i++)
+    fieldIndexes.insert(record.fieldName(i), i);
+
+  indexes.resize(size);
+  for(int i = 0; i < size; i++)
+    indexes[i] = fieldIndexes.value(QLatin1String(names[i]), -1);
+}
+
+/*
+ * Reads values by resolved column ordinal either from the current row of a query or from a record.
+ * Used by both the record and the query based fill methods of MapTypesFactory to keep results identical.
+ * Columns missing in the query or record return null or default values.
+ */
+class ColumnRow
+{
+public:
+  ColumnRow(const SqlQuery& queryParam, const QVector<int>& indexesParam)
+    : query(&queryParam), indexes(indexesParam)
+  {
+  }
+
+  ColumnRow(const SqlRecord& recordParam, const QVector<int>& indexesParam)
+    : record(&recordParam), indexes(indexesParam)
+  {
+  }
+
+  bool contains(int column) const
+  {
+    return indexes.at(column) != -1;
+  }
+
+  QVariant value(int column) const
+  {
+    int index = indexes.at(column);
+    if(index == -1)
+      return QVariant();
+    else
+      return query != nullptr ? query->value(index) : record->value(index);
+  }
+
+  int valueInt(int column, int defaultValue = 0) const
+  {
+    return contains(column) ? value(column).toInt() : defaultValue;
+  }
+
+  float valueFloat(int column, float defaultValue = 0.f) const
+  {
+    return contains(column) ? value(column).toFloat() : defaultValue;
+  }
+
+  QString valueStr(int column) const
+  {
+    return value(column).toString();
+  }
+
+  bool isNull(int column) const
+  {
+    return value(column).isNull();
+  }
+
+private:
+  const SqlQuery *query = nullptr;
+  const SqlRecord *record = nullptr;
+  const QVector<int>& indexes;
+};
+
+/* Use defaults for missing columns. Null values are returned as zero. */
+static MapAirportFlags fillAirportFlagsRow(const ColumnRow& row, bool overview)
+{
+  MapAirportFlags flags = AP_NONE;
+
+  for(const AirportFlagColumn& flagCol : AIRPORT_FLAG_COLUMNS)
+  {
+    if(row.valueInt(flagCol.column) != 0)
+      flags |= flagCol.flag;
+  }
+
+  if(!overview)
+  {
+    // The procedure flag is not accurate for mixed mode databases and is updated later on by
+    // AirportQuery::hasAirportProcedures()
+    for(const AirportFlagColumn& flagCol : AIRPORT_FLAG_COLUMNS_COMPLETE)
+    {
+      if(row.valueInt(flagCol.column) != 0)
+        flags |= flagCol.flag;
+    }
+  }
+  else if(row.valueInt(AP_COL_RATING) > 0)
+  {
+    // Force non empty airports for overview results
+    flags |= AP_APRON;
+    flags |= AP_TAXIWAY;
+    flags |= AP_TOWER_OBJ;
+  }
+
+  return flags;
+}
+
+static void fillAirportBaseRow(const ColumnRow& row, map::MapAirport& ap, bool complete)
+{
+  ap.id = row.valueInt(AP_COL_AIRPORT_ID);
+  ap.rating = row.valueInt(AP_COL_RATING);
+
+  if(complete)
+  {
+    ap.towerFrequency = row.valueInt(AP_COL_TOWER_FREQUENCY);
+    ap.ident = row.valueStr(AP_COL_IDENT);
+    ap.icao = row.valueStr(AP_COL_ICAO);
+    ap.iata = row.valueStr(AP_COL_IATA);
+    ap.faa = row.valueStr(AP_COL_FAA);
+    ap.local = row.valueStr(AP_COL_LOCAL);
+    ap.name = row.valueStr(AP_COL_NAME);
+    ap.type = static_cast<map::MapAirportType>(row.valueInt(AP_COL_TYPE, map::AP_TYPE_NONE));
+    ap.longestRunwayLength = row.valueInt(AP_COL_LONGEST_RUNWAY_LENGTH);
+    ap.longestRunwayHeading = static_cast<int>(std::round(row.valueFloat(AP_COL_LONGEST_RUNWAY_HEADING)));
+    ap.magvar = row.valueFloat(AP_COL_MAG_VAR);
+    ap.transitionAltitude = row.valueFloat(AP_COL_TRANSITION_ALTITUDE);
+    ap.transitionLevel = row.valueFloat(AP_COL_TRANSITION_LEVEL);
+
+    if(row.contains(AP_COL_FLATTEN))
+      ap.flatten = row.isNull(AP_COL_FLATTEN) ? -1 : row.valueInt(AP_COL_FLATTEN);
+
+    ap.bounding = Rect(row.valueFloat(AP_COL_LEFT_LONX), row.valueFloat(AP_COL_TOP_LATY),
+                       row.valueFloat(AP_COL_RIGHT_LONX), row.valueFloat(AP_COL_BOTTOM_LATY));
+    ap.flags |= AP_COMPLETE;
+  }
+}
+
+static void fillAirportRow(const ColumnRow& row, map::MapAirport& airport, bool complete, bool nav, bool xplane)
 {
-  fillAirportBase(record, airport, complete);
+  fillAirportBaseRow(row, airport, complete);
   airport.navdata = nav;
   airport.xplane = xplane;
 
   if(complete)
   {
-    airport.flags = fillAirportFlags(record, false);
-    if(record.contains("has_tower_object"))
-      airport.towerCoords = Pos(record.valueFloat("tower_lonx"), record.valueFloat("tower_laty"));
-
-    airport.atisFrequency = record.valueInt("atis_frequency");
-    airport.awosFrequency = record.valueInt("awos_frequency");
-    airport.asosFrequency = record.valueInt("asos_frequency");
-    airport.unicomFrequency = record.valueInt("unicom_frequency");
-    airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), record.valueFloat("altitude"));
-    airport.region = record.valueStr("region", QString());
+    airport.flags = fillAirportFlagsRow(row, false);
+    if(row.contains(AP_COL_HAS_TOWER_OBJECT))
+      airport.towerCoords = Pos(row.valueFloat(AP_COL_TOWER_LONX), row.valueFloat(AP_COL_TOWER_LATY));
+
+    airport.atisFrequency = row.valueInt(AP_COL_ATIS_FREQUENCY);
+    airport.awosFrequency = row.valueInt(AP_COL_AWOS_FREQUENCY);
+    airport.asosFrequency = row.valueInt(AP_COL_ASOS_FREQUENCY);
+    airport.unicomFrequency = row.valueInt(AP_COL_UNICOM_FREQUENCY);
+    airport.position = Pos(row.valueFloat(AP_COL_LONX), row.valueFloat(AP_COL_LATY), row.valueFloat(AP_COL_ALTITUDE));
+    airport.region = row.valueStr(AP_COL_REGION);
   }
   else
-    airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), 0.f);
+    airport.position = Pos(row.valueFloat(AP_COL_LONX), row.valueFloat(AP_COL_LATY), 0.f);
 }
 
-void MapTypesFactory::fillAirportForOverview(const SqlRecord& record, map::MapAirport& airport, bool nav, bool xplane)
+static void fillAirportForOverviewRow(const ColumnRow& row, map::MapAirport& airport, bool nav, bool xplane)
 {
-  fillAirportBase(record, airport, true);
+  fillAirportBaseRow(row, airport, true);
   airport.navdata = nav;
   airport.xplane = xplane;
 
-  airport.flags = fillAirportFlags(record, true);
-  airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), 0.f);
+  airport.flags = fillAirportFlagsRow(row, true);
+  airport.position = Pos(row.valueFloat(AP_COL_LONX), row.valueFloat(AP_COL_LATY), 0.f);
+}
+
+static void fillVorBaseRow(const ColumnRow& row, map::MapVor& vor)
+{
+  vor.id = row.valueInt(NAV_COL_ID);
+  vor.ident = row.valueStr(NAV_COL_IDENT);
+  vor.region = row.valueStr(NAV_COL_REGION);
+  vor.name = atools::capString(row.valueStr(NAV_COL_NAME));
+
+  // Check also for types from the nav_search table and VORTACs
+  QString type = row.valueStr(NAV_COL_TYPE);
+  if(type == "VH" || type == "VTH")
+    vor.type = "H";
+  else if(type == "VL" || type == "VTL")
+    vor.type = "L";
+  else if(type == "VT" || type == "VTT")
+    vor.type = "T";
+  else
+    vor.type = type;
+
+  vor.tacan = type == "TC";
+  vor.vortac = type.startsWith("VT");
+
+  vor.channel = row.valueStr(NAV_COL_CHANNEL);
+  vor.frequency = row.valueInt(NAV_COL_FREQUENCY);
+
+  vor.range = row.valueInt(NAV_COL_RANGE);
+  vor.magvar = row.valueFloat(NAV_COL_MAG_VAR);
+
+  if(row.isNull(NAV_COL_ALTITUDE))
+    vor.position = Pos(row.valueFloat(NAV_COL_LONX), row.valueFloat(NAV_COL_LATY), INVALID_ALTITUDE_VALUE);
+  else
+    vor.position = Pos(row.valueFloat(NAV_COL_LONX), row.valueFloat(NAV_COL_LATY), row.valueFloat(NAV_COL_ALTITUDE));
+}
+
+static void fillVorRow(const ColumnRow& row, map::MapVor& vor)
+{
+  fillVorBaseRow(row, vor);
+
+  vor.dmeOnly = row.valueInt(NAV_COL_DME_ONLY) > 0;
+  vor.hasDme = !row.isNull(NAV_COL_DME_ALTITUDE);
+}
+
+static void fillNdbRow(const ColumnRow& row, map::MapNdb& ndb)
+{
+  ndb.id = row.valueInt(NAV_COL_ID);
+  ndb.ident = row.valueStr(NAV_COL_IDENT);
+  ndb.region = row.valueStr(NAV_COL_REGION);
+  ndb.name = atools::capString(row.valueStr(NAV_COL_NAME));
+  ndb.type = row.valueStr(NAV_COL_TYPE);
+  ndb.frequency = row.valueInt(NAV_COL_FREQUENCY);
+  ndb.range = row.valueInt(NAV_COL_RANGE);
+  ndb.magvar = row.valueFloat(NAV_COL_MAG_VAR);
+
+  if(row.isNull(NAV_COL_ALTITUDE))
+    ndb.position = Pos(row.valueFloat(NAV_COL_LONX), row.valueFloat(NAV_COL_LATY), INVALID_ALTITUDE_VALUE);
+  else
+    ndb.position = Pos(row.valueFloat(NAV_COL_LONX), row.valueFloat(NAV_COL_LATY), row.valueFloat(NAV_COL_ALTITUDE));
+}
+
+/* Track database and nav_search table use different column names for some fields */
+static void resolveWaypointColumns(QVector<int>& indexes, const SqlRecord& record, bool track, bool nav)
+{
+  resolveColumns(indexes, record, WAYPOINT_COLUMNS, WP_COL_SIZE);
+
+  if(track)
+    indexes[WP_COL_ID] = record.indexOf("trackpoint_id");
+
+  if(nav)
+  {
+    indexes[WP_COL_NUM_VICTOR_AIRWAY] = record.indexOf("waypoint_num_victor_airway");
+    indexes[WP_COL_NUM_JET_AIRWAY] = record.indexOf("waypoint_num_jet_airway");
+  }
+}
+
+static void fillWaypointRow(const ColumnRow& row, map::MapWaypoint& waypoint, bool track)
+{
+  waypoint.id = row.valueInt(WP_COL_ID);
+  waypoint.ident = row.valueStr(WP_COL_IDENT);
+  waypoint.region = row.valueStr(WP_COL_REGION);
+  waypoint.type = row.valueStr(WP_COL_TYPE);
+  waypoint.arincType = row.valueStr(WP_COL_ARINC_TYPE);
+  waypoint.magvar = row.valueFloat(WP_COL_MAG_VAR);
+  waypoint.hasVictorAirways = row.valueInt(WP_COL_NUM_VICTOR_AIRWAY) > 0;
+  waypoint.hasJetAirways = row.valueInt(WP_COL_NUM_JET_AIRWAY) > 0;
+  waypoint.artificial = static_cast<map::MapWaypointArtificial>(row.valueInt(WP_COL_ARTIFICIAL, map::WAYPOINT_ARTIFICIAL_NONE));
+  waypoint.hasTracks = track;
+  waypoint.position = Pos(row.valueFloat(WP_COL_LONX), row.valueFloat(WP_COL_LATY));
+}
+
+static void fillAirspaceRow(const ColumnRow& row, map::MapAirspace& airspace, map::MapAirspaceSources src)
+{
+  if(row.contains(AS_COL_BOUNDARY_ID))
+    airspace.id = row.valueInt(AS_COL_BOUNDARY_ID);
+  else if(row.contains(AS_COL_ATC_ID))
+    airspace.id = row.valueInt(AS_COL_ATC_ID);
+
+  airspace.src = src;
+
+  airspace.type = map::airspaceTypeFromDatabase(row.valueStr(AS_COL_TYPE));
+  airspace.name = row.valueStr(airspace.isOnline() ? AS_COL_CALLSIGN : AS_COL_NAME);
+  airspace.comType = row.valueStr(AS_COL_COM_TYPE);
+
+  const QStringList split = row.valueStr(row.contains(AS_COL_COM_FREQUENCY) ? AS_COL_COM_FREQUENCY : AS_COL_FREQUENCY).split("&");
+  for(const QString& str : split)
+  {
+    bool ok;
+    int frequency = str.toInt(&ok);
+
+    if(frequency > 0 && ok)
+      airspace.comFrequencies.append(frequency);
+  }
+
+  // Use default values for online network ATC centers
+  airspace.comName = row.valueStr(AS_COL_COM_NAME);
+  airspace.multipleCode = row.valueStr(AS_COL_MULTIPLE_CODE).trimmed();
+  airspace.restrictiveDesignation = row.valueStr(AS_COL_RESTRICTIVE_DESIGNATION);
+  airspace.restrictiveType = row.valueStr(AS_COL_RESTRICTIVE_TYPE);
+  airspace.timeCode = row.valueStr(AS_COL_TIME_CODE);
+  airspace.minAltitudeType = row.valueStr(AS_COL_MIN_ALTITUDE_TYPE);
+  airspace.maxAltitudeType = row.valueStr(AS_COL_MAX_ALTITUDE_TYPE);
+  airspace.maxAltitude = row.valueInt(AS_COL_MAX_ALTITUDE, 0);
+  airspace.minAltitude = row.valueInt(AS_COL_MIN_ALTITUDE, 70000);
+
+  Pos topLeft(row.value(AS_COL_MIN_LONX), row.value(AS_COL_MAX_LATY));
+  Pos bottomRight(row.value(AS_COL_MAX_LONX), row.value(AS_COL_MIN_LATY));
+
+  if(topLeft.isValid() && bottomRight.isValid())
+  {
+    airspace.bounding = Rect(topLeft, bottomRight);
+    airspace.position = airspace.bounding.getCenter();
+  }
+}
+
+// ==========================================================================================================
+// Record based methods
+
+void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airport, bool complete, bool nav, bool xplane)
+{
+  QVector<int> indexes;
+  resolveColumns(indexes, record, AIRPORT_COLUMNS, AP_COL_SIZE);
+  fillAirportRow(ColumnRow(record, indexes), airport, complete, nav, xplane);
+}
+
+void MapTypesFactory::fillAirportForOverview(const SqlRecord& record, map::MapAirport& airport, bool nav, bool xplane)
+{
+  QVector<int> indexes;
+  resolveColumns(indexes, record, AIRPORT_COLUMNS, AP_COL_SIZE);
+  fillAirportForOverviewRow(ColumnRow(record, indexes), airport, nav, xplane);
 }
 
 void MapTypesFactory::fillRunway(const atools::sql::SqlRecord& record, map::MapRunway& runway, bool overview)
@@ -127,108 +517,18 @@ void MapTypesFactory::fillRunwayEnd(const atools::sql::SqlRecord& record, MapRun
   end.pattern = record.valueStr("is_pattern", QString());
 }
 
-void MapTypesFactory::fillAirportBase(const SqlRecord& record, map::MapAirport& ap, bool complete)
-{
-  ap.id = record.valueInt("airport_id");
-  ap.rating = record.valueInt("rating");
-
-  if(complete)
-  {
-    ap.towerFrequency = record.valueInt("tower_frequency");
-    ap.ident = record.valueStr("ident");
-    ap.icao = record.valueStr("icao", QString());
-    ap.iata = record.valueStr("iata", QString());
-    ap.faa = record.valueStr("faa", QString());
-    ap.local = record.valueStr("local", QString());
-    ap.name = record.valueStr("name");
-    ap.type = static_cast<map::MapAirportType>(record.valueInt("type", map::AP_TYPE_NONE));
-    ap.longestRunwayLength = record.valueInt("longest_runway_length");
-    ap.longestRunwayHeading = static_cast<int>(std::round(record.valueFloat("longest_runway_heading")));
-    ap.magvar = record.valueFloat("mag_var");
-    ap.transitionAltitude = record.valueFloat("transition_altitude", 0.f);
-    ap.transitionLevel = record.valueFloat("transition_level", 0.f);
-
-    if(record.contains("flatten"))
-      ap.flatten = record.isNull("flatten") ? -1 : record.valueInt("flatten");
-
-    ap.bounding = Rect(record.valueFloat("left_lonx"), record.valueFloat("top_laty"),
-                       record.valueFloat("right_lonx"), record.valueFloat("bottom_laty"));
-    ap.flags |= AP_COMPLETE;
-  }
-}
-
-map::MapAirportFlags MapTypesFactory::fillAirportFlags(const SqlRecord& record, bool overview)
-{
-  MapAirportFlags flags = AP_NONE;
-  flags |= airportFlag(record, "num_helipad", AP_HELIPAD);
-  flags |= airportFlag(record, "has_avgas", AP_AVGAS);
-  flags |= airportFlag(record, "has_jetfuel", AP_JETFUEL);
-  flags |= airportFlag(record, "tower_frequency", AP_TOWER);
-  flags |= airportFlag(record, "is_closed", AP_CLOSED);
-  flags |= airportFlag(record, "is_military", AP_MIL);
-  flags |= airportFlag(record, "is_addon", AP_ADDON);
-  flags |= airportFlag(record, "is_3d", AP_3D);
-  flags |= airportFlag(record, "num_runway_hard", AP_HARD);
-  flags |= airportFlag(record, "num_runway_soft", AP_SOFT);
-  flags |= airportFlag(record, "num_runway_water", AP_WATER);
-
-  if(!overview)
-  {
-    // The procedure flag is not accurate for mixed mode databases and is updated later on by
-    // AirportQuery::hasAirportProcedures()
-    flags |= airportFlag(record, "num_approach", AP_PROCEDURE);
-    flags |= airportFlag(record, "num_runway_light", AP_LIGHT);
-    flags |= airportFlag(record, "num_runway_end_ils", AP_ILS);
-
-    flags |= airportFlag(record, "num_apron", AP_APRON);
-    flags |= airportFlag(record, "num_taxi_path", AP_TAXIWAY);
-    flags |= airportFlag(record, "has_tower_object", AP_TOWER_OBJ);
-
-    flags |= airportFlag(record, "num_parking_gate", AP_PARKING);
-    flags |= airportFlag(record, "num_parking_ga_ramp", AP_PARKING);
-    flags |= airportFlag(record, "num_parking_cargo", AP_PARKING);
-    flags |= airportFlag(record, "num_parking_mil_cargo", AP_PARKING);
-    flags |= airportFlag(record, "num_parking_mil_combat", AP_PARKING);
-
-    flags |= airportFlag(record, "num_runway_end_vasi", AP_VASI);
-    flags |= airportFlag(record, "num_runway_end_als", AP_ALS);
-    flags |= airportFlag(record, "num_runway_end_closed", AP_RW_CLOSED);
-
-  }
-  else
-  {
-    if(record.valueInt("rating") > 0)
-    {
-      // Force non empty airports for overview results
-      flags |= AP_APRON;
-      flags |= AP_TAXIWAY;
-      flags |= AP_TOWER_OBJ;
-    }
-  }
-
-  return flags;
-}
-
-map::MapAirportFlags MapTypesFactory::airportFlag(const SqlRecord& record, const QString& field,
-                                                  map::MapAirportFlags flag)
-{
-  if(!record.contains(field) || record.isNull(field) || record.valueInt(field) == 0)
-    return AP_NONE;
-  else
-    return flag;
-}
-
 void MapTypesFactory::fillVor(const SqlRecord& record, map::MapVor& vor)
 {
-  fillVorBase(record, vor);
-
-  vor.dmeOnly = record.valueInt("dme_only") > 0;
-  vor.hasDme = !record.isNull("dme_altitude");
+  QVector<int> indexes;
+  resolveColumns(indexes, record, VOR_COLUMNS, NAV_COL_SIZE);
+  fillVorRow(ColumnRow(record, indexes), vor);
 }
 
 void MapTypesFactory::fillVorFromNav(const SqlRecord& record, map::MapVor& vor)
 {
-  fillVorBase(record, vor);
+  QVector<int> indexes;
+  resolveColumns(indexes, record, VOR_COLUMNS, NAV_COL_SIZE);
+  fillVorBaseRow(ColumnRow(record, indexes), vor);
 
   QString navType = record.valueStr("nav_type");
   if(navType == "TC")
@@ -285,39 +585,6 @@ void MapTypesFactory::fillVorFromNav(const SqlRecord& record, map::MapVor& vor)
   vor.frequency /= 10;
 }
 
-void MapTypesFactory::fillVorBase(const SqlRecord& record, map::MapVor& vor)
-{
-  vor.id = record.valueInt("vor_id");
-  vor.ident = record.valueStr("ident");
-  vor.region = record.valueStr("region");
-  vor.name = atools::capString(record.valueStr("name"));
-
-  // Check also for types from the nav_search table and VORTACs
-  QString type = record.valueStr("type");
-  if(type == "VH" || type == "VTH")
-    vor.type = "H";
-  else if(type == "VL" || type == "VTL")
-    vor.type = "L";
-  else if(type == "VT" || type == "VTT")
-    vor.type = "T";
-  else
-    vor.type = type;
-
-  vor.tacan = type == "TC";
-  vor.vortac = type.startsWith("VT");
-
-  vor.channel = record.valueStr("channel");
-  vor.frequency = record.valueInt("frequency");
-
-  vor.range = record.valueInt("range");
-  vor.magvar = record.valueFloat("mag_var");
-
-  if(record.isNull("altitude"))
-    vor.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), INVALID_ALTITUDE_VALUE);
-  else
-    vor.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), record.valueFloat("altitude"));
-}
-
 void MapTypesFactory::fillUserdataPoint(const SqlRecord& rec, map::MapUserpoint& obj)
 {
   if(!rec.isEmpty())
@@ -396,19 +663,9 @@ void MapTypesFactory::fillLogbookEntry(const atools::sql::SqlRecord& rec, MapLog
 
 void MapTypesFactory::fillNdb(const SqlRecord& record, map::MapNdb& ndb)
 {
-  ndb.id = record.valueInt("ndb_id");
-  ndb.ident = record.valueStr("ident");
-  ndb.region = record.valueStr("region");
-  ndb.name = atools::capString(record.valueStr("name"));
-  ndb.type = record.valueStr("type");
-  ndb.frequency = record.valueInt("frequency");
-  ndb.range = record.valueInt("range");
-  ndb.magvar = record.valueFloat("mag_var");
-
-  if(record.isNull("altitude"))
-    ndb.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), INVALID_ALTITUDE_VALUE);
-  else
-    ndb.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), record.valueFloat("altitude"));
+  QVector<int> indexes;
+  resolveColumns(indexes, record, NDB_COLUMNS, NAV_COL_SIZE);
+  fillNdbRow(ColumnRow(record, indexes), ndb);
 }
 
 void MapTypesFactory::fillHelipad(const SqlRecord& record, map::MapHelipad& helipad)
@@ -432,31 +689,16 @@ void MapTypesFactory::fillHelipad(const SqlRecord& record, map::MapHelipad& heli
 
 void MapTypesFactory::fillWaypoint(const SqlRecord& record, map::MapWaypoint& waypoint, bool track)
 {
-  waypoint.id = record.valueInt(track ? "trackpoint_id" : "waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
-  waypoint.arincType = record.valueStr("arinc_type", QString());
-  waypoint.magvar = record.valueFloat("mag_var");
-  waypoint.hasVictorAirways = record.valueInt("num_victor_airway") > 0;
-  waypoint.hasJetAirways = record.valueInt("num_jet_airway") > 0;
-  waypoint.artificial = static_cast<map::MapWaypointArtificial>(record.valueInt("artificial", map::WAYPOINT_ARTIFICIAL_NONE));
-  waypoint.hasTracks = track;
-  waypoint.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"));
+  QVector<int> indexes;
+  resolveWaypointColumns(indexes, record, track, false /* nav */);
+  fillWaypointRow(ColumnRow(record, indexes), waypoint, track);
 }
 
 void MapTypesFactory::fillWaypointFromNav(const SqlRecord& record, map::MapWaypoint& waypoint)
 {
-  waypoint.id = record.valueInt("waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
-  waypoint.arincType = record.valueStr("arinc_type", QString());
-  waypoint.magvar = record.valueFloat("mag_var");
-  waypoint.hasVictorAirways = record.valueInt("waypoint_num_victor_airway") > 0;
-  waypoint.hasJetAirways = record.valueInt("waypoint_num_jet_airway") > 0;
-  waypoint.artificial = static_cast<map::MapWaypointArtificial>(record.valueInt("artificial", map::WAYPOINT_ARTIFICIAL_NONE));
-  waypoint.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"));
+  QVector<int> indexes;
+  resolveWaypointColumns(indexes, record, false /* track */, true /* nav */);
+  fillWaypointRow(ColumnRow(record, indexes), waypoint, false /* track */);
 }
 
 void MapTypesFactory::fillAirwayOrTrack(const SqlRecord& record, map::MapAirway& airway, bool track)
@@ -790,50 +1032,69 @@ void MapTypesFactory::fillStart(const SqlRecord& record, map::MapStart& start)
 
 void MapTypesFactory::fillAirspace(const SqlRecord& record, map::MapAirspace& airspace, map::MapAirspaceSources src)
 {
-  if(record.contains("boundary_id"))
-    airspace.id = record.valueInt("boundary_id");
-  else if(record.contains("atc_id"))
-    airspace.id = record.valueInt("atc_id");
+  QVector<int> indexes;
+  resolveColumns(indexes, record, AIRSPACE_COLUMNS, AS_COL_SIZE);
+  fillAirspaceRow(ColumnRow(record, indexes), airspace, src);
+}
 
-  airspace.src = src;
+// ==========================================================================================================
+// Fast path reading values by column ordinal from the current query row
 
-  airspace.type = map::airspaceTypeFromDatabase(record.valueStr("type"));
-  airspace.name = record.valueStr(airspace.isOnline() ? "callsign" : "name");
-  airspace.comType = record.valueStr("com_type");
+void MapTypesFactory::initAirportColumns(MapTypesColumns& columns, const SqlQuery& query)
+{
+  resolveColumns(columns.indexes, query.record(), AIRPORT_COLUMNS, AP_COL_SIZE);
+}
 
-  QString comCol;
-  if(record.contains("com_frequency"))
-    comCol = "com_frequency";
-  else if(record.contains("frequency"))
-    comCol = "frequency";
+void MapTypesFactory::fillAirport(const SqlQuery& query, const MapTypesColumns& columns, map::MapAirport& airport, bool nav,
+                                  bool xplane)
+{
+  fillAirportRow(ColumnRow(query, columns.indexes), airport, true /* complete */, nav, xplane);
+}
 
-  const QStringList split = record.valueStr(comCol, QString()).split("&");
-  for(const QString& str : split)
-  {
-    bool ok;
-    int frequency = str.toInt(&ok);
+void MapTypesFactory::fillAirportForOverview(const SqlQuery& query, const MapTypesColumns& columns, map::MapAirport& airport,
+                                             bool nav, bool xplane)
+{
+  fillAirportForOverviewRow(ColumnRow(query, columns.indexes), airport, nav, xplane);
+}
 
-    if(frequency > 0 && ok)
-      airspace.comFrequencies.append(frequency);
-  }
+void MapTypesFactory::initVorColumns(MapTypesColumns& columns, const SqlQuery& query)
+{
+  resolveColumns(columns.indexes, query.record(), VOR_COLUMNS, NAV_COL_SIZE);
+}
 
-  // Use default values for online network ATC centers
-  airspace.comName = record.valueStr("com_name", QString());
-  airspace.multipleCode = record.valueStr("multiple_code", QString()).trimmed();
-  airspace.restrictiveDesignation = record.valueStr("restrictive_designation", QString());
-  airspace.restrictiveType = record.valueStr("restrictive_type", QString());
-  airspace.timeCode = record.valueStr("time_code", QString());
-  airspace.minAltitudeType = record.valueStr("min_altitude_type", QString());
-  airspace.maxAltitudeType = record.valueStr("max_altitude_type", QString());
-  airspace.maxAltitude = record.valueInt("max_altitude", 0);
-  airspace.minAltitude = record.valueInt("min_altitude", 70000);
-
-  Pos topLeft(record.value("min_lonx"), record.value("max_laty"));
-  Pos bottomRight(record.value("max_lonx"), record.value("min_laty"));
+void MapTypesFactory::fillVor(const SqlQuery& query, const MapTypesColumns& columns, map::MapVor& vor)
+{
+  fillVorRow(ColumnRow(query, columns.indexes), vor);
+}
 
-  if(topLeft.isValid() && bottomRight.isValid())
-  {
-    airspace.bounding = Rect(topLeft, bottomRight);
-    airspace.position = airspace.bounding.getCenter();
-  }
+void MapTypesFactory::initNdbColumns(MapTypesColumns& columns, const SqlQuery& query)
+{
+  resolveColumns(columns.indexes, query.record(), NDB_COLUMNS, NAV_COL_SIZE);
+}
+
+void MapTypesFactory::fillNdb(const SqlQuery& query, const MapTypesColumns& columns, map::MapNdb& ndb)
+{
+  fillNdbRow(ColumnRow(query, columns.indexes), ndb);
+}
+
+void MapTypesFactory::initWaypointColumns(MapTypesColumns& columns, const SqlQuery& query, bool track)
+{
+  resolveWaypointColumns(columns.indexes, query.record(), track, false /* nav */);
+}
+
+void MapTypesFactory::fillWaypoint(const SqlQuery& query, const MapTypesColumns& columns, map::MapWaypoint& waypoint,
+                                   bool track)
+{
+  fillWaypointRow(ColumnRow(query, columns.indexes), waypoint, track);
+}
+
+void MapTypesFactory::initAirspaceColumns(MapTypesColumns& columns, const SqlQuery& query)
+{
+  resolveColumns(columns.indexes, query.record(), AIRSPACE_COLUMNS, AS_COL_SIZE);
+}
+
+void MapTypesFactory::fillAirspace(const SqlQuery& query, const MapTypesColumns& columns, map::MapAirspace& airspace,
+                                   map::MapAirspaceSources src)
+{
+  fillAirspaceRow(ColumnRow(query, columns.indexes), airspace, src);
 }
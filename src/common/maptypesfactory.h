@@ -20,10 +20,13 @@
 
 #include "common/mapflags.h"
 
+#include <QVector>
+
 namespace atools {
 namespace sql {
 
 class SqlRecord;
+class SqlQuery;
 }
 }
 
@@ -47,6 +50,24 @@ struct MapLogbookEntry;
 struct MapAirportMsa;
 }
 
+/*
+ * Column ordinals of an executed query used by the fast path fill methods of MapTypesFactory.
+ * Filled by one of the MapTypesFactory::init*Columns() methods. Index is -1 for columns missing in the query.
+ */
+class MapTypesColumns
+{
+public:
+  bool isEmpty() const
+  {
+    return indexes.isEmpty();
+  }
+
+private:
+  friend class MapTypesFactory;
+
+  QVector<int> indexes;
+};
+
 /*
  * Create all map objects (namespace maptypes) from sql records. The sql records can be
  * a result from sql queries or manually built.
@@ -97,11 +118,32 @@ public:
 
   void fillLogbookEntry(const atools::sql::SqlRecord& rec, map::MapLogbookEntry& obj);
 
+  /*
+   * Fast path for the map display queries which return thousands of rows.
+   * Call the init method once after exec() and then the fill method for each row. Values are read by
+   * ordinal from the current row of the query which avoids the record copy and the column name lookups.
+   * Both variants share the same implementation. Missing columns get default values.
+   */
+  void initAirportColumns(MapTypesColumns& columns, const atools::sql::SqlQuery& query);
+  void fillAirport(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapAirport& airport, bool nav,
+                   bool xplane);
+  void fillAirportForOverview(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapAirport& airport,
+                              bool nav, bool xplane);
+
+  void initVorColumns(MapTypesColumns& columns, const atools::sql::SqlQuery& query);
+  void fillVor(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapVor& vor);
+
+  void initNdbColumns(MapTypesColumns& columns, const atools::sql::SqlQuery& query);
+  void fillNdb(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapNdb& ndb);
+
+  void initWaypointColumns(MapTypesColumns& columns, const atools::sql::SqlQuery& query, bool track);
+  void fillWaypoint(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapWaypoint& waypoint, bool track);
+
+  void initAirspaceColumns(MapTypesColumns& columns, const atools::sql::SqlQuery& query);
+  void fillAirspace(const atools::sql::SqlQuery& query, const MapTypesColumns& columns, map::MapAirspace& airspace,
+                    map::MapAirspaceSources src);
+
 private:
-  void fillVorBase(const atools::sql::SqlRecord& record, map::MapVor& vor);
-  void fillAirportBase(const atools::sql::SqlRecord& record, map::MapAirport& ap, bool complete);
-  map::MapAirportFlags airportFlag(const atools::sql::SqlRecord& record, const QString& field, map::MapAirportFlags airportFlag);
-  map::MapAirportFlags fillAirportFlags(const atools::sql::SqlRecord& record, bool overview);
   map::MapType strToType(const QString& navType);
 
 };
@@ -40,6 +40,7 @@
 #include "settings/settings.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
 #include "sql/sqltransaction.h"
 #include "sql/sqlutil.h"
 #include "track/trackmanager.h"
@@ -188,6 +189,13 @@ DatabaseManager::DatabaseManager(MainWindow *parent)
     onlinedataManager->createSchema();
     onlinedataManager->initQueries();
 
+    // Staging database is opened and filled by the online parser thread. It is attached to the online database
+    // to copy the tables over. Attaching creates the file if missing and the schema is created by the thread.
+    onlineStagingDatabaseFile = databaseDirectory + QDir::separator() + lnm::DATABASE_PREFIX + "onlinedata_staging" +
+                                lnm::DATABASE_SUFFIX;
+    atools::sql::SqlQuery(databaseOnline).exec("attach database '" + QString(onlineStagingDatabaseFile).replace('\'', "''") +
+                                               "' as staging");
+
     if(migrate::getOptionsVersion().isValid() && migrate::getOptionsVersion() <= atools::util::Version("2.8.1.beta"))
     {
       qDebug() << Q_FUNC_INFO << "Cleaning undo/redo in logbook and userdata";
@@ -226,6 +226,12 @@ public:
     return onlinedataManager;
   }
 
+  /* File of the staging database which is opened and filled by the online parser thread */
+  const QString& getOnlineStagingDatabaseFile() const
+  {
+    return onlineStagingDatabaseFile;
+  }
+
   atools::sql::SqlDatabase *getDatabaseUser() const
   {
     return databaseUser;
@@ -373,6 +379,9 @@ private:
   *databaseNavAirspace = nullptr /* Airspace database from navdata independent from nav switch */,
   *databaseOnline = nullptr /* Database for network online data */;
 
+  /* Network online data written in background and copied to databaseOnline */
+  QString onlineStagingDatabaseFile;
+
   bool showingDatabaseChangeWarning = false;
 
   MainWindow *mainWindow = nullptr;
@@ -0,0 +1,264 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "db/databasepool.h"
+
+#include "app/navapp.h"
+#include "common/constants.h"
+#include "db/dbtools.h"
+#include "exception.h"
+#include "query/airportquery.h"
+#include "query/airwayquery.h"
+#include "query/airwaytrackquery.h"
+#include "query/infoquery.h"
+#include "query/mapquery.h"
+#include "query/procedurequery.h"
+#include "query/waypointquery.h"
+#include "query/waypointtrackquery.h"
+#include "routing/routenetwork.h"
+#include "settings/settings.h"
+#include "sql/sqldatabase.h"
+
+#include <QThread>
+
+using atools::sql::SqlDatabase;
+
+DatabasePool::DatabasePool()
+{
+  numConnections = atools::settings::Settings::instance().getAndStoreValue(lnm::SETTINGS_DATABASE + "PoolConnections",
+                                                                           std::min(QThread::idealThreadCount(), 4)).toInt();
+  numConnections = std::max(numConnections, 1);
+
+  qDebug() << Q_FUNC_INFO << "numConnections" << numConnections;
+}
+
+DatabasePool::~DatabasePool()
+{
+  close();
+}
+
+/* Get file name of an opened database or empty if not open */
+static QString databaseFile(const SqlDatabase *database)
+{
+  return database != nullptr && database->isOpen() ? database->databaseName() : QString();
+}
+
+/* Create a connection in the calling thread and open it read only */
+static SqlDatabase *openPoolDatabase(const QString& name, const QString& file)
+{
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, name);
+  SqlDatabase *db = new SqlDatabase(name);
+
+  if(!file.isEmpty())
+  {
+    db->setReadonly();
+    dbtools::openDatabaseFileExt(db, file, true /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+  }
+  return db;
+}
+
+static void closePoolDatabase(SqlDatabase *& db, const QString& name)
+{
+  if(db != nullptr)
+  {
+    dbtools::closeDatabaseFile(db);
+    delete db;
+    db = nullptr;
+    SqlDatabase::removeDatabase(name);
+  }
+}
+
+void DatabasePool::open()
+{
+  close();
+
+  fileSim = databaseFile(NavApp::getDatabaseSim());
+  fileNav = databaseFile(NavApp::getDatabaseNav());
+  fileUser = databaseFile(NavApp::getDatabaseUser());
+  fileTrack = databaseFile(NavApp::getDatabaseTrack());
+
+  // Connections are opened lazily by each thread on its first task
+  for(int i = 0; i < numConnections; i++)
+  {
+    QThread *thread = QThread::create([this, i]() {
+      runThread(i);
+    });
+    thread->setObjectName(dbtools::DATABASE_NAME_POOL + QString::number(i));
+    threads.append(thread);
+    thread->start();
+  }
+}
+
+void DatabasePool::close()
+{
+  if(threads.isEmpty())
+    return;
+
+  {
+    QMutexLocker locker(&mutex);
+    stopping = true;
+    taskAvailable.wakeAll();
+  }
+
+  // Threads finish all queued tasks and close their connections before returning
+  for(QThread *thread : qAsConst(threads))
+    thread->wait();
+  qDeleteAll(threads);
+  threads.clear();
+
+  QMutexLocker locker(&mutex);
+  stopping = false;
+  fileSim.clear();
+  fileNav.clear();
+  fileUser.clear();
+  fileTrack.clear();
+}
+
+bool DatabasePool::enqueue(const Task& task)
+{
+  QMutexLocker locker(&mutex);
+  if(threads.isEmpty() || stopping)
+    return false;
+
+  tasks.enqueue(task);
+  taskAvailable.wakeOne();
+  return true;
+}
+
+void DatabasePool::runThread(int index)
+{
+  DatabasePoolContext *context = nullptr;
+  bool contextCreated = false;
+
+  while(true)
+  {
+    Task task;
+    {
+      QMutexLocker locker(&mutex);
+      while(tasks.isEmpty() && !stopping)
+        taskAvailable.wait(&mutex);
+
+      // Stop only after queue is drained
+      if(tasks.isEmpty())
+        break;
+      task = tasks.dequeue();
+    }
+
+    if(!contextCreated)
+    {
+      context = createContext(index);
+      contextCreated = true;
+    }
+
+    task(context);
+  }
+
+  deleteContext(context, index);
+}
+
+DatabasePoolContext *DatabasePool::createContext(int index)
+{
+  QString prefix = dbtools::DATABASE_NAME_POOL + QString::number(index);
+  DatabasePoolContext *context = new DatabasePoolContext;
+
+  try
+  {
+    context->dbSim = openPoolDatabase(prefix + "SIM", fileSim);
+    context->dbNav = openPoolDatabase(prefix + "NAV", fileNav);
+    context->dbUser = openPoolDatabase(prefix + "USER", fileUser);
+    context->dbTrack = openPoolDatabase(prefix + "TRACK", fileTrack);
+
+    context->mapQuery = new MapQuery(context->dbSim, context->dbNav, context->dbUser);
+    context->mapQuery->initQueries();
+
+    context->airportQuerySim = new AirportQuery(context->dbSim, false /* nav */);
+    context->airportQuerySim->initQueries();
+
+    context->airportQueryNav = new AirportQuery(context->dbNav, true /* nav */);
+    context->airportQueryNav->initQueries();
+
+    context->infoQuery = new InfoQuery(context->dbSim, context->dbNav, context->dbTrack);
+    context->infoQuery->initQueries();
+
+    context->waypointQuery = new WaypointQuery(context->dbNav, false /* trackDatabase */);
+    context->waypointQuery->initQueries();
+
+    // Own waypoint and airway queries including tracks to avoid the GUI ones in NavApp
+    context->waypointTrackQuery = new WaypointTrackQuery(new WaypointQuery(context->dbNav, false),
+                                                         new WaypointQuery(context->dbTrack, true));
+    context->waypointTrackQuery->initQueries();
+
+    context->airwayTrackQuery = new AirwayTrackQuery(new AirwayQuery(context->dbNav, false),
+                                                     new AirwayQuery(context->dbTrack, true));
+    context->airwayTrackQuery->initQueries();
+
+    // Pass own queries to avoid accessing the GUI thread queries
+    context->airportQuerySim->setAirportQueryNav(context->airportQueryNav);
+    context->airportQueryNav->setAirportQueryNav(context->airportQueryNav);
+    context->mapQuery->setQueries(context->airportQuerySim, context->airportQueryNav,
+                                  context->waypointTrackQuery, context->airwayTrackQuery);
+
+    context->procedureQuery = new ProcedureQuery(context->dbNav, context->mapQuery, context->airportQueryNav);
+    context->procedureQuery->initQueries();
+    return context;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open database pool connection" << index << e.what();
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open database pool connection" << index;
+  }
+
+  deleteContext(context, index);
+  return nullptr;
+}
+
+void DatabasePool::deleteContext(DatabasePoolContext *context, int index)
+{
+  if(context == nullptr)
+    return;
+
+  QString prefix = dbtools::DATABASE_NAME_POOL + QString::number(index);
+
+  // Procedure query uses the map and airport queries
+  ATOOLS_DELETE(context->procedureQuery);
+  ATOOLS_DELETE(context->mapQuery);
+  ATOOLS_DELETE(context->airportQuerySim);
+  ATOOLS_DELETE(context->airportQueryNav);
+  ATOOLS_DELETE(context->infoQuery);
+  ATOOLS_DELETE(context->waypointQuery);
+
+  if(context->waypointTrackQuery != nullptr)
+    context->waypointTrackQuery->deleteChildren();
+  ATOOLS_DELETE(context->waypointTrackQuery);
+
+  if(context->airwayTrackQuery != nullptr)
+    context->airwayTrackQuery->deleteChildren();
+  ATOOLS_DELETE(context->airwayTrackQuery);
+
+  ATOOLS_DELETE(context->routeNetworkRadio);
+  ATOOLS_DELETE(context->routeNetworkAirway);
+
+  closePoolDatabase(context->dbSim, prefix + "SIM");
+  closePoolDatabase(context->dbNav, prefix + "NAV");
+  closePoolDatabase(context->dbUser, prefix + "USER");
+  closePoolDatabase(context->dbTrack, prefix + "TRACK");
+  delete context;
+}
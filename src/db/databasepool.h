@@ -0,0 +1,199 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_DATABASEPOOL_H
+#define LNM_DATABASEPOOL_H
+
+#include <QDebug>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <functional>
+
+namespace atools {
+namespace routing {
+class RouteNetwork;
+}
+namespace sql {
+class SqlDatabase;
+}
+}
+
+class AirportQuery;
+class AirwayTrackQuery;
+class InfoQuery;
+class MapQuery;
+class ProcedureQuery;
+class QThread;
+class WaypointQuery;
+class WaypointTrackQuery;
+
+/*
+ * One set of read only database connections and query objects with prepared statements.
+ * Created, used and deleted by exactly one thread of the DatabasePool.
+ *
+ * The map and airport queries are given the airport, waypoint and airway queries of this context and do not use
+ * the global GUI queries from NavApp.
+ */
+struct DatabasePoolContext
+{
+  atools::sql::SqlDatabase *dbSim = nullptr, *dbNav = nullptr, *dbUser = nullptr, *dbTrack = nullptr;
+
+  MapQuery *mapQuery = nullptr;
+  AirportQuery *airportQuerySim = nullptr, *airportQueryNav = nullptr;
+  InfoQuery *infoQuery = nullptr;
+
+  /* Own procedure query using the queries above. Caches are not used when building legs with createAllLegs(). */
+  ProcedureQuery *procedureQuery = nullptr;
+
+  /* Waypoints from the nav database without tracks */
+  WaypointQuery *waypointQuery = nullptr;
+
+  /* Waypoints and airways including tracks. Used by the map query. */
+  WaypointTrackQuery *waypointTrackQuery = nullptr;
+  AirwayTrackQuery *airwayTrackQuery = nullptr;
+
+  /* Route networks owned by this thread. Loaded on demand by tasks and reused as long as
+   * routeNetworkKey does not change. Dropped with the context when the databases are switched. */
+  atools::routing::RouteNetwork *routeNetworkRadio = nullptr, *routeNetworkAirway = nullptr;
+  QString routeNetworkKey;
+};
+
+/*
+ * Pool of read only connections to the simulator, navdata, userpoint and track databases.
+ * Work is submitted with run() and executed by one of the pool threads.
+ *
+ * Each thread owns one DatabasePoolContext. The connections and queries are created lazily in the thread when
+ * it runs its first task and are closed in the same thread when the pool is closed. This is required since
+ * Qt SQL connections can only be used in the thread which created them.
+ *
+ * open() only remembers the database files and starts the threads. close() lets all queued tasks finish and
+ * stops the threads. Both are called in the GUI thread before the databases are switched or reloaded.
+ * Tasks submitted while the pool is closed return a default constructed result.
+ *
+ * Tasks must not access any GUI objects. Results are passed back through the returned future,
+ * e.g. using a QFutureWatcher.
+ */
+class DatabasePool
+{
+public:
+  DatabasePool();
+  ~DatabasePool();
+
+  DatabasePool(const DatabasePool& other) = delete;
+  DatabasePool& operator=(const DatabasePool& other) = delete;
+
+  /* Start threads using the currently opened databases. Called in GUI thread after databases are opened. */
+  void open();
+
+  /* Wait for all queued and running tasks and stop threads which closes all connections.
+   * Called in GUI thread before databases are closed. */
+  void close();
+
+  /* Number of connection sets and threads */
+  int getNumConnections() const
+  {
+    return numConnections;
+  }
+
+  /* true if threads are running and tasks will be executed */
+  bool isOpen() const
+  {
+    return !threads.isEmpty();
+  }
+
+  /* Execute func(DatabasePoolContext&) in a pool thread and return a future for the result */
+  template<typename FUNC>
+  auto run(FUNC func)->QFuture<decltype(func(std::declval<DatabasePoolContext&>()))>;
+
+private:
+  /* Task gets the context of the executing thread or null if it could not be opened */
+  typedef std::function<void (DatabasePoolContext *context)> Task;
+
+  /* Add task to the queue. Returns false if the pool is closed. */
+  bool enqueue(const Task& task);
+
+  /* Thread function. Runs tasks until the pool is closed and the queue is empty. */
+  void runThread(int index);
+
+  /* Create connections and queries in the calling pool thread. Returns null on error. */
+  DatabasePoolContext *createContext(int index);
+
+  /* Close connections and delete queries in the calling pool thread */
+  void deleteContext(DatabasePoolContext *context, int index);
+
+  int numConnections = 2;
+
+  /* Database files as opened in the GUI thread. Empty if not open. Read-only while threads are running. */
+  QString fileSim, fileNav, fileUser, fileTrack;
+
+  QVector<QThread *> threads;
+
+  /* Queue and stop flag guarded by mutex */
+  QQueue<Task> tasks;
+  bool stopping = false;
+  QMutex mutex;
+  QWaitCondition taskAvailable;
+};
+
+// ---------------------------------------------------------------------------------
+
+template<typename FUNC>
+auto DatabasePool::run(FUNC func)->QFuture<decltype(func(std::declval<DatabasePoolContext&>()))>
+{
+  typedef decltype(func(std::declval<DatabasePoolContext&>())) RESULT;
+
+  QFutureInterface<RESULT> futureInterface;
+  futureInterface.reportStarted();
+  QFuture<RESULT> future = futureInterface.future();
+
+  bool queued = enqueue([futureInterface, func](DatabasePoolContext *context) mutable {
+    RESULT result = RESULT();
+    if(context != nullptr)
+    {
+      try
+      {
+        result = func(*context);
+      }
+      catch(std::exception& e)
+      {
+        qWarning() << Q_FUNC_INFO << "Error in database pool task" << e.what();
+      }
+      catch(...)
+      {
+        qWarning() << Q_FUNC_INFO << "Unknown error in database pool task";
+      }
+    }
+    futureInterface.reportResult(result);
+    futureInterface.reportFinished();
+  });
+
+  if(!queued)
+  {
+    // Pool is closed - return default result
+    futureInterface.reportResult(RESULT());
+    futureInterface.reportFinished();
+  }
+
+  return future;
+}
+
+#endif // LNM_DATABASEPOOL_H
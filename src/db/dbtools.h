@@ -51,6 +51,10 @@ const QString DATABASE_NAME_NAV_AIRSPACE = "LNMDBNAVAS";
 /* Network online player data */
 const QString DATABASE_NAME_ONLINE = "LNMDBONLINE";
 
+/* Network online data parsed in background and user airspaces read by the parser thread */
+const QString DATABASE_NAME_ONLINE_STAGING = "LNMDBONLINESTAGING";
+const QString DATABASE_NAME_ONLINE_AIRSPACE = "LNMDBONLINEAS";
+
 /* Temporary database used for database checking, copying and preparation */
 const QString DATABASE_NAME_TEMP = "LNMTEMPDB";
 
@@ -60,6 +64,15 @@ const QString DATABASE_NAME_LOADER = "LNMLOADER";
 /* Used to temporary load metadata */
 const QString DATABASE_NAME_DLG_INFO_TEMP = "LNMTEMPDB2";
 
+/* Prefix for read only connections of the database pool. Number and database type are appended. */
+const QString DATABASE_NAME_POOL = "LNMDBPOOL";
+
+/* Prefix for connections building the search text index. Table name is appended. */
+const QString DATABASE_NAME_TEXT_INDEX = "LNMDBTEXTINDEX";
+
+/* Prefix for read only connections of the search query workers. Table name is appended. */
+const QString DATABASE_NAME_SEARCH = "LNMDBSEARCH";
+
 /* Common type for all databases */
 const QString DATABASE_TYPE = "QSQLITE";
 
@@ -88,6 +88,7 @@
 #include "weather/weatherreporter.h"
 #include "weather/windreporter.h"
 #include "web/webcontroller.h"
+#include "web/webmapcontroller.h"
 #include "common/updatehandler.h"
 
 #include <marble/MarbleAboutDialog.h>
@@ -1647,6 +1648,18 @@ void MainWindow::connectAllSlots()
   connect(ui->actionOpenWebserver, &QAction::triggered, this, &MainWindow::openWebserver);
   connect(NavApp::getWebController(), &WebController::webserverStatusChanged, this, &MainWindow::webserverStatusChanged);
 
+  // Invalidate cached web map images on all changes affecting the map
+  WebMapController *webMapController = NavApp::getWebController()->getWebMapController();
+  connect(connectClient, &ConnectClient::dataPacketReceived, webMapController, &WebMapController::simDataChanged);
+  connect(routeController, &RouteController::routeChanged, webMapController, &WebMapController::mapChanged);
+  connect(weatherReporter, &WeatherReporter::weatherUpdated, webMapController, &WebMapController::mapChanged);
+  connect(connectClient, &ConnectClient::weatherUpdated, webMapController, &WebMapController::mapChanged);
+  connect(windReporter, &WindReporter::windDisplayUpdated, webMapController, &WebMapController::mapChanged);
+  connect(onlinedataController, &OnlinedataController::onlineClientAndAtcUpdated, webMapController, &WebMapController::mapChanged);
+  connect(optionsDialog, &OptionsDialog::optionsChanged, webMapController, &WebMapController::mapChanged);
+  connect(styleHandler, &StyleHandler::styleChanged, webMapController, &WebMapController::mapChanged);
+  connect(mapWidget, &MapPaintWidget::visibleLatLonAltBoxChanged, webMapController, &WebMapController::visibleMapChanged);
+
   // Shortcut menu
   connect(ui->actionShortcutMap, &QAction::triggered, this, &MainWindow::actionShortcutMapTriggered);
   connect(ui->actionShortcutProfile, &QAction::triggered, this, &MainWindow::actionShortcutProfileTriggered);
@@ -3118,6 +3131,10 @@ void MainWindow::resetMapObjectsShown()
 void MainWindow::updateMapObjectsShown()
 {
   mapWidget->updateMapObjectsShown();
+
+  // Null on startup
+  if(NavApp::getWebController() != nullptr)
+    NavApp::getWebController()->getWebMapController()->mapChanged();
   profileWidget->update();
   updateActionStates();
 }
@@ -4020,8 +4037,8 @@ void MainWindow::updateMapKeys()
       mapWidget->setKeys(mapThemeHandler->getMapThemeKeysHash());
 
     // Might be null if not started
-    if(NavApp::getMapPaintWidgetWeb() != nullptr)
-      NavApp::getMapPaintWidgetWeb()->setKeys(mapThemeHandler->getMapThemeKeysHash());
+    for(MapPaintWidget *webWidget : NavApp::getMapPaintWidgetsWeb())
+      webWidget->setKeys(mapThemeHandler->getMapThemeKeysHash());
   }
 }
 
@@ -30,6 +30,7 @@
 #include "gui/tools.h"
 #include "gui/widgetutil.h"
 #include "info/aircraftprogressconfig.h"
+#include "info/textbrowserupdater.h"
 #include "mapgui/mapwidget.h"
 #include "online/onlinedatacontroller.h"
 #include "options/optiondata.h"
@@ -117,6 +118,7 @@ InfoController::InfoController(MainWindow *parent)
                         "Keep instructions in sync with translated menus and shortcuts");
 
   aircraftProgressConfig = new AircraftProgressConfig(mainWindow);
+  textUpdater = new TextBrowserUpdater;
 
   // ==================================================================================
   // Create a configuration push button and place it into the aircraft progress info text browser
@@ -188,6 +190,10 @@ InfoController::~InfoController()
   delete aircraftProgressConfig;
   aircraftProgressConfig = nullptr;
 
+  qDebug() << Q_FUNC_INFO << "delete textUpdater";
+  delete textUpdater;
+  textUpdater = nullptr;
+
   qDebug() << Q_FUNC_INFO << "delete tabHandlerInfo";
   delete tabHandlerInfo;
   tabHandlerInfo = nullptr;
@@ -586,8 +592,8 @@ void InfoController::updateProgress()
     html.clear();
     html.setIdBits(aircraftProgressConfig->getEnabledBits());
     infoBuilder->aircraftProgressText(lastSimData.getUserAircraftConst(), html, NavApp::getRouteConst());
-    atools::gui::util::updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
-                                      false /* scroll to top*/, true /* keep selection */);
+    textUpdater->updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
+                                false /* scroll to top*/, true /* keep selection */);
   }
 }
 
@@ -617,8 +623,8 @@ void InfoController::updateAirportInternal(bool newAirport, bool bearingChange,
 
       Ui::MainWindow *ui = NavApp::getMainUi();
       // Leave position for weather or bearing updates
-      atools::gui::util::updateTextEdit(ui->textBrowserAirportInfo, html.getHtml(),
-                                        scrollToTop, !scrollToTop /* keep selection */);
+      textUpdater->updateTextEdit(ui->textBrowserAirportInfo, html.getHtml(),
+                                  scrollToTop, !scrollToTop /* keep selection */);
 
       if(newAirport || weatherChanged || forceWeatherUpdate)
       {
@@ -1121,8 +1127,8 @@ bool InfoController::updateNavaidInternal(const map::MapResult& result, bool bea
     html.clear();
 
   if(foundNavaid || forceUpdate)
-    atools::gui::util::updateTextEdit(ui->textBrowserNavaidInfo, html.getHtml(),
-                                      scrollToTop, !scrollToTop /* keep selection */);
+    textUpdater->updateTextEdit(ui->textBrowserNavaidInfo, html.getHtml(),
+                                scrollToTop, !scrollToTop /* keep selection */);
 
   return foundNavaid;
 }
@@ -1146,8 +1152,8 @@ bool InfoController::updateUserpointInternal(const map::MapResult& result, bool
   }
 
   if(foundUserpoint)
-    atools::gui::util::updateTextEdit(ui->textBrowserUserpointInfo, html.getHtml(),
-                                      scrollToTop, !scrollToTop /* keep selection */);
+    textUpdater->updateTextEdit(ui->textBrowserUserpointInfo, html.getHtml(),
+                                scrollToTop, !scrollToTop /* keep selection */);
   else
     ui->textBrowserUserpointInfo->clear();
 
@@ -1205,8 +1211,8 @@ void InfoController::updateUserAircraftText()
         HtmlBuilder html(true /* has background color */);
         infoBuilder->aircraftText(lastSimData.getUserAircraftConst(), html);
         infoBuilder->aircraftTextWeightAndFuel(lastSimData.getUserAircraftConst(), html);
-        atools::gui::util::updateTextEdit(ui->textBrowserAircraftInfo, html.getHtml(),
-                                          false /* scroll to top*/, true /* keep selection */);
+        textUpdater->updateTextEdit(ui->textBrowserAircraftInfo, html.getHtml(),
+                                    false /* scroll to top*/, true /* keep selection */);
       }
       ui->textBrowserAircraftInfo->setToolTip(QString());
       ui->textBrowserAircraftInfo->setStatusTip(QString());
@@ -1241,8 +1247,8 @@ void InfoController::updateAircraftProgressText()
         HtmlBuilder html(true /* has background color */);
         html.setIdBits(aircraftProgressConfig->getEnabledBits());
         infoBuilder->aircraftProgressText(lastSimData.getUserAircraftConst(), html, NavApp::getRouteConst());
-        atools::gui::util::updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
-                                          false /* scroll to top*/, true /* keep selection */);
+        textUpdater->updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
+                                    false /* scroll to top*/, true /* keep selection */);
       }
       ui->textBrowserAircraftProgressInfo->setToolTip(QString());
       ui->textBrowserAircraftProgressInfo->setStatusTip(QString());
@@ -1287,8 +1293,8 @@ void InfoController::updateAiAircraftText()
             num++;
           }
 
-          atools::gui::util::updateTextEdit(ui->textBrowserAircraftAiInfo, html.getHtml(),
-                                            false /* scroll to top*/, true /* keep selection */);
+          textUpdater->updateTextEdit(ui->textBrowserAircraftAiInfo, html.getHtml(),
+                                      false /* scroll to top*/, true /* keep selection */);
         }
         else
         {
@@ -1301,8 +1307,8 @@ void InfoController::updateAiAircraftText()
           text += tr("No AI or multiplayer aircraft selected.<br/>"
                      "Found %1 AI or multiplayer aircraft.").
                   arg(numAi > 0 ? QLocale().toString(numAi) : tr("no"));
-          atools::gui::util::updateTextEdit(ui->textBrowserAircraftAiInfo, text,
-                                            false /* scroll to top*/, true /* keep selection */);
+          textUpdater->updateTextEdit(ui->textBrowserAircraftAiInfo, text,
+                                      false /* scroll to top*/, true /* keep selection */);
         }
       }
       ui->textBrowserAircraftAiInfo->setToolTip(QString());
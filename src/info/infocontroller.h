@@ -32,6 +32,7 @@ class HtmlInfoBuilder;
 class QTextEdit;
 class AirspaceController;
 class AircraftProgressConfig;
+class TextBrowserUpdater;
 
 namespace atools {
 namespace gui {
@@ -192,6 +193,9 @@ private:
 
   AircraftProgressConfig *aircraftProgressConfig;
 
+  /* Replaces only changed values in aircraft, progress and bearing updates */
+  TextBrowserUpdater *textUpdater = nullptr;
+
   atools::gui::TabWidgetHandler *tabHandlerInfo = nullptr, *tabHandlerAirportInfo = nullptr, *tabHandlerAircraft = nullptr;
 };
 
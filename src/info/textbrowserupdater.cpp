@@ -0,0 +1,194 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "info/textbrowserupdater.h"
+
+#include "common/constants.h"
+#include "gui/widgetutil.h"
+#include "settings/settings.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextEdit>
+#include <QTextList>
+#include <QTextTable>
+
+/* Frame format and cell of the innermost table containing the block */
+struct BlockContext
+{
+  QTextFrameFormat frameFormat;
+  int row = -1, column = -1;
+
+  bool operator==(const BlockContext& other) const
+  {
+    return row == other.row && column == other.column && frameFormat == other.frameFormat;
+  }
+
+  bool operator!=(const BlockContext& other) const
+  {
+    return !operator==(other);
+  }
+};
+
+static BlockContext blockContext(const QTextBlock& block)
+{
+  BlockContext context;
+  QTextCursor cursor(block);
+
+  QTextFrame *frame = cursor.currentFrame();
+  if(frame != nullptr)
+    context.frameFormat = frame->frameFormat();
+
+  QTextTable *table = cursor.currentTable();
+  if(table != nullptr)
+  {
+    QTextTableCell cell = table->cellAt(block.position());
+    context.row = cell.row();
+    context.column = cell.column();
+  }
+  return context;
+}
+
+TextBrowserUpdater::TextBrowserUpdater()
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  enabled = settings.getAndStoreValue(lnm::OPTIONS_INFO_INCREMENTAL_UPDATE, true).toBool();
+  verbose = settings.getAndStoreValue(lnm::OPTIONS_INFO_INCREMENTAL_UPDATE_DEBUG, false).toBool();
+
+  // Not needed for the offscreen document
+  newDocument.setUndoRedoEnabled(false);
+
+  qDebug() << Q_FUNC_INFO << "enabled" << enabled;
+}
+
+TextBrowserUpdater::~TextBrowserUpdater()
+{
+  clear();
+}
+
+void TextBrowserUpdater::clear()
+{
+  for(const QMetaObject::Connection& connection : qAsConst(connections))
+    QObject::disconnect(connection);
+  connections.clear();
+  lastHtml.clear();
+}
+
+void TextBrowserUpdater::updateTextEdit(QTextEdit *textEdit, const QString& html, bool scrollToTop, bool keepSelection)
+{
+  if(textEdit == nullptr)
+    return;
+
+  QElapsedTimer timer;
+  if(verbose)
+    timer.start();
+
+  // Nothing to do if neither HTML nor document changed since last call
+  auto it = lastHtml.constFind(textEdit);
+  if(!scrollToTop && it != lastHtml.constEnd() && it.value() == html)
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << textEdit->objectName() << "unchanged in" << timer.nsecsElapsed() / 1000 << "us";
+    return;
+  }
+
+  QTextDocument *document = textEdit->document();
+  bool incremental = false;
+  int numEdits = 0;
+
+  if(enabled && !scrollToTop && !document->isEmpty())
+  {
+    // Parse into offscreen document using the same settings - nothing is laid out here
+    newDocument.setDefaultFont(document->defaultFont());
+    newDocument.setDefaultStyleSheet(document->defaultStyleSheet());
+    newDocument.setHtml(html);
+
+    QVector<Edit> edits;
+    if(buildEdits(edits, document, &newDocument))
+    {
+      // Replace from end to start to keep positions valid and lay out changed blocks only once
+      QTextCursor cursor(document);
+      cursor.beginEditBlock();
+      for(int i = edits.size() - 1; i >= 0; i--)
+      {
+        const Edit& edit = edits.at(i);
+        cursor.setPosition(edit.position);
+        cursor.setPosition(edit.position + edit.length, QTextCursor::KeepAnchor);
+        cursor.insertText(edit.text, edit.format);
+      }
+      cursor.endEditBlock();
+
+      numEdits = edits.size();
+      incremental = true;
+    }
+    newDocument.clear();
+  }
+
+  if(!incremental)
+    // Structure differs - replace whole document
+    atools::gui::util::updateTextEdit(textEdit, html, scrollToTop, keepSelection);
+
+  if(!connections.contains(textEdit))
+    // Forget HTML if document is changed by others, e.g. by clear() - also called for own changes above
+    connections.insert(textEdit, QObject::connect(document, &QTextDocument::contentsChanged, [this, textEdit]() {
+      lastHtml.remove(textEdit);
+    }));
+  lastHtml.insert(textEdit, html);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << textEdit->objectName() << (incremental ? "incremental" : "full")
+             << "edits" << numEdits << "in" << timer.nsecsElapsed() / 1000 << "us";
+}
+
+bool TextBrowserUpdater::buildEdits(QVector<Edit>& edits, const QTextDocument *document,
+                                    const QTextDocument *newDoc) const
+{
+  if(document->blockCount() != newDoc->blockCount())
+    return false;
+
+  for(QTextBlock block = document->begin(), newBlock = newDoc->begin();
+      block.isValid() && newBlock.isValid(); block = block.next(), newBlock = newBlock.next())
+  {
+    // Compare paragraph, list and table structure
+    if(block.blockFormat() != newBlock.blockFormat() ||
+       (block.textList() == nullptr) != (newBlock.textList() == nullptr) ||
+       blockContext(block) != blockContext(newBlock))
+      return false;
+
+    // Replace changed fragments if the number of fragments is equal
+    QTextBlock::iterator it = block.begin(), newIt = newBlock.begin();
+    for(; !it.atEnd() && !newIt.atEnd(); ++it, ++newIt)
+    {
+      QTextFragment fragment = it.fragment(), newFragment = newIt.fragment();
+      if(fragment.text() != newFragment.text() || fragment.charFormat() != newFragment.charFormat())
+      {
+        // Icons cannot be replaced by inserting text
+        if(fragment.charFormat().isImageFormat() || newFragment.charFormat().isImageFormat())
+          return false;
+
+        edits.append(Edit{fragment.position(), fragment.length(), newFragment.text(), newFragment.charFormat()});
+      }
+    }
+
+    if(!it.atEnd() || !newIt.atEnd())
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_TEXTBROWSERUPDATER_H
+#define LNM_TEXTBROWSERUPDATER_H
+
+#include <QHash>
+#include <QMetaObject>
+#include <QTextDocument>
+#include <QTextFormat>
+#include <QVector>
+
+class QTextEdit;
+
+/*
+ * Updates text browsers showing frequently changing values like the aircraft progress or bearing to airports.
+ *
+ * The new HTML is parsed into an offscreen document which is not laid out and compared with the shown document.
+ * If both have the same structure only the changed text fragments like speed, altitude or ETA are replaced in place.
+ * This avoids laying out and repainting the whole document for each simulator update.
+ *
+ * A full update is done if the structure differs, e.g. if table rows were added or removed.
+ */
+class TextBrowserUpdater
+{
+public:
+  TextBrowserUpdater();
+  ~TextBrowserUpdater();
+
+  TextBrowserUpdater(const TextBrowserUpdater& other) = delete;
+  TextBrowserUpdater& operator=(const TextBrowserUpdater& other) = delete;
+
+  /* Same parameters as atools::gui::util::updateTextEdit(). Updates in place if possible and scrollToTop is false.
+   * Does nothing if HTML and document did not change since the last call. */
+  void updateTextEdit(QTextEdit *textEdit, const QString& html, bool scrollToTop, bool keepSelection);
+
+  /* Forget last HTML for all text browsers */
+  void clear();
+
+private:
+  struct Edit
+  {
+    int position, length;
+    QString text;
+    QTextCharFormat format;
+  };
+
+  /* Collect edits needed to change document into newDocument. Returns false if structure differs. */
+  bool buildEdits(QVector<Edit>& edits, const QTextDocument *document, const QTextDocument *newDocument) const;
+
+  /* Last HTML for each text browser. Removed when document is changed by others. */
+  QHash<const QTextEdit *, QString> lastHtml;
+  QHash<const QTextEdit *, QMetaObject::Connection> connections;
+
+  /* Reused for parsing */
+  QTextDocument newDocument;
+
+  bool enabled = true, verbose = false;
+};
+
+#endif // LNM_TEXTBROWSERUPDATER_H
@@ -23,6 +23,7 @@
 #include "common/unit.h"
 #include "geo/calculations.h"
 #include "mapgui/aprongeometrycache.h"
+#include "mapgui/mapprefetcher.h"
 #include "mapgui/mapscreenindex.h"
 #include "mapgui/mapthemehandler.h"
 #include "mappainter/mappaintlayer.h"
@@ -36,6 +37,7 @@
 #include "settings/settings.h"
 
 #include <QPainter>
+#include <QCoreApplication>
 #include <QJsonDocument>
 #include <QResizeEvent>
 #include <QPaintEvent>
@@ -112,12 +114,18 @@ MapPaintWidget::MapPaintWidget(QWidget *parent, bool visible)
   waypointTrackQuery->initQueries();
 
   paintLayer->initQueries();
+
+  if(visibleWidget)
+    prefetcher = new MapPrefetcher(this);
 }
 
 MapPaintWidget::~MapPaintWidget()
 {
   removeLayer(paintLayer);
 
+  // Stop thread before deleting the queries
+  ATOOLS_DELETE_LOG(prefetcher);
+
   // Have to delete manually since classes can be copied and does not delete in destructor
   airwayTrackQuery->deleteChildren();
   ATOOLS_DELETE_LOG(airwayTrackQuery);
@@ -208,6 +216,7 @@ void MapPaintWidget::setTheme(const QString& themePath, const QString& themeId)
   currentThemeId = themeId;
 
   setThemeInternal(themePath);
+  paintLayer->invalidateStaticLayerCache();
 }
 
 bool MapPaintWidget::noRender() const
@@ -294,11 +303,13 @@ void MapPaintWidget::optionsChanged()
 
   // reloadMap();
   updateCacheSizes();
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
 void MapPaintWidget::styleChanged()
 {
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -327,7 +338,10 @@ void MapPaintWidget::setShowMapSunShading(bool show)
 void MapPaintWidget::weatherUpdated()
 {
   if(paintLayer->getShownMapDisplayTypes().testFlag(map::AIRPORT_WEATHER))
+  {
+    paintLayer->invalidateStaticLayerCache();
     update();
+  }
 
   updateMapVisibleUi();
 }
@@ -336,7 +350,10 @@ void MapPaintWidget::windDisplayUpdated()
 {
   if(paintLayer->getShownMapDisplayTypes().testFlag(map::WIND_BARBS) ||
      paintLayer->getShownMapDisplayTypes().testFlag(map::WIND_BARBS_ROUTE))
+  {
+    paintLayer->invalidateStaticLayerCache();
     update();
+  }
 
   updateMapVisibleUi();
 }
@@ -512,6 +529,10 @@ void MapPaintWidget::preDatabaseLoad()
   databaseLoadStatus = true;
   apronGeometryCache->clear();
   paintLayer->preDatabaseLoad();
+
+  if(prefetcher != nullptr)
+    prefetcher->preDatabaseLoad();
+
   mapQuery->deInitQueries();
   airwayTrackQuery->deInitQueries();
   waypointTrackQuery->deInitQueries();
@@ -529,6 +550,9 @@ void MapPaintWidget::postDatabaseLoad()
   waypointTrackQuery->initQueries();
   mapQuery->initQueries();
   paintLayer->postDatabaseLoad();
+
+  if(prefetcher != nullptr)
+    prefetcher->postDatabaseLoad();
   update();
   updateMapVisibleUiPostDatabaseLoad();
 }
@@ -627,6 +651,23 @@ void MapPaintWidget::prepareDraw(int width, int height)
   noNavPaint = false;
 }
 
+void MapPaintWidget::resizeNoPaint(int width, int height)
+{
+  if(width > 0 && height > 0 && size() != QSize(width, height))
+  {
+    QSize oldSize = size();
+    resize(width, height);
+
+    if(!isVisible())
+    {
+      // Hidden widgets defer the resize event until shown or grabbed - send it now to update the viewport
+      QResizeEvent event(size(), oldSize);
+      QCoreApplication::sendEvent(this, &event);
+      setAttribute(Qt::WA_PendingResizeEvent, false);
+    }
+  }
+}
+
 QPixmap MapPaintWidget::getPixmap(int width, int height)
 {
   if(width > 0 && height > 0)
@@ -919,6 +960,7 @@ void MapPaintWidget::routeChanged(bool geometryChanged)
     screenIndex->updateRouteScreenGeometry(getCurrentViewBoundingBox());
   }
   screenIndex->updateIlsScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -929,6 +971,7 @@ void MapPaintWidget::routeAltitudeChanged(float)
 
   qDebug() << Q_FUNC_INFO;
   screenIndex->updateAirspaceScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -936,6 +979,7 @@ void MapPaintWidget::connectedToSimulator()
 {
   qDebug() << Q_FUNC_INFO;
   jumpBackToAircraftCancel();
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -946,6 +990,7 @@ void MapPaintWidget::disconnectedFromSimulator()
   screenIndex->clearSimData();
   updateMapVisibleUi();
   jumpBackToAircraftCancel();
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -981,6 +1026,7 @@ void MapPaintWidget::clearSearchHighlights()
 
   screenIndex->updateLogEntryScreenGeometry(getCurrentViewBoundingBox());
   screenIndex->updateAirspaceScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -1043,6 +1089,7 @@ void MapPaintWidget::changeProcedureHighlights(const QVector<proc::MapProcedureL
   cancelDragAll();
   screenIndex->setProcedureHighlights(procedures);
   screenIndex->updateRouteScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -1060,6 +1107,7 @@ void MapPaintWidget::changeProcedureHighlight(const proc::MapProcedureLegs& proc
   cancelDragAll();
   screenIndex->setProcedureHighlight(procedure);
   screenIndex->updateRouteScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -1097,6 +1145,7 @@ void MapPaintWidget::changeSearchHighlights(const map::MapResult& newHighlights,
     screenIndex->updateLogEntryScreenGeometry(getCurrentViewBoundingBox());
   if(updateAirspace)
     screenIndex->updateAirspaceScreenGeometry(getCurrentViewBoundingBox());
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -1147,6 +1196,7 @@ void MapPaintWidget::postTrackLoad()
 
   waypointTrackQuery->initQueries();
   airwayTrackQuery->initQueries();
+  paintLayer->invalidateStaticLayerCache();
 }
 
 void MapPaintWidget::cancelDragAll()
@@ -1335,6 +1385,10 @@ void MapPaintWidget::paintEvent(QPaintEvent *paintEvent)
       if(!NavApp::isMainWindowVisible())
         QPainter(this).fillRect(paintEvent->rect(), QGuiApplication::palette().color(QPalette::Window));
 
+      // Load objects in pan direction after caches were updated for this view
+      if(prefetcher != nullptr)
+        prefetcher->viewChanged(visibleLatLonBox);
+
       if(changed)
       {
         // Major change - update index and visible objects
@@ -1378,6 +1432,7 @@ bool MapPaintWidget::loadKml(const QString& filename, bool center)
 void MapPaintWidget::onlineClientAndAtcUpdated()
 {
   screenIndex->updateAirspaceScreenGeometry(currentViewBoundingBox);
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
 
@@ -1385,5 +1440,6 @@ void MapPaintWidget::onlineNetworkChanged()
 {
   screenIndex->resetAirspaceOnlineScreenGeometry();
   screenIndex->updateAirspaceScreenGeometry(currentViewBoundingBox);
+  paintLayer->invalidateStaticLayerCache();
   update();
 }
@@ -57,6 +57,7 @@ class SimConnectData;
 
 class MainWindow;
 class MapPaintLayer;
+class MapPrefetcher;
 class MapScreenIndex;
 class ApronGeometryCache;
 class MapQuery;
@@ -320,6 +321,10 @@ public:
   /* Prepare Marble widget drawing with a dummy paint event without drawing navaids */
   void prepareDraw(int width, int height);
 
+  /* Resize widget and update the Marble viewport immediately without painting.
+   * Used for hidden widgets where only the view rectangle and map layer are needed. */
+  void resizeNoPaint(int width, int height);
+
   bool isAvoidBlurredMap() const
   {
     return avoidBlurredMap;
@@ -525,6 +530,9 @@ protected:
 
   MapPaintLayer *paintLayer;
 
+  /* Loads map objects for the next view in background. Only for the visible map widget otherwise null. */
+  MapPrefetcher *prefetcher = nullptr;
+
   /* Do not draw while database is unavailable */
   bool databaseLoadStatus = false;
 
@@ -0,0 +1,201 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "mapgui/mapprefetcher.h"
+
+#include "app/navapp.h"
+#include "atools.h"
+#include "common/constants.h"
+#include "db/databasepool.h"
+#include "geo/calculations.h"
+#include "geo/pos.h"
+#include "mapgui/maplayer.h"
+#include "mapgui/mappaintwidget.h"
+#include "mappainter/mappaintlayer.h"
+#include "query/waypointquery.h"
+#include "query/waypointtrackquery.h"
+#include "settings/settings.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+
+using Marble::GeoDataLatLonBox;
+using Marble::GeoDataCoordinates;
+
+/* Ignore view changes which are too far apart to get a velocity */
+static const qint64 MAX_VIEW_CHANGE_INTERVAL_MS = 500L;
+
+/* Minimum ground speed to predict aircraft movement */
+static const float MIN_GROUND_SPEED_KTS = 30.f;
+
+MapPrefetcher::MapPrefetcher(MapPaintWidget *parentMapWidget)
+  : QObject(parentMapWidget), mapWidget(parentMapWidget)
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  enabled = settings.getAndStoreValue(lnm::OPTIONS_MAP_PREFETCH, true).toBool();
+  verbose = settings.getAndStoreValue(lnm::OPTIONS_MAP_PREFETCH_DEBUG, false).toBool();
+  lookaheadSeconds = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "PrefetchLookaheadSeconds", 60.f).toFloat();
+
+  connect(&watcher, &QFutureWatcher<MapPrefetchTiles>::finished, this, &MapPrefetcher::loadTilesFinished);
+
+  qDebug() << Q_FUNC_INFO << "enabled" << enabled << "lookaheadSeconds" << lookaheadSeconds;
+}
+
+MapPrefetcher::~MapPrefetcher()
+{
+  watcher.waitForFinished();
+}
+
+void MapPrefetcher::aircraftChanged(const atools::geo::Pos& pos, float trackDegTrue, float groundSpeedKts)
+{
+  if(!enabled || !pos.isValid() || groundSpeedKts < MIN_GROUND_SPEED_KTS || trackDegTrue > 360.f)
+    return;
+
+  const GeoDataLatLonBox& viewRect = mapWidget->getCurrentViewBoundingBox();
+  if(viewRect.isEmpty())
+    return;
+
+  // Move view in flight direction by the distance flown in lookahead time but not more than half a view
+  float viewHeightNm = static_cast<float>(viewRect.height(GeoDataCoordinates::Degree)) * 60.f;
+  float distanceNm = std::min(groundSpeedKts * lookaheadSeconds / 3600.f, viewHeightNm / 2.f);
+  atools::geo::Pos center = pos.endpoint(atools::geo::nmToMeter(distanceNm), trackDegTrue);
+
+  double halfWidth = viewRect.width(GeoDataCoordinates::Degree) / 2., halfHeight = viewRect.height(GeoDataCoordinates::Degree) / 2.;
+  prefetch(GeoDataLatLonBox(std::min(center.getLatY() + halfHeight, 90.), std::max(center.getLatY() - halfHeight, -90.),
+                            GeoDataCoordinates::normalizeLon(center.getLonX() + halfWidth, GeoDataCoordinates::Degree),
+                            GeoDataCoordinates::normalizeLon(center.getLonX() - halfWidth, GeoDataCoordinates::Degree),
+                            GeoDataCoordinates::Degree));
+}
+
+void MapPrefetcher::viewChanged(const GeoDataLatLonBox& rect)
+{
+  if(!enabled || rect.isEmpty() || rect == lastViewRect)
+    return;
+
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  qint64 intervalMs = now - lastViewTimestampMs;
+
+  // Check if view was only moved and not zoomed
+  double width = rect.width(GeoDataCoordinates::Degree), height = rect.height(GeoDataCoordinates::Degree);
+  if(!lastViewRect.isEmpty() && intervalMs > 0 && intervalMs < MAX_VIEW_CHANGE_INTERVAL_MS &&
+     atools::almostEqual(width, lastViewRect.width(GeoDataCoordinates::Degree), width / 10.) &&
+     atools::almostEqual(height, lastViewRect.height(GeoDataCoordinates::Degree), height / 10.))
+  {
+    GeoDataCoordinates center = rect.center(), lastCenter = lastViewRect.center();
+    double deltaLon = GeoDataCoordinates::normalizeLon(center.longitude(GeoDataCoordinates::Degree) -
+                                                       lastCenter.longitude(GeoDataCoordinates::Degree),
+                                                       GeoDataCoordinates::Degree);
+    double deltaLat = center.latitude(GeoDataCoordinates::Degree) - lastCenter.latitude(GeoDataCoordinates::Degree);
+
+    // Extrapolate movement for lookahead time but not more than one view
+    double factor = std::min(1000. / intervalMs, std::min(width / std::max(std::abs(deltaLon), 1.e-6),
+                                                          height / std::max(std::abs(deltaLat), 1.e-6)));
+    deltaLon *= factor;
+    deltaLat *= factor;
+
+    // Skip if movement is small compared to the inflated cache rectangles
+    if(std::abs(deltaLon) > width / 4. || std::abs(deltaLat) > height / 4.)
+      prefetch(GeoDataLatLonBox(std::min(rect.north(GeoDataCoordinates::Degree) + deltaLat, 90.),
+                                std::max(rect.south(GeoDataCoordinates::Degree) + deltaLat, -90.),
+                                GeoDataCoordinates::normalizeLon(rect.east(GeoDataCoordinates::Degree) + deltaLon,
+                                                                 GeoDataCoordinates::Degree),
+                                GeoDataCoordinates::normalizeLon(rect.west(GeoDataCoordinates::Degree) + deltaLon,
+                                                                 GeoDataCoordinates::Degree),
+                                GeoDataCoordinates::Degree));
+  }
+
+  lastViewRect = rect;
+  lastViewTimestampMs = now;
+}
+
+void MapPrefetcher::preDatabaseLoad()
+{
+  databaseLoading = true;
+  hasNextRect = false;
+
+  // Wait for thread and drop results
+  watcher.waitForFinished();
+}
+
+void MapPrefetcher::postDatabaseLoad()
+{
+  databaseLoading = false;
+}
+
+void MapPrefetcher::prefetch(const GeoDataLatLonBox& rect)
+{
+  // Nothing to gain for the world view
+  if(databaseLoading || rect.width(GeoDataCoordinates::Degree) > 180.)
+    return;
+
+  if(watcher.isRunning())
+  {
+    // Load later and replace any older request
+    nextRect = rect;
+    hasNextRect = true;
+    return;
+  }
+
+  const MapLayer *mapLayer = mapWidget->getMapPaintLayer()->getMapLayer();
+  map::MapTypes types = mapWidget->getShownMapTypes();
+  if(mapLayer == nullptr || !NavApp::getDatabasePool()->isOpen())
+    return;
+
+  // Collect tiles not loaded yet in the map widget caches
+  MapPrefetchTiles tiles;
+  mapWidget->getMapQuery()->getMissingTiles(tiles.mapTiles, rect, mapLayer, types);
+
+  if(mapLayer->isAirwayWaypoint() && types.testFlag(map::WAYPOINT))
+    mapWidget->getWaypointTrackQuery()->getWaypointQuery()->getMissingWaypointTiles(tiles.waypointTiles, rect, mapLayer);
+
+  if(tiles.mapTiles.isEmpty() && tiles.waypointTiles.isEmpty())
+    return;
+
+  // Load in pool thread using its own connections
+  bool verboseLog = verbose;
+  watcher.setFuture(NavApp::getDatabasePool()->run([tiles, verboseLog](DatabasePoolContext& context) -> MapPrefetchTiles {
+    QElapsedTimer timer;
+    timer.start();
+
+    MapPrefetchTiles loaded(tiles);
+    context.mapQuery->loadMissingTiles(loaded.mapTiles);
+    context.waypointQuery->loadMissingWaypointTiles(loaded.waypointTiles);
+
+    if(verboseLog)
+      qDebug() << Q_FUNC_INFO << "airports" << loaded.mapTiles.airports.keys.size()
+               << "vors" << loaded.mapTiles.vors.keys.size() << "ndbs" << loaded.mapTiles.ndbs.keys.size()
+               << "waypoints" << loaded.waypointTiles.keys.size() << "tiles in" << timer.elapsed() << "ms";
+    return loaded;
+  }));
+}
+
+void MapPrefetcher::loadTilesFinished()
+{
+  if(databaseLoading)
+    return;
+
+  // Caches drop the tiles if they were cleared or the layer changed in the meantime
+  const MapPrefetchTiles tiles = watcher.result();
+  mapWidget->getMapQuery()->insertMissingTiles(tiles.mapTiles);
+  mapWidget->getWaypointTrackQuery()->getWaypointQuery()->insertMissingWaypointTiles(tiles.waypointTiles);
+
+  if(hasNextRect)
+  {
+    hasNextRect = false;
+    prefetch(nextRect);
+  }
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_MAPPREFETCHER_H
+#define LNM_MAPPREFETCHER_H
+
+#include "query/mapquery.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+
+#include <marble/GeoDataLatLonBox.h>
+
+namespace atools {
+namespace geo {
+class Pos;
+}
+}
+
+class MapPaintWidget;
+
+/* Tiles missing in the map widget caches. Passed to the thread, filled there and passed back. */
+struct MapPrefetchTiles
+{
+  MapQueryMissingTiles mapTiles;
+  query::MissingTiles<map::MapWaypoint> waypointTiles;
+};
+
+/*
+ * Loads airport, VOR, NDB and waypoint tiles for the predicted next map view in a background thread and adds them
+ * to the caches of the map widget queries. The paint thread then finds the data already loaded.
+ *
+ * The next view is predicted from aircraft ground speed and track while the map follows the aircraft or from the
+ * pan velocity of the last view changes.
+ *
+ * Loading is done in the DatabasePool which has its own read only database connections and query instances.
+ * Only one request is loaded at a time. Requests arriving meanwhile replace each other and only the last one
+ * is loaded afterwards.
+ */
+class MapPrefetcher :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MapPrefetcher(MapPaintWidget *parentMapWidget);
+  virtual ~MapPrefetcher() override;
+
+  MapPrefetcher(const MapPrefetcher& other) = delete;
+  MapPrefetcher& operator=(const MapPrefetcher& other) = delete;
+
+  /* Prefetch area ahead of the aircraft. Call only if map is centered on the aircraft. */
+  void aircraftChanged(const atools::geo::Pos& pos, float trackDegTrue, float groundSpeedKts);
+
+  /* Visible map region changed. Prefetches the area in pan direction if the view moved quickly. */
+  void viewChanged(const Marble::GeoDataLatLonBox& rect);
+
+  /* Waits for the thread and drops the result */
+  void preDatabaseLoad();
+  void postDatabaseLoad();
+
+private:
+  /* Get missing tiles from the map widget caches and start the thread if there is anything to load */
+  void prefetch(const Marble::GeoDataLatLonBox& rect);
+
+  /* Called by watcher in the GUI thread. Inserts the loaded tiles into the caches. */
+  void loadTilesFinished();
+
+  MapPaintWidget *mapWidget;
+  QFutureWatcher<MapPrefetchTiles> watcher;
+
+  /* Request which arrived while the thread was busy */
+  Marble::GeoDataLatLonBox nextRect;
+  bool hasNextRect = false;
+
+  /* Last view to calculate pan velocity */
+  Marble::GeoDataLatLonBox lastViewRect;
+  qint64 lastViewTimestampMs = 0L;
+
+  float lookaheadSeconds = 60.f;
+  bool enabled = true, databaseLoading = false, verbose = false;
+};
+
+#endif // LNM_MAPPREFETCHER_H
@@ -0,0 +1,198 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LITTLENAVMAP_MAPSCREENGRID_H
+#define LITTLENAVMAP_MAPSCREENGRID_H
+
+#include <QLine>
+#include <QPolygon>
+#include <QRect>
+#include <QVector>
+
+#include <algorithm>
+
+/*
+ * Uniform grid of buckets in screen coordinates used by MapScreenIndex to find objects near the mouse cursor.
+ * Each object is stored once in a list and its index is added to all cells overlapped by the bounding rectangle.
+ * A lookup then only checks objects in the cells near the given point instead of all objects on screen.
+ *
+ * ID is the object id type and GEOMETRY one of QLine, QPolygon or QPoint.
+ * Grid falls back to a linear scan if no screen rectangle was given in clear().
+ */
+template<typename ID, typename GEOMETRY>
+class MapScreenGrid
+{
+public:
+  typedef std::pair<ID, GEOMETRY> Item;
+
+  explicit MapScreenGrid(int cellSizeParam = 64)
+    : cellSize(std::max(cellSizeParam, 8))
+  {
+  }
+
+  /* Remove all objects and set the screen rectangle covered by the grid */
+  void clear(const QRect& screenRect);
+
+  /* Remove all objects and cells */
+  void clear()
+  {
+    clear(QRect());
+  }
+
+  /* Add object and put it into all cells touched by its bounding rectangle */
+  void append(const ID& id, const GEOMETRY& geometry);
+
+  /* Calls func(const ID& id, const GEOMETRY& geometry) once for each object where the
+   * bounding rectangle inflated by maxDistance contains point. Objects are passed in insertion order. */
+  template<typename FUNC>
+  void forEachNear(const QPoint& point, int maxDistance, FUNC func) const;
+
+  /* All objects in insertion order */
+  const QList<Item>& getItems() const
+  {
+    return items;
+  }
+
+  bool isEmpty() const
+  {
+    return items.isEmpty();
+  }
+
+  int size() const
+  {
+    return items.size();
+  }
+
+private:
+  static QRect boundingRect(const QLine& line)
+  {
+    return QRect(line.p1(), line.p2()).normalized();
+  }
+
+  static QRect boundingRect(const QPolygon& polygon)
+  {
+    return polygon.boundingRect();
+  }
+
+  static QRect boundingRect(const QPoint& point)
+  {
+    return QRect(point, QSize(1, 1));
+  }
+
+  /* Cell column and row clamped to grid */
+  int column(int x) const
+  {
+    return std::min(std::max((x - origin.x()) / cellSize, 0), columns - 1);
+  }
+
+  int row(int y) const
+  {
+    return std::min(std::max((y - origin.y()) / cellSize, 0), rows - 1);
+  }
+
+  QList<Item> items;
+
+  /* Bounding rectangles for items using the same index */
+  QVector<QRect> itemRects;
+
+  /* Row major cells containing indexes into items */
+  QVector<QVector<int> > cells;
+  QPoint origin;
+  int cellSize, columns = 0, rows = 0;
+};
+
+// ---------------------------------------------------------------------------------
+
+template<typename ID, typename GEOMETRY>
+void MapScreenGrid<ID, GEOMETRY>::clear(const QRect& screenRect)
+{
+  items.clear();
+  itemRects.clear();
+  cells.clear();
+  columns = rows = 0;
+
+  if(screenRect.isValid())
+  {
+    origin = screenRect.topLeft();
+    columns = screenRect.width() / cellSize + 1;
+    rows = screenRect.height() / cellSize + 1;
+    cells.resize(columns * rows);
+  }
+}
+
+template<typename ID, typename GEOMETRY>
+void MapScreenGrid<ID, GEOMETRY>::append(const ID& id, const GEOMETRY& geometry)
+{
+  int index = items.size();
+  QRect rect = boundingRect(geometry);
+  items.append(std::make_pair(id, geometry));
+  itemRects.append(rect);
+
+  if(!cells.isEmpty())
+  {
+    // Objects partially or fully outside of the screen are added to the border cells
+    int colEnd = column(rect.right()), rowEnd = row(rect.bottom());
+    for(int r = row(rect.top()); r <= rowEnd; r++)
+    {
+      for(int c = column(rect.left()); c <= colEnd; c++)
+        cells[r * columns + c].append(index);
+    }
+  }
+}
+
+template<typename ID, typename GEOMETRY>
+template<typename FUNC>
+void MapScreenGrid<ID, GEOMETRY>::forEachNear(const QPoint& point, int maxDistance, FUNC func) const
+{
+  if(items.isEmpty())
+    return;
+
+  QRect searchRect(point.x() - maxDistance, point.y() - maxDistance, 2 * maxDistance + 1, 2 * maxDistance + 1);
+
+  if(cells.isEmpty())
+  {
+    // No grid - check all objects
+    for(int i = 0; i < items.size(); i++)
+    {
+      if(itemRects.at(i).intersects(searchRect))
+        func(items.at(i).first, items.at(i).second);
+    }
+  }
+  else
+  {
+    // Collect indexes of all cells touched by the search rectangle
+    QVector<int> indexes;
+    int colEnd = column(searchRect.right()), rowEnd = row(searchRect.bottom());
+    for(int r = row(searchRect.top()); r <= rowEnd; r++)
+    {
+      for(int c = column(searchRect.left()); c <= colEnd; c++)
+        indexes.append(cells.at(r * columns + c));
+    }
+
+    // Objects can be in more than one cell - remove duplicates and keep insertion order
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+    for(int index : qAsConst(indexes))
+    {
+      if(itemRects.at(index).intersects(searchRect))
+        func(items.at(index).first, items.at(index).second);
+    }
+  }
+}
+
+#endif // LITTLENAVMAP_MAPSCREENGRID_H
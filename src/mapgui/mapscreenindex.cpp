@@ -41,6 +41,7 @@
 #include "util/average.h"
 
 #include <marble/GeoDataLineString.h>
+#include <marble/ViewportParams.h>
 
 using atools::geo::Pos;
 using atools::geo::Line;
@@ -128,6 +129,7 @@ void MapScreenIndex::copy(const MapScreenIndex& other)
   routePointsAll = other.routePointsAll;
   lastUserAircraftForAverageTs = other.lastUserAircraftForAverageTs;
   routeDrawnNavaids = other.routeDrawnNavaids;
+  aiAircraftPointsValid = false;
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceId>& ids, map::MapAirspaceSources source,
@@ -165,6 +167,9 @@ void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceI
         airspaces.append(&airspace);
     }
 
+    // Same pixel-accurate simplified geometry as used by the airspace painter
+    float toleranceNm = scale->getNmPerPixel();
+
     CoordinateConverter conv(mapWidget->viewport());
     for(const map::MapAirspace *airspace : qAsConst(airspaces))
     {
@@ -176,14 +181,14 @@ void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceI
       // Check if airspace overlaps with current screen and is not already in list
       if(airspacebox.intersects(curBox) && !ids.contains(airspace->combinedId()))
       {
-        const atools::geo::LineString *lines = controller->getAirspaceGeometry(airspace->combinedId());
+        const atools::geo::LineString *lines = controller->getAirspaceGeometry(airspace->combinedId(), toleranceNm);
         if(lines != nullptr)
         {
           const QVector<QPolygonF *> polys = conv.createPolygons(*lines, mapWidget->rect());
           for(const QPolygonF *poly : qAsConst(polys))
           {
             // Cut off all polygon parts that are not visible on screen
-            airspacePolygons.append(std::make_pair(airspace->combinedId(), poly->intersected(QPolygon(mapWidget->rect())).toPolygon()));
+            airspacePolygons.append(airspace->combinedId(), poly->intersected(QPolygon(mapWidget->rect())).toPolygon());
             ids.insert(airspace->combinedId());
           }
           conv.releasePolygons(polys);
@@ -201,13 +206,13 @@ void MapScreenIndex::resetAirspaceOnlineScreenGeometry()
 
 void MapScreenIndex::resetIlsScreenGeometry()
 {
-  ilsPolygons.clear();
-  ilsLines.clear();
+  ilsPolygons.clear(mapWidget->rect());
+  ilsLines.clear(mapWidget->rect());
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
-  airspacePolygons.clear();
+  airspacePolygons.clear(mapWidget->rect());
   if(paintLayer == nullptr || paintLayer->getMapLayer() == nullptr)
     return;
 
@@ -319,14 +324,14 @@ void MapScreenIndex::updateIlsScreenGeometry(const Marble::GeoDataLatLonBox& cur
       }
       polygon = polygon.intersected(QPolygon(mapWidget->rect()));
       if(!polygon.isEmpty())
-        ilsPolygons.append(std::make_pair(ils.id, polygon));
+        ilsPolygons.append(ils.id, polygon);
     }
   }
 }
 
 void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
-  logEntryLines.clear();
+  logEntryLines.clear(mapWidget->rect());
 
   const MapScale *scale = paintLayer->getMapScale();
 
@@ -367,7 +372,7 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox&
   if(paintLayer == nullptr || paintLayer->getMapLayer() == nullptr)
     return;
 
-  airwayLines.clear();
+  airwayLines.clear(mapWidget->rect());
 
   // Use ID set to check for duplicates between calls
   QSet<int> ids;
@@ -452,7 +457,7 @@ void MapScreenIndex::updateAirwayScreenGeometryInternal(QSet<int>& ids, const Ma
   }
 }
 
-void MapScreenIndex::updateLineScreenGeometry(QList<std::pair<int, QLine> >& index,
+void MapScreenIndex::updateLineScreenGeometry(MapScreenGrid<int, QLine>& index,
                                               int id, const atools::geo::Line& line,
                                               const Marble::GeoDataLatLonBox& curBox,
                                               const CoordinateConverter& conv)
@@ -480,7 +485,7 @@ void MapScreenIndex::updateLineScreenGeometry(QList<std::pair<int, QLine> >& ind
             rect.adjust(-1, -1, 1, 1);
 
             if(mapGeo.intersects(rect))
-              index.append(std::make_pair(id, l));
+              index.append(id, l);
           }
         }
       }
@@ -665,6 +670,7 @@ void MapScreenIndex::clearSimData()
 void MapScreenIndex::updateSimData(const atools::fs::sc::SimConnectData& data)
 {
   *simData = data;
+  aiAircraftPointsValid = false;
   updateAverageTurn();
 }
 
@@ -756,7 +762,7 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonBox& c
   bool missed = paintLayer->getShownMapTypes().testFlag(map::MISSED_APPROACH);
   bool alternate = paintLayer->getShownMapDisplayTypes().testFlag(map::FLIGHTPLAN_ALTERNATE);
 
-  routeLines.clear();
+  routeLines.clear(mapWidget->rect());
   routePointsEditable.clear();
   routePointsAll.clear();
 
@@ -846,23 +852,24 @@ void MapScreenIndex::getAllNearest(const QPoint& point, int maxDistance, map::Ma
   // Check for AI / multiplayer aircraft from simulator ==============================
   int x, y;
 
+  // Screen positions of all AI are kept in a grid until simulator data or view changes
+  const QVector<atools::fs::sc::SimConnectAircraft>& aiAircraft = simData->getAiAircraftConst();
+  updateAiScreenGeometry(conv);
+
   // Add boats ======================================
   result.aiAircraft.clear();
   if(NavApp::isConnected())
   {
     if(shown & map::AIRCRAFT_AI_SHIP && mapLayer->isAiShipLarge())
     {
-      for(const atools::fs::sc::SimConnectAircraft& obj : simData->getAiAircraftConst())
-      {
+      aiAircraftPoints.forEachNear(point, maxDistance, [&](int index, const QPoint& pt) {
+        const atools::fs::sc::SimConnectAircraft& obj = aiAircraft.at(index);
         if(obj.isValid() && obj.isAnyBoat() && (obj.getModelRadiusCorrected() * 2 > layer::LARGE_SHIP_SIZE || mapLayer->isAiShipSmall()))
         {
-          if(conv.wToS(obj.getPosition(), x, y))
-          {
-            if((atools::geo::manhattanDistance(x, y, xs, ys)) < maxDistance)
-              insertSortedByDistance(conv, result.aiAircraft, nullptr, xs, ys, map::MapAiAircraft(obj));
-          }
+          if((atools::geo::manhattanDistance(pt.x(), pt.y(), xs, ys)) < maxDistance)
+            insertSortedByDistance(conv, result.aiAircraft, nullptr, xs, ys, map::MapAiAircraft(obj));
         }
-      }
+      });
     }
   }
 
@@ -871,36 +878,34 @@ void MapScreenIndex::getAllNearest(const QPoint& point, int maxDistance, map::Ma
   bool hideAiOnGround = OptionData::instance().getFlags().testFlag(opts::MAP_AI_HIDE_GROUND);
 
   // Add AI or injected multiplayer aircraft ======================================
-  for(const atools::fs::sc::SimConnectAircraft& ac : mapWidget->getAiAircraft())
-  {
+  aiAircraftPoints.forEachNear(point, maxDistance, [&](int index, const QPoint& pt) {
+    const atools::fs::sc::SimConnectAircraft& ac = aiAircraft.at(index);
+
     // Skip boats
     if(ac.isAnyBoat())
-      continue;
+      return;
 
     // Skip shadow aircraft if online is disabled
     if(!onlineEnabled && ac.isOnlineShadow())
-      continue;
+      return;
 
     // Skip AI aircraft (means not shadow) if AI is disabled
     if(!aiEnabled && !ac.isOnlineShadow())
-      continue;
+      return;
 
     if(ac.isValid() && !ac.isAnyBoat() && mapfunc::aircraftVisible(ac, mapLayer, hideAiOnGround))
     {
-      if(conv.wToS(ac.getPosition(), x, y))
+      if((atools::geo::manhattanDistance(pt.x(), pt.y(), xs, ys)) < maxDistance)
       {
-        if((atools::geo::manhattanDistance(x, y, xs, ys)) < maxDistance)
-        {
-          // Add online network shadow aircraft from simulator to online list
-          atools::fs::sc::SimConnectAircraft shadow = NavApp::getOnlinedataController()->getShadowedOnlineAircraft(ac);
-          if(shadow.isValid())
-            insertSortedByDistance(conv, result.onlineAircraft, &result.onlineAircraftIds, xs, ys, map::MapOnlineAircraft(shadow));
+        // Add online network shadow aircraft from simulator to online list
+        atools::fs::sc::SimConnectAircraft shadow = NavApp::getOnlinedataController()->getShadowedOnlineAircraft(ac);
+        if(shadow.isValid())
+          insertSortedByDistance(conv, result.onlineAircraft, &result.onlineAircraftIds, xs, ys, map::MapOnlineAircraft(shadow));
 
-          insertSortedByDistance(conv, result.aiAircraft, nullptr, xs, ys, map::MapAiAircraft(ac));
-        }
+        insertSortedByDistance(conv, result.aiAircraft, nullptr, xs, ys, map::MapAiAircraft(ac));
       }
     }
-  }
+  });
 
   if(onlineEnabled)
   {
@@ -1255,27 +1260,46 @@ void MapScreenIndex::updateAllGeometry(const Marble::GeoDataLatLonBox& curBox)
   updateIlsScreenGeometry(curBox);
 }
 
-void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result) const
+void MapScreenIndex::updateAiScreenGeometry(const CoordinateConverter& conv) const
 {
-  for(const std::pair<map::MapAirspaceId, QPolygon>& polyPair : airspacePolygons)
+  const Marble::ViewportParams *viewport = mapWidget->viewport();
+  const Marble::GeoDataLatLonBox& box = viewport->viewLatLonAltBox();
+
+  if(!aiAircraftPointsValid || aiAircraftPointsBox != box || aiAircraftPointsRadius != viewport->radius())
   {
-    if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
-      result.airspaces.append(NavApp::getAirspaceController()->getAirspaceById(polyPair.first));
+    aiAircraftPoints.clear(mapWidget->rect());
+
+    const QVector<atools::fs::sc::SimConnectAircraft>& aiAircraft = simData->getAiAircraftConst();
+    int x, y;
+    for(int i = 0; i < aiAircraft.size(); i++)
+    {
+      if(conv.wToS(aiAircraft.at(i).getPosition(), x, y))
+        aiAircraftPoints.append(i, QPoint(x, y));
+    }
+
+    aiAircraftPointsBox = box;
+    aiAircraftPointsRadius = viewport->radius();
+    aiAircraftPointsValid = true;
   }
 }
 
-QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys,
+void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result) const
+{
+  QPoint point(xs, ys);
+  airspacePolygons.forEachNear(point, 0, [&result, &point](const map::MapAirspaceId& id, const QPolygon& polygon) {
+    if(polygon.containsPoint(point, Qt::OddEvenFill))
+      result.airspaces.append(NavApp::getAirspaceController()->getAirspaceById(id));
+  });
+}
+
+QSet<int> MapScreenIndex::nearestLineIds(const MapScreenGrid<int, QLine>& lineList, int xs, int ys,
                                          int maxDistance, bool lineDistanceOnly) const
 {
   QSet<int> ids;
-  for(int i = 0; i < lineList.size(); i++)
-  {
-    const std::pair<int, QLine>& linePair = lineList.at(i);
-    const QLine& line = linePair.second;
-
+  lineList.forEachNear(QPoint(xs, ys), maxDistance, [&](int id, const QLine& line) {
     if(atools::geo::distanceToLine(xs, ys, line.x1(), line.y1(), line.x2(), line.y2(), lineDistanceOnly) < maxDistance)
-      ids.insert(linePair.first);
-  }
+      ids.insert(id);
+  });
   return ids;
 }
 
@@ -1317,12 +1341,11 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
   QSet<int> ilsIds = nearestLineIds(ilsLines, xs, ys, maxDistance, false /* lineDistanceOnly */);
 
   // Get nearest ILS by geometry - duplicates are removed in set
-  for(int i = 0; i < ilsPolygons.size(); i++)
-  {
-    const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(i);
-    if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
-      ilsIds.insert(polyPair.first);
-  }
+  QPoint point(xs, ys);
+  ilsPolygons.forEachNear(point, 0, [&ilsIds, &point](int id, const QPolygon& polygon) {
+    if(polygon.containsPoint(point, Qt::OddEvenFill))
+      ilsIds.insert(id);
+  });
 
   // Get ILS map objects for ids
   MapQuery *mapQuery = mapWidget->getMapQuery();
@@ -1347,19 +1370,14 @@ int MapScreenIndex::getNearestRouteLegIndex(int xs, int ys, int maxDistance) con
   int minIndex = -1;
   float minDist = std::numeric_limits<float>::max();
 
-  for(int i = 0; i < routeLines.size(); i++)
-  {
-    const std::pair<int, QLine>& line = routeLines.at(i);
-
-    QLine l = line.second;
-
+  routeLines.forEachNear(QPoint(xs, ys), maxDistance, [&](int index, const QLine& l) {
     float dist = atools::geo::distanceToLine(xs, ys, l.x1(), l.y1(), l.x2(), l.y2(), true /* no dist to points */);
 
     if(dist < minDist && dist < maxDistance)
     {
       minDist = dist;
-      minIndex = line.first;
+      minIndex = index;
     }
-  }
+  });
   return minIndex;
 }
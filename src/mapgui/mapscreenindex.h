@@ -19,10 +19,13 @@
 #define LITTLENAVMAP_MAPSCREENINDEX_H
 
 #include "common/mapflags.h"
+#include "mapgui/mapscreengrid.h"
 
 #include <QDateTime>
 #include <QHash>
 
+#include <marble/GeoDataLatLonBox.h>
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -69,9 +72,6 @@ struct PatternMarker;
 struct RangeMarker;
 }
 
-namespace Marble {
-class GeoDataLatLonBox;
-}
 
 class MapPaintWidget;
 class AirwayTrackQuery;
@@ -285,7 +285,7 @@ public:
   /* For debug functions */
   QList<std::pair<int, QLine> > getAirwayLines() const
   {
-    return airwayLines;
+    return airwayLines.getItems();
   }
 
   const QVector<map::MapRef>& getRouteDrawnNavaidsConst() const
@@ -315,13 +315,16 @@ private:
                                             const Marble::GeoDataLatLonBox& curBox, bool highlights);
   void updateAirwayScreenGeometryInternal(QSet<int>& ids, const Marble::GeoDataLatLonBox& curBox, bool highlight);
 
-  void updateLineScreenGeometry(QList<std::pair<int, QLine> >& index, int id, const atools::geo::Line& line,
+  void updateLineScreenGeometry(MapScreenGrid<int, QLine>& index, int id, const atools::geo::Line& line,
                                 const Marble::GeoDataLatLonBox& curBox, const CoordinateConverter& conv);
 
+  /* Rebuild screen coordinate index for AI aircraft and ships if simulator data or view has changed */
+  void updateAiScreenGeometry(const CoordinateConverter& conv) const;
+
   /* Fill average values for ground speed and turn speed for turn path display. */
   void updateAverageTurn();
 
-  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys, int maxDistance, bool lineDistanceOnly) const;
+  QSet<int> nearestLineIds(const MapScreenGrid<int, QLine>& lineList, int xs, int ys, int maxDistance, bool lineDistanceOnly) const;
 
   template<typename TYPE>
   int getNearestId(int xs, int ys, int maxDistance, const QHash<int, TYPE>& typeList) const;
@@ -374,19 +377,27 @@ private:
   QHash<int, map::MsaMarker> msaMarks;
 
   /* Cached screen coordinates for flight plan to ease mouse cursor change. */
-  QList<std::pair<int, QLine> > routeLines;
+  MapScreenGrid<int, QLine> routeLines;
   QList<std::pair<int, QPoint> > routePointsEditable; /* Editable points */
   QList<std::pair<int, QPoint> > routePointsAll; /* All points */
 
-  /* Geometry objects that are cached in screen coordinate system for faster access to tooltips etc. */
-  QList<std::pair<int, QLine> > airwayLines;
+  /* Geometry objects that are cached in screen coordinate system for faster access to tooltips etc.
+   * Grids are filled in updateAllGeometry() and the related methods. */
+  MapScreenGrid<int, QLine> airwayLines;
 
   /* Collects logbook entry route and direct line geometry */
-  QList<std::pair<int, QLine> > logEntryLines;
-  QList<std::pair<map::MapAirspaceId, QPolygon> > airspacePolygons;
-  QList<std::pair<int, QPolygon> > ilsPolygons;
-  QList<std::pair<int, QLine> > ilsLines; /* Index ILS center lines separately to allow
-                                           * tooltips when getting the cursor near a line */
+  MapScreenGrid<int, QLine> logEntryLines;
+  MapScreenGrid<map::MapAirspaceId, QPolygon> airspacePolygons;
+  MapScreenGrid<int, QPolygon> ilsPolygons;
+  MapScreenGrid<int, QLine> ilsLines; /* Index ILS center lines separately to allow
+                                       * tooltips when getting the cursor near a line */
+
+  /* Screen positions of AI aircraft and ships. Value is index into simData AI list.
+   * Built lazily on first lookup after simulator data or view changes. */
+  mutable MapScreenGrid<int, QPoint> aiAircraftPoints;
+  mutable bool aiAircraftPointsValid = false;
+  mutable Marble::GeoDataLatLonBox aiAircraftPointsBox;
+  mutable int aiAircraftPointsRadius = 0;
 };
 
 #endif // LITTLENAVMAP_MAPSCREENINDEX_H
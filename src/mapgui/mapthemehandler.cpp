@@ -748,8 +748,8 @@ void MapThemeHandler::changeMapTheme()
   qDebug() << Q_FUNC_INFO << themeId << theme;
 
   mapWidget->setTheme(theme.getDgmlFilepath(), themeId);
-  if(NavApp::getMapPaintWidgetWeb() != nullptr)
-    NavApp::getMapPaintWidgetWeb()->setTheme(theme.getDgmlFilepath(), themeId);
+  for(MapPaintWidget *webWidget : NavApp::getMapPaintWidgetsWeb())
+    webWidget->setTheme(theme.getDgmlFilepath(), themeId);
 
   NavApp::setStatusMessage(tr("Map theme changed to %1.").arg(actionGroupMapTheme->checkedAction()->text()));
 }
@@ -805,8 +805,8 @@ void MapThemeHandler::optionsChanged()
     currentThemeId = defaultTheme.getThemeId();
     NavApp::getMapWidgetGui()->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
 
-    if(NavApp::getMapPaintWidgetWeb() != nullptr)
-      NavApp::getMapPaintWidgetWeb()->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
+    for(MapPaintWidget *webWidget : NavApp::getMapPaintWidgetsWeb())
+      webWidget->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
   }
 
   // Check the theme action
@@ -45,6 +45,7 @@
 #include "mapgui/mapdetailhandler.h"
 #include "mapgui/maplayersettings.h"
 #include "mapgui/mapmarkhandler.h"
+#include "mapgui/mapprefetcher.h"
 #include "mapgui/mapscreenindex.h"
 #include "mapgui/mapthemehandler.h"
 #include "mapgui/mapthemehandler.h"
@@ -2511,6 +2512,10 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
   // Show aircraft is enabled
   bool centerAircraftChecked = mainWindow->getUi()->actionMapAircraftCenter->isChecked();
 
+  // Load map objects ahead of the aircraft in background
+  if(centerAircraftChecked && prefetcher != nullptr)
+    prefetcher->aircraftChanged(aircraft.getPosition(), aircraft.getTrackDegTrue(), aircraft.getGroundSpeedKts());
+
   // Get delta values for update rate
   opts::SimUpdateRate rate = od.getSimUpdateRate();
   SimUpdateDelta deltas = distance() < SIM_UPDATE_CLOSE_KM ? SIM_UPDATE_DELTA_MAP_CLOSE.value(rate) : SIM_UPDATE_DELTA_MAP.value(rate);
@@ -2799,8 +2804,11 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     // touchdownDetected = false;
 
     if((dataHasChanged || aiVisible) && !contextMenuActive)
-      // Not scrolled or zoomed but needs a redraw
+    {
+      // Not scrolled or zoomed but needs a redraw - static layers like airspaces can be taken from cache
+      paintLayer->setNextRenderDynamicOnly();
       update();
+    }
 
     if(!updatesEnabled())
       setUpdatesEnabled(true);
@@ -3090,6 +3098,8 @@ void MapWidget::restoreState()
   // Restore range rings, patterns, holds and more
   getScreenIndex()->restoreState();
 
+  // Enable journal before loading to replay positions recorded after the last full save
+  aircraftTrail->enableJournal(lnm::AIRCRAFT_TRACK_SUFFIX, 2 /* numBackups */);
   if(OptionData::instance().getFlags() & opts::STARTUP_LOAD_TRAIL && !NavApp::isSafeMode())
     aircraftTrail->restoreState(lnm::AIRCRAFT_TRACK_SUFFIX);
   aircraftTrail->setMaxTrackEntries(OptionData::instance().getAircraftTrailMaxPoints());
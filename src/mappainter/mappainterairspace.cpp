@@ -73,6 +73,9 @@ void MapPainterAirspace::render()
   int displayThicknessAirspace = optionData.getDisplayThicknessAirspace();
   int displayTransparencyAirspace = optionData.getDisplayTransparencyAirspace();
 
+  // Use simplified geometry where deviation is below one pixel
+  float toleranceNm = scale->isValid() ? scale->getNmPerPixel() : 0.f;
+
   // Collect visible airspaces ==================================================================================
   struct DrawAirspace
   {
@@ -111,7 +114,7 @@ void MapPainterAirspace::render()
           return;
 
         // Get cached geometry =====================
-        const LineString *lineString = controller->getAirspaceGeometry(airspace->combinedId());
+        const LineString *lineString = controller->getAirspaceGeometry(airspace->combinedId(), toleranceNm);
         if(lineString != nullptr)
         {
           if(airspace->isOnline())
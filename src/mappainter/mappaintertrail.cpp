@@ -21,6 +21,7 @@
 #include "common/aircrafttrail.h"
 #include "fs/sc/simconnectuseraircraft.h"
 #include "mapgui/mappaintwidget.h"
+#include "mapgui/mapscale.h"
 #include "route/route.h"
 #include "util/paintercontextsaver.h"
 #include "geo/linestring.h"
@@ -29,6 +30,9 @@
 
 using atools::fs::sc::SimConnectAircraft;
 
+/* Minimum screen distance between drawn trail points */
+static const float MIN_TRAIL_POINT_DIST_PX = 2.f;
+
 MapPainterTrail::MapPainterTrail(MapPaintWidget *mapWidget, MapScale *mapScale, PaintContext *paintContext)
   : MapPainterVehicle(mapWidget, mapScale, paintContext)
 {
@@ -67,7 +71,10 @@ void MapPainterTrail::render()
         maxAltitude = std::max(context->route->getCruiseAltitudeFt(), maxAltitude);
 
       atools::util::PainterContextSaver saver(context->painter);
-      const QVector<atools::geo::LineString> lineStrings = aircraftTrail.getLineStrings(mapPaintWidget->getUserAircraft().getPosition());
+      // Get only visible parts and leave out points too close to be distinguished at the current zoom
+      const QVector<atools::geo::LineString> lineStrings =
+        aircraftTrail.getLineStrings(mapPaintWidget->getUserAircraft().getPosition(), context->viewportRect,
+                                     scale->getMeterPerPixel() * MIN_TRAIL_POINT_DIST_PX);
       paintAircraftTrail(lineStrings, aircraftTrail.getMinAltitude(), maxAltitude);
     }
   }
@@ -17,6 +17,7 @@
 
 #include "mappainter/mappaintlayer.h"
 
+#include "atools.h"
 #include "common/constants.h"
 #include "common/mapcolors.h"
 #include "geo/calculations.h"
@@ -47,6 +48,7 @@
 #include <QElapsedTimer>
 
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -56,6 +58,7 @@ MapPaintLayer::MapPaintLayer(MapPaintWidget *widget)
 {
   verbose = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_LAYER_DEBUG, false).toBool();
   verboseDraw = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_LAYER_DEBUG_DRAW, false).toBool();
+  staticLayerCacheEnabled = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_STATIC_LAYER_CACHE, true).toBool();
 
   // Create the layer configuration
   initMapLayerSettings();
@@ -122,11 +125,13 @@ void MapPaintLayer::copySettings(const MapPaintLayer& other)
 void MapPaintLayer::preDatabaseLoad()
 {
   databaseLoadStatus = true;
+  invalidateStaticLayerCache();
 }
 
 void MapPaintLayer::postDatabaseLoad()
 {
   databaseLoadStatus = false;
+  invalidateStaticLayerCache();
 }
 
 void MapPaintLayer::setShowMapObjects(map::MapTypes type, map::MapTypes mask)
@@ -538,74 +543,210 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       // =========================================================================
       // Draw ====================================
 
-      // Altitude below all others
-      mapPainterAltitude->render();
+      // Use cached image for static layers only for simulator updates on the still visible map
+      bool useStaticLayerCache = staticLayerCacheEnabled && still && mapPaintWidget->isVisibleWidget() &&
+                                 !mapPaintWidget->isPrinting();
 
-      // Ship below other navaids and airports
-      mapPainterShip->render();
-
-      if(!mapPaintWidget->isDistanceCutOff())
+      if(useStaticLayerCache)
+        // Altitude, airspaces, navaids, route and more from cache - ship is drawn in between
+        renderStaticLayersCached(painter, viewport);
+      else
       {
-        if(!context.isObjectOverflow())
-          mapPainterAirspace->render();
+        // Draw all directly into map
+        staticLayerImageBelowShip = QImage();
+        staticLayerImage = QImage();
+        invalidateStaticLayerCache();
 
-        if(!context.isObjectOverflow())
-          mapPainterIls->render();
+        renderStaticLayersBelowShip();
 
-        if(context.mapLayer->isAirportDiagram())
-        {
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
+        // Ship below other navaids and airports
+        mapPainterShip->render();
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
-        }
-        else
-        {
-          if(!context.isObjectOverflow())
-            mapPainterMsa->render();
+        renderStaticLayers();
+      }
+      nextRenderDynamicOnly = false;
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
+      // Trail, aircraft and marks above all static layers for both cached and direct painting
+      renderDynamicLayers();
 
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
-        }
-      }
+      resetNoAntiAliasFont(&context);
+      context.endTimer("All");
 
-      if(!context.isObjectOverflow())
-        mapPainterUser->render();
+      mapPainterTop->render();
+    } // if(!noRender())
 
-      if(!context.isObjectOverflow())
-        mapPainterWind->render();
+    if(!mapPaintWidget->isPrinting() && mapPaintWidget->isVisibleWidget())
+      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
+      mapcolors::darkenPainterRect(*painter);
+  }
+  return true;
+}
+
+void MapPaintLayer::renderStaticLayersBelowShip()
+{
+  // Altitude below all others
+  mapPainterAltitude->render();
+}
+
+void MapPaintLayer::renderStaticLayers()
+{
+  if(!mapPaintWidget->isDistanceCutOff())
+  {
+    if(!context.isObjectOverflow())
+      mapPainterAirspace->render();
 
-      // if(!context.isOverflow()) always paint route even if number of objects is too large
-      mapPainterRoute->render();
+    if(!context.isObjectOverflow())
+      mapPainterIls->render();
 
+    if(context.mapLayer->isAirportDiagram())
+    {
       if(!context.isObjectOverflow())
-        mapPainterWeather->render();
+        mapPainterAirport->render();
 
-      if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
+      if(!context.isObjectOverflow())
+        mapPainterNav->render();
+    }
+    else
+    {
+      if(!context.isObjectOverflow())
         mapPainterMsa->render();
 
       if(!context.isObjectOverflow())
-        mapPainterTrack->render();
+        mapPainterNav->render();
 
-      mapPainterAircraft->render();
+      if(!context.isObjectOverflow())
+        mapPainterAirport->render();
+    }
+  }
 
-      mapPainterMark->render();
+  if(!context.isObjectOverflow())
+    mapPainterUser->render();
 
-      resetNoAntiAliasFont(&context);
-      context.endTimer("All");
+  if(!context.isObjectOverflow())
+    mapPainterWind->render();
 
-      mapPainterTop->render();
-    } // if(!noRender())
+  // if(!context.isOverflow()) always paint route even if number of objects is too large
+  mapPainterRoute->render();
 
-    if(!mapPaintWidget->isPrinting() && mapPaintWidget->isVisibleWidget())
-      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
-      mapcolors::darkenPainterRect(*painter);
+  if(!context.isObjectOverflow())
+    mapPainterWeather->render();
+
+  if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
+    mapPainterMsa->render();
+}
+
+void MapPaintLayer::renderDynamicLayers()
+{
+  if(!context.isObjectOverflow())
+    mapPainterTrack->render();
+
+  mapPainterAircraft->render();
+
+  mapPainterMark->render();
+}
+
+void MapPaintLayer::renderStaticLayersCached(GeoPainter *painter, ViewportParams *viewport)
+{
+  StaticLayerCacheKey key = staticLayerCacheKey(painter, viewport);
+
+  if(!nextRenderDynamicOnly || !staticLayerCacheValid || staticLayerImage.isNull() || staticLayerImageBelowShip.isNull() ||
+     key != staticLayerKey)
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Updating static layer cache" << "dynamicOnly" << nextRenderDynamicOnly
+               << "valid" << staticLayerCacheValid << "keyChanged" << (key != staticLayerKey);
+
+    // Paint static layers into two images below and above the ship ===================
+    context.startTimer("Static layers");
+    renderStaticLayerImage(staticLayerImageBelowShip, painter, viewport, key, true /* belowShip */);
+    renderStaticLayerImage(staticLayerImage, painter, viewport, key, false /* belowShip */);
+
+    // Remember values which are collected by painters ==================
+    staticRouteDrawnNavaids = *context.routeDrawnNavaids;
+    staticShownDetailAirportIds = shownDetailAirportIds;
+    staticObjectCount = context.objectCount;
+    staticQueryOverflow = context.queryOverflow;
+
+    staticLayerKey = key;
+    staticLayerCacheValid = true;
+    context.endTimer("Static layers");
   }
-  return true;
+  else
+  {
+    // Restore values from last static layer paint ==================
+    *context.routeDrawnNavaids = staticRouteDrawnNavaids;
+    shownDetailAirportIds = staticShownDetailAirportIds;
+    context.objectCount = staticObjectCount;
+    context.queryOverflow = staticQueryOverflow;
+  }
+
+  // Keep the same order as when painting directly
+  painter->drawImage(QPoint(0, 0), staticLayerImageBelowShip);
+
+  // Ship below other navaids and airports
+  mapPainterShip->render();
+
+  painter->drawImage(QPoint(0, 0), staticLayerImage);
+}
+
+void MapPaintLayer::renderStaticLayerImage(QImage& image, GeoPainter *painter, ViewportParams *viewport,
+                                           const StaticLayerCacheKey& key, bool belowShip)
+{
+  // Transparent image having the same resolution as the widget
+  image = QImage(key.size * key.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+  image.setDevicePixelRatio(key.devicePixelRatio);
+  image.fill(Qt::transparent);
+
+  GeoPainter cachePainter(&image, viewport, painter->mapQuality());
+  cachePainter.setFont(painter->font());
+  cachePainter.setRenderHints(painter->renderHints());
+
+  context.painter = &cachePainter;
+  if(belowShip)
+    renderStaticLayersBelowShip();
+  else
+    renderStaticLayers();
+  context.painter = painter;
+}
+
+MapPaintLayer::StaticLayerCacheKey MapPaintLayer::staticLayerCacheKey(const GeoPainter *painter,
+                                                                      const ViewportParams *viewport) const
+{
+  StaticLayerCacheKey key;
+  key.viewBox = viewport->viewLatLonAltBox();
+  key.radius = viewport->radius();
+  key.projection = viewport->projection();
+  key.size = viewport->size();
+  key.devicePixelRatio = painter->device() != nullptr ? painter->device()->devicePixelRatioF() : 1.;
+  key.mapLayer = mapLayer;
+  key.mapLayerRoute = mapLayerRoute;
+  key.mapLayerEffective = mapLayerEffective;
+  key.objectTypes = context.objectTypes;
+  key.objectDisplayTypes = context.objectDisplayTypes;
+  key.airspaceFilter = context.airspaceFilterByLayer;
+  key.weatherSource = context.weatherSource;
+  key.userPointTypes = context.userPointTypes;
+  key.flags = context.flags;
+  key.flags2 = context.flags2;
+  key.minimumRunwayLengthFt = context.mimimumRunwayLengthFt;
+  key.activeLegIndex = context.route->isActiveValid() ? context.route->getActiveLegIndex() : -1;
+  key.darkMap = context.darkMap;
+  key.userPointTypeUnknown = context.userPointTypeUnknown;
+  key.distanceCutOff = mapPaintWidget->isDistanceCutOff();
+  return key;
+}
+
+bool MapPaintLayer::StaticLayerCacheKey::operator==(const StaticLayerCacheKey& other) const
+{
+  return viewBox == other.viewBox && radius == other.radius && projection == other.projection && size == other.size &&
+         atools::almostEqual(devicePixelRatio, other.devicePixelRatio) &&
+         mapLayer == other.mapLayer && mapLayerRoute == other.mapLayerRoute && mapLayerEffective == other.mapLayerEffective &&
+         objectTypes == other.objectTypes && objectDisplayTypes == other.objectDisplayTypes &&
+         airspaceFilter == other.airspaceFilter && weatherSource == other.weatherSource &&
+         userPointTypes == other.userPointTypes && flags == other.flags && flags2 == other.flags2 &&
+         minimumRunwayLengthFt == other.minimumRunwayLengthFt && activeLegIndex == other.activeLegIndex &&
+         darkMap == other.darkMap && userPointTypeUnknown == other.userPointTypeUnknown &&
+         distanceCutOff == other.distanceCutOff;
 }
 
 void MapPaintLayer::setNoAntiAliasFont(PaintContext *context)
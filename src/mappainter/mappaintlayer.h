@@ -20,8 +20,12 @@
 
 #include "mappainter/mappainter.h"
 
+#include <QImage>
 #include <QPen>
 
+#include <marble/GeoDataLatLonAltBox.h>
+#include <marble/MarbleGlobal.h>
+
 #include <marble/LayerInterface.h>
 
 namespace Marble {
@@ -187,7 +191,49 @@ public:
     return shownDetailAirportIds;
   }
 
+  /* Drop the cached image of static layers. Has to be called for all changes that affect static layers
+   * like route, options, database, weather or online network changes. */
+  void invalidateStaticLayerCache()
+  {
+    staticLayerCacheValid = false;
+  }
+
+  /* Marks the next render call as caused by simulator updates only. Static layers are then
+   * taken from the cache if nothing else changed. Flag is reset in render(). */
+  void setNextRenderDynamicOnly()
+  {
+    nextRenderDynamicOnly = true;
+  }
+
 private:
+  /* Key for the static layer image. Image is valid as long as all values are equal */
+  struct StaticLayerCacheKey
+  {
+    Marble::GeoDataLatLonAltBox viewBox;
+    int radius = 0;
+    Marble::Projection projection = Marble::Spherical;
+    QSize size;
+    qreal devicePixelRatio = 1.;
+    const MapLayer *mapLayer = nullptr, *mapLayerRoute = nullptr, *mapLayerEffective = nullptr;
+    map::MapTypes objectTypes = map::NONE;
+    map::MapDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
+    map::MapAirspaceFilter airspaceFilter;
+    map::MapWeatherSource weatherSource = map::WEATHER_SOURCE_SIMULATOR;
+    QStringList userPointTypes;
+    opts::Flags flags;
+    opts2::Flags2 flags2;
+    int minimumRunwayLengthFt = 0, activeLegIndex = -1;
+    bool darkMap = false, userPointTypeUnknown = false, distanceCutOff = false;
+
+    bool operator==(const StaticLayerCacheKey& other) const;
+
+    bool operator!=(const StaticLayerCacheKey& other) const
+    {
+      return !operator==(other);
+    }
+
+  };
+
   void initMapLayerSettings();
 
   /* Implemented from LayerInterface: We  draw above all but below user tools */
@@ -206,6 +252,23 @@ private:
   /* Restore normal font anti-aliasing for default and painter font */
   void resetNoAntiAliasFont(PaintContext *context);
 
+  /* Painters for objects which change only on route, options or database updates.
+   * Split into layers below and above the AI ships which are painted in between. */
+  void renderStaticLayersBelowShip();
+  void renderStaticLayers();
+
+  /* Painters for user and AI aircraft, trail and marks which change with each simulator update */
+  void renderDynamicLayers();
+
+  /* Paint static layers into the cached images if needed and draw the images and the ships into painter */
+  void renderStaticLayersCached(Marble::GeoPainter *painter, Marble::ViewportParams *viewport);
+
+  /* Paint static layers below or above ship into the given image */
+  void renderStaticLayerImage(QImage& image, Marble::GeoPainter *painter, Marble::ViewportParams *viewport,
+                              const StaticLayerCacheKey& key, bool belowShip);
+
+  StaticLayerCacheKey staticLayerCacheKey(const Marble::GeoPainter *painter, const Marble::ViewportParams *viewport) const;
+
   /* Map objects currently shown */
   map::MapTypes objectTypes = map::NONE;
   map::MapDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
@@ -248,6 +311,18 @@ private:
   MapPaintWidget *mapPaintWidget = nullptr;
   const MapLayer *mapLayer = nullptr, *mapLayerRoute = nullptr, *mapLayerEffective = nullptr;
   bool verbose = false, verboseDraw = false;
+
+  /* Offscreen images containing all static layers below and above ships and values needed to check validity */
+  bool staticLayerCacheEnabled = true, staticLayerCacheValid = false, nextRenderDynamicOnly = false;
+  QImage staticLayerImageBelowShip, staticLayerImage;
+  StaticLayerCacheKey staticLayerKey;
+
+  /* Values collected while painting static layers which have to be restored when using the cached image */
+  QVector<map::MapRef> staticRouteDrawnNavaids;
+  QSet<int> staticShownDetailAirportIds;
+  int staticObjectCount = 0;
+  bool staticQueryOverflow = false;
+
   QFont::StyleStrategy savedFontStrategy, savedDefaultFontStrategy;
 
 };
@@ -18,7 +18,6 @@
 #include "online/onlinedatacontroller.h"
 
 #include "fs/online/onlinedatamanager.h"
-#include "airspace/airspacecontroller.h"
 #include "util/httpdownloader.h"
 #include "gui/mainwindow.h"
 #include "common/maptools.h"
@@ -31,13 +30,20 @@
 #include "sql/sqlrecord.h"
 #include "mapgui/maplayer.h"
 #include "app/navapp.h"
+#include "db/dbtools.h"
 #include "settings/settings.h"
 #include "fs/sc/simconnectdata.h"
+#include "query/airspacequery.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqltransaction.h"
+#include "exception.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QMessageBox>
 #include <QTextCodec>
 #include <QCoreApplication>
+#include <QtConcurrent/QtConcurrentRun>
 
 static const int MIN_SERVER_DOWNLOAD_INTERVAL_MIN = 15;
 static const int MIN_TRANSCEIVER_DOWNLOAD_INTERVAL_MIN = 5;
@@ -71,8 +77,11 @@ atools::fs::online::Format convertFormat(opts::OnlineFormat format)
   return atools::fs::online::UNKNOWN;
 }
 
-OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager, MainWindow *parent)
-  : manager(onlineManager), mainWindow(parent), aircraftCache()
+OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager,
+                                           const QString& stagingDatabaseFileParam, const QString& userAirspaceDatabaseFileParam,
+                                           MainWindow *parent)
+  : manager(onlineManager), stagingDatabaseFile(stagingDatabaseFileParam), userAirspaceDatabaseFile(userAirspaceDatabaseFileParam),
+  mainWindow(parent), aircraftCache()
 {
   // Files use Windows code with embedded UTF-8 for ATIS text
   codec = QTextCodec::codecForName("Windows-1252");
@@ -81,6 +90,7 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
 
   atools::settings::Settings& settings = atools::settings::Settings::instance();
   verbose = settings.getAndStoreValue(lnm::OPTIONS_ONLINE_NETWORK_DEBUG, false).toBool();
+  verboseParser = settings.getAndStoreValue(lnm::OPTIONS_WHAZZUP_PARSER_DEBUG, false).toBool();
 
   // Load criteria used to detect shadow aircraft right after download finished
   maxShadowDistanceNm = settings.getAndStoreValue(lnm::OPTIONS_ONLINE_NETWORK_MAX_SHADOW_DIST_NM, 2.0).toFloat();
@@ -102,8 +112,12 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
   // Recurring downloads
   connect(&downloadTimer, &QTimer::timeout, this, &OnlinedataController::startDownloadInternal);
 
-  using namespace std::placeholders;
-  manager->setGeometryCallback(std::bind(&OnlinedataController::airspaceGeometryCallback, this, _1, _2));
+  // Continue download chain once parsing is done
+  connect(&parserWatcher, &QFutureWatcher<OnlineParserResult>::finished, this, &OnlinedataController::parserFinished);
+
+  // Connections are bound to the thread - use always the same one
+  parserThread.setMaxThreadCount(1);
+  parserThread.setExpiryTimeout(-1);
 
 #ifdef DEBUG_ONLINE_DOWNLOAD
   downloader->enableCache(60);
@@ -112,13 +126,22 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
 
 OnlinedataController::~OnlinedataController()
 {
-  manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+  waitForParser();
 
+  // Remove all from the database to avoid confusion on startup
+#ifndef DEBUG_INFORMATION
+  runParserTask([this]() {
+    openParserDatabases();
+    managerStaging->clearData();
+  });
+#endif
+
+  // Closes staging connections in the parser thread
   deInitQueries();
+  parserThread.waitForDone();
 
   delete downloader;
 
-  // Remove all from the database to avoid confusion on startup
 #ifndef DEBUG_INFORMATION
   manager->clearData();
 #endif
@@ -166,6 +189,9 @@ void OnlinedataController::updateAtcSizes()
     sizeMap.insert(type, diameter != -1 ? std::max(1, diameter / 2) : -1);
   }
   manager->setAtcSize(sizeMap);
+
+  // Passed to the staging manager in the parser thread
+  parserAtcSizes = sizeMap;
 }
 
 void OnlinedataController::startProcessing()
@@ -313,45 +339,238 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
       lastUpdateTime = now;
     }
   }
-  else if(currentState == DOWNLOADING_TRANSCEIVERS)
+  else if(currentState == DOWNLOADING_TRANSCEIVERS || currentState == DOWNLOADING_WHAZZUP ||
+          currentState == DOWNLOADING_WHAZZUP_SERVERS)
+    // Uncompress and parse in background - chain is continued in parserFinished()
+    startParser(data);
+}
+
+void OnlinedataController::startParser(const QByteArray& data)
+{
+  waitForParser();
+
+  // Copy all options needed in the thread
+  const OptionData& od = OptionData::instance();
+  opts2::Flags2 flags2 = od.getFlags2();
+  parserAirspaceByName = flags2.testFlag(opts2::ONLINE_AIRSPACE_BY_NAME);
+  parserAirspaceByFile = flags2.testFlag(opts2::ONLINE_AIRSPACE_BY_FILE);
+  parserFormat = convertFormat(od.getOnlineFormat());
+  parserState = currentState;
+
+  State state = parserState;
+  atools::fs::online::Format format = parserFormat;
+  parserWatcher.setFuture(QtConcurrent::run(&parserThread, [this, state, data, format]() -> OnlineParserResult {
+    return parseData(state, data, format);
+  }));
+}
+
+OnlineParserResult OnlinedataController::parseData(OnlinedataController::State state, const QByteArray& data,
+                                                   atools::fs::online::Format format)
+{
+  QElapsedTimer timer;
+  timer.start();
+  OnlineParserResult parserResult;
+  bool& retval = parserResult.result;
+
+  try
   {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "DOWNLOADING_TRANSCEIVERS";
+    // Connections are opened on first use in this thread
+    openParserDatabases();
+    managerStaging->setAtcSize(parserAtcSizes);
 
-    QString tranceiversTxt = uncompress(data, Q_FUNC_INFO, true /* utf8 */);
+    if(state == DOWNLOADING_TRANSCEIVERS)
+    {
+      // transceivers.json downloaded ============================================
+      QString tranceiversTxt = uncompress(data, Q_FUNC_INFO, true /* utf8 */);
 
 #ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", tranceiversTxt);
+      atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", tranceiversTxt);
 #endif
-    // transceivers.json downloaded ============================================
-    manager->readFromTransceivers(tranceiversTxt);
+      managerStaging->readFromTransceivers(tranceiversTxt);
+      retval = true;
+    }
+    else if(state == DOWNLOADING_WHAZZUP)
+    {
+      // whazzup.txt or JSON downloaded ============================================
+      bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+      QString whazzupTxt = uncompress(data, Q_FUNC_INFO, json /* utf8 */);
 
-    // Next in chain after transceivers is JSON
-    currentState = DOWNLOADING_WHAZZUP;
-    lastUpdateTimeTransceivers = now;
-    downloader->setUrl(whazzupUrlFromStatus);
-    startDownloader();
+#ifdef DEBUG_INFORMATION_ONLINE
+      atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (json ? "json" : "txt"), whazzupTxt);
+#endif
+      retval = managerStaging->readFromWhazzup(whazzupTxt, format, managerStaging->getLastUpdateTimeFromWhazzup());
+
+      // Copy values needed in the GUI thread after publishing the data
+      parserResult.lastUpdateTimeWhazzup = managerStaging->getLastUpdateTimeFromWhazzup();
+      parserResult.reloadMinutesWhazzup = managerStaging->getReloadMinutesFromWhazzup();
+      for(const atools::fs::online::OnlineAircraft& aircraft : managerStaging->getClientCallsignAndPosMap())
+        parserResult.aircraft.append(aircraft);
+    }
+    else if(state == DOWNLOADING_WHAZZUP_SERVERS)
+    {
+      // servers.txt downloaded ============================================
+      QString serversTxt = uncompress(data, Q_FUNC_INFO, false /* utf8 */);
+
+#ifdef DEBUG_INFORMATION_ONLINE
+      QString suffix;
+      switch(format)
+      {
+        case atools::fs::online::UNKNOWN:
+        case atools::fs::online::VATSIM:
+        case atools::fs::online::IVAO:
+          suffix = "txt";
+          break;
+
+        case atools::fs::online::VATSIM_JSON3:
+        case atools::fs::online::IVAO_JSON2:
+          suffix = "json";
+          break;
+      }
+      atools::strToFile(QDir::tempPath() + "/lnm_servers." + suffix, serversTxt);
+#endif
+      managerStaging->readServersFromWhazzup(serversTxt, format, managerStaging->getLastUpdateTimeFromWhazzup());
+      retval = true;
+    }
   }
-  else if(currentState == DOWNLOADING_WHAZZUP)
+  catch(atools::Exception& e)
   {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "DOWNLOADING_WHAZZUP";
+    qWarning() << Q_FUNC_INFO << "Error parsing online data" << e.what();
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Unknown error parsing online data";
+  }
 
-    // whazzup.txt or JSON downloaded ============================================
-    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << stateAsStr(state) << "data size" << data.size() << "result" << retval
+             << "in" << timer.elapsed() << "ms";
 
-    // Contains servers and does not need an extra download
-    bool vatsimJson = format == atools::fs::online::VATSIM_JSON3;
-    bool ivaoJson = format == atools::fs::online::IVAO_JSON2;
+  return parserResult;
+}
 
-    QString whazzupTxt = uncompress(data, Q_FUNC_INFO, ivaoJson || vatsimJson /* utf8 */);
+void OnlinedataController::waitForParser()
+{
+  parserWatcher.waitForFinished();
+}
 
-#ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (ivaoJson || vatsimJson ? "json" : "txt"), whazzupTxt);
-#endif
+void OnlinedataController::runParserTask(const std::function<void()>& func)
+{
+  QtConcurrent::run(&parserThread, [func]() {
+    try
+    {
+      func();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Error in online parser task" << e.what();
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "Unknown error in online parser task";
+    }
+  }).waitForFinished();
+}
+
+static void closeParserDatabase(atools::sql::SqlDatabase *& db, const QString& name)
+{
+  if(db != nullptr)
+  {
+    dbtools::closeDatabaseFile(db);
+    delete db;
+    db = nullptr;
+    atools::sql::SqlDatabase::removeDatabase(name);
+  }
+}
+
+void OnlinedataController::openParserDatabases()
+{
+  if(managerStaging != nullptr)
+    return;
 
-    if(manager->readFromWhazzup(whazzupTxt, format, manager->getLastUpdateTimeFromWhazzup()))
+  using atools::sql::SqlDatabase;
+  try
+  {
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, dbtools::DATABASE_NAME_ONLINE_STAGING);
+    databaseStaging = new SqlDatabase(dbtools::DATABASE_NAME_ONLINE_STAGING);
+    dbtools::openDatabaseFileExt(databaseStaging, stagingDatabaseFile, false /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+
+    // Center geometry is looked up in the user airspaces
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, dbtools::DATABASE_NAME_ONLINE_AIRSPACE);
+    databaseUserAirspace = new SqlDatabase(dbtools::DATABASE_NAME_ONLINE_AIRSPACE);
+    dbtools::openDatabaseFileExt(databaseUserAirspace, userAirspaceDatabaseFile, true /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+
+    airspaceQueryStaging = new AirspaceQuery(databaseUserAirspace, map::AIRSPACE_SRC_USER);
+    airspaceQueryStaging->initQueries();
+
+    managerStaging = new atools::fs::online::OnlinedataManager(databaseStaging, verboseParser);
+    managerStaging->createSchema();
+    managerStaging->initQueries();
+
+    using namespace std::placeholders;
+    managerStaging->setGeometryCallback(std::bind(&OnlinedataController::airspaceGeometryCallback, this, _1, _2));
+  }
+  catch(...)
+  {
+    closeParserDatabases();
+    throw;
+  }
+}
+
+void OnlinedataController::closeParserDatabases()
+{
+  if(managerStaging != nullptr)
+    managerStaging->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+
+  delete managerStaging;
+  managerStaging = nullptr;
+
+  delete airspaceQueryStaging;
+  airspaceQueryStaging = nullptr;
+
+  closeParserDatabase(databaseStaging, dbtools::DATABASE_NAME_ONLINE_STAGING);
+  closeParserDatabase(databaseUserAirspace, dbtools::DATABASE_NAME_ONLINE_AIRSPACE);
+}
+
+void OnlinedataController::parserFinished()
+{
+  // Download chain was stopped or restarted while parsing
+  if(currentState == NONE || currentState != parserState)
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Ignoring result for" << stateAsStr(parserState);
+    return;
+  }
+
+  OnlineParserResult parserResult = parserWatcher.result();
+  bool result = parserResult.result;
+  const QDateTime now = QDateTime::currentDateTime();
+
+  if(parserState == DOWNLOADING_WHAZZUP && result)
+  {
+    // Copy values from staging manager which are needed for the timer and the shadow index
+    lastUpdateTimeWhazzup = parserResult.lastUpdateTimeWhazzup;
+    reloadMinutesWhazzup = parserResult.reloadMinutesWhazzup;
+    whazzupAircraft = parserResult.aircraft;
+  }
+
+  if(parserState == DOWNLOADING_TRANSCEIVERS)
+  {
+    // Next in chain after transceivers is JSON
+    currentState = DOWNLOADING_WHAZZUP;
+    lastUpdateTimeTransceivers = now;
+    downloader->setUrl(whazzupUrlFromStatus);
+    startDownloader();
+  }
+  else if(parserState == DOWNLOADING_WHAZZUP)
+  {
+    if(result)
     {
+      // Contains servers and does not need an extra download
+      bool vatsimJson = parserFormat == atools::fs::online::VATSIM_JSON3;
+      bool ivaoJson = parserFormat == atools::fs::online::IVAO_JSON2;
+
       QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
       if(!vatsimJson && !ivaoJson && !whazzupVoiceUrlFromStatus.isEmpty() &&
          lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
@@ -368,9 +587,8 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
         currentState = NONE;
         lastUpdateTime = now;
 
-        // Clear map display cache and update spatial index to match simulator shadow aircraft
-        aircraftCache.clear();
-        updateShadowIndex();
+        // Publish new data, clear map display cache and update spatial index to match simulator shadow aircraft
+        copyStagingData();
 
         // Message for search tabs, map widget and info
         emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
@@ -389,33 +607,8 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
       lastUpdateTime = now;
     }
   }
-  else if(currentState == DOWNLOADING_WHAZZUP_SERVERS)
+  else if(parserState == DOWNLOADING_WHAZZUP_SERVERS)
   {
-    if(verbose)
-      qDebug() << Q_FUNC_INFO << "DOWNLOADING_WHAZZUP_SERVERS";
-
-    QString serversTxt = uncompress(data, Q_FUNC_INFO, false /* utf8 */);
-    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
-
-#ifdef DEBUG_INFORMATION_ONLINE
-    QString suffix;
-    switch(format)
-    {
-      case atools::fs::online::UNKNOWN:
-      case atools::fs::online::VATSIM:
-      case atools::fs::online::IVAO:
-        suffix = "txt";
-        break;
-
-      case atools::fs::online::VATSIM_JSON3:
-      case atools::fs::online::IVAO_JSON2:
-        suffix = "json";
-        break;
-    }
-    atools::strToFile(QDir::tempPath() + "/lnm_servers." + suffix, serversTxt);
-#endif
-
-    manager->readServersFromWhazzup(serversTxt, format, manager->getLastUpdateTimeFromWhazzup());
     lastServerDownload = now;
 
     // Done after downloading server.txt - start timer for next session
@@ -423,6 +616,9 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
     currentState = NONE;
     lastUpdateTime = now;
 
+    // Publish whazzup and server data
+    copyStagingData();
+
     // Message for search tabs, map widget and info
     emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
     emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
@@ -430,6 +626,49 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
   }
 }
 
+void OnlinedataController::copyStagingData()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  try
+  {
+    // Staging database is attached as "staging" to the online database connection
+    atools::sql::SqlDatabase *db = manager->getDatabase();
+    atools::sql::SqlQuery tableQuery(db);
+    tableQuery.exec("select name from staging.sqlite_master where type = 'table' and name not like 'sqlite_%'");
+    QStringList tables;
+    while(tableQuery.next())
+      tables.append(tableQuery.valueStr("name"));
+    tableQuery.finish();
+
+    // Readers see either the old or the new data
+    atools::sql::SqlTransaction transaction(db);
+    atools::sql::SqlQuery query(db);
+    for(const QString& table : qAsConst(tables))
+    {
+      query.exec("delete from " + table);
+      query.exec("insert into " + table + " select * from staging." + table);
+    }
+    transaction.commit();
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Error copying online data" << e.what();
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Unknown error copying online data";
+  }
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "in" << timer.elapsed() << "ms";
+
+  // Clear map display cache and update spatial index to match simulator shadow aircraft
+  aircraftCache.clear();
+  updateShadowIndex();
+}
+
 void OnlinedataController::startDownloader()
 {
   if(verbose)
@@ -485,6 +724,7 @@ void OnlinedataController::statusBarMessage()
 void OnlinedataController::stopAllProcesses()
 {
   downloader->cancelDownload();
+  waitForParser();
   downloadTimer.stop();
   currentState = NONE;
   // clientCallsignAndPosMap.clear(); // Do not clear these until the download is finished
@@ -498,19 +738,17 @@ void OnlinedataController::showMessageDialog()
 
 const LineString *OnlinedataController::airspaceGeometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type)
 {
-  opts2::Flags2 flags2 = OptionData::instance().getFlags2();
-
   const LineString *lineString = nullptr;
 
   // Try to get airspace boundary by name vs. callsign if set in options
-  if(flags2 & opts2::ONLINE_AIRSPACE_BY_NAME)
-    lineString = NavApp::getAirspaceController()->getOnlineAirspaceGeoByName(callsign, atools::fs::online::facilityTypeToDb(type));
+  if(parserAirspaceByName)
+    lineString = airspaceQueryStaging->getAirspaceGeometryByName(callsign, atools::fs::online::facilityTypeToDb(type));
 
   // Try to get airspace boundary by file name vs. callsign if set in options
-  if(flags2 & opts2::ONLINE_AIRSPACE_BY_FILE)
+  if(parserAirspaceByFile)
   {
     if(lineString == nullptr)
-      lineString = NavApp::getAirspaceController()->getOnlineAirspaceGeoByFile(callsign);
+      lineString = airspaceQueryStaging->getAirspaceGeometryByFile(callsign);
   }
 
   return lineString;
@@ -520,13 +758,23 @@ void OnlinedataController::optionsChanged()
 {
   qDebug() << Q_FUNC_INFO;
 
+  // Parser thread is finished after this
+  stopAllProcesses();
+
   // Clear all URL from status.txt too
   manager->resetForNewOptions();
-  stopAllProcesses();
+  runParserTask([this]() {
+    openParserDatabases();
+    managerStaging->resetForNewOptions();
+    managerStaging->clearData();
+  });
 
   // Remove all from the database
   manager->clearData();
   aircraftCache.clear();
+  lastUpdateTimeWhazzup = QDateTime();
+  reloadMinutesWhazzup = 0;
+  whazzupAircraft.clear();
   onlineAircraftSpatialIndex.clear();
   aircraftIdSimToOnline.clear();
   aircraftIdOnlineToSim.clear();
@@ -547,6 +795,10 @@ void OnlinedataController::optionsChanged()
 
 void OnlinedataController::userAirspacesUpdated()
 {
+  // Drop cached geometry in the parser airspace query - reopened by the next parser run
+  stopAllProcesses();
+  runParserTask(std::bind(&OnlinedataController::closeParserDatabases, this));
+
   optionsChanged();
 }
 
@@ -808,7 +1060,6 @@ void OnlinedataController::updateShadowIndex()
 
   if(OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW) && !currentDataPacketMap.isEmpty())
   {
-    const QDateTime lastUpdateTimeWhazzup = manager->getLastUpdateTimeFromWhazzup();
     const auto upper = currentDataPacketMap.upperBound(lastUpdateTimeWhazzup);
     const auto lower = currentDataPacketMap.lowerBound(lastUpdateTimeWhazzup);
     QMap<QDateTime, atools::fs::sc::SimConnectData>::iterator entry = currentDataPacketMap.end();
@@ -853,7 +1104,7 @@ void OnlinedataController::updateShadowIndex()
       if(currentDataPacket.isUserAircraftValid())
       {
         // Fill and update spatial index =================================
-        onlineAircraftSpatialIndex.append(manager->getClientCallsignAndPosMap());
+        onlineAircraftSpatialIndex.append(whazzupAircraft);
         onlineAircraftSpatialIndex.updateIndex();
 
         const atools::fs::sc::SimConnectUserAircraft& simUserAircraft = currentDataPacket.getUserAircraftConst();
@@ -937,6 +1188,7 @@ void OnlinedataController::initQueries()
 {
   deInitQueries();
 
+  // Parser connections and queries are opened lazily in the parser thread
   manager->initQueries();
 
   aircraftByRectQuery = new atools::sql::SqlQuery(getDatabase());
@@ -949,6 +1201,10 @@ void OnlinedataController::deInitQueries()
 
   manager->deInitQueries();
 
+  // Close parser connections in the thread which opened them
+  waitForParser();
+  runParserTask(std::bind(&OnlinedataController::closeParserDatabases, this));
+
   delete aircraftByRectQuery;
   aircraftByRectQuery = nullptr;
 }
@@ -976,7 +1232,7 @@ void OnlinedataController::startDownloadTimer()
     if(intervalSeconds == -1)
     {
       // Use time from whazzup.txt - mode auto
-      intervalSeconds = std::max(manager->getReloadMinutesFromWhazzup() * 60, 60);
+      intervalSeconds = std::max(reloadMinutesWhazzup * 60, 60);
       source = "whazzup";
     }
     else
@@ -23,9 +23,14 @@
 #include "query/querytypes.h"
 
 #include <QDateTime>
+#include <QFutureWatcher>
 #include <QObject>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <functional>
+
+class AirspaceQuery;
 class MapLayer;
 
 namespace Marble {
@@ -63,9 +68,30 @@ struct MapResult;
 class MainWindow;
 class QTextCodec;
 
+/* Result of the parser thread including values copied from the staging database manager in the thread */
+struct OnlineParserResult
+{
+  /* false if whazzup is not recent or on error */
+  bool result = false;
+
+  QDateTime lastUpdateTimeWhazzup;
+  int reloadMinutesWhazzup = 0;
+
+  /* All online aircraft for the spatial index used to detect shadow aircraft */
+  QVector<atools::fs::online::OnlineAircraft> aircraft;
+};
+
 /*
  * Manages recurring download of online network data from the status.txt and whazzup.txt files.
  * Uses options to determine how to download data.
+ *
+ * Transceivers, whazzup and server files are uncompressed and parsed in a background thread into a staging
+ * database. The tables are copied from the staging database into the online database in one transaction
+ * once the download chain is finished. Only the small status.txt is read in the GUI thread.
+ *
+ * The parser uses a single thread which owns the connections to the staging and the user airspace databases.
+ * These are opened lazily in the thread and closed there by deInitQueries(). Values needed by the GUI thread
+ * are copied from the staging database manager into the parser result.
  */
 class OnlinedataController :
   public QObject
@@ -73,7 +99,13 @@ class OnlinedataController :
   Q_OBJECT
 
 public:
-  explicit OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager, MainWindow *parent);
+  /*
+   * @param onlineManager Manager for the online database used by the GUI
+   * @param stagingDatabaseFile Staging database file which is filled in the parser thread
+   * @param userAirspaceDatabaseFile User airspace database file used to look up center geometry in the thread
+   */
+  explicit OnlinedataController(atools::fs::online::OnlinedataManager *onlineManager, const QString& stagingDatabaseFile,
+                                const QString& userAirspaceDatabaseFile, MainWindow *parent);
   virtual ~OnlinedataController() override;
 
   OnlinedataController(const OnlinedataController& other) = delete;
@@ -123,10 +155,10 @@ public:
   /* Get client record with all field values */
   atools::sql::SqlRecord getClientRecordById(int clientId);
 
-  /* Close all query objects thus disconnecting from the database */
+  /* Create and prepare all queries */
   void initQueries();
 
-  /* Create and prepare all queries */
+  /* Close all query objects thus disconnecting from the database. Waits for the parser and closes its connections. */
   void deInitQueries();
 
   /* Get number of online clients/aircraft */
@@ -174,9 +206,31 @@ private:
   QString uncompress(const QByteArray& data, const QString& func, bool utf8);
   void startDownloader();
 
-  /* Tries to fetch geometry for atc centers from the user geometry database from cache */
+  /* Tries to fetch geometry for atc centers from the user geometry database from cache. Called in the parser thread. */
   const atools::geo::LineString *airspaceGeometryCallback(const QString& callsign, atools::fs::online::fac::FacilityType type);
 
+  /* Parse downloaded data for the current state in a background thread into the staging database */
+  void startParser(const QByteArray& data);
+
+  /* Called by watcher in the GUI thread. Continues the download chain. */
+  void parserFinished();
+
+  /* Wait for parser thread. Result is ignored if the download chain was stopped. */
+  void waitForParser();
+
+  /* Run function in the parser thread and wait for it. Parser has to be finished before. */
+  void runParserTask(const std::function<void()>& func);
+
+  /* Open staging and user airspace databases and create queries if not already done. Called in the parser thread. */
+  void openParserDatabases();
+
+  /* Delete queries and close connections. Called in the parser thread. */
+  void closeParserDatabases();
+
+  /* Copy all tables from the staging database into the online database in one transaction
+   * and update caches and indexes */
+  void copyStagingData();
+
   /* Called after each download */
   void updateShadowIndex();
   void clearShadowIndexes();
@@ -184,9 +238,21 @@ private:
   /* Return online aircraft for simulator aircraft based on distance and other parameter similarity */
   atools::fs::online::OnlineAircraft shadowAircraftInternal(const atools::fs::sc::SimConnectAircraft& simAircraft);
 
-  /* Database manager */
+  /* Database manager for the GUI */
   atools::fs::online::OnlinedataManager *manager;
 
+  /* Created, used and deleted in the parser thread only. Staging manager and query to look up center geometry. */
+  atools::sql::SqlDatabase *databaseStaging = nullptr, *databaseUserAirspace = nullptr;
+  atools::fs::online::OnlinedataManager *managerStaging = nullptr;
+  AirspaceQuery *airspaceQueryStaging = nullptr;
+  QString stagingDatabaseFile, userAirspaceDatabaseFile;
+
+  /* Single thread which is kept alive so that the connections opened by it can be reused */
+  QThreadPool parserThread;
+
+  /* Running while data is parsed into the staging database */
+  QFutureWatcher<OnlineParserResult> parserWatcher;
+
   /* Downloader for all files */
   atools::util::HttpDownloader *downloader;
 
@@ -205,11 +271,25 @@ private:
 
   QString stateAsStr(OnlinedataController::State state);
 
+  /* Runs in background thread. Result is false if whazzup is not recent or on error. */
+  OnlineParserResult parseData(OnlinedataController::State state, const QByteArray& data, atools::fs::online::Format format);
+
   // Criteria used to detect shadow aircraft right after download finished
   float maxShadowDistanceNm = 0.5f, maxShadowAltDiffFt = 500.f, maxShadowGsDiffKts = 30.f, maxShadowHdgDiffDeg = 20.f;
 
   State currentState = NONE;
 
+  /* Download state, format and options the parser thread was started for */
+  State parserState = NONE;
+  atools::fs::online::Format parserFormat = atools::fs::online::UNKNOWN;
+  bool parserAirspaceByName = false, parserAirspaceByFile = false;
+  QHash<atools::fs::online::fac::FacilityType, int> parserAtcSizes;
+
+  /* Copied from the last parser result of a whazzup file in the GUI thread */
+  QDateTime lastUpdateTimeWhazzup;
+  int reloadMinutesWhazzup = 0;
+  QVector<atools::fs::online::OnlineAircraft> whazzupAircraft;
+
   QTimer downloadTimer; /* Triggers recurring downloads OnlinedataController::startDownloadInternal */
 
   /* Used to check server downloads and limit them to 15 minutes */
@@ -225,7 +305,7 @@ private:
 
   QTextCodec *codec = nullptr;
 
-  bool verbose = false;
+  bool verbose = false, verboseParser = false;
 
   // All online aircraft from download for spatial search (nearest)
   atools::geo::SpatialIndex<atools::fs::online::OnlineAircraft> onlineAircraftSpatialIndex;
@@ -46,6 +46,8 @@
 
 #include <QPainter>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentMap>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QStringBuilder>
 
@@ -75,6 +77,9 @@ static const float ELEVATION_SAMPLE_RADIUS_NM = 0.1f;
 /* Do not calculate a profile for legs longer than this value */
 static const int ELEVATION_MAX_LEG_NM = 2000;
 
+/* Maximum number of elevation points in the leg cache */
+static const int ELEVATION_CACHE_MAX_POINTS = 1000000;
+
 /* Zoom to aircraft + 100 NM or to aircraft to destination */
 static const float ZOOM_DESTINATION_MAX_AHEAD = 100.f;
 
@@ -178,6 +183,7 @@ ProfileWidget::ProfileWidget(QWidget *parent)
 
   profileOptions = new ProfileOptions(this);
   legList = new ElevationLegList;
+  elevationCache.setMaxCost(ELEVATION_CACHE_MAX_POINTS);
 
   scrollArea = new ProfileScrollArea(this, ui->scrollAreaProfile);
   scrollArea->setProfileLeftOffset(left);
@@ -185,6 +191,10 @@ ProfileWidget::ProfileWidget(QWidget *parent)
 
   jumpBack = new JumpBack(this, atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROFILE_JUMP_BACK_DEBUG,
                                                                                         false).toBool());
+  parallelElevation = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROFILE_PARALLEL_ELEVATION,
+                                                                              true).toBool();
+  verboseElevation = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROFILE_ELEVATION_DEBUG,
+                                                                             false).toBool();
   connect(jumpBack, &JumpBack::jumpBack, this, &ProfileWidget::jumpBackToAircraftTimeout);
 
   connect(scrollArea, &ProfileScrollArea::showPosAlongFlightplan, this, &ProfileWidget::showPosAlongFlightplan);
@@ -1839,6 +1849,9 @@ QStringList ProfileWidget::textsAndColorForLeg(QColor& color, bool& procSymbol,
 /* Update signal from Marble elevation model */
 void ProfileWidget::elevationUpdateAvailable()
 {
+  // Cached elevations are outdated only if the source has changed - Marble updates are not cached
+  updateElevationSource();
+
   if(databaseLoadStatus)
     return;
 
@@ -1954,8 +1967,13 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
 
   if(elevationProvider->isValid())
   {
+    float sampleRadiusMeter = atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM);
+
     for(int i = 0; i < geometry.size() - 1; i++)
     {
+      if(terminateThreadSignal)
+        return false;
+
       // Create a line string from the two points and split it at the date line if crossing
       GeoDataLineString coords;
       coords.setTessellate(true);
@@ -1968,7 +1986,10 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
         for(int j = 1; j < ls->size(); j++)
         {
           if(terminateThreadSignal)
+          {
+            qDeleteAll(coordsCorrected);
             return false;
+          }
 
           const Marble::GeoDataCoordinates& c1 = ls->at(j - 1);
           const Marble::GeoDataCoordinates& c2 = ls->at(j);
@@ -1977,7 +1998,7 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
 
           p1.toDeg();
           p2.toDeg();
-          elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2), atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM));
+          elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2), sampleRadiusMeter);
         }
       }
       qDeleteAll(coordsCorrected);
@@ -2004,6 +2025,64 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
   return true;
 }
 
+bool ProfileWidget::fetchLegElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const
+{
+  QByteArray cacheKey = elevationCacheKey(geometry);
+  {
+    // Reuse elevations for unchanged leg
+    QMutexLocker locker(&elevationCacheMutex);
+    const LineString *cachedElevations = elevationCache.object(cacheKey);
+    if(cachedElevations != nullptr)
+    {
+      elevations = *cachedElevations;
+      return true;
+    }
+  }
+
+  if(!fetchRouteElevations(elevations, geometry))
+    return false;
+
+  // Cache only complete offline data - Marble online data might be incomplete and is updated later
+  if(NavApp::isGlobeOfflineProvider() && !elevations.isEmpty())
+  {
+    QMutexLocker locker(&elevationCacheMutex);
+    elevationCache.insert(cacheKey, new LineString(elevations), elevations.size());
+  }
+  return true;
+}
+
+QByteArray ProfileWidget::elevationCacheKey(const atools::geo::LineString& geometry) const
+{
+  // Use raw coordinate values to get an exact match
+  QByteArray key;
+  key.reserve(static_cast<int>(sizeof(float)) * (geometry.size() * 2 + 1) + 1);
+  key.append(NavApp::isGlobeOfflineProvider() ? 'G' : 'M');
+  key.append(reinterpret_cast<const char *>(&ELEVATION_SAMPLE_RADIUS_NM), sizeof(float));
+  for(const Pos& pos : geometry)
+  {
+    float lonX = pos.getLonX(), latY = pos.getLatY();
+    key.append(reinterpret_cast<const char *>(&lonX), sizeof(float));
+    key.append(reinterpret_cast<const char *>(&latY), sizeof(float));
+  }
+  return key;
+}
+
+void ProfileWidget::clearElevationCache()
+{
+  QMutexLocker locker(&elevationCacheMutex);
+  elevationCache.clear();
+}
+
+void ProfileWidget::updateElevationSource()
+{
+  QString source = NavApp::isGlobeOfflineProvider() ? OptionData::instance().getOfflineElevationPath() : QString();
+  if(source != elevationSource)
+  {
+    elevationSource = source;
+    clearElevationCache();
+  }
+}
+
 /* Background thread. Fetches elevation points from Marble elevation model and updates totals. */
 ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs) const
 {
@@ -2027,19 +2106,82 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     // Return empty result
     return ElevationLegList();
 
+  QElapsedTimer timer;
+  timer.start();
+
+  // Collect geometry for all legs up to destination ===========================================
+  // Elevations are in meter after sampling and are independent of other legs
+  struct LegSample
+  {
+    LineString geometry, elevations;
+    bool skipped = false, /* Too long for online provider */
+         failed = false; /* Aborted or no result */
+  };
+
+  bool globe = NavApp::isGlobeOfflineProvider();
+  QVector<LegSample> samples;
+  for(int i = 1; i <= legs.route.getDestinationLegIndex(); i++)
+  {
+    const RouteAltitudeLeg& altLeg = legs.route.getAltitudeLegAt(i);
+    if(altLeg.isMissed() || altLeg.isAlternate())
+      break;
+
+    LegSample sample;
+
+    // Skip for too long segments when using the marble online provider
+    if(altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || globe)
+    {
+      sample.geometry = altLeg.getGeoLineString();
+      sample.geometry.removeInvalid();
+      if(sample.geometry.size() == 1)
+        sample.geometry.append(sample.geometry.constFirst());
+    }
+    else
+      sample.skipped = true;
+    samples.append(sample);
+  }
+
+  // Sample elevations for each leg ===========================================
+  auto sampleLeg = [this](LegSample& sample) -> void
+  {
+    if(!sample.skipped)
+    {
+      if(terminateThreadSignal || !fetchLegElevations(sample.elevations, sample.geometry) || sample.elevations.isEmpty())
+        sample.failed = true;
+    }
+  };
+
+  // The Marble elevation model is locked and cannot benefit from more threads
+  if(parallelElevation && globe && samples.size() > 1)
+    // Calling thread takes part in the work too
+    QtConcurrent::blockingMap(samples, sampleLeg);
+  else
+  {
+    for(LegSample& sample : samples)
+    {
+      sampleLeg(sample);
+      if(sample.failed)
+        break;
+    }
+  }
+
+  if(terminateThreadSignal)
+    // Return empty result
+    return ElevationLegList();
+
+  // Stitch legs together in order and calculate distances ===========================================
   // Total calculated distance across all legs
   double totalDistanceNm = 0.;
 
   // Loop over all route legs - first is departure airport point
-  for(int i = 1; i <= legs.route.getDestinationLegIndex(); i++)
+  for(int i = 0; i < samples.size(); i++)
   {
     if(terminateThreadSignal)
       // Return empty result
       return ElevationLegList();
 
-    const RouteAltitudeLeg& altLeg = legs.route.getAltitudeLegAt(i);
-    if(altLeg.isMissed() || altLeg.isAlternate())
-      break;
+    const RouteAltitudeLeg& altLeg = legs.route.getAltitudeLegAt(i + 1);
+    LegSample& sample = samples[i];
 
     ElevationLeg leg;
     leg.ident = altLeg.getIdent();
@@ -2047,38 +2189,26 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     // Used to adapt distances of all legs to total distance due to inaccuracies
     double scale = 1.;
 
-    // Skip for too long segments when using the marble online provider
-    if(altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::isGlobeOfflineProvider())
+    if(!sample.skipped)
     {
-      LineString geometry = altLeg.getGeoLineString();
-
-      geometry.removeInvalid();
-      if(geometry.size() == 1)
-        geometry.append(geometry.constFirst());
-
-      // Includes first and last point
-      LineString elevations;
-      if(!fetchRouteElevations(elevations, geometry))
+      if(sample.failed)
         return ElevationLegList();
 
-      if(elevations.isEmpty())
-        return ElevationLegList();
+      // Includes first and last point
+      LineString& elevations = sample.elevations;
 
       // elevations.removeDuplicates();
 #ifdef DEBUG_INFORMATION_PROFILE
       qDebug() << Q_FUNC_INFO << "elevations" << elevations << atools::geo::meterToNm(elevations.lengthMeter());
-      qDebug() << Q_FUNC_INFO << "geometry" << geometry << atools::geo::meterToNm(geometry.lengthMeter());
+      qDebug() << Q_FUNC_INFO << "geometry" << sample.geometry << atools::geo::meterToNm(sample.geometry.lengthMeter());
 #endif
-      leg.geometry = geometry;
+      leg.geometry = sample.geometry;
 
       double distNm = totalDistanceNm;
       // Loop over all elevation points for the current leg
       Pos lastPos;
       for(int j = 0; j < elevations.size(); j++)
       {
-        if(terminateThreadSignal)
-          return ElevationLegList();
-
         Pos& coord = elevations[j];
         float altFeet = meterToFeet(coord.getAltitude());
         coord.setAltitude(altFeet);
@@ -2141,6 +2271,10 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
   }
 
   legs.totalDistance = static_cast<float>(totalDistanceNm);
+
+  if(verboseElevation)
+    qDebug() << Q_FUNC_INFO << "legs" << samples.size() << "points" << legs.totalNumPoints
+             << "parallel" << (parallelElevation && globe) << "time" << timer.elapsed() << "ms";
   return legs;
 }
 
@@ -2710,6 +2844,9 @@ void ProfileWidget::postDatabaseLoad()
 
 void ProfileWidget::optionsChanged()
 {
+  // Elevation source might have changed
+  updateElevationSource();
+
   jumpBack->cancel();
   scrollArea->optionsChanged();
 
@@ -20,9 +20,13 @@
 
 #include "fs/sc/simconnectdata.h"
 
+#include <QCache>
 #include <QFutureWatcher>
+#include <QMutex>
 #include <QWidget>
 
+#include <atomic>
+
 namespace atools {
 namespace geo {
 class LineString;
@@ -210,6 +214,20 @@ private:
 
   bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
   ElevationLegList fetchRouteElevationsThread(ElevationLegList legs) const;
+
+  /* Get elevations in meter for a leg geometry from elevationCache or provider. Thread safe.
+   * @return false if aborted */
+  bool fetchLegElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
+
+  /* Key for elevationCache built from leg geometry, sample radius and elevation source */
+  QByteArray elevationCacheKey(const atools::geo::LineString& geometry) const;
+
+  /* Remove all entries from elevationCache. Thread safe. */
+  void clearElevationCache();
+
+  /* Clear elevationCache only if the elevation source like offline data directory has changed */
+  void updateElevationSource();
+
   void elevationUpdateAvailable();
   void updateTimeout();
   void updateThreadFinished();
@@ -305,7 +323,23 @@ private:
   QFuture<ElevationLegList> future;
   /* Sends signal once thread is finished */
   QFutureWatcher<ElevationLegList> watcher;
-  bool terminateThreadSignal = false;
+  /* Set in GUI thread and polled by the elevation threads */
+  std::atomic<bool> terminateThreadSignal{false};
+
+  /* Elevation points in meter for each leg geometry. Allows to reuse results for unchanged legs when editing
+   * the flight plan. Filled by the thread for GLOBE offline data only since Marble online data is completed
+   * by later updates. Cleared in the main thread if the elevation source changes. */
+  mutable QCache<QByteArray, atools::geo::LineString> elevationCache;
+  mutable QMutex elevationCacheMutex;
+
+  /* GLOBE directory for offline data or empty for Marble online data. Used to detect source changes. */
+  QString elevationSource;
+
+  /* Sample legs concurrently in fetchRouteElevationsThread() if the GLOBE offline provider is used */
+  bool parallelElevation = true;
+
+  /* Log number of legs, points and time for each elevation calculation */
+  bool verboseElevation = false;
 
   bool databaseLoadStatus = false;
   bool active = false;
@@ -125,6 +125,11 @@ void AirportQuery::correctAirportProcedureFlag(MapAirport& airport)
     airport.flags.setFlag(map::AP_PROCEDURE, hasAirportProcedures(airport.ident, airport.iata));
 }
 
+AirportQuery *AirportQuery::getAirportQueryNav() const
+{
+  return airportQueryNav != nullptr ? airportQueryNav : NavApp::getAirportQueryNav();
+}
+
 bool AirportQuery::hasAirportProcedures(const QString& ident, const QString& iata)
 {
   if(!ident.isEmpty() && airportsWithProceduresIdent.contains(ident))
@@ -180,7 +185,7 @@ void AirportQuery::getAirportById(map::MapAirport& airport, int airportId)
     airportByIdQuery->finish();
 
     if(!navdata)
-      NavApp::getAirportQueryNav()->correctAirportProcedureFlag(ap);
+      getAirportQueryNav()->correctAirportProcedureFlag(ap);
 
     airport = *ap;
     airportIdCache.insert(airportId, ap);
@@ -216,7 +221,7 @@ void AirportQuery::getAirportByIdent(map::MapAirport& airport, const QString& id
                                    NavApp::isAirportDatabaseXPlane(navdata));
     airportByIdentQuery->finish();
     if(!navdata)
-      NavApp::getAirportQueryNav()->correctAirportProcedureFlag(ap);
+      getAirportQueryNav()->correctAirportProcedureFlag(ap);
 
     airport = *ap;
     airportIdentCache.insert(ident, ap);
@@ -246,7 +251,7 @@ void AirportQuery::getAirportsByTruncatedIdent(QList<map::MapAirport>& airports,
     mapTypesFactory->fillAirport(airportsByTruncatedIdentQuery->record(), airport, true /* complete */, navdata,
                                  NavApp::isAirportDatabaseXPlane(navdata));
     if(!navdata)
-      NavApp::getAirportQueryNav()->correctAirportProcedureFlag(airport);
+      getAirportQueryNav()->correctAirportProcedureFlag(airport);
     airports.append(airport);
   }
 }
@@ -307,7 +312,7 @@ void AirportQuery::getAirportsByOfficialIdent(QList<map::MapAirport>& airports,
       mapTypesFactory->fillAirport(airportByOfficialQuery->record(), airport, true /* complete */, navdata,
                                    NavApp::isAirportDatabaseXPlane(navdata));
       if(!navdata)
-        NavApp::getAirportQueryNav()->correctAirportProcedureFlag(airport);
+        getAirportQueryNav()->correctAirportProcedureFlag(airport);
       airports.append(airport);
     }
   }
@@ -383,7 +388,7 @@ void AirportQuery::getAirportFuzzy(map::MapAirport& airport, const map::MapAirpo
         mapTypesFactory->fillAirport(query->record(), airportByCoord, true /* complete */,
                                      navdata, NavApp::isAirportDatabaseXPlane(navdata));
         if(!navdata)
-          NavApp::getAirportQueryNav()->correctAirportProcedureFlag(airportByCoord);
+          getAirportQueryNav()->correctAirportProcedureFlag(airportByCoord);
         airports.append(airportByCoord);
       });
     }
@@ -1002,7 +1007,7 @@ void AirportQuery::getRunwaysAndAirports(map::MapResultIndex& runwayAirports, co
         map::MapAirport airport;
         mapTypesFactory->fillAirport(query.record(), airport, false /* complete */, navdata, xp);
         if(!navdata)
-          NavApp::getAirportQueryNav()->correctAirportProcedureFlag(airport);
+          getAirportQueryNav()->correctAirportProcedureFlag(airport);
         runwayAirports.add(map::MapResult::createFromMapBase(&airport));
       }
     }
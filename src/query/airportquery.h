@@ -211,6 +211,13 @@ public:
   /* Create and prepare all queries */
   void deInitQueries();
 
+  /* Use the given navdata query to correct airport procedure flags instead of the global one from NavApp.
+   * Needed if this instance is used in another thread. Not owned. */
+  void setAirportQueryNav(AirportQuery *airportQueryNavParam)
+  {
+    airportQueryNav = airportQueryNavParam;
+  }
+
   /* Get copies of cached objects */
   QHash<int, QList<map::MapParking> > getParkingCache() const;
   QHash<int, QList<map::MapHelipad> > getHelipadCache() const;
@@ -244,6 +251,9 @@ private:
    * Fast but not 100 percent accurate for airports with not matching idents since no fuzzy search is done. */
   bool hasAirportProcedures(const QString& ident, const QString& iata);
 
+  /* Query set by setAirportQueryNav() or global one */
+  AirportQuery *getAirportQueryNav() const;
+
   /* true if third party navdata */
   bool navdata;
 
@@ -263,6 +273,9 @@ private:
   QCache<NearestCacheKeyAirport, map::MapResultIndex> nearestAirportCache;
   QSet<QString> airportsWithProceduresIdent, airportsWithProceduresIata;
 
+  /* Not owned. Null if the global query is used. */
+  AirportQuery *airportQueryNav = nullptr;
+
   /* Available ident columns in airport table. Set to true if column exists and has not null values. */
   bool icaoCol = false, faaCol = false, iataCol = false, localCol = false;
 
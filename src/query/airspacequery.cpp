@@ -21,6 +21,8 @@
 #include "common/constants.h"
 #include "common/maptypesfactory.h"
 #include "fs/common/binarygeometry.h"
+#include "geo/calculations.h"
+#include "geo/linestring.h"
 #include "mapgui/maplayer.h"
 #include "settings/settings.h"
 #include "sql/sqldatabase.h"
@@ -37,6 +39,90 @@ static double queryRectInflationFactor = 0.2;
 static double queryRectInflationIncrement = 0.1;
 int AirspaceQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
 
+/* Maximum deviation in NM from original geometry for each level of detail. First is full geometry. */
+static const QVector<float> AIRSPACE_LOD_TOLERANCE_NM({0.f, 0.05f, 0.25f, 1.f, 4.f});
+
+struct AirspaceQuery::AirspaceLineLod
+{
+  /* Index is the same as in AIRSPACE_LOD_TOLERANCE_NM. Empty if not created yet. */
+  QVector<LineString> levels = QVector<LineString>(AIRSPACE_LOD_TOLERANCE_NM.size());
+};
+
+/* Normalize longitude difference to -180 to 180 to cope with lines crossing the anti-meridian */
+static inline float lonDiff(float lonX1, float lonX2)
+{
+  float diff = lonX2 - lonX1;
+  if(diff > 180.f)
+    diff -= 360.f;
+  else if(diff < -180.f)
+    diff += 360.f;
+  return diff;
+}
+
+/* Douglas-Peucker simplification using a local equirectangular projection per segment which is accurate enough
+ * for deciding on screen detail. Keeps first and last point. */
+static void simplifyLineString(LineString& result, const LineString& line, float toleranceNm)
+{
+  result.clear();
+  int size = line.size();
+  if(size < 3)
+  {
+    result = line;
+    return;
+  }
+
+  float toleranceDeg = toleranceNm / 60.f;
+  float toleranceDeg2 = toleranceDeg * toleranceDeg;
+
+  QVector<bool> keep(size, false);
+  keep[0] = keep[size - 1] = true;
+
+  // Iterate using a stack of index ranges to avoid deep recursion for large boundaries
+  QVector<std::pair<int, int> > ranges({std::make_pair(0, size - 1)});
+  while(!ranges.isEmpty())
+  {
+    std::pair<int, int> range = ranges.takeLast();
+    const Pos& p1 = line.at(range.first);
+    const Pos& p2 = line.at(range.second);
+
+    float cosLat = std::cos(toRadians((p1.getLatY() + p2.getLatY()) / 2.f));
+    float dx = lonDiff(p1.getLonX(), p2.getLonX()) * cosLat, dy = p2.getLatY() - p1.getLatY();
+    float length2 = dx * dx + dy * dy;
+
+    // Find point with maximum distance to segment
+    float maxDist2 = 0.f;
+    int maxIndex = -1;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      const Pos& pos = line.at(i);
+      float px = lonDiff(p1.getLonX(), pos.getLonX()) * cosLat, py = pos.getLatY() - p1.getLatY();
+
+      // Closed rings have equal first and last point
+      float t = length2 > 0.f ? atools::minmax(0.f, 1.f, (px * dx + py * dy) / length2) : 0.f;
+      float ex = px - t * dx, ey = py - t * dy;
+      float dist2 = ex * ex + ey * ey;
+      if(dist2 > maxDist2)
+      {
+        maxDist2 = dist2;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDist2 > toleranceDeg2)
+    {
+      keep[maxIndex] = true;
+      ranges.append(std::make_pair(range.first, maxIndex));
+      ranges.append(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  for(int i = 0; i < size; i++)
+  {
+    if(keep.at(i))
+      result.append(line.at(i));
+  }
+}
+
 AirspaceQuery::AirspaceQuery(SqlDatabase *sqlDb, map::MapAirspaceSources src)
   : db(sqlDb), source(src)
 {
@@ -44,6 +130,7 @@ AirspaceQuery::AirspaceQuery(SqlDatabase *sqlDb, map::MapAirspaceSources src)
   atools::settings::Settings& settings = atools::settings::Settings::instance();
 
   airspaceLineCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "AirspaceLineCache", 10000).toInt());
+  airspaceCache.setMaxKb(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "TileCacheKb", 16384).toInt());
   onlineCenterGeoCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "OnlineCenterGeoCache", 10000).toInt());
   onlineCenterGeoFileCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY % "OnlineCenterGeoFileCache", 10000).toInt());
 
@@ -110,154 +197,169 @@ const QList<map::MapAirspace> *AirspaceQuery::getAirspaces(const GeoDataLatLonBo
                                                            const map::MapAirspaceFilter& filter, float flightPlanAltitude,
                                                            bool lazy, bool& overflow)
 {
-  airspaceCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                            [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-  {
-    return curLayer->hasSameQueryParametersAirspace(newLayer);
-  });
-
   if(filter != lastAirspaceFilter || atools::almostNotEqual(lastFlightplanAltitude, flightPlanAltitude))
   {
     // Need a few more parameters to clear the cache which is different to other map features
-    airspaceCache.list.clear();
+    airspaceCache.clear();
     lastAirspaceFilter = filter;
     lastFlightplanAltitude = flightPlanAltitude;
   }
 
-  if(airspaceCache.list.isEmpty() && !lazy)
+  if(filter.types != map::AIRSPACE_NONE)
   {
-    QStringList typeStrings;
-
-    if(filter.types != map::AIRSPACE_NONE)
+    // Assign altitude limits ======================================
+    bool altitude = true;
+    int minAlt = map::MapAirspaceFilter::MIN_AIRSPACE_ALT, maxAlt = map::MapAirspaceFilter::MAX_AIRSPACE_ALT;
+    if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_ALL))
+      // No altitude query =========
+      altitude = false;
+    else if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_FLIGHTPLAN))
+      // One altitude query =========
+      minAlt = maxAlt = atools::roundToInt(flightPlanAltitude);
+    else if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_SET))
     {
-      // Build a list of query strings based on the bitfield
-      if(filter.types == map::AIRSPACE_ALL)
-        typeStrings.append("%");
+      // Altitude range query =========
+      minAlt = filter.minAltitudeFt;
+
+      // Use unlimited for the maximum value if not equal
+      if(filter.minAltitudeFt != filter.maxAltitudeFt && filter.maxAltitudeFt == map::MapAirspaceFilter::MAX_AIRSPACE_ALT)
+        maxAlt = 100000;
       else
-      {
-        for(int i = 0; i <= map::MAP_AIRSPACE_TYPE_BITS; i++)
-        {
-          map::MapAirspaceTypes t(1 << i);
-          if(filter.types & t)
-            typeStrings.append(map::airspaceTypeToDatabase(t));
-        }
-      }
+        maxAlt = filter.maxAltitudeFt;
+    }
 
-      // Select query and assign altitude limits ======================================
-      SqlQuery *query = nullptr;
-      int minAlt = map::MapAirspaceFilter::MIN_AIRSPACE_ALT, maxAlt = map::MapAirspaceFilter::MAX_AIRSPACE_ALT;
-      if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_ALL))
-        // No altitude query =========
-        query = airspaceByRectQuery;
-      else if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_FLIGHTPLAN))
+    // Get query for all types and flags in one run
+    SqlQuery *query = airspaceByRectQueryForFilter(filter, altitude);
+
+    if(query::valid(Q_FUNC_INFO, query))
+    {
+      // Get the airspace objects without geometry for each missing tile
+      bool updated = airspaceCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                                               [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
       {
-        // One altitude query =========
-        minAlt = maxAlt = atools::roundToInt(flightPlanAltitude);
-        query = airspaceByRectAltQuery;
-      }
-      else if(filter.flags.testFlag(map::AIRSPACE_ALTITUDE_SET))
+        return curLayer->hasSameQueryParametersAirspace(newLayer);
+      },
+                                               [ =](const GeoDataLatLonBox& r, QList<map::MapAirspace>& objects) -> void
       {
-        // Altitude range query =========
-        minAlt = filter.minAltitudeFt;
+        query::bindRect(r, query);
 
-        // Use unlimited for the maximum value if not equal
-        if(filter.minAltitudeFt != filter.maxAltitudeFt && filter.maxAltitudeFt == map::MapAirspaceFilter::MAX_AIRSPACE_ALT)
-          maxAlt = 100000;
-        else
-          maxAlt = filter.maxAltitudeFt;
-
-        // Can use single alt query if values are equal
-        query = maxAlt == minAlt ? airspaceByRectAltQuery : airspaceByRectAltRangeQuery;
-      }
+        // Bind altitude values ===========================
+        if(altitude)
+        {
+          query->bindValue(":minalt", minAlt);
+          query->bindValue(":maxalt", maxAlt);
+        }
 
-      if(query::valid(Q_FUNC_INFO, query))
-      {
-        QSet<int> ids;
+        // Run query ===========================================
+        query->exec();
 
-        // Get the airspace objects without geometry
-        for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+        MapTypesColumns columns;
+        mapTypesFactory->initAirspaceColumns(columns, *query);
+        while(query->next())
         {
-          for(const QString& typeStr : qAsConst(typeStrings))
-          {
-            query::bindRect(r, query);
-            query->bindValue(":type", typeStr);
-
-            // Bind altitude values ===========================
-            if(query == airspaceByRectAltQuery)
-              query->bindValue(":alt", minAlt);
-            else if(query == airspaceByRectAltRangeQuery)
-            {
-              query->bindValue(":minalt", minAlt);
-              query->bindValue(":maxalt", maxAlt);
-            }
-
-            // Run query ===========================================
-            query->exec();
-            while(query->next())
-            {
-              // Avoid double airspaces which can happen if they cross the date boundary
-              if(ids.contains(query->valueInt("boundary_id")))
-                continue;
-
-              if(hasMultipleCode && filter.flags.testFlag(map::AIRSPACE_NO_MULTIPLE_Z) && query->valueStr("multiple_code") == "Z")
-                continue;
-
-              if(hasFirUir)
-              {
-                // Database has new FIR/UIR types - filter out the old deprecated centers
-                QString name = query->valueStr("name");
-                if(name.contains("(FIR)") || name.contains("(UIR)") || name.contains("(FIR/UIR)"))
-                  continue;
-              }
-
-              map::MapAirspace airspace;
-              mapTypesFactory->fillAirspace(query->record(), airspace, source);
-              airspaceCache.list.append(airspace);
-
-              ids.insert(airspace.id);
-            }
-          }
+          map::MapAirspace airspace;
+          mapTypesFactory->fillAirspace(*query, columns, airspace, source);
+          objects.append(airspace);
         }
+      });
 
+      if(updated)
         // Sort by importance
         std::sort(airspaceCache.list.begin(), airspaceCache.list.end(),
                   [](const map::MapAirspace& airspace1, const map::MapAirspace& airspace2) -> bool
         {
           return map::airspaceDrawingOrder(airspace1.type) < map::airspaceDrawingOrder(airspace2.type);
         });
-      }
     }
   }
   overflow = airspaceCache.validate(queryMaxRows);
   return &airspaceCache.list;
 }
 
+SqlQuery *AirspaceQuery::airspaceByRectQueryForFilter(const map::MapAirspaceFilter& filter, bool altitude)
+{
+  if(airspaceByRectQueryBase.isEmpty())
+    return nullptr;
+
+  // Build condition for all selected types ======================================
+  QStringList conditions;
+  if(filter.types != map::AIRSPACE_ALL)
+  {
+    QStringList types;
+    for(int i = 0; i <= map::MAP_AIRSPACE_TYPE_BITS; i++)
+    {
+      map::MapAirspaceTypes t(1 << i);
+      if(filter.types & t)
+        types.append("'" % map::airspaceTypeToDatabase(t) % "'");
+    }
+    conditions.append("type in (" % types.join(", ") % ")");
+  }
+  else
+    // Same as former "type like '%'" which does not match null
+    conditions.append("type is not null");
+
+  if(altitude)
+    conditions.append("((:minalt <= max_altitude and :maxalt >= min_altitude) or "
+                      "(max_altitude = 0 and :maxalt >= min_altitude))");
+
+  if(hasMultipleCode && filter.flags.testFlag(map::AIRSPACE_NO_MULTIPLE_Z))
+    conditions.append("coalesce(multiple_code, '') <> 'Z'");
+
+  if(hasFirUir)
+    // Database has new FIR/UIR types - filter out the old deprecated centers
+    // instr() is case sensitive like the former QString::contains() while like is not
+    conditions.append("instr(coalesce(name, ''), '(FIR)') = 0 and instr(coalesce(name, ''), '(UIR)') = 0 and "
+                      "instr(coalesce(name, ''), '(FIR/UIR)') = 0");
+
+  QString sql = airspaceByRectQueryBase;
+  if(!conditions.isEmpty())
+    sql.append(" and " % conditions.join(" and "));
+
+  // Prepare again only if filter has changed
+  if(airspaceByRectQuery == nullptr || sql != airspaceByRectQuerySql)
+  {
+    delete airspaceByRectQuery;
+    airspaceByRectQuery = new SqlQuery(db);
+    airspaceByRectQuery->prepare(sql);
+    airspaceByRectQuerySql = sql;
+  }
+  return airspaceByRectQuery;
+}
+
 void AirspaceQuery::airspaceGeometry(LineString *lines, const QByteArray& bytes)
 {
   atools::fs::common::BinaryGeometry geometry(bytes);
   geometry.swapGeometry(*lines);
 }
 
-const LineString *AirspaceQuery::getAirspaceGeometryById(int airspaceId)
+const LineString *AirspaceQuery::getAirspaceGeometryById(int airspaceId, float maxToleranceNm)
 {
   if(!query::valid(Q_FUNC_INFO, airspaceLinesByIdQuery))
     return nullptr;
 
-  if(airspaceLineCache.contains(airspaceId))
-    return airspaceLineCache.object(airspaceId);
-  else
+  AirspaceLineLod *lod = airspaceLineCache.object(airspaceId);
+  if(lod == nullptr)
   {
-    LineString *linestring = new LineString;
+    lod = new AirspaceLineLod;
 
     airspaceLinesByIdQuery->bindValue(":id", airspaceId);
     airspaceLinesByIdQuery->exec();
     if(airspaceLinesByIdQuery->next())
-      airspaceGeometry(linestring, airspaceLinesByIdQuery->value("geometry").toByteArray());
+      airspaceGeometry(&lod->levels[0], airspaceLinesByIdQuery->value("geometry").toByteArray());
     airspaceLinesByIdQuery->finish();
-    airspaceLineCache.insert(airspaceId, linestring);
-
-    return linestring;
+    airspaceLineCache.insert(airspaceId, lod);
   }
+
+  // Find coarsest level which is still accurate enough
+  int level = 0;
+  while(level < AIRSPACE_LOD_TOLERANCE_NM.size() - 1 && AIRSPACE_LOD_TOLERANCE_NM.at(level + 1) <= maxToleranceNm)
+    level++;
+
+  LineString& lineString = lod->levels[level];
+  if(level > 0 && lineString.isEmpty())
+    simplifyLineString(lineString, lod->levels.constFirst(), AIRSPACE_LOD_TOLERANCE_NM.at(level));
+
+  return &lineString;
 }
 
 const LineString *AirspaceQuery::getAirspaceGeometryByFile(QString callsign)
@@ -456,20 +558,8 @@ void AirspaceQuery::initQueries()
   QString airspaceRect = " (not (max_lonx < :leftx or min_lonx > :rightx or "
                          "min_laty > :topy or max_laty < :bottomy) or max_lonx < min_lonx) ";
 
-  airspaceByRectQuery = new SqlQuery(db);
-  airspaceByRectQuery->prepare("select " % airspaceQueryBase % "from " % table % " where " % airspaceRect % " and type like :type");
-
-  airspaceByRectAltRangeQuery = new SqlQuery(db);
-  airspaceByRectAltRangeQuery->prepare("select " % airspaceQueryBase % " from " % table %
-                                       " where " % airspaceRect % " and type like :type and " %
-                                       "((:minalt <= max_altitude and :maxalt >= min_altitude) or "
-                                       "(max_altitude = 0 and :maxalt >= min_altitude))");
-
-  airspaceByRectAltQuery = new SqlQuery(db);
-  airspaceByRectAltQuery->prepare("select " % airspaceQueryBase % " from " % table %
-                                  " where " % airspaceRect % " and type like :type and " %
-                                  "((:alt <= max_altitude and :alt >= min_altitude) or "
-                                  "(max_altitude = 0 and :alt >= min_altitude))");
+  // Query is prepared on demand since filter conditions are added to the statement
+  airspaceByRectQueryBase = "select " % airspaceQueryBase % " from " % table % " where " % airspaceRect;
 
   airspaceLinesByIdQuery = new SqlQuery(db);
   airspaceLinesByIdQuery->prepare("select geometry from " % table % " where " % id % " = :id");
@@ -492,12 +582,8 @@ void AirspaceQuery::deInitQueries()
 
   delete airspaceByRectQuery;
   airspaceByRectQuery = nullptr;
-
-  delete airspaceByRectAltRangeQuery;
-  airspaceByRectAltRangeQuery = nullptr;
-
-  delete airspaceByRectAltQuery;
-  airspaceByRectAltQuery = nullptr;
+  airspaceByRectQueryBase.clear();
+  airspaceByRectQuerySql.clear();
 
   delete airspaceLinesByIdQuery;
   airspaceLinesByIdQuery = nullptr;
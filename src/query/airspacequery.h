@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_AIRSPACEQUERY_H
 
 #include "query/querytypes.h"
+#include "query/tilerectcache.h"
 
 #include <QCache>
 
@@ -67,7 +68,10 @@ public:
   /* Get airspaces for map display */
   const QList<map::MapAirspace> *getAirspaces(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                               const map::MapAirspaceFilter& filter, float flightPlanAltitude, bool lazy, bool& overflow);
-  const atools::geo::LineString *getAirspaceGeometryById(int airspaceId);
+
+  /* Get boundary for airspace. A simplified geometry is returned where the deviation from the original is below
+   * maxToleranceNm. Use the size of a screen pixel in NM to get a pixel-accurate geometry or 0 for full detail. */
+  const atools::geo::LineString *getAirspaceGeometryById(int airspaceId, float maxToleranceNm = 0.f);
 
   /* Query raw geometry blob by online callsign (name) and facility type */
   const atools::geo::LineString *getAirspaceGeometryByName(QString callsign, const QString& facilityType);
@@ -95,16 +99,23 @@ private:
   const atools::geo::LineString *airspaceGeometryByNameInternal(const QString& callsign, const QString& facilityType);
   void airspaceGeometry(atools::geo::LineString* lines, const QByteArray& bytes);
 
+  /* Get query for rectangle with type, flag and optional altitude conditions for the filter in the where clause.
+   * Query is prepared again if the filter has changed. Has to bind rect and ":minalt" and ":maxalt" if altitude is true. */
+  atools::sql::SqlQuery *airspaceByRectQueryForFilter(const map::MapAirspaceFilter& filter, bool altitude);
+
+  /* Boundary geometry in several levels of detail. Simplified levels are created on demand. */
+  struct AirspaceLineLod;
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *db;
 
-  /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapAirspace> airspaceCache;
+  /* Tile based spatial caches */
+  query::TileRectCache<map::MapAirspace> airspaceCache;
   map::MapAirspaceFilter lastAirspaceFilter;
   float lastFlightplanAltitude = 0.f;
 
   /* ID/object caches */
-  QCache<int, atools::geo::LineString> airspaceLineCache;
+  QCache<int, AirspaceLineLod> airspaceLineCache;
   QCache<QString, atools::geo::LineString> onlineCenterGeoCache, onlineCenterGeoFileCache;
 
   static int queryMaxRows;
@@ -115,12 +126,16 @@ private:
        hasFirUir = false;
 
   /* Database queries */
-  atools::sql::SqlQuery *airspaceByRectQuery = nullptr, *airspaceByRectAltRangeQuery = nullptr, *airspaceByRectAltQuery = nullptr,
+  atools::sql::SqlQuery *airspaceByRectQuery = nullptr,
                         *airspaceLinesByIdQuery = nullptr, *airspaceGeoByNameQuery = nullptr, *airspaceGeoByFileQuery = nullptr,
                         *airspaceByIdQuery = nullptr, *airspaceInfoQuery = nullptr;
 
   bool hasMultipleCode = false;
 
+  /* Select statement with rectangle condition created in initQueries() and full statement used
+   * for the currently prepared airspaceByRectQuery */
+  QString airspaceByRectQueryBase, airspaceByRectQuerySql;
+
   /* Source database definition */
   map::MapAirspaceSources source;
 };
@@ -41,6 +41,7 @@ AirwayQuery::AirwayQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam)
   queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
   queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
   queryMaxRowsAirways = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "AirwayQueryRowLimitAw", map::MAX_MAP_OBJECTS).toInt();
+  airwayCache.setMaxKb(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheKb", 16384).toInt());
 }
 
 AirwayQuery::~AirwayQuery()
@@ -254,28 +255,18 @@ const QList<map::MapAirway> *AirwayQuery::getAirways(const GeoDataLatLonBox& rec
                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersAirwayTrack(newLayer);
-  });
-
-  if(airwayCache.list.isEmpty() && !lazy)
+  },
+                          [ =](const GeoDataLatLonBox& r, QList<map::MapAirway>& objects) -> void
   {
-    QSet<int> ids;
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(r, airwayByRectQuery);
+    airwayByRectQuery->exec();
+    while(airwayByRectQuery->next())
     {
-      query::bindRect(r, airwayByRectQuery);
-      airwayByRectQuery->exec();
-      while(airwayByRectQuery->next())
-      {
-        if(ids.contains(airwayByRectQuery->valueInt(airwayIdCol)))
-          continue;
-
-        map::MapAirway airway;
-        mapTypesFactory->fillAirwayOrTrack(airwayByRectQuery->record(), airway, trackDatabase);
-        airwayCache.list.append(airway);
-        ids.insert(airway.id);
-      }
+      map::MapAirway airway;
+      mapTypesFactory->fillAirwayOrTrack(airwayByRectQuery->record(), airway, trackDatabase);
+      objects.append(airway);
     }
-  }
+  });
   airwayCache.validate(queryMaxRowsAirways);
   return &airwayCache.list;
 }
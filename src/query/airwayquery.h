@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_AIRWAYQUERY_H
 
 #include "query/querytypes.h"
+#include "query/tilerectcache.h"
 
 #include <QCache>
 
@@ -108,8 +109,8 @@ private:
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbNav;
 
-  /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapAirway> airwayCache;
+  /* Tile based spatial caches */
+  query::TileRectCache<map::MapAirway> airwayCache;
 
   /* ID/object caches */
   QCache<query::NearestCacheKeyNavaid, map::MapResultIndex> nearestNavaidCache;
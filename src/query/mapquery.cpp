@@ -83,6 +83,16 @@ MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDbSim, SqlDatabase *sqlDbNav, Sq
   queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.5).toDouble();
   queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.5).toDouble();
   queryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "MapQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+
+  // Memory limit for each tile cache
+  int tileCacheKb = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheKb", 16384).toInt();
+  airportCache.setMaxKb(tileCacheKb);
+  vorCache.setMaxKb(tileCacheKb);
+  ndbCache.setMaxKb(tileCacheKb);
+  markerCache.setMaxKb(tileCacheKb);
+  holdingCache.setMaxKb(tileCacheKb);
+  ilsCache.setMaxKb(tileCacheKb);
+  airportMsaCache.setMaxKb(tileCacheKb);
 }
 
 MapQuery::~MapQuery()
@@ -91,11 +101,40 @@ MapQuery::~MapQuery()
   delete mapTypesFactory;
 }
 
+void MapQuery::setQueries(AirportQuery *airportQuerySimParam, AirportQuery *airportQueryNavParam,
+                          WaypointTrackQuery *waypointTrackQueryParam, AirwayTrackQuery *airwayTrackQueryParam)
+{
+  airportQuerySim = airportQuerySimParam;
+  airportQueryNav = airportQueryNavParam;
+  waypointTrackQuery = waypointTrackQueryParam;
+  airwayTrackQuery = airwayTrackQueryParam;
+}
+
+AirportQuery *MapQuery::getAirportQuerySim() const
+{
+  return airportQuerySim != nullptr ? airportQuerySim : NavApp::getAirportQuerySim();
+}
+
+AirportQuery *MapQuery::getAirportQueryNav() const
+{
+  return airportQueryNav != nullptr ? airportQueryNav : NavApp::getAirportQueryNav();
+}
+
+WaypointTrackQuery *MapQuery::getWaypointTrackQuery() const
+{
+  return waypointTrackQuery != nullptr ? waypointTrackQuery : NavApp::getWaypointTrackQueryGui();
+}
+
+AirwayTrackQuery *MapQuery::getAirwayTrackQuery() const
+{
+  return airwayTrackQuery != nullptr ? airwayTrackQuery : NavApp::getAirwayTrackQueryGui();
+}
+
 bool MapQuery::hasProcedures(const map::MapAirport& airport) const
 {
   MapAirport airportNav = getAirportNav(airport);
   if(airportNav.isValid())
-    return NavApp::getAirportQueryNav()->hasProcedures(airportNav);
+    return getAirportQueryNav()->hasProcedures(airportNav);
 
   return false;
 }
@@ -104,7 +143,7 @@ bool MapQuery::hasArrivalProcedures(const map::MapAirport& airport) const
 {
   MapAirport airportNav = getAirportNav(airport);
   if(airportNav.isValid())
-    return NavApp::getAirportQueryNav()->hasArrivalProcedures(airportNav);
+    return getAirportQueryNav()->hasArrivalProcedures(airportNav);
 
   return false;
 }
@@ -113,7 +152,7 @@ bool MapQuery::hasDepartureProcedures(const map::MapAirport& airport) const
 {
   MapAirport airportNav = getAirportNav(airport);
   if(airportNav.isValid())
-    return NavApp::getAirportQueryNav()->hasDepartureProcedures(airportNav);
+    return getAirportQueryNav()->hasDepartureProcedures(airportNav);
 
   return false;
 }
@@ -123,7 +162,7 @@ map::MapAirport MapQuery::getAirportSim(const map::MapAirport& airport) const
   if(airport.navdata)
   {
     MapAirport retval;
-    NavApp::getAirportQuerySim()->getAirportFuzzy(retval, airport);
+    getAirportQuerySim()->getAirportFuzzy(retval, airport);
     return retval;
   }
   return airport;
@@ -134,7 +173,7 @@ map::MapAirport MapQuery::getAirportNav(const map::MapAirport& airport) const
   if(!airport.navdata)
   {
     MapAirport retval;
-    NavApp::getAirportQueryNav()->getAirportFuzzy(retval, airport);
+    getAirportQueryNav()->getAirportFuzzy(retval, airport);
     return retval;
   }
   return airport;
@@ -143,13 +182,13 @@ map::MapAirport MapQuery::getAirportNav(const map::MapAirport& airport) const
 void MapQuery::getAirportSimReplace(map::MapAirport& airport) const
 {
   if(airport.navdata)
-    NavApp::getAirportQuerySim()->getAirportFuzzy(airport, airport);
+    getAirportQuerySim()->getAirportFuzzy(airport, airport);
 }
 
 void MapQuery::getAirportNavReplace(map::MapAirport& airport) const
 {
   if(!airport.navdata)
-    NavApp::getAirportQueryNav()->getAirportFuzzy(airport, airport);
+    getAirportQueryNav()->getAirportFuzzy(airport, airport);
 }
 
 void MapQuery::getAirportTransitionAltiudeAndLevel(const map::MapAirport& airport, float& transitionAltitude, float& transitionLevel) const
@@ -302,14 +341,14 @@ map::MapResultIndex *MapQuery::nearestNavaidsInternal(const Pos& pos, float dist
 
     if(type & map::WAYPOINT)
     {
-      query::fetchObjectsForRect(rect, NavApp::getWaypointTrackQueryGui()->getWaypointsByRectQueryTrack(),
+      query::fetchObjectsForRect(rect, getWaypointTrackQuery()->getWaypointsByRectQueryTrack(),
                                  [ =, &res](atools::sql::SqlQuery *query) -> void {
         MapWaypoint obj;
         mapTypesFactory->fillWaypoint(query->record(), obj, true /* track database */);
         res.waypoints.append(obj);
       });
 
-      query::fetchObjectsForRect(rect, NavApp::getWaypointTrackQueryGui()->getWaypointsByRectQuery(),
+      query::fetchObjectsForRect(rect, getWaypointTrackQuery()->getWaypointsByRectQuery(),
                                  [ =, &res](atools::sql::SqlQuery *query) -> void {
         MapWaypoint obj;
         mapTypesFactory->fillWaypoint(query->record(), obj, false /* track database */);
@@ -371,7 +410,7 @@ void MapQuery::mapObjectByIdentInternal(map::MapResult& result, map::MapTypes ty
 {
   if(type & map::AIRPORT)
   {
-    AirportQuery *airportQuery = airportFromNavDatabase ? NavApp::getAirportQueryNav() : NavApp::getAirportQuerySim();
+    AirportQuery *airportQuery = airportFromNavDatabase ? getAirportQueryNav() : getAirportQuerySim();
 
     // Try exact ident first =====================
     MapAirport ap = airportQuery->getAirportByIdent(ident);
@@ -442,7 +481,7 @@ void MapQuery::mapObjectByIdentInternal(map::MapResult& result, map::MapTypes ty
 
   if(type & map::WAYPOINT)
   {
-    NavApp::getWaypointTrackQueryGui()->getWaypointByIdent(result.waypoints, ident, region);
+    getWaypointTrackQuery()->getWaypointByIdent(result.waypoints, ident, region);
     maptools::sortByDistance(result.waypoints, sortByDistancePos);
     maptools::removeByDistance(result.waypoints, sortByDistancePos, maxDistanceMeter);
   }
@@ -465,13 +504,13 @@ void MapQuery::mapObjectByIdentInternal(map::MapResult& result, map::MapTypes ty
   if(type & map::RUNWAYEND)
   {
     if(airportFromNavDatabase)
-      NavApp::getAirportQueryNav()->getRunwayEndByNames(result, ident, airport);
+      getAirportQueryNav()->getRunwayEndByNames(result, ident, airport);
     else
-      NavApp::getAirportQuerySim()->getRunwayEndByNames(result, ident, airport);
+      getAirportQuerySim()->getRunwayEndByNames(result, ident, airport);
   }
 
   if(type & map::AIRWAY)
-    NavApp::getAirwayTrackQueryGui()->getAirwaysByName(result.airways, ident);
+    getAirwayTrackQuery()->getAirwaysByName(result.airways, ident);
 }
 
 void MapQuery::getMapObjectById(map::MapResult& result, map::MapTypes type, map::MapAirspaceSources src, int id,
@@ -480,8 +519,8 @@ void MapQuery::getMapObjectById(map::MapResult& result, map::MapTypes type, map:
   if(type == map::AIRPORT)
   {
     MapAirport airport = (airportFromNavDatabase ?
-                          NavApp::getAirportQueryNav() :
-                          NavApp::getAirportQuerySim())->getAirportById(id);
+                          getAirportQueryNav() :
+                          getAirportQuerySim())->getAirportById(id);
     if(airport.isValid())
       result.airports.append(airport);
   }
@@ -511,7 +550,7 @@ void MapQuery::getMapObjectById(map::MapResult& result, map::MapTypes type, map:
   }
   else if(type == map::WAYPOINT)
   {
-    MapWaypoint waypoint = NavApp::getWaypointTrackQueryGui()->getWaypointById(id);
+    MapWaypoint waypoint = getWaypointTrackQuery()->getWaypointById(id);
     if(waypoint.isValid())
       result.waypoints.append(waypoint);
   }
@@ -535,7 +574,7 @@ void MapQuery::getMapObjectById(map::MapResult& result, map::MapTypes type, map:
   }
   else if(type == map::RUNWAYEND)
   {
-    map::MapRunwayEnd end = (airportFromNavDatabase ? NavApp::getAirportQueryNav() : NavApp::getAirportQuerySim())->getRunwayEndById(id);
+    map::MapRunwayEnd end = (airportFromNavDatabase ? getAirportQueryNav() : getAirportQuerySim())->getRunwayEndById(id);
     if(end.isValid())
       result.runwayEnds.append(end);
   }
@@ -551,7 +590,7 @@ void MapQuery::getMapObjectById(map::MapResult& result, map::MapTypes type, map:
   }
   else if(type == map::AIRWAY)
   {
-    map::MapAirway airway = NavApp::getAirwayTrackQueryGui()->getAirwayById(id);
+    map::MapAirway airway = getAirwayTrackQuery()->getAirwayById(id);
     if(airway.isValid())
       result.airways.append(airway);
   }
@@ -774,7 +813,7 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
   if(victorWaypoints || jetWaypoints || trackWaypoints || normalWaypoints || flightplan)
   {
     // Get all close waypoints
-    NavApp::getWaypointTrackQueryGui()->getNearestScreenObjects(conv, mapLayer, types, xs, ys, screenDistance, result);
+    getWaypointTrackQuery()->getNearestScreenObjects(conv, mapLayer, types, xs, ys, screenDistance, result);
 
     // Filter waypoints by airway/track type and remove artificial ones
     QHash<int, MapWaypoint> waypoints;
@@ -827,7 +866,7 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
   if(mapLayer->isAirport() && airportDiagram)
   {
     // Also check parking and helipads in airport diagrams
-    QHash<int, QList<MapParking> > parkingCache = NavApp::getAirportQuerySim()->getParkingCache();
+    QHash<int, QList<MapParking> > parkingCache = getAirportQuerySim()->getParkingCache();
     for(auto it = parkingCache.constBegin(); it != parkingCache.constEnd(); ++it)
     {
       // Only draw if airport is actually drawn on map
@@ -841,7 +880,7 @@ void MapQuery::getNearestScreenObjects(const CoordinateConverter& conv, const Ma
       }
     }
 
-    QHash<int, QList<MapHelipad> > helipadCache = NavApp::getAirportQuerySim()->getHelipadCache();
+    QHash<int, QList<MapHelipad> > helipadCache = getAirportQuerySim()->getHelipadCache();
     for(auto it = helipadCache.constBegin(); it != helipadCache.constEnd(); ++it)
     {
       if(shownDetailAirportIds.contains(it.key()))
@@ -863,19 +902,8 @@ const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonB
   bool addon = types.testFlag(map::AIRPORT_ADDON);
   bool normal = types & map::AIRPORT_ALL;
 
-  airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                           [this, addon, normal](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-  {
-    return curLayer->hasSameQueryParametersAirport(newLayer) &&
-    // Invalidate cache if settings differ
-    airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
-  });
-
-  airportCacheAddonFlag = addon;
-  airportCacheNormalFlag = normal;
-
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(rect, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
+  return fetchAirports(rect, mapLayer, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
 }
 
 const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rect& rect, const MapLayer *mapLayer, bool lazy,
@@ -890,11 +918,8 @@ const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rec
   bool addon = types.testFlag(map::AIRPORT_ADDON);
   bool normal = types & map::AIRPORT_ALL;
 
-  airportCacheAddonFlag = addon;
-  airportCacheNormalFlag = normal;
-
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(latLonBox, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
+  return fetchAirports(latLonBox, mapLayer, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
 }
 
 const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
@@ -907,24 +932,28 @@ const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersVor(newLayer);
+  },
+                       [ =](const GeoDataLatLonBox& r, QList<map::MapVor>& objects) -> void
+  {
+    fetchVorTile(r, objects);
   });
+  overflow = vorCache.validate(queryMaxRows);
+  return &vorCache.list;
+}
+
+void MapQuery::fetchVorTile(const GeoDataLatLonBox& rect, QList<map::MapVor>& vors)
+{
+  query::bindRect(rect, vorsByRectQuery);
+  vorsByRectQuery->exec();
 
-  if(vorCache.list.isEmpty() && !lazy)
+  MapTypesColumns columns;
+  mapTypesFactory->initVorColumns(columns, *vorsByRectQuery);
+  while(vorsByRectQuery->next())
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, vorsByRectQuery);
-      vorsByRectQuery->exec();
-      while(vorsByRectQuery->next())
-      {
-        MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
-        vorCache.list.append(vor);
-      }
-    }
+    MapVor vor;
+    mapTypesFactory->fillVor(*vorsByRectQuery, columns, vor);
+    vors.append(vor);
   }
-  overflow = vorCache.validate(queryMaxRows);
-  return &vorCache.list;
 }
 
 const QList<map::MapVor> *MapQuery::getVorsByRect(const atools::geo::Rect& rect, const MapLayer *mapLayer, bool lazy, bool& overflow)
@@ -943,24 +972,28 @@ const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersNdb(newLayer);
+  },
+                       [ =](const GeoDataLatLonBox& r, QList<map::MapNdb>& objects) -> void
+  {
+    fetchNdbTile(r, objects);
   });
+  overflow = ndbCache.validate(queryMaxRows);
+  return &ndbCache.list;
+}
+
+void MapQuery::fetchNdbTile(const GeoDataLatLonBox& rect, QList<map::MapNdb>& ndbs)
+{
+  query::bindRect(rect, ndbsByRectQuery);
+  ndbsByRectQuery->exec();
 
-  if(ndbCache.list.isEmpty() && !lazy)
+  MapTypesColumns columns;
+  mapTypesFactory->initNdbColumns(columns, *ndbsByRectQuery);
+  while(ndbsByRectQuery->next())
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, ndbsByRectQuery);
-      ndbsByRectQuery->exec();
-      while(ndbsByRectQuery->next())
-      {
-        MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
-        ndbCache.list.append(ndb);
-      }
-    }
+    MapNdb ndb;
+    mapTypesFactory->fillNdb(*ndbsByRectQuery, columns, ndb);
+    ndbs.append(ndb);
   }
-  overflow = ndbCache.validate(queryMaxRows);
-  return &ndbCache.list;
 }
 
 const QList<map::MapNdb> *MapQuery::getNdbsByRect(const atools::geo::Rect& rect, const MapLayer *mapLayer, bool lazy, bool& overflow)
@@ -1081,23 +1114,18 @@ const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersMarker(newLayer);
-  });
-
-  if(markerCache.list.isEmpty() && !lazy)
+  },
+                          [ =](const GeoDataLatLonBox& r, QList<map::MapMarker>& objects) -> void
   {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(r, markersByRectQuery);
+    markersByRectQuery->exec();
+    while(markersByRectQuery->next())
     {
-      query::bindRect(r, markersByRectQuery);
-      markersByRectQuery->exec();
-      while(markersByRectQuery->next())
-      {
-        map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
-        markerCache.list.append(marker);
-      }
+      map::MapMarker marker;
+      mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+      objects.append(marker);
     }
-  }
+  });
   overflow = markerCache.validate(queryMaxRows);
   return &markerCache.list;
 }
@@ -1119,23 +1147,18 @@ const QList<map::MapHolding> *MapQuery::getHoldings(const Marble::GeoDataLatLonB
                              [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
       return curLayer->hasSameQueryParametersHolding(newLayer);
-    });
-
-    if(holdingCache.list.isEmpty() && !lazy)
+    },
+                             [ =](const GeoDataLatLonBox& r, QList<map::MapHolding>& objects) -> void
     {
-      for(const GeoDataLatLonBox& r :
-          query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+      query::bindRect(r, holdingByRectQuery);
+      holdingByRectQuery->exec();
+      while(holdingByRectQuery->next())
       {
-        query::bindRect(r, holdingByRectQuery);
-        holdingByRectQuery->exec();
-        while(holdingByRectQuery->next())
-        {
-          MapHolding holding;
-          mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
-          holdingCache.list.append(holding);
-        }
+        MapHolding holding;
+        mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
+        objects.append(holding);
       }
-    }
+    });
     overflow = holdingCache.validate(queryMaxRows);
     return &holdingCache.list;
   }
@@ -1151,24 +1174,19 @@ const QList<map::MapAirportMsa> *MapQuery::getAirportMsa(const Marble::GeoDataLa
                                 [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
       return curLayer->hasSameQueryParametersAirportMsa(newLayer);
-    });
-
-    if(airportMsaCache.list.isEmpty() && !lazy)
+    },
+                                [ =](const GeoDataLatLonBox& r, QList<map::MapAirportMsa>& objects) -> void
     {
-      for(const GeoDataLatLonBox& r :
-          query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-      {
-        query::bindRect(r, airportMsaByRectQuery);
+      query::bindRect(r, airportMsaByRectQuery);
 
-        airportMsaByRectQuery->exec();
-        while(airportMsaByRectQuery->next())
-        {
-          MapAirportMsa msa;
-          mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
-          airportMsaCache.list.append(msa);
-        }
+      airportMsaByRectQuery->exec();
+      while(airportMsaByRectQuery->next())
+      {
+        MapAirportMsa msa;
+        mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
+        objects.append(msa);
       }
-    }
+    });
     overflow = airportMsaCache.validate(queryMaxRows);
     return &airportMsaCache.list;
   }
@@ -1180,41 +1198,113 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
   if(!query::valid(Q_FUNC_INFO, ilsByRectQuery))
     return nullptr;
 
+  // ILS length is 9 NM * 1' per degree
+  double increase = atools::geo::toRadians(9. / 60.);
+
+  // Increase bounding rect since ILS has no bounding to query
+  rect.setBoundaries(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
+
   ilsCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersIls(newLayer);
+  },
+                       [ =](const GeoDataLatLonBox& r, QList<map::MapIls>& objects) -> void
+  {
+    query::bindRect(r, ilsByRectQuery);
+
+    ilsByRectQuery->exec();
+    while(ilsByRectQuery->next())
+    {
+      // ILS is always loaded from nav except if all is off
+      map::MapRunwayEnd end;
+      if(mapLayer->isIlsDetail() && !NavApp::isNavdataOff())
+        // Get the runway end to fix graphical alignment issues in map
+        end = getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
+
+      MapIls ils;
+      mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
+      objects.append(ils);
+    }
   });
+  overflow = ilsCache.validate(queryMaxRows);
+  return &ilsCache.list;
+}
+
+void MapQuery::getMissingTiles(MapQueryMissingTiles& missing, const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                               map::MapTypes types) const
+{
+  missing = MapQueryMissingTiles();
+  if(mapLayer == nullptr)
+    return;
+
+  missing.addon = types.testFlag(map::AIRPORT_ADDON);
+  missing.normal = types & map::AIRPORT_ALL;
+  missing.minRunwayLength = mapLayer->getMinRunwayLength();
 
-  if(ilsCache.list.isEmpty() && !lazy)
+  if(mapLayer->isAirport() && (missing.addon || missing.normal))
   {
-    // ILS length is 9 NM * 1' per degree
-    double increase = atools::geo::toRadians(9. / 60.);
+    bool addon = missing.addon, normal = missing.normal;
+    airportCache.getMissingTiles(missing.airports, rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement,
+                                 [this, addon, normal](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+    {
+      return curLayer->hasSameQueryParametersAirport(newLayer) &&
+      airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
+    });
+  }
 
-    // Increase bounding rect since ILS has no bounding to query
-    rect.setBoundaries(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
+  if(mapLayer->isVor() && types.testFlag(map::VOR))
+    vorCache.getMissingTiles(missing.vors, rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement,
+                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+    {
+      return curLayer->hasSameQueryParametersVor(newLayer);
+    });
 
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+  if(mapLayer->isNdb() && types.testFlag(map::NDB))
+    ndbCache.getMissingTiles(missing.ndbs, rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement,
+                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
-      query::bindRect(r, ilsByRectQuery);
+      return curLayer->hasSameQueryParametersNdb(newLayer);
+    });
+}
 
-      ilsByRectQuery->exec();
-      while(ilsByRectQuery->next())
-      {
-        // ILS is always loaded from nav except if all is off
-        map::MapRunwayEnd end;
-        if(mapLayer->isIlsDetail() && !NavApp::isNavdataOff())
-          // Get the runway end to fix graphical alignment issues in map
-          end = NavApp::getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
-
-        MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
-        ilsCache.list.append(ils);
-      }
+void MapQuery::loadMissingTiles(MapQueryMissingTiles& missing)
+{
+  if(!missing.airports.isEmpty() && query::valid(Q_FUNC_INFO, airportByRectQuery))
+  {
+    airportByRectQuery->bindValue(":minlength", missing.minRunwayLength);
+    for(const GeoDataLatLonBox& rect : qAsConst(missing.airports.rects))
+    {
+      missing.airports.objects.append(QList<map::MapAirport>());
+      fetchAirportTile(rect, airportByRectQuery, false /* overview */, missing.addon, missing.normal,
+                       missing.airports.objects.last());
     }
   }
-  overflow = ilsCache.validate(queryMaxRows);
-  return &ilsCache.list;
+
+  if(!missing.vors.isEmpty() && query::valid(Q_FUNC_INFO, vorsByRectQuery))
+  {
+    for(const GeoDataLatLonBox& rect : qAsConst(missing.vors.rects))
+    {
+      missing.vors.objects.append(QList<map::MapVor>());
+      fetchVorTile(rect, missing.vors.objects.last());
+    }
+  }
+
+  if(!missing.ndbs.isEmpty() && query::valid(Q_FUNC_INFO, ndbsByRectQuery))
+  {
+    for(const GeoDataLatLonBox& rect : qAsConst(missing.ndbs.rects))
+    {
+      missing.ndbs.objects.append(QList<map::MapNdb>());
+      fetchNdbTile(rect, missing.ndbs.objects.last());
+    }
+  }
+}
+
+void MapQuery::insertMissingTiles(const MapQueryMissingTiles& missing)
+{
+  airportCache.insertMissingTiles(missing.airports, queryMaxRows);
+  vorCache.insertMissingTiles(missing.vors, queryMaxRows);
+  ndbCache.insertMissingTiles(missing.ndbs, queryMaxRows);
 }
 
 /*
@@ -1224,72 +1314,92 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
  * @param overview fetch only incomplete data for overview airports
  * @return pointer to the airport cache
  */
-const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                                      bool lazy, bool overview, bool addon, bool normal, bool& overflow)
+const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                      atools::sql::SqlQuery *query, bool lazy, bool overview, bool addon,
+                                                      bool normal, bool& overflow)
 {
   if(!query::valid(Q_FUNC_INFO, query))
     return nullptr;
 
-  AirportQuery *airportQueryNav = NavApp::getAirportQueryNav();
+  airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                           [this, addon, normal](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  {
+    return curLayer->hasSameQueryParametersAirport(newLayer) &&
+    // Invalidate cache if settings differ
+    airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
+  },
+                           [ =](const GeoDataLatLonBox& r, QList<map::MapAirport>& airports) -> void
+  {
+    fetchAirportTile(r, query, overview, addon, normal, airports);
+  });
 
-  if(airportCache.list.isEmpty() && !lazy)
+  airportCacheAddonFlag = addon;
+  airportCacheNormalFlag = normal;
+
+  overflow = airportCache.validate(queryMaxRows);
+  return &airportCache.list;
+}
+
+void MapQuery::fetchAirportTile(const GeoDataLatLonBox& rect, atools::sql::SqlQuery *query, bool overview, bool addon,
+                                bool normal, QList<map::MapAirport>& airports)
+{
+  AirportQuery *navQuery = getAirportQueryNav();
+  bool navdata = NavApp::isNavdataAll();
+  bool xplane = NavApp::isAirportDatabaseXPlane(navdata);
+
+  // Avoid duplicates between both queries
+  QSet<int> ids;
+
+  // Get normal airports ==========
+  if(normal)
   {
-    bool navdata = NavApp::isNavdataAll();
+    query::bindRect(rect, query);
+    query->exec();
 
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    // Resolve column ordinals once and not for each row
+    MapTypesColumns columns;
+    mapTypesFactory->initAirportColumns(columns, *query);
+    while(query->next())
     {
-      // Avoid duplicates between both queries
-      QSet<int> ids;
+      MapAirport airport;
+      if(overview)
+        // Fill only a part of the object
+        mapTypesFactory->fillAirportForOverview(*query, columns, airport, navdata, xplane);
+      else
+        mapTypesFactory->fillAirport(*query, columns, airport, navdata, xplane);
 
-      // Get normal airports ==========
-      if(normal)
-      {
-        query::bindRect(r, query);
-        query->exec();
-        while(query->next())
-        {
-          MapAirport airport;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(query->record(), airport, navdata, NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(query->record(), airport, true /* complete */, navdata, NavApp::isAirportDatabaseXPlane(navdata));
-
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
-
-          ids.insert(airport.id);
-          airportCache.list.append(airport);
-        }
-      }
+      // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+      navQuery->correctAirportProcedureFlag(airport);
 
-      // Get add-on airports ==========
-      if(addon && airportAddonByRectQuery != nullptr)
-      {
-        query::bindRect(r, airportAddonByRectQuery);
-        airportAddonByRectQuery->exec();
-        while(airportAddonByRectQuery->next())
-        {
-          MapAirport airport;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(airportAddonByRectQuery->record(), airport, navdata,
-                                                    NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), airport, true /* complete */, navdata,
-                                         NavApp::isAirportDatabaseXPlane(navdata));
-
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
-
-          if(!ids.contains(airport.id))
-            airportCache.list.append(airport);
-        }
-      }
+      ids.insert(airport.id);
+      airports.append(airport);
+    }
+  }
+
+  // Get add-on airports ==========
+  if(addon && airportAddonByRectQuery != nullptr)
+  {
+    query::bindRect(rect, airportAddonByRectQuery);
+    airportAddonByRectQuery->exec();
+
+    MapTypesColumns columns;
+    mapTypesFactory->initAirportColumns(columns, *airportAddonByRectQuery);
+    while(airportAddonByRectQuery->next())
+    {
+      MapAirport airport;
+      if(overview)
+        // Fill only a part of the object
+        mapTypesFactory->fillAirportForOverview(*airportAddonByRectQuery, columns, airport, navdata, xplane);
+      else
+        mapTypesFactory->fillAirport(*airportAddonByRectQuery, columns, airport, navdata, xplane);
+
+      // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+      navQuery->correctAirportProcedureFlag(airport);
+
+      if(!ids.contains(airport.id))
+        airports.append(airport);
     }
   }
-  overflow = airportCache.validate(queryMaxRows);
-  return &airportCache.list;
 }
 
 const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
@@ -1334,7 +1444,7 @@ void MapQuery::getRunwayEndByNameFuzzy(QList<map::MapRunwayEnd>& runwayEnds, con
 void MapQuery::runwayEndByNameFuzzy(QList<map::MapRunwayEnd>& runwayEnds, const QString& name,
                                     const map::MapAirport& airport, bool navData) const
 {
-  AirportQuery *aquery = navData ? NavApp::getAirportQueryNav() : NavApp::getAirportQuerySim();
+  AirportQuery *aquery = navData ? getAirportQueryNav() : getAirportQuerySim();
   map::MapResult result;
 
   if(!name.isEmpty())
@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_MAPQUERY_H
 
 #include "query/querytypes.h"
+#include "query/tilerectcache.h"
 
 #include <QCache>
 
@@ -37,9 +38,29 @@ class SqlQuery;
 }
 }
 
+class AirportQuery;
+class AirwayTrackQuery;
 class CoordinateConverter;
 class MapTypesFactory;
 class MapLayer;
+class WaypointTrackQuery;
+
+/* Tiles missing in the airport, VOR and NDB caches of MapQuery. Used to load tiles in a background thread. */
+struct MapQueryMissingTiles
+{
+  query::MissingTiles<map::MapAirport> airports;
+  query::MissingTiles<map::MapVor> vors;
+  query::MissingTiles<map::MapNdb> ndbs;
+
+  /* Airport query parameters */
+  int minRunwayLength = 0;
+  bool addon = false, normal = false;
+
+  bool isEmpty() const
+  {
+    return airports.isEmpty() && vors.isEmpty() && ndbs.isEmpty();
+  }
+};
 
 /*
  * Provides map related database queries.
@@ -59,6 +80,11 @@ public:
   MapQuery(const MapQuery& other) = delete;
   MapQuery& operator=(const MapQuery& other) = delete;
 
+  /* Use the given queries to resolve airports, runways, waypoints and airways instead of the global GUI queries
+   * from NavApp. Needed if this instance is used in another thread. Queries are not owned. */
+  void setQueries(AirportQuery *airportQuerySimParam, AirportQuery *airportQueryNavParam,
+                  WaypointTrackQuery *waypointTrackQueryParam, AirwayTrackQuery *airwayTrackQueryParam);
+
   /* Convert airport instances from/to simulator and third party nav databases */
   map::MapAirport  getAirportSim(const map::MapAirport& airport) const;
   map::MapAirport  getAirportNav(const map::MapAirport& airport) const;
@@ -239,6 +265,18 @@ public:
   QString getAirportIdentFromVor(const QString& ident, const QString& region, const atools::geo::Pos& pos, bool found) const;
   QString getAirportIdentFromNdb(const QString& ident, const QString& region, const atools::geo::Pos& pos, bool found) const;
 
+  /* Get tiles of getAirports(), getVors() and getNdbs() which are not cached yet for rect.
+   * Only types shown in the layer and in types are considered. Called in the GUI thread. */
+  void getMissingTiles(MapQueryMissingTiles& missing, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                       map::MapTypes types) const;
+
+  /* Load objects for missing tiles. Does not use or change the caches and can be called for an instance
+   * with its own database connections in a background thread. */
+  void loadMissingTiles(MapQueryMissingTiles& missing);
+
+  /* Add loaded tiles to the caches. Called in the GUI thread. */
+  void insertMissingTiles(const MapQueryMissingTiles& missing);
+
   /* Close all query objects thus disconnecting from the database */
   void initQueries();
 
@@ -260,8 +298,15 @@ private:
                                 const atools::geo::Pos& sortByDistancePos,
                                 float maxDistanceMeter, bool airportFromNavDatabase, map::AirportQueryFlags flags) const;
 
-  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                              bool lazy, bool overview, bool addon, bool normal, bool& overflow);
+  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                              atools::sql::SqlQuery *query, bool lazy, bool overview, bool addon, bool normal,
+                                              bool& overflow);
+
+  /* Load all objects for a tile rectangle not crossing the anti-meridian */
+  void fetchAirportTile(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query, bool overview, bool addon,
+                        bool normal, QList<map::MapAirport>& airports);
+  void fetchVorTile(const Marble::GeoDataLatLonBox& rect, QList<map::MapVor>& vors);
+  void fetchNdbTile(const Marble::GeoDataLatLonBox& rect, QList<map::MapNdb>& ndbs);
 
   QVector<map::MapIls> ilsByAirportAndRunway(const QString& airportIdent, const QString& runway) const;
 
@@ -270,20 +315,33 @@ private:
   QString airportIdentFromQuery(const QString& queryStr, const QString& ident, const QString& region,
                                 const atools::geo::Pos& pos, bool& found) const;
 
+  /* Get queries passed to setQueries() or the global GUI queries */
+  AirportQuery *getAirportQuerySim() const;
+  AirportQuery *getAirportQueryNav() const;
+  WaypointTrackQuery *getWaypointTrackQuery() const;
+  AirwayTrackQuery *getAirwayTrackQuery() const;
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbSim, *dbNav, *dbUser;
 
-  /* Simple bounding rectangle caches */
+  /* Not owned. Null if the GUI queries are used. */
+  AirportQuery *airportQuerySim = nullptr, *airportQueryNav = nullptr;
+  WaypointTrackQuery *waypointTrackQuery = nullptr;
+  AirwayTrackQuery *airwayTrackQuery = nullptr;
+
+  /* Tile based spatial caches */
   bool airportCacheAddonFlag = false; // Keep addon status flag for comparing
   bool airportCacheNormalFlag = false; // Keep normal (non add-on) status flag for comparing
-  query::SimpleRectCache<map::MapAirport> airportCache;
+  query::TileRectCache<map::MapAirport> airportCache;
+  query::TileRectCache<map::MapVor> vorCache;
+  query::TileRectCache<map::MapNdb> ndbCache;
+  query::TileRectCache<map::MapMarker> markerCache;
+  query::TileRectCache<map::MapHolding> holdingCache;
+  query::TileRectCache<map::MapIls> ilsCache;
+  query::TileRectCache<map::MapAirportMsa> airportMsaCache;
+
+  /* Simple bounding rectangle cache for user points which is filled manually */
   query::SimpleRectCache<map::MapUserpoint> userpointCache;
-  query::SimpleRectCache<map::MapVor> vorCache;
-  query::SimpleRectCache<map::MapNdb> ndbCache;
-  query::SimpleRectCache<map::MapMarker> markerCache;
-  query::SimpleRectCache<map::MapHolding> holdingCache;
-  query::SimpleRectCache<map::MapIls> ilsCache;
-  query::SimpleRectCache<map::MapAirportMsa> airportMsaCache;
 
   bool gls = false;
 
@@ -0,0 +1,153 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "query/procedureprefetcher.h"
+
+#include "app/navapp.h"
+#include "common/constants.h"
+#include "common/maptypes.h"
+#include "common/proctypes.h"
+#include "db/databasepool.h"
+#include "query/mapquery.h"
+#include "query/procedurequery.h"
+#include "settings/settings.h"
+
+#include <QElapsedTimer>
+
+ProcedurePrefetcher::ProcedurePrefetcher(QObject *parent)
+  : QObject(parent)
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  enabled = settings.getAndStoreValue(lnm::OPTIONS_PROCEDURE_PREFETCH, true).toBool();
+  verbose = settings.getAndStoreValue(lnm::OPTIONS_MAP_PREFETCH_DEBUG, false).toBool();
+
+  qDebug() << Q_FUNC_INFO << "enabled" << enabled;
+}
+
+ProcedurePrefetcher::~ProcedurePrefetcher()
+{
+  cancel();
+}
+
+void ProcedurePrefetcher::preDatabaseLoad()
+{
+  databaseLoading = true;
+
+  // Wait for threads before database pool is closed
+  cancel();
+  airportIds.clear();
+}
+
+void ProcedurePrefetcher::postDatabaseLoad()
+{
+  databaseLoading = false;
+}
+
+void ProcedurePrefetcher::cancel()
+{
+  for(QFutureWatcher<ProcedurePrefetchLegs> *watcher : qAsConst(watchers))
+  {
+    watcher->disconnect(this);
+    watcher->waitForFinished();
+    deleteLegs(watcher->result());
+    delete watcher;
+  }
+  watchers.clear();
+}
+
+void ProcedurePrefetcher::deleteLegs(const ProcedurePrefetchLegs& legs)
+{
+  qDeleteAll(legs.procedures);
+  qDeleteAll(legs.transitions);
+}
+
+void ProcedurePrefetcher::prefetch(const map::MapAirport& airport)
+{
+  DatabasePool *pool = NavApp::getDatabasePool();
+  if(!enabled || databaseLoading || !airport.isValid() || !airport.procedure() || !pool->isOpen())
+    return;
+
+  // Caches were cleared - prefetch again
+  ProcedureQuery *procedureQuery = NavApp::getProcedureQuery();
+  if(procedureQuery->getCacheGeneration() != cacheGeneration)
+  {
+    airportIds.clear();
+    cacheGeneration = procedureQuery->getCacheGeneration();
+  }
+
+  // Procedures are always loaded from the nav database
+  map::MapAirport airportNav(airport);
+  NavApp::getMapQueryGui()->getAirportNavReplace(airportNav);
+  if(!airportNav.isValid() || airportIds.contains(airportNav.id))
+    return;
+
+  airportIds.insert(airportNav.id);
+
+  const QVector<int> procedureIds = procedureQuery->getProcedureIdsForAirport(airportNav.id);
+  if(procedureIds.isEmpty())
+    return;
+
+  // Distribute procedures round robin across all connections of the pool
+  int numTasks = std::min(pool->getNumConnections(), procedureIds.size());
+  QVector<QVector<int> > taskProcedureIds(numTasks);
+  for(int i = 0; i < procedureIds.size(); i++)
+    taskProcedureIds[i % numTasks].append(procedureIds.at(i));
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << airportNav.ident << "procedures" << procedureIds.size() << "tasks" << numTasks;
+
+  bool verboseLog = verbose;
+  int generation = cacheGeneration;
+  for(const QVector<int>& ids : qAsConst(taskProcedureIds))
+  {
+    QFutureWatcher<ProcedurePrefetchLegs> *watcher = new QFutureWatcher<ProcedurePrefetchLegs>(this);
+    connect(watcher, &QFutureWatcher<ProcedurePrefetchLegs>::finished, this, [this, watcher]() {
+      legsFinished(watcher);
+    });
+    watchers.append(watcher);
+
+    // Build legs in pool thread using its own connections and procedure query
+    watcher->setFuture(pool->run([airportNav, ids, verboseLog, generation](DatabasePoolContext& context) -> ProcedurePrefetchLegs {
+      QElapsedTimer timer;
+      timer.start();
+
+      ProcedurePrefetchLegs legs;
+      legs.cacheGeneration = generation;
+      context.procedureQuery->createAllLegs(airportNav, ids, legs.procedures, legs.transitions);
+
+      if(verboseLog)
+        qDebug() << Q_FUNC_INFO << airportNav.ident << "procedures" << legs.procedures.size()
+                 << "transitions" << legs.transitions.size() << "in" << timer.elapsed() << "ms";
+      return legs;
+    }));
+  }
+}
+
+void ProcedurePrefetcher::legsFinished(QFutureWatcher<ProcedurePrefetchLegs> *watcher)
+{
+  watchers.removeOne(watcher);
+  watcher->deleteLater();
+
+  const ProcedurePrefetchLegs legs = watcher->result();
+  ProcedureQuery *procedureQuery = NavApp::getProcedureQuery();
+
+  // Drop legs if caches were cleared or database was switched in the meantime
+  if(databaseLoading || procedureQuery->getCacheGeneration() != legs.cacheGeneration)
+    deleteLegs(legs);
+  else
+    procedureQuery->insertAllLegs(legs.procedures, legs.transitions);
+}
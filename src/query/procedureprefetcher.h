@@ -0,0 +1,89 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_PROCEDUREPREFETCHER_H
+#define LNM_PROCEDUREPREFETCHER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+namespace map {
+struct MapAirport;
+}
+
+namespace proc {
+struct MapProcedureLegs;
+}
+
+/* Legs built in a pool thread. Owned by the receiver. */
+struct ProcedurePrefetchLegs
+{
+  QVector<proc::MapProcedureLegs *> procedures, transitions;
+
+  /* Cache generation of the procedure query when the task was started */
+  int cacheGeneration = -1;
+};
+
+/*
+ * Builds all SID, STAR, approach and transition legs of an airport in the DatabasePool and passes them to the
+ * global ProcedureQuery which keeps them apart from its caches until requested. Opening the procedure search or
+ * previewing procedures for big airports then does not have to build and process the legs in the GUI thread.
+ *
+ * Procedures of an airport are split across all pool connections. Results are dropped if the procedure caches
+ * were cleared in the meantime.
+ */
+class ProcedurePrefetcher :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ProcedurePrefetcher(QObject *parent);
+  virtual ~ProcedurePrefetcher() override;
+
+  ProcedurePrefetcher(const ProcedurePrefetcher& other) = delete;
+  ProcedurePrefetcher& operator=(const ProcedurePrefetcher& other) = delete;
+
+  /* Build procedures for airport in background if not already done. Airport can be from simulator or nav database. */
+  void prefetch(const map::MapAirport& airport);
+
+  /* Waits for the threads and drops the results */
+  void preDatabaseLoad();
+  void postDatabaseLoad();
+
+private:
+  /* Called by watcher in the GUI thread. Inserts the legs into the procedure query caches. */
+  void legsFinished(QFutureWatcher<ProcedurePrefetchLegs> *watcher);
+
+  /* Wait for all threads and delete results */
+  void cancel();
+
+  static void deleteLegs(const ProcedurePrefetchLegs& legs);
+
+  /* One watcher for each running task */
+  QVector<QFutureWatcher<ProcedurePrefetchLegs> *> watchers;
+
+  /* Nav airport ids already prefetched or in progress for the cache generation */
+  QSet<int> airportIds;
+  int cacheGeneration = -1;
+
+  bool enabled = true, databaseLoading = false, verbose = false;
+};
+
+#endif // LNM_PROCEDUREPREFETCHER_H
@@ -50,9 +50,10 @@ using proc::MapSpeedRestriction;
 namespace pln = atools::fs::pln;
 namespace ageo = atools::geo;
 
-ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav)
-  : dbNav(sqlDbNav)
+ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam, AirportQuery *airportQueryNavParam)
+  : dbNav(sqlDbNav), mapQuery(mapQueryParam), airportQueryNav(airportQueryNavParam)
 {
+  useGuiQueries = mapQueryParam == nullptr || airportQueryNavParam == nullptr;
 }
 
 ProcedureQuery::~ProcedureQuery()
@@ -62,13 +63,13 @@ ProcedureQuery::~ProcedureQuery()
 
 const proc::MapProcedureLegs *ProcedureQuery::getProcedureLegs(map::MapAirport airport, int procedureId)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(airport);
+  mapQuery->getAirportNavReplace(airport);
   return fetchProcedureLegs(airport, procedureId);
 }
 
 const proc::MapProcedureLegs *ProcedureQuery::getTransitionLegs(map::MapAirport airport, int transitionId)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(airport);
+  mapQuery->getAirportNavReplace(airport);
   return fetchTransitionLegs(airport, procedureIdForTransitionId(transitionId), transitionId);
 }
 
@@ -595,22 +596,20 @@ void ProcedureQuery::runwayEndByName(map::MapResult& result, const QString& name
 {
   Q_ASSERT(airport.navdata);
 
-  NavApp::getMapQueryGui()->getRunwayEndByNameFuzzy(result.runwayEnds, name, airport, true /* navdata */);
+  mapQuery->getRunwayEndByNameFuzzy(result.runwayEnds, name, airport, true /* navdata */);
 }
 
 void ProcedureQuery::runwayEndByNameSim(map::MapResult& result, const QString& name,
                                         const map::MapAirport& airport)
 {
   Q_ASSERT(!airport.navdata);
-  NavApp::getMapQueryGui()->getRunwayEndByNameFuzzy(result.runwayEnds, name, airport, false /* navdata */);
+  mapQuery->getRunwayEndByNameFuzzy(result.runwayEnds, name, airport, false /* navdata */);
 }
 
 void ProcedureQuery::mapObjectByIdent(map::MapResult& result, map::MapTypes type,
                                       const QString& ident, const QString& region, const QString& airport,
                                       const Pos& sortByDistancePos)
 {
-  MapQuery *mapQuery = NavApp::getMapQueryGui();
-
   mapQuery->getMapObjectByIdent(result, type, ident, region, airport, sortByDistancePos,
                                 nmToMeter(1000.f), true /* airport from nav database */);
   if(result.isEmpty(type))
@@ -688,6 +687,13 @@ proc::MapProcedureLegs *ProcedureQuery::fetchProcedureLegs(const map::MapAirport
 #ifndef DEBUG_APPROACH_NO_CACHE
   if(procedureCache.contains(procedureId))
     return procedureCache.object(procedureId);
+  else if(prefetchedProcedures.contains(procedureId))
+  {
+    // Built in background - move into cache
+    MapProcedureLegs *legs = prefetchedProcedures.take(procedureId);
+    insertProcedureCache(legs);
+    return legs;
+  }
   else
 #endif
   {
@@ -695,15 +701,69 @@ proc::MapProcedureLegs *ProcedureQuery::fetchProcedureLegs(const map::MapAirport
     qDebug() << Q_FUNC_INFO << airport.ident << "procedureId" << procedureId;
 #endif
 
-    MapProcedureLegs *legs = buildProcedureLegs(airport, procedureId);
+    MapProcedureLegs *legs = createProcedureLegs(airport, procedureId);
+    if(legs != nullptr)
+      insertProcedureCache(legs);
+    return legs;
+  }
+}
+
+proc::MapProcedureLegs *ProcedureQuery::createProcedureLegs(const map::MapAirport& airport, int procedureId)
+{
+  MapProcedureLegs *legs = buildProcedureLegs(airport, procedureId);
+  if(legs != nullptr)
     postProcessLegs(airport, *legs, true /*addArtificialLegs*/);
+  return legs;
+}
 
-    for(int i = 0; i < legs->size(); i++)
-      procedureLegIndex.insert(legs->at(i).legId, std::make_pair(procedureId, i));
+/* QCache deletes the least recently used objects on insert without notice. Remove index entries of these. */
+static void purgeLegIndex(const QCache<int, proc::MapProcedureLegs>& cache, QHash<int, QVector<int> >& legIds,
+                          QHash<int, std::pair<int, int> >& legIndex)
+{
+  if(legIds.size() <= cache.size())
+    return;
 
-    procedureCache.insert(procedureId, legs);
-    return legs;
+  for(auto it = legIds.begin(); it != legIds.end();)
+  {
+    if(!cache.contains(it.key()))
+    {
+      for(int legId : qAsConst(it.value()))
+        legIndex.remove(legId);
+      it = legIds.erase(it);
+    }
+    else
+      ++it;
+  }
+}
+
+void ProcedureQuery::insertProcedureCache(proc::MapProcedureLegs *legs)
+{
+  int procedureId = legs->ref.procedureId;
+  QVector<int>& legIds = procedureLegIds[procedureId];
+  legIds.clear();
+  for(int i = 0; i < legs->size(); i++)
+  {
+    procedureLegIndex.insert(legs->at(i).legId, std::make_pair(procedureId, i));
+    legIds.append(legs->at(i).legId);
+  }
+
+  procedureCache.insert(procedureId, legs);
+  purgeLegIndex(procedureCache, procedureLegIds, procedureLegIndex);
+}
+
+void ProcedureQuery::insertTransitionCache(proc::MapProcedureLegs *legs)
+{
+  int transitionId = legs->ref.transitionId;
+  QVector<int>& legIds = transitionLegIds[transitionId];
+  legIds.clear();
+  for(int i = 0; i < legs->size(); ++i)
+  {
+    transitionLegIndex.insert(legs->at(i).legId, std::make_pair(transitionId, i));
+    legIds.append(legs->at(i).legId);
   }
+
+  transitionCache.insert(transitionId, legs);
+  purgeLegIndex(transitionCache, transitionLegIds, transitionLegIndex);
 }
 
 proc::MapProcedureLegs *ProcedureQuery::fetchTransitionLegs(const map::MapAirport& airport, int procedureId, int transitionId)
@@ -716,6 +776,13 @@ proc::MapProcedureLegs *ProcedureQuery::fetchTransitionLegs(const map::MapAirpor
 #ifndef DEBUG_APPROACH_NO_CACHE
   if(transitionCache.contains(transitionId))
     return transitionCache.object(transitionId);
+  else if(prefetchedTransitions.contains(transitionId))
+  {
+    // Built in background - move into cache
+    MapProcedureLegs *legs = prefetchedTransitions.take(transitionId);
+    insertTransitionCache(legs);
+    return legs;
+  }
   else
 #endif
   {
@@ -724,57 +791,68 @@ proc::MapProcedureLegs *ProcedureQuery::fetchTransitionLegs(const map::MapAirpor
              << "transitionId" << transitionId;
 #endif
 
-    transitionLegQuery->bindValue(":id", transitionId);
-    transitionLegQuery->exec();
-
-    proc::MapProcedureLegs *legs = new proc::MapProcedureLegs;
-    legs->ref.airportId = airport.id;
-    legs->ref.procedureId = procedureId;
-    legs->ref.transitionId = transitionId;
-    legs->ref.mapType = legs->mapType;
+    proc::MapProcedureLegs *legs = createTransitionLegs(airport, procedureId, transitionId);
+    if(legs != nullptr)
+      insertTransitionCache(legs);
+    return legs;
+  }
+}
 
-    while(transitionLegQuery->next())
-    {
-      legs->transitionLegs.append(buildTransitionLegEntry(airport));
-      legs->transitionLegs.last().airportId = airport.id;
-      legs->transitionLegs.last().procedureId = procedureId;
-      legs->transitionLegs.last().transitionId = transitionId;
-    }
+proc::MapProcedureLegs *ProcedureQuery::createTransitionLegs(const map::MapAirport& airport, int procedureId, int transitionId)
+{
+  if(!query::valid(Q_FUNC_INFO, transitionLegQuery) || !query::valid(Q_FUNC_INFO, transitionQuery))
+    return nullptr;
 
-    // Add a full copy of the approach because approach legs will be modified for different transitions
-    proc::MapProcedureLegs *procedure = buildProcedureLegs(airport, procedureId);
-    legs->procedureLegs = procedure->procedureLegs;
-    legs->runwayEnd = procedure->runwayEnd;
-    legs->runway = procedure->runway;
-    legs->type = procedure->type;
-    legs->suffix = procedure->suffix;
-    legs->procedureFixIdent = procedure->procedureFixIdent;
-    legs->arincName = procedure->arincName;
-    legs->aircraftCategory = procedure->aircraftCategory;
-    legs->gpsOverlay = procedure->gpsOverlay;
-    legs->verticalAngle = procedure->verticalAngle;
-    legs->rnp = procedure->rnp;
-    legs->circleToLand = procedure->circleToLand;
+  transitionLegQuery->bindValue(":id", transitionId);
+  transitionLegQuery->exec();
 
-    delete procedure;
+  proc::MapProcedureLegs *legs = new proc::MapProcedureLegs;
+  legs->ref.airportId = airport.id;
+  legs->ref.procedureId = procedureId;
+  legs->ref.transitionId = transitionId;
+  legs->ref.mapType = legs->mapType;
 
-    transitionQuery->bindValue(":id", transitionId);
-    transitionQuery->exec();
-    if(transitionQuery->next())
-    {
-      legs->transitionType = transitionQuery->value("type").toString();
-      legs->transitionFixIdent = transitionQuery->value("fix_ident").toString();
-    }
-    transitionQuery->finish();
+  while(transitionLegQuery->next())
+  {
+    legs->transitionLegs.append(buildTransitionLegEntry(airport));
+    legs->transitionLegs.last().airportId = airport.id;
+    legs->transitionLegs.last().procedureId = procedureId;
+    legs->transitionLegs.last().transitionId = transitionId;
+  }
 
-    postProcessLegs(airport, *legs, true /*addArtificialLegs*/);
+  // Add a full copy of the approach because approach legs will be modified for different transitions
+  proc::MapProcedureLegs *procedure = buildProcedureLegs(airport, procedureId);
+  if(procedure == nullptr)
+  {
+    delete legs;
+    return nullptr;
+  }
+  legs->procedureLegs = procedure->procedureLegs;
+  legs->runwayEnd = procedure->runwayEnd;
+  legs->runway = procedure->runway;
+  legs->type = procedure->type;
+  legs->suffix = procedure->suffix;
+  legs->procedureFixIdent = procedure->procedureFixIdent;
+  legs->arincName = procedure->arincName;
+  legs->aircraftCategory = procedure->aircraftCategory;
+  legs->gpsOverlay = procedure->gpsOverlay;
+  legs->verticalAngle = procedure->verticalAngle;
+  legs->rnp = procedure->rnp;
+  legs->circleToLand = procedure->circleToLand;
 
-    for(int i = 0; i < legs->size(); ++i)
-      transitionLegIndex.insert(legs->at(i).legId, std::make_pair(transitionId, i));
+  delete procedure;
 
-    transitionCache.insert(transitionId, legs);
-    return legs;
+  transitionQuery->bindValue(":id", transitionId);
+  transitionQuery->exec();
+  if(transitionQuery->next())
+  {
+    legs->transitionType = transitionQuery->value("type").toString();
+    legs->transitionFixIdent = transitionQuery->value("fix_ident").toString();
   }
+  transitionQuery->finish();
+
+  postProcessLegs(airport, *legs, true /*addArtificialLegs*/);
+  return legs;
 }
 
 proc::MapProcedureLegs *ProcedureQuery::buildProcedureLegs(const map::MapAirport& airport, int procedureId)
@@ -1230,7 +1308,7 @@ void ProcedureQuery::processLegErrors(proc::MapProcedureLegs& legs) const
 
 void ProcedureQuery::processLegsFixRestrictions(const map::MapAirport& airport, proc::MapProcedureLegs& legs) const
 {
-  const map::MapAirport airportSim = NavApp::getMapQueryGui()->getAirportSim(airport);
+  const map::MapAirport airportSim = mapQuery->getAirportSim(airport);
   float airportAlt = airportSim.isValid() ? airportSim.position.getAltitude() : airport.position.getAltitude();
 
   for(int i = 1; i < legs.size(); i++)
@@ -1957,7 +2035,11 @@ void ProcedureQuery::processCourseInterceptLegs(proc::MapProcedureLegs& legs) co
 
 void ProcedureQuery::initQueries()
 {
-  airportQueryNav = NavApp::getAirportQueryNav();
+  if(useGuiQueries)
+  {
+    mapQuery = NavApp::getMapQueryGui();
+    airportQueryNav = NavApp::getAirportQueryNav();
+  }
 
   deInitQueries();
 
@@ -2025,14 +2107,14 @@ void ProcedureQuery::initQueries()
 
   transitionIdsForProcedureQuery = new SqlQuery(dbNav);
   transitionIdsForProcedureQuery->prepare("select transition_id from transition where approach_id = :id");
+
+  procedureIdsForAirportQuery = new SqlQuery(dbNav);
+  procedureIdsForAirportQuery->prepare("select approach_id from approach where airport_id = :id");
 }
 
 void ProcedureQuery::deInitQueries()
 {
-  procedureCache.clear();
-  transitionCache.clear();
-  procedureLegIndex.clear();
-  transitionLegIndex.clear();
+  clearCaches();
 
   ATOOLS_DELETE(procedureLegQuery);
   ATOOLS_DELETE(transitionLegQuery);
@@ -2047,6 +2129,7 @@ void ProcedureQuery::deInitQueries()
   ATOOLS_DELETE(sidTransIdByWpQuery);
   ATOOLS_DELETE(starTransIdByWpQuery);
   ATOOLS_DELETE(transitionIdsForProcedureQuery);
+  ATOOLS_DELETE(procedureIdsForAirportQuery);
 }
 
 void ProcedureQuery::clearFlightplanProcedureProperties(QHash<QString, QString>& properties, const proc::MapProcedureTypes& type)
@@ -2199,7 +2282,7 @@ proc::MapProcedureTypes ProcedureQuery::getMissingProcedures(QHash<QString, QStr
 
 int ProcedureQuery::getSidId(map::MapAirport departure, const QString& sid, const QString& runway, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(departure);
+  mapQuery->getAirportNavReplace(departure);
 
   int sidApprId = -1;
   // Get a SID id =================================================================
@@ -2223,7 +2306,7 @@ int ProcedureQuery::getSidId(map::MapAirport departure, const QString& sid, cons
 
 int ProcedureQuery::getSidTransitionId(map::MapAirport departure, const QString& sidTrans, int sidId, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(departure);
+  mapQuery->getAirportNavReplace(departure);
 
   int sidTransId = -1;
   // Get a SID transition id =================================================================
@@ -2243,7 +2326,7 @@ int ProcedureQuery::getSidTransitionId(map::MapAirport departure, const QString&
 
 int ProcedureQuery::getSidTransitionIdByWp(map::MapAirport departure, const QString& transWaypoint, int sidId, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(departure);
+  mapQuery->getAirportNavReplace(departure);
 
   int sidTransId = -1;
   // Get a SID transition id =================================================================
@@ -2262,7 +2345,7 @@ int ProcedureQuery::getSidTransitionIdByWp(map::MapAirport departure, const QStr
 
 int ProcedureQuery::getStarId(map::MapAirport destination, const QString& star, const QString& runway, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(destination);
+  mapQuery->getAirportNavReplace(destination);
 
   int starId = -1;
   // Get a STAR id =================================================================
@@ -2286,7 +2369,7 @@ int ProcedureQuery::getStarId(map::MapAirport destination, const QString& star,
 
 int ProcedureQuery::getStarTransitionId(map::MapAirport destination, const QString& starTrans, int starId, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(destination);
+  mapQuery->getAirportNavReplace(destination);
 
   int starTransId = -1;
   // Get a STAR transition id =================================================================
@@ -2305,7 +2388,7 @@ int ProcedureQuery::getStarTransitionId(map::MapAirport destination, const QStri
 
 int ProcedureQuery::getApprOrStarTransitionIdByWp(map::MapAirport destination, const QString& transWaypoint, int starId, bool strict)
 {
-  NavApp::getMapQueryGui()->getAirportNavReplace(destination);
+  mapQuery->getAirportNavReplace(destination);
 
   int starTransId = -1;
   // Get a STAR transition id =================================================================
@@ -2324,7 +2407,7 @@ int ProcedureQuery::getApprOrStarTransitionIdByWp(map::MapAirport destination, c
 int ProcedureQuery::getApproachId(map::MapAirport destination, const QString& arincName, const QString& runway)
 {
   int approachId = -1;
-  NavApp::getMapQueryGui()->getAirportNavReplace(destination);
+  mapQuery->getAirportNavReplace(destination);
 
   if(destination.isValid())
   {
@@ -2358,7 +2441,7 @@ int ProcedureQuery::getApproachId(map::MapAirport destination, const QString& ar
 int ProcedureQuery::getTransitionId(map::MapAirport destination, const QString& fixIdent, const QString& type, int approachId)
 {
   int transitionId = -1;
-  NavApp::getMapQueryGui()->getAirportNavReplace(destination);
+  mapQuery->getAirportNavReplace(destination);
 
   if(destination.isValid())
   {
@@ -2539,11 +2622,23 @@ void ProcedureQuery::createCustomDeparture(proc::MapProcedureLegs& procedure, co
 void ProcedureQuery::clearCache()
 {
   qDebug() << Q_FUNC_INFO;
+  clearCaches();
+}
 
+void ProcedureQuery::clearCaches()
+{
+  cacheGeneration++;
   procedureCache.clear();
   transitionCache.clear();
   procedureLegIndex.clear();
   transitionLegIndex.clear();
+  procedureLegIds.clear();
+  transitionLegIds.clear();
+
+  qDeleteAll(prefetchedProcedures);
+  prefetchedProcedures.clear();
+  qDeleteAll(prefetchedTransitions);
+  prefetchedTransitions.clear();
 }
 
 QVector<int> ProcedureQuery::getTransitionIdsForProcedure(int procedureId)
@@ -2561,6 +2656,86 @@ QVector<int> ProcedureQuery::getTransitionIdsForProcedure(int procedureId)
   return transitionIds;
 }
 
+QVector<int> ProcedureQuery::getProcedureIdsForAirport(int airportId)
+{
+  QVector<int> procedureIds;
+
+  if(!query::valid(Q_FUNC_INFO, procedureIdsForAirportQuery))
+    return procedureIds;
+
+  procedureIdsForAirportQuery->bindValue(":id", airportId);
+  procedureIdsForAirportQuery->exec();
+
+  while(procedureIdsForAirportQuery->next())
+    procedureIds.append(procedureIdsForAirportQuery->value("approach_id").toInt());
+  return procedureIds;
+}
+
+void ProcedureQuery::createAllLegs(const map::MapAirport& airport, const QVector<int>& procedureIds,
+                                   QVector<proc::MapProcedureLegs *>& procedures, QVector<proc::MapProcedureLegs *>& transitions)
+{
+  Q_ASSERT(airport.navdata);
+
+  for(int procedureId : procedureIds)
+  {
+    proc::MapProcedureLegs *legs = createProcedureLegs(airport, procedureId);
+    if(legs != nullptr)
+      procedures.append(legs);
+
+    for(int transitionId : getTransitionIdsForProcedure(procedureId))
+    {
+      legs = createTransitionLegs(airport, procedureId, transitionId);
+      if(legs != nullptr)
+        transitions.append(legs);
+    }
+  }
+}
+
+void ProcedureQuery::insertAllLegs(const QVector<proc::MapProcedureLegs *>& procedures,
+                                   const QVector<proc::MapProcedureLegs *>& transitions)
+{
+  // Drop legs of other airports if too many are kept - caches are not touched
+  if(prefetchedProcedures.size() + prefetchedTransitions.size() + procedures.size() + transitions.size() > MAX_PREFETCHED_LEGS)
+  {
+    int airportId = -1;
+    if(!procedures.isEmpty())
+      airportId = procedures.constFirst()->ref.airportId;
+    else if(!transitions.isEmpty())
+      airportId = transitions.constFirst()->ref.airportId;
+
+    for(QHash<int, proc::MapProcedureLegs *> *prefetched : {&prefetchedProcedures, &prefetchedTransitions})
+    {
+      for(auto it = prefetched->begin(); it != prefetched->end();)
+      {
+        if(it.value()->ref.airportId != airportId)
+        {
+          delete it.value();
+          it = prefetched->erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+  }
+
+  // Keep legs already loaded on demand since these might be referenced
+  for(proc::MapProcedureLegs *legs : procedures)
+  {
+    if(procedureCache.contains(legs->ref.procedureId) || prefetchedProcedures.contains(legs->ref.procedureId))
+      delete legs;
+    else
+      prefetchedProcedures.insert(legs->ref.procedureId, legs);
+  }
+
+  for(proc::MapProcedureLegs *legs : transitions)
+  {
+    if(transitionCache.contains(legs->ref.transitionId) || prefetchedTransitions.contains(legs->ref.transitionId))
+      delete legs;
+    else
+      prefetchedTransitions.insert(legs->ref.transitionId, legs);
+  }
+}
+
 QString ProcedureQuery::runwayErrorString(const QString& runway)
 {
   return runway.isEmpty() ? tr("no runway") : tr("runway %1").arg(runway);
@@ -2573,7 +2748,6 @@ void ProcedureQuery::getLegsForFlightplanProperties(const QHash<QString, QString
                                                     QStringList& errors, bool autoresolveTransition)
 {
   errors.clear();
-  MapQuery *mapQuery = NavApp::getMapQueryGui();
   map::MapAirport departureNav = mapQuery->getAirportNav(departure);
   map::MapAirport destinationNav = mapQuery->getAirportNav(destination);
 
@@ -67,8 +67,10 @@ public:
   /*
    * @param sqlDb database for simulator scenery data
    * @param sqlDbNav for updated navaids
+   * @param mapQueryParam and airportQueryNavParam Queries used to resolve navaids and runways. The global GUI
+   * queries from NavApp are used if null. Pass own queries if this instance is used in another thread.
    */
-  ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav);
+  ProcedureQuery(atools::sql::SqlDatabase *sqlDbNav, MapQuery *mapQueryParam = nullptr, AirportQuery *airportQueryNavParam = nullptr);
   ~ProcedureQuery();
 
   /* Do not allow copying */
@@ -91,6 +93,24 @@ public:
   /* Get all available transitions for the given procedure ID (approach.approach_id in database */
   QVector<int> getTransitionIdsForProcedure(int procedureId);
 
+  /* Get all SID, STAR and approach IDs for the given nav airport */
+  QVector<int> getProcedureIdsForAirport(int airportId);
+
+  /* Build legs of all given procedures and their transitions without using the caches. Airport has to be from the nav database.
+   * Used with a separate instance in threads of the database pool. Caller takes ownership. */
+  void createAllLegs(const map::MapAirport& airport, const QVector<int>& procedureIds,
+                     QVector<proc::MapProcedureLegs *>& procedures, QVector<proc::MapProcedureLegs *>& transitions);
+
+  /* Keep legs created by createAllLegs() until they are requested. Takes ownership and deletes legs which are
+   * already cached or kept. Legs are moved into the caches on demand and do not evict cached legs before. */
+  void insertAllLegs(const QVector<proc::MapProcedureLegs *>& procedures, const QVector<proc::MapProcedureLegs *>& transitions);
+
+  /* Incremented each time the caches are cleared. Used to drop precomputed legs which are outdated. */
+  int getCacheGeneration() const
+  {
+    return cacheGeneration;
+  }
+
   /* Resolves all procedures based on given properties and loads them from the database.
    * Procedures are partially resolved in a fuzzy way. */
   void getLegsForFlightplanProperties(const QHash<QString, QString>& properties,
@@ -223,6 +243,18 @@ private:
   proc::MapProcedureLegs *buildProcedureLegs(const map::MapAirport& airport, int procedureId);
   proc::MapProcedureLegs *fetchProcedureLegs(const map::MapAirport& airport, int procedureId);
   proc::MapProcedureLegs *fetchTransitionLegs(const map::MapAirport& airport, int procedureId, int transitionId);
+
+  /* Build and post process legs without adding them to the caches */
+  proc::MapProcedureLegs *createProcedureLegs(const map::MapAirport& airport, int procedureId);
+  proc::MapProcedureLegs *createTransitionLegs(const map::MapAirport& airport, int procedureId, int transitionId);
+
+  /* Add to cache and leg index. Takes ownership. Removes index entries of legs evicted from the cache. */
+  void insertProcedureCache(proc::MapProcedureLegs *legs);
+  void insertTransitionCache(proc::MapProcedureLegs *legs);
+
+  /* Clear caches, leg index and prefetched legs */
+  void clearCaches();
+
   int procedureIdForTransitionId(int transitionId);
   void mapObjectByIdent(map::MapResult& result, map::MapTypes type, const QString& ident, const QString& region, const QString& airport,
                         const atools::geo::Pos& sortByDistancePos);
@@ -256,7 +288,7 @@ private:
                         *runwayEndIdQuery = nullptr, *transitionQuery = nullptr, *procedureQuery = nullptr,
                         *transitionIdByNameQuery = nullptr, *sidTransIdByWpQuery = nullptr, *starTransIdByWpQuery = nullptr,
                         *procedureIdByNameQuery = nullptr, *procedureIdByArincNameQuery = nullptr,
-                        *transitionIdsForProcedureQuery = nullptr;
+                        *transitionIdsForProcedureQuery = nullptr, *procedureIdsForAirportQuery = nullptr;
 
   /* approach ID and transition ID to full lists
    * The procedure also has to be stored for transitions since the handover can modify procedure legs (CI legs, etc.) */
@@ -265,8 +297,23 @@ private:
   /* maps leg ID to procedure/transition ID and index in list */
   QHash<int, std::pair<int, int> > procedureLegIndex, transitionLegIndex;
 
+  /* procedure/transition ID to leg IDs in the index. Used to purge the index after eviction from the cache. */
+  QHash<int, QVector<int> > procedureLegIds, transitionLegIds;
+
+  /* Legs built by prefetching. Owned and moved into the caches above when requested. */
+  QHash<int, proc::MapProcedureLegs *> prefetchedProcedures, prefetchedTransitions;
+
+  MapQuery *mapQuery = nullptr;
   AirportQuery *airportQueryNav = nullptr;
 
+  /* Fetch GUI queries from NavApp in initQueries() if true */
+  bool useGuiQueries = true;
+
+  int cacheGeneration = 0;
+
+  /* Prefetched legs of other airports are dropped if more procedures and transitions are kept */
+  Q_DECL_CONSTEXPR static int MAX_PREFETCHED_LEGS = 3000;
+
   /* Dummy used for custom approaches. */
   Q_DECL_CONSTEXPR static int CUSTOM_APPROACH_ID = 1000000000;
   Q_DECL_CONSTEXPR static int CUSTOM_DEPARTURE_ID = 1000000001;
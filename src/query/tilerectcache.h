@@ -0,0 +1,356 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_TILERECTCACHE_H
+#define LNM_TILERECTCACHE_H
+
+#include "query/querytypes.h"
+
+#include <QCache>
+#include <QSet>
+#include <QVector>
+
+#include <functional>
+
+class MapLayer;
+
+namespace query {
+
+/*
+ * Tiles missing in a TileRectCache which can be loaded outside of the cache, e.g. in a background thread.
+ * keys and rects are filled by TileRectCache::getMissingTiles() and objects by the loader with one list per rect.
+ */
+template<typename TYPE>
+struct MissingTiles
+{
+  QVector<quint64> keys;
+  QVector<Marble::GeoDataLatLonBox> rects;
+  QVector<QList<TYPE> > objects;
+
+  /* Cache generation at the time of the request. Used to drop outdated results. */
+  quint64 generation = 0;
+
+  bool isEmpty() const
+  {
+    return keys.isEmpty();
+  }
+};
+
+/*
+ * Spatial cache which keeps objects in fixed lat/lon tiles instead of one single bounding rectangle.
+ *
+ * Tile size is a power of two fraction of 180 degree and depends on the size of the requested rectangle. Tiles of
+ * all sizes are kept in a LRU cache limited by an approximate size in bytes. Panning therefore only fetches newly
+ * exposed tiles and zooming back and forth reuses already loaded tiles.
+ *
+ * All tiles are dropped if the map layer has different query parameters, if the cache is cleared or if a
+ * tile was truncated by the query row limit.
+ *
+ * list contains all objects of the tiles overlapping the inflated request rectangle. Objects on tile borders or
+ * objects overlapping more than one tile are added only once. Since this uses the id, TYPE needs an integer field id.
+ */
+template<typename TYPE>
+class TileRectCache
+{
+public:
+  typedef std::function<bool (const MapLayer *curLayer, const MapLayer *mapLayer)> LayerCompareFunc;
+
+  /* Load all objects for a tile rectangle which never crosses the anti-meridian */
+  typedef std::function<void (const Marble::GeoDataLatLonBox& rect, QList<TYPE>& objects)> FetchFunc;
+
+  explicit TileRectCache(int maxKb = 16384)
+  {
+    setMaxKb(maxKb);
+  }
+
+  /* Cost is approximated by the size of the object structures */
+  void setMaxKb(int maxKb)
+  {
+    tiles.setMaxCost(std::max(maxKb, 1));
+  }
+
+  /*
+   * @param rect bounding rectangle - all objects inside this rectangle are returned
+   * @param mapLayer current map layer
+   * @param lazy if true do not fetch new data but return the old potentially incomplete dataset
+   * @param funcFetch called to load missing tiles
+   * @return true if list was rebuilt
+   */
+  bool updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor, double increment,
+                   bool lazy, LayerCompareFunc funcSameLayer, FetchFunc funcFetch);
+
+  /* Remove all tiles and objects. Call if filter parameters not covered by map layer have changed. */
+  void clear();
+
+  /* Returns true in case of overflow and removes the truncated tiles */
+  bool validate(int queryMaxRows);
+
+  /* Get all tiles needed for rect which are not loaded yet. Returns nothing if the layer differs from the
+   * one used for the last update since all tiles would be dropped anyway. */
+  void getMissingTiles(MissingTiles<TYPE>& missing, const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                       double factor, double increment, LayerCompareFunc funcSameLayer) const;
+
+  /* Add tiles loaded from getMissingTiles(). Ignored if the cache was cleared in the meantime.
+   * Tiles filled up to queryMaxRows are ignored since they are probably truncated. */
+  void insertMissingTiles(const MissingTiles<TYPE>& missing, int queryMaxRows);
+
+  /* Objects for the last rectangle */
+  QList<TYPE> list;
+
+private:
+  struct Tile
+  {
+    QList<TYPE> objects;
+  };
+
+  /* Smallest tile is 180 / 2^MAX_LEVEL degree */
+  static Q_DECL_CONSTEXPR int MIN_LEVEL = 2;
+  static Q_DECL_CONSTEXPR int MAX_LEVEL = 10;
+
+  /* Level, column and row combined */
+  static quint64 tileKey(int level, int x, int y)
+  {
+    return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(x) << 24) | static_cast<quint64>(y);
+  }
+
+  static Marble::GeoDataLatLonBox tileRect(int level, int x, int y);
+
+  /* Get keys and rectangles of all tiles covering the inflated rectangle using the level for its size */
+  static void tileKeysForRect(QVector<quint64>& keys, QVector<Marble::GeoDataLatLonBox>& rects,
+                              const Marble::GeoDataLatLonBox& rect, double factor, double increment);
+
+  static int costKb(const Tile& tile)
+  {
+    return std::max(static_cast<int>((tile.objects.size() * sizeof(TYPE) + sizeof(Tile)) / 1024), 1);
+  }
+
+  /* Collect keys for all tiles overlapping rect. rect must not cross the anti-meridian. */
+  static void tileKeys(QVector<quint64>& keys, QVector<Marble::GeoDataLatLonBox>& rects,
+                       const Marble::GeoDataLatLonBox& rect, int level);
+
+  QCache<quint64, Tile> tiles;
+
+  /* Sorted tile keys and layer used for list */
+  QVector<quint64> curKeys;
+  const MapLayer *curMapLayer = nullptr;
+
+  /* Incremented each time all tiles are dropped */
+  quint64 generation = 0;
+};
+
+// ---------------------------------------------------------------------------------
+
+template<typename TYPE>
+Marble::GeoDataLatLonBox TileRectCache<TYPE>::tileRect(int level, int x, int y)
+{
+  double size = 180. / (1 << level);
+  double west = -180. + x * size, south = -90. + y * size;
+  return Marble::GeoDataLatLonBox(std::min(south + size, 90.), south, std::min(west + size, 180.), west,
+                                  Marble::GeoDataCoordinates::Degree);
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::tileKeys(QVector<quint64>& keys, QVector<Marble::GeoDataLatLonBox>& rects,
+                                   const Marble::GeoDataLatLonBox& rect, int level)
+{
+  double size = 180. / (1 << level);
+  int columns = 2 << level, rows = 1 << level;
+
+  int xStart = std::max(static_cast<int>((rect.west(Marble::GeoDataCoordinates::Degree) + 180.) / size), 0);
+  int xEnd = std::min(static_cast<int>((rect.east(Marble::GeoDataCoordinates::Degree) + 180.) / size), columns - 1);
+  int yStart = std::max(static_cast<int>((rect.south(Marble::GeoDataCoordinates::Degree) + 90.) / size), 0);
+  int yEnd = std::min(static_cast<int>((rect.north(Marble::GeoDataCoordinates::Degree) + 90.) / size), rows - 1);
+
+  for(int y = yStart; y <= yEnd; y++)
+  {
+    for(int x = xStart; x <= xEnd; x++)
+    {
+      quint64 key = tileKey(level, x, y);
+      if(!keys.contains(key))
+      {
+        keys.append(key);
+        rects.append(tileRect(level, x, y));
+      }
+    }
+  }
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::tileKeysForRect(QVector<quint64>& keys, QVector<Marble::GeoDataLatLonBox>& rects,
+                                          const Marble::GeoDataLatLonBox& rect, double factor, double increment)
+{
+  // Use two to four tiles across the larger side of the rectangle
+  double span = std::max(rect.width(Marble::GeoDataCoordinates::Degree), rect.height(Marble::GeoDataCoordinates::Degree));
+  int level = MIN_LEVEL;
+  while(level < MAX_LEVEL && 180. / (1 << (level + 1)) >= span / 2.)
+    level++;
+
+  for(const Marble::GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, factor, increment))
+    tileKeys(keys, rects, r, level);
+}
+
+template<typename TYPE>
+bool TileRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor,
+                                      double increment, bool lazy, LayerCompareFunc funcSameLayer, FetchFunc funcFetch)
+{
+  if(lazy)
+    // Nothing changed
+    return false;
+
+#ifndef DEBUG_DISABLE_RECT_CACHE
+  if(curMapLayer == nullptr || !funcSameLayer(curMapLayer, mapLayer))
+#else
+  Q_UNUSED(funcSameLayer)
+#endif
+  {
+    // New layer selected - objects in tiles might be different
+    tiles.clear();
+    curKeys.clear();
+    list.clear();
+    generation++;
+  }
+  curMapLayer = mapLayer;
+
+  // Get all tiles covering the inflated rectangle ==============================
+  QVector<quint64> keys;
+  QVector<Marble::GeoDataLatLonBox> rects;
+  tileKeysForRect(keys, rects, rect, factor, increment);
+
+  QVector<quint64> sortedKeys(keys);
+  std::sort(sortedKeys.begin(), sortedKeys.end());
+
+  if(sortedKeys == curKeys && !list.isEmpty())
+    // Same tiles - nothing to do
+    return false;
+
+  // Build list from cached and newly fetched tiles ==============================
+  list.clear();
+  QSet<int> ids;
+  for(int i = 0; i < keys.size(); i++)
+  {
+    Tile *tile = tiles.object(keys.at(i));
+    Tile newTile;
+    if(tile == nullptr)
+    {
+      funcFetch(rects.at(i), newTile.objects);
+      tile = &newTile;
+    }
+
+    for(const TYPE& obj : qAsConst(tile->objects))
+    {
+      // Avoid duplicates from tile borders
+      if(!ids.contains(obj.id))
+      {
+        ids.insert(obj.id);
+        list.append(obj);
+      }
+    }
+
+    // Insert after copying objects since the cache might delete the tile immediately if too large
+    if(tile == &newTile)
+    {
+      int cost = costKb(newTile);
+      tiles.insert(keys.at(i), new Tile(std::move(newTile)), cost);
+    }
+  }
+
+  curKeys = sortedKeys;
+  return true;
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::getMissingTiles(MissingTiles<TYPE>& missing, const Marble::GeoDataLatLonBox& rect,
+                                          const MapLayer *mapLayer, double factor, double increment,
+                                          LayerCompareFunc funcSameLayer) const
+{
+  missing.keys.clear();
+  missing.rects.clear();
+  missing.objects.clear();
+  missing.generation = generation;
+
+  if(curMapLayer == nullptr || mapLayer == nullptr || !funcSameLayer(curMapLayer, mapLayer))
+    return;
+
+  QVector<quint64> keys;
+  QVector<Marble::GeoDataLatLonBox> rects;
+  tileKeysForRect(keys, rects, rect, factor, increment);
+
+  for(int i = 0; i < keys.size(); i++)
+  {
+    if(!tiles.contains(keys.at(i)))
+    {
+      missing.keys.append(keys.at(i));
+      missing.rects.append(rects.at(i));
+    }
+  }
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::insertMissingTiles(const MissingTiles<TYPE>& missing, int queryMaxRows)
+{
+  if(missing.generation != generation || missing.objects.size() != missing.keys.size())
+    // Cache was cleared or layer changed - tiles might be loaded with different parameters
+    return;
+
+  for(int i = 0; i < missing.keys.size(); i++)
+  {
+    quint64 key = missing.keys.at(i);
+    if(!tiles.contains(key) && missing.objects.at(i).size() < queryMaxRows)
+    {
+      Tile *tile = new Tile;
+      tile->objects = missing.objects.at(i);
+      tiles.insert(key, tile, costKb(*tile));
+    }
+  }
+}
+
+template<typename TYPE>
+bool TileRectCache<TYPE>::validate(int queryMaxRows)
+{
+  bool overflow = list.size() >= queryMaxRows;
+
+  for(quint64 key : qAsConst(curKeys))
+  {
+    const Tile *tile = tiles.object(key);
+    if(tile != nullptr && tile->objects.size() >= queryMaxRows)
+    {
+      // Tile was truncated by the query limit - load again next time
+      tiles.remove(key);
+      overflow = true;
+    }
+  }
+
+  if(overflow)
+    // Force rebuild of list on next update
+    curKeys.clear();
+
+  return overflow;
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::clear()
+{
+  tiles.clear();
+  list.clear();
+  curKeys.clear();
+  curMapLayer = nullptr;
+  generation++;
+}
+
+} // namespace query
+
+#endif // LNM_TILERECTCACHE_H
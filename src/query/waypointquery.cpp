@@ -43,6 +43,11 @@ WaypointQuery::WaypointQuery(SqlDatabase *sqlDbNav, bool trackDatabaseParam)
   queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
   queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
   queryMaxRowsWaypoints = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "WaypointQueryRowLimit1", map::MAX_MAP_OBJECTS * 2).toInt();
+
+  // Memory limit for each tile cache
+  int tileCacheKb = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheKb", 16384).toInt();
+  waypointCache.setMaxKb(tileCacheKb);
+  waypointAirwayCache.setMaxKb(tileCacheKb);
   waypointInfoCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "WaypointCache", 100).toInt());
 }
 
@@ -157,27 +162,59 @@ const QList<map::MapWaypoint> *WaypointQuery::getWaypoints(const GeoDataLatLonBo
                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer);
+  },
+                            [ =](const GeoDataLatLonBox& r, QList<map::MapWaypoint>& objects) -> void
+  {
+    fetchWaypointTile(r, objects);
   });
+  overflow = waypointCache.validate(queryMaxRowsWaypoints);
+  return &waypointCache.list;
+}
 
-  if(waypointCache.list.isEmpty() && !lazy)
+void WaypointQuery::fetchWaypointTile(const GeoDataLatLonBox& rect, QList<map::MapWaypoint>& waypoints)
+{
+  query::bindRect(rect, waypointsByRectQuery);
+  waypointsByRectQuery->exec();
+
+  MapTypesColumns columns;
+  mapTypesFactory->initWaypointColumns(columns, *waypointsByRectQuery, trackDatabase);
+  while(waypointsByRectQuery->next())
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
-    {
-      query::bindRect(r, waypointsByRectQuery);
-      waypointsByRectQuery->exec();
-      while(waypointsByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp, trackDatabase);
-
-        // Avoid artificial waypoints created only for procedure or airway resolution
-        if(wp.artificial == map::WAYPOINT_ARTIFICIAL_NONE)
-          waypointCache.list.append(wp);
-      }
-    }
+    map::MapWaypoint wp;
+    mapTypesFactory->fillWaypoint(*waypointsByRectQuery, columns, wp, trackDatabase);
+
+    // Avoid artificial waypoints created only for procedure or airway resolution
+    if(wp.artificial == map::WAYPOINT_ARTIFICIAL_NONE)
+      waypoints.append(wp);
+  }
+}
+
+void WaypointQuery::getMissingWaypointTiles(query::MissingTiles<map::MapWaypoint>& missing, const GeoDataLatLonBox& rect,
+                                            const MapLayer *mapLayer) const
+{
+  waypointCache.getMissingTiles(missing, rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement,
+                                [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  {
+    return curLayer->hasSameQueryParametersWaypoint(newLayer);
+  });
+}
+
+void WaypointQuery::loadMissingWaypointTiles(query::MissingTiles<map::MapWaypoint>& missing)
+{
+  missing.objects.clear();
+  if(!query::valid(Q_FUNC_INFO, waypointsByRectQuery))
+    return;
+
+  for(const GeoDataLatLonBox& rect : qAsConst(missing.rects))
+  {
+    missing.objects.append(QList<map::MapWaypoint>());
+    fetchWaypointTile(rect, missing.objects.last());
   }
-  overflow = waypointCache.validate(queryMaxRowsWaypoints);
-  return &waypointCache.list;
+}
+
+void WaypointQuery::insertMissingWaypointTiles(const query::MissingTiles<map::MapWaypoint>& missing)
+{
+  waypointCache.insertMissingTiles(missing, queryMaxRowsWaypoints);
 }
 
 const QList<MapWaypoint> *WaypointQuery::getWaypointsAirway(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
@@ -190,24 +227,23 @@ const QList<MapWaypoint> *WaypointQuery::getWaypointsAirway(const Marble::GeoDat
                                   [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer) && curLayer->hasSameQueryParametersAirwayTrack(newLayer);
-  });
-
-  if(waypointAirwayCache.list.isEmpty() && !lazy)
+  },
+                                  [ =](const GeoDataLatLonBox& r, QList<map::MapWaypoint>& objects) -> void
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(r, waypointsAirwayByRectQuery);
+    waypointsAirwayByRectQuery->exec();
+
+    MapTypesColumns columns;
+    mapTypesFactory->initWaypointColumns(columns, *waypointsAirwayByRectQuery, trackDatabase);
+    while(waypointsAirwayByRectQuery->next())
     {
-      query::bindRect(r, waypointsAirwayByRectQuery);
-      waypointsAirwayByRectQuery->exec();
-      while(waypointsAirwayByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsAirwayByRectQuery->record(), wp, trackDatabase);
-
-        // Also insert artificial waypoints
-        waypointAirwayCache.list.append(wp);
-      }
+      map::MapWaypoint wp;
+      mapTypesFactory->fillWaypoint(*waypointsAirwayByRectQuery, columns, wp, trackDatabase);
+
+      // Also insert artificial waypoints
+      objects.append(wp);
     }
-  }
+  });
   overflow = waypointAirwayCache.validate(queryMaxRowsWaypoints);
   return &waypointAirwayCache.list;
 }
@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_WAYPOINTQUERY_H
 
 #include "query/querytypes.h"
+#include "query/tilerectcache.h"
 
 #include <QCache>
 
@@ -77,6 +78,17 @@ public:
   const QList<map::MapWaypoint> *getWaypointsAirway(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy,
                                                     bool& overflow);
 
+  /* Get tiles of getWaypoints() which are not cached yet for rect. Called in the GUI thread. */
+  void getMissingWaypointTiles(query::MissingTiles<map::MapWaypoint>& missing, const Marble::GeoDataLatLonBox& rect,
+                               const MapLayer *mapLayer) const;
+
+  /* Load objects for missing tiles. Does not use or change the cache and can be called for an instance
+   * with its own database connection in a background thread. */
+  void loadMissingWaypointTiles(query::MissingTiles<map::MapWaypoint>& missing);
+
+  /* Add loaded tiles to the cache. Called in the GUI thread. */
+  void insertMissingWaypointTiles(const query::MissingTiles<map::MapWaypoint>& missing);
+
   /* Get record for joined tables waypoint, bgl_file and scenery_area */
   const atools::sql::SqlRecord *getWaypointInformation(int waypointId);
 
@@ -94,11 +106,14 @@ public:
   void clearCache();
 
 private:
+  /* Load all waypoints for a tile rectangle not crossing the anti-meridian */
+  void fetchWaypointTile(const Marble::GeoDataLatLonBox& rect, QList<map::MapWaypoint>& waypoints);
+
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbNav;
 
-  /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapWaypoint> waypointCache, waypointAirwayCache;
+  /* Tile based spatial caches */
+  query::TileRectCache<map::MapWaypoint> waypointCache, waypointAirwayCache;
   QCache<int, atools::sql::SqlRecord> waypointInfoCache;
 
   static int queryMaxRowsWaypoints;
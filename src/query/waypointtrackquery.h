@@ -123,6 +123,12 @@ public:
   atools::sql::SqlQuery *getWaypointsByRectQuery() const;
   atools::sql::SqlQuery *getWaypointsByRectQueryTrack() const;
 
+  /* Query for the nav database without tracks */
+  WaypointQuery *getWaypointQuery() const
+  {
+    return waypointQuery;
+  }
+
 private:
   /* Copies objects and avoids duplicates in the to list/vector. */
   void copy(const QList<map::MapWaypoint>& from, QList<map::MapWaypoint>& to);
@@ -77,6 +77,7 @@ RouteCalcDialog::RouteCalcDialog(QWidget *parent)
 
   ui->buttonBox->button(QDialogButtonBox::Apply)->setText(tr("&Calculate"));
 
+  connect(ui->pushButtonRouteCalcCompare, &QPushButton::clicked, this, &RouteCalcDialog::compareClicked);
   connect(ui->pushButtonRouteCalcDirect, &QPushButton::clicked, this, &RouteCalcDialog::calculateDirectClicked);
   connect(ui->pushButtonRouteCalcReverse, &QPushButton::clicked, this, &RouteCalcDialog::calculateReverseClicked);
   connect(ui->pushButtonRouteCalcTrackDownload, &QPushButton::clicked, this, &RouteCalcDialog::downloadTrackClicked);
@@ -118,6 +119,16 @@ void RouteCalcDialog::buttonBoxClicked(QAbstractButton *button)
     QDialog::hide();
 }
 
+void RouteCalcDialog::compareClicked()
+{
+  calculating = true;
+  updateWidgets();
+  QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  emit calculateCompareClicked();
+  calculating = false;
+  updateWidgets();
+}
+
 void RouteCalcDialog::showForFullCalculation()
 {
   ui->radioButtonRouteCalcFull->setChecked(true);
@@ -168,6 +179,7 @@ void RouteCalcDialog::updateWidgets()
   {
     ui->buttonBox->button(QDialogButtonBox::Apply)->setEnabled(false);
     ui->buttonBox->button(QDialogButtonBox::Close)->setEnabled(false);
+    ui->pushButtonRouteCalcCompare->setEnabled(false);
     ui->pushButtonRouteCalcDirect->setEnabled(false);
     ui->pushButtonRouteCalcReverse->setEnabled(false);
   }
@@ -188,6 +200,7 @@ void RouteCalcDialog::updateWidgets()
     ui->pushButtonRouteCalcAdjustAltitude->setEnabled(canCalcRoute);
     ui->buttonBox->button(QDialogButtonBox::Apply)->setEnabled(isCalculateSelection() ? canCalculateSelection : canCalcRoute);
     ui->buttonBox->button(QDialogButtonBox::Close)->setEnabled(true);
+    ui->pushButtonRouteCalcCompare->setEnabled(isCalculateSelection() ? canCalculateSelection : canCalcRoute);
 
     ui->pushButtonRouteCalcDirect->setEnabled(canCalcRoute && NavApp::getRouteConst().hasEntries());
     ui->pushButtonRouteCalcReverse->setEnabled(canCalcRoute);
@@ -368,6 +381,34 @@ float RouteCalcDialog::getAirwayPreferenceCostFactor() const
   return DIRECT_COST_FACTORS.at(ui->horizontalSliderRouteCalcAirwayPref->value());
 }
 
+float RouteCalcDialog::getAirwayPreferenceCostFactor(int preference)
+{
+  return DIRECT_COST_FACTORS.value(preference, DIRECT_COST_FACTORS.at(AIRWAY_WAYPOINT_PREF_CENTER));
+}
+
+QVector<int> RouteCalcDialog::getAirwayWaypointPreferenceCandidates() const
+{
+  int pref = ui->horizontalSliderRouteCalcAirwayPref->value();
+  QVector<int> candidates({pref});
+
+  // Ends change the route finder mode - do not vary
+  if(pref > AIRWAY_WAYPOINT_PREF_MIN && pref < AIRWAY_WAYPOINT_PREF_MAX)
+  {
+    for(int offset : {-3, 3})
+    {
+      int candidate = atools::minmax(AIRWAY_WAYPOINT_PREF_MIN + 1, AIRWAY_WAYPOINT_PREF_MAX - 1, pref + offset);
+      if(!candidates.contains(candidate))
+        candidates.append(candidate);
+    }
+  }
+  return candidates;
+}
+
+QString RouteCalcDialog::getAirwayWaypointPreferenceText(int preference) const
+{
+  return preferenceTexts.value(preference).simplified();
+}
+
 void RouteCalcDialog::adjustAltitudePressed()
 {
   ui->spinBoxRouteCalcCruiseAltitude->setValue(NavApp::getRouteConst().getAdjustedAltitude(ui->spinBoxRouteCalcCruiseAltitude->value()));
@@ -20,6 +20,7 @@
 
 #include <QDialog>
 #include <QObject>
+#include <QVector>
 
 class UnitStringTool;
 class QAbstractButton;
@@ -125,6 +126,14 @@ public:
   }
 
   float getAirwayPreferenceCostFactor() const;
+  static float getAirwayPreferenceCostFactor(int preference);
+
+  /* Slider positions around the current one used for the comparison calculation.
+   * Only the current position if this is one of the airway or waypoint only ends. */
+  QVector<int> getAirwayWaypointPreferenceCandidates() const;
+
+  /* Text describing the slider position */
+  QString getAirwayWaypointPreferenceText(int preference) const;
 
   /* Min and max values including for ui->horizontalSliderRouteCalcAirwayPreference.
    * Sync with DIRECT_COST_FACTORS */
@@ -136,6 +145,7 @@ signals:
   /* Use clicked calculate flight plan button */
   void downloadTrackClicked();
   void calculateClicked();
+  void calculateCompareClicked();
   void calculateDirectClicked();
   void calculateReverseClicked();
 
@@ -148,6 +158,7 @@ private:
   void adjustAltitudePressed();
 
   void buttonBoxClicked(QAbstractButton *button);
+  void compareClicked();
 
   /* Catch events to allow repositioning */
   virtual void showEvent(QShowEvent *) override;
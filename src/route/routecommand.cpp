@@ -18,6 +18,80 @@
 #include "route/routecommand.h"
 #include "route/routecontroller.h"
 
+#include "atools.h"
+#include "fs/pln/flightplanentry.h"
+
+using atools::fs::pln::Flightplan;
+using atools::fs::pln::FlightplanEntry;
+
+/* Compare all fields of the entries. Entries found equal are not stored in the command, so any field
+ * missing here would be lost on undo. This includes frequencies updated from navaids as well as
+ * airport, runway and procedure fields set for MSFS. */
+static bool entryEquals(const FlightplanEntry& entry1, const FlightplanEntry& entry2)
+{
+  return entry1.getWaypointType() == entry2.getWaypointType() &&
+         entry1.getIdent() == entry2.getIdent() &&
+         entry1.getRegion() == entry2.getRegion() &&
+         entry1.getName() == entry2.getName() &&
+         entry1.getAirway() == entry2.getAirway() &&
+         entry1.getComment() == entry2.getComment() &&
+         entry1.getFlags() == entry2.getFlags() &&
+         entry1.getPosition() == entry2.getPosition() &&
+         atools::almostEqual(entry1.getAltitude(), entry2.getAltitude()) &&
+         atools::almostEqual(entry1.getMagvar(), entry2.getMagvar()) &&
+         entry1.getFrequency() == entry2.getFrequency() &&
+         entry1.getAirport() == entry2.getAirport() &&
+         entry1.getRunwayNumber() == entry2.getRunwayNumber() &&
+         entry1.getRunwayDesignator() == entry2.getRunwayDesignator() &&
+         entry1.getSid() == entry2.getSid() &&
+         entry1.getStar() == entry2.getStar() &&
+         entry1.getApproachType() == entry2.getApproachType() &&
+         entry1.getApproachSuffix() == entry2.getApproachSuffix();
+}
+
+/* Compare header fields which can be changed by flight plan edits */
+static bool headerEquals(const Flightplan& plan1, const Flightplan& plan2)
+{
+  return plan1.getFlightplanType() == plan2.getFlightplanType() &&
+         atools::almostEqual(plan1.getCruiseAltitudeFt(), plan2.getCruiseAltitudeFt()) &&
+         plan1.getDepartureIdent() == plan2.getDepartureIdent() &&
+         plan1.getDepartureName() == plan2.getDepartureName() &&
+         plan1.getDeparturePosition() == plan2.getDeparturePosition() &&
+         plan1.getDepartureParkingName() == plan2.getDepartureParkingName() &&
+         plan1.getDepartureParkingType() == plan2.getDepartureParkingType() &&
+         plan1.getDepartureParkingPosition() == plan2.getDepartureParkingPosition() &&
+         plan1.getDestinationIdent() == plan2.getDestinationIdent() &&
+         plan1.getDestinationName() == plan2.getDestinationName() &&
+         plan1.getDestinationPosition() == plan2.getDestinationPosition() &&
+         plan1.getComment() == plan2.getComment() &&
+         plan1.getPropertiesConst() == plan2.getPropertiesConst();
+}
+
+/* Copy of plan without entries */
+static Flightplan headerOnly(const Flightplan& flightplan)
+{
+  Flightplan header(flightplan);
+  header.erase(header.begin(), header.end());
+  return header;
+}
+
+static qint64 entrySizeBytes(const FlightplanEntry& entry)
+{
+  return static_cast<qint64>(sizeof(FlightplanEntry)) +
+         (entry.getIdent().size() + entry.getRegion().size() + entry.getName().size() + entry.getAirway().size() +
+          entry.getComment().size() + entry.getAirport().size() + entry.getSid().size() + entry.getStar().size()) *
+         static_cast<qint64>(sizeof(QChar));
+}
+
+static qint64 headerSizeBytes(const Flightplan& flightplan)
+{
+  qint64 size = static_cast<qint64>(sizeof(Flightplan)) + flightplan.getComment().size() * static_cast<qint64>(sizeof(QChar));
+  const auto& properties = flightplan.getPropertiesConst();
+  for(auto it = properties.constBegin(); it != properties.constEnd(); ++it)
+    size += (it.key().size() + it.value().size()) * static_cast<qint64>(sizeof(QChar));
+  return size;
+}
+
 RouteCommand::RouteCommand(RouteController *routeController,
                            const atools::fs::pln::Flightplan& flightplanBefore, const QString& text,
                            rctype::RouteCmdType rcType)
@@ -33,12 +107,102 @@ RouteCommand::~RouteCommand()
 
 void RouteCommand::setFlightplanAfter(const atools::fs::pln::Flightplan& flightplanAfter)
 {
-  planAfterChange = flightplanAfter;
+  const Flightplan& before = planBeforeChange;
+  const Flightplan& after = flightplanAfter;
+
+  // Find unchanged entries at start and end
+  int minSize = std::min(before.size(), after.size());
+  numPrefixEntries = 0;
+  while(numPrefixEntries < minSize && entryEquals(before.at(numPrefixEntries), after.at(numPrefixEntries)))
+    numPrefixEntries++;
+
+  numSuffixEntries = 0;
+  while(numSuffixEntries < minSize - numPrefixEntries &&
+        entryEquals(before.at(before.size() - 1 - numSuffixEntries), after.at(after.size() - 1 - numSuffixEntries)))
+    numSuffixEntries++;
+
+  // Keep the replaced range only
+  entriesBeforeChange.clear();
+  for(int i = numPrefixEntries; i < before.size() - numSuffixEntries; i++)
+    entriesBeforeChange.append(before.at(i));
+
+  entriesAfterChange.clear();
+  for(int i = numPrefixEntries; i < after.size() - numSuffixEntries; i++)
+    entriesAfterChange.append(after.at(i));
+
+  headerChanged = !headerEquals(before, after);
+  if(headerChanged)
+  {
+    headerBeforeChange = headerOnly(before);
+    headerAfterChange = headerOnly(after);
+  }
+
+  // Calculate memory usage of difference
+  sizeBytes = static_cast<qint64>(sizeof(RouteCommand));
+  for(const FlightplanEntry& entry : qAsConst(entriesBeforeChange))
+    sizeBytes += entrySizeBytes(entry);
+  for(const FlightplanEntry& entry : qAsConst(entriesAfterChange))
+    sizeBytes += entrySizeBytes(entry);
+  if(headerChanged)
+    sizeBytes += headerSizeBytes(headerBeforeChange) + headerSizeBytes(headerAfterChange);
+
+#ifdef DEBUG_INFORMATION
+  qDebug() << Q_FUNC_INFO << text() << "prefix" << numPrefixEntries << "suffix" << numSuffixEntries
+           << "before" << entriesBeforeChange.size() << "after" << entriesAfterChange.size()
+           << "headerChanged" << headerChanged << "sizeBytes" << sizeBytes;
+#endif
+
+  // Full copy not needed anymore
+  planBeforeChange = Flightplan();
+}
+
+RouteCommand *RouteCommand::clone() const
+{
+  RouteCommand *command = new RouteCommand(controller, Flightplan(), text(), type);
+  command->numPrefixEntries = numPrefixEntries;
+  command->numSuffixEntries = numSuffixEntries;
+  command->entriesBeforeChange = entriesBeforeChange;
+  command->entriesAfterChange = entriesAfterChange;
+  command->headerBeforeChange = headerBeforeChange;
+  command->headerAfterChange = headerAfterChange;
+  command->headerChanged = headerChanged;
+  command->sizeBytes = sizeBytes;
+  return command;
+}
+
+Flightplan RouteCommand::applyDifference(const Flightplan& flightplan, bool undoChange) const
+{
+  const QList<FlightplanEntry>& removeEntries = undoChange ? entriesAfterChange : entriesBeforeChange;
+  const QList<FlightplanEntry>& insertEntries = undoChange ? entriesBeforeChange : entriesAfterChange;
+
+  if(flightplan.size() != numPrefixEntries + removeEntries.size() + numSuffixEntries)
+  {
+    // Should not happen since the controller keeps the plan in sync with the undo stack index
+    qWarning() << Q_FUNC_INFO << "Flight plan size mismatch" << flightplan.size()
+               << "prefix" << numPrefixEntries << "remove" << removeEntries.size() << "suffix" << numSuffixEntries;
+    return flightplan;
+  }
+
+  Flightplan plan(flightplan);
+  plan.erase(plan.begin() + numPrefixEntries, plan.begin() + numPrefixEntries + removeEntries.size());
+  for(int i = 0; i < insertEntries.size(); i++)
+    plan.insert(numPrefixEntries + i, insertEntries.at(i));
+
+  if(headerChanged)
+  {
+    // Copy entries into changed header
+    Flightplan header(undoChange ? headerBeforeChange : headerAfterChange);
+    for(const FlightplanEntry& entry : qAsConst(plan))
+      header.append(entry);
+    return header;
+  }
+  else
+    return plan;
 }
 
 void RouteCommand::undo()
 {
-  controller->changeRouteUndo(planBeforeChange);
+  controller->changeRouteUndo(applyDifference(controller->undoFlightplan, true /* undoChange */));
 }
 
 void RouteCommand::redo()
@@ -47,5 +211,5 @@ void RouteCommand::redo()
     // Skip first redo - I need to do the initial changes myself
     firstRedoExecuted = true;
   else
-    controller->changeRouteRedo(planAfterChange);
+    controller->changeRouteRedo(applyDifference(controller->undoFlightplan, false /* undoChange */));
 }
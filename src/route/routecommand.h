@@ -27,7 +27,12 @@ class RouteController;
 
 /*
  * Flight plan undo command including a few workaround for QUndoCommand inflexibilities.
- * Keeps a copy of the flight plan before and after the change.
+ *
+ * Keeps only the difference between the flight plan before and after the change. This is the range of entries
+ * which was replaced between the unchanged entries at the start and end of the plan as well as
+ * the flight plan header (properties, departure, destination, etc.) if it was modified.
+ *
+ * The difference is applied to the flight plan of the current undo state kept by the RouteController.
  */
 class RouteCommand :
   public QUndoCommand
@@ -40,15 +45,41 @@ public:
   virtual void undo() override;
   virtual void redo() override;
 
-  /* Need to keep both versions in a redundant way since linking between commands is not reliable */
+  /* Calculates the difference to the plan given in the constructor and drops the copy of the latter */
   void setFlightplanAfter(const atools::fs::pln::Flightplan& flightplanAfter);
 
+  /* Estimated memory used by the difference in bytes */
+  qint64 getSizeBytes() const
+  {
+    return sizeBytes;
+  }
+
+  /* Create a copy which can be pushed to a stack without executing redo. Used to trim the stack. */
+  RouteCommand *clone() const;
+
 private:
+  /* Replace the changed entries and header in plan. Reverses the change if undoChange is true. */
+  atools::fs::pln::Flightplan applyDifference(const atools::fs::pln::Flightplan& flightplan, bool undoChange) const;
+
   /* Avoid the first redo action when inserting the command. This not usable for complex interactions. */
   bool firstRedoExecuted = false;
   RouteController *controller;
   rctype::RouteCmdType type;
-  atools::fs::pln::Flightplan planBeforeChange, planAfterChange;
+
+  /* Only valid until setFlightplanAfter() is called */
+  atools::fs::pln::Flightplan planBeforeChange;
+
+  /* Number of unchanged entries at the start and the end of the plan */
+  int numPrefixEntries = 0, numSuffixEntries = 0;
+
+  /* Entries between prefix and suffix which were replaced */
+  QList<atools::fs::pln::FlightplanEntry> entriesBeforeChange, entriesAfterChange;
+
+  /* Flight plan without entries. Only set if header was changed. */
+  atools::fs::pln::Flightplan headerBeforeChange, headerAfterChange;
+  bool headerChanged = false;
+
+  qint64 sizeBytes = 0L;
 };
 
 #endif // LITTLENAVMAP_ROUTECOMMAND_H
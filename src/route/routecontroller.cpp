@@ -27,6 +27,7 @@
 #include "common/unit.h"
 #include "common/unit.h"
 #include "common/unitstringtool.h"
+#include "db/databasepool.h"
 #include "exception.h"
 #include "export/csvexporter.h"
 #include "fs/perf/aircraftperf.h"
@@ -50,6 +51,7 @@
 #include "query/airportquery.h"
 #include "query/airwaytrackquery.h"
 #include "query/mapquery.h"
+#include "query/procedureprefetcher.h"
 #include "query/procedurequery.h"
 #include "route/customproceduredialog.h"
 #include "route/flightplanentrybuilder.h"
@@ -67,6 +69,7 @@
 #include "routing/routenetwork.h"
 #include "routing/routenetworkloader.h"
 #include "settings/settings.h"
+#include "sql/sqldatabase.h"
 #include "track/trackcontroller.h"
 #include "ui_mainwindow.h"
 #include "util/contextsaver.h"
@@ -76,14 +79,18 @@
 #include <QFile>
 #include <QStandardItemModel>
 #include <QInputDialog>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QTextTable>
 #include <QPlainTextEdit>
 #include <QProgressDialog>
 #include <QScrollBar>
 #include <QStringBuilder>
+#include <QThread>
 #include <QUndoStack>
 
+#include <atomic>
+
 namespace rcol {
 // Route table column indexes
 enum RouteColumns
@@ -164,6 +171,27 @@ const static int MAX_REMARK_COLS_HTML_AND_PRINT = 200;
 const static int MIN_SIM_UPDATE_TIME_MS = 100;
 const static int ROUTE_ALT_CHANGE_DELAY_MS = 500;
 
+/* Cruise altitude variation and minimum for flight plan comparison */
+const static float ROUTE_COMPARE_ALT_STEP_FT = 2000.f;
+const static float ROUTE_COMPARE_ALT_MIN_FT = 1000.f;
+
+/* One calculation for the flight plan comparison. Parameters are set in the GUI thread and the
+ * result in a thread of the database pool. Profile values are filled in the GUI thread afterwards. */
+struct RouteCompareCandidate
+{
+  float altitudeFt = 0.f;
+  int preference = 0;
+  atools::routing::Modes mode = atools::routing::MODE_NONE;
+
+  bool found = false;
+  float distanceMeter = 0.f;
+  QVector<RouteEntry> entries;
+
+  float distanceNm = 0.f, tripFuel = 0.f;
+  int numLegs = 0;
+  bool validProfile = false;
+};
+
 using atools::fs::pln::Flightplan;
 using atools::fs::pln::FlightplanEntry;
 using atools::gui::ActionTool;
@@ -286,12 +314,18 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
   routeNetworkRadio = new atools::routing::RouteNetwork(atools::routing::SOURCE_RADIO);
   routeNetworkAirway = new atools::routing::RouteNetwork(atools::routing::SOURCE_AIRWAY);
 
+  // Fills procedure caches for departure and destination in background
+  procedurePrefetcher = new ProcedurePrefetcher(this);
+
   // Do not use a parent to allow the window moving to back
   routeCalcDialog = new RouteCalcDialog(nullptr);
 
   // Set up undo/redo framework ========================================
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
   undoStack = new QUndoStack(mainWindow);
-  undoStack->setUndoLimit(ROUTE_UNDO_LIMIT);
+  undoStack->setUndoLimit(settings.getAndStoreValue(lnm::SETTINGS_ROUTE + "UndoLimit", ROUTE_UNDO_LIMIT).toInt());
+  undoBudgetBytes = settings.getAndStoreValue(lnm::SETTINGS_ROUTE + "UndoBudgetKb", ROUTE_UNDO_BUDGET_KB).toLongLong() * 1024L;
+  routeNetworkWarmup = settings.getAndStoreValue(lnm::SETTINGS_ROUTE + "NetworkWarmup", true).toBool();
 
   undoAction = undoStack->createUndoAction(mainWindow, tr("&Undo Flight Plan"));
   undoAction->setIcon(QIcon(":/littlenavmap/resources/icons/undo.svg"));
@@ -422,7 +456,9 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
   connect(ui->pushButtonRouteSettings, &QPushButton::clicked, this, &RouteController::routeTableOptions);
 
   connect(this, &RouteController::routeChanged, routeCalcDialog, &RouteCalcDialog::routeChanged);
+  connect(this, &RouteController::routeChanged, this, &RouteController::prefetchProcedures);
   connect(routeCalcDialog, &RouteCalcDialog::calculateClicked, this, &RouteController::calculateRoute);
+  connect(routeCalcDialog, &RouteCalcDialog::calculateCompareClicked, this, &RouteController::calculateRouteCompare);
   connect(routeCalcDialog, &RouteCalcDialog::calculateDirectClicked, this, &RouteController::calculateDirect);
   connect(routeCalcDialog, &RouteCalcDialog::calculateReverseClicked, this, &RouteController::reverseRoute);
   connect(routeCalcDialog, &RouteCalcDialog::downloadTrackClicked, NavApp::getTrackController(), &TrackController::startDownload);
@@ -451,6 +487,8 @@ RouteController::~RouteController()
   ATOOLS_DELETE_LOG(entryBuilder);
   ATOOLS_DELETE_LOG(model);
   ATOOLS_DELETE_LOG(undoStack);
+  ATOOLS_DELETE_LOG(procedurePrefetcher);
+  waitForRouteNetworks();
   ATOOLS_DELETE_LOG(routeNetworkRadio);
   ATOOLS_DELETE_LOG(routeNetworkAirway);
   ATOOLS_DELETE_LOG(zoomHandler);
@@ -1090,6 +1128,10 @@ void RouteController::restoreState()
 
   units->update();
 
+  // Load networks for flight plan calculation in background after startup
+  routeNetworkKey = routeNetworkDatabaseKey();
+  warmupRouteNetworks();
+
   connect(NavApp::getRouteTabHandler(), &atools::gui::TabWidgetHandler::tabOpened, this, &RouteController::updateRouteTabChangedStatus);
 }
 
@@ -1849,24 +1891,14 @@ void RouteController::calculateRouteWindowShow()
   routeCalcDialog->setCruisingAltitudeFt(route.getCruiseAltitudeFt());
 }
 
-void RouteController::calculateRoute()
+atools::routing::Modes RouteController::calculateRouteMode(QString& command, bool& airway, int& fromIdx, int& toIdx) const
 {
-  qDebug() << Q_FUNC_INFO;
-
-  atools::routing::RouteNetwork *net = nullptr;
-  QString command;
   atools::routing::Modes mode = atools::routing::MODE_NONE;
-  bool fetchAirways = false;
-
-  // Ignore events triggering follow due to selection changes
-  atools::util::ContextSaverBool saver(ignoreFollowSelection);
 
   // Build configuration for route finder =======================================
-  if(routeCalcDialog->getRoutingType() == rd::AIRWAY)
+  airway = routeCalcDialog->getRoutingType() == rd::AIRWAY;
+  if(airway)
   {
-    net = routeNetworkAirway;
-    fetchAirways = true;
-
     // Airway preference =======================================
     switch(routeCalcDialog->getAirwayRoutingType())
     {
@@ -1901,27 +1933,17 @@ void RouteController::calculateRoute()
     if(routeCalcDialog->isUseTracks())
       mode |= atools::routing::MODE_TRACK;
   }
-  else if(routeCalcDialog->getRoutingType() == rd::RADIONNAV)
+  else
   {
     // Radionav settings ========================================
     command = tr("Radionnav Flight Plan Calculation");
-    fetchAirways = false;
-    net = routeNetworkRadio;
     mode = atools::routing::MODE_RADIONAV_VOR;
     if(routeCalcDialog->isRadionavNdb())
       mode |= atools::routing::MODE_RADIONAV_NDB;
   }
 
-  if(!net->isLoaded())
-  {
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    loader.load(net);
-  }
-
-  atools::routing::RouteFinder routeFinder(net);
-  routeFinder.setCostFactorForceAirways(routeCalcDialog->getAirwayPreferenceCostFactor());
-
-  int fromIdx = -1, toIdx = -1;
+  fromIdx = -1;
+  toIdx = -1;
   if(routeCalcDialog->isCalculateSelection())
   {
     fromIdx = routeCalcDialog->getRouteRangeFromIndex();
@@ -1935,7 +1957,34 @@ void RouteController::calculateRoute()
     // Disable certain optimizations in route finder - use nearest underlying point as start for departure position
     mode |= atools::routing::MODE_POINT_TO_POINT;
 
-  if(calculateRouteInternal(&routeFinder, command, fetchAirways, routeCalcDialog->getCruisingAltitudeFt(), fromIdx, toIdx, mode))
+  return mode;
+}
+
+void RouteController::calculateRoute()
+{
+  qDebug() << Q_FUNC_INFO;
+
+  // Ignore events triggering follow due to selection changes
+  atools::util::ContextSaverBool saver(ignoreFollowSelection);
+
+  QString command;
+  bool airway = false;
+  int fromIdx = -1, toIdx = -1;
+  atools::routing::Modes mode = calculateRouteMode(command, airway, fromIdx, toIdx);
+  atools::routing::RouteNetwork *net = airway ? routeNetworkAirway : routeNetworkRadio;
+
+  // Network is usually loaded in background after database loading - wait for it
+  waitForRouteNetworks();
+  if(!net->isLoaded())
+  {
+    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
+    loader.load(net);
+  }
+
+  atools::routing::RouteFinder routeFinder(net);
+  routeFinder.setCostFactorForceAirways(routeCalcDialog->getAirwayPreferenceCostFactor());
+
+  if(calculateRouteInternal(&routeFinder, command, airway /* fetchAirways */, routeCalcDialog->getCruisingAltitudeFt(), fromIdx, toIdx, mode))
     NavApp::setStatusMessage(tr("Calculated flight plan."));
   else
     NavApp::setStatusMessage(tr("No route found."));
@@ -1943,9 +1992,316 @@ void RouteController::calculateRoute()
   routeCalcDialog->updateWidgets();
 }
 
+void RouteController::calculateRouteCompare()
+{
+  qDebug() << Q_FUNC_INFO;
+
+  DatabasePool *pool = NavApp::getDatabasePool();
+  if(!pool->isOpen())
+    return;
+
+  // Ignore events triggering follow due to selection changes
+  atools::util::ContextSaverBool saver(ignoreFollowSelection);
+
+  QString command;
+  bool airway = false;
+  int fromIdx = -1, toIdx = -1;
+  atools::routing::Modes mode = calculateRouteMode(command, airway, fromIdx, toIdx);
+  bool calcRange = fromIdx != -1 && toIdx != -1;
+  int oldRouteSize = route.size();
+
+  // Same positions as in calculateRouteInternal()
+  Pos departurePos, destinationPos;
+  if(calcRange)
+  {
+    fromIdx = std::max(route.getLastIndexOfDepartureProcedure(), fromIdx);
+    toIdx = std::min(route.getDestinationIndexBeforeProcedure(), toIdx);
+    departurePos = route.value(fromIdx).getPosition();
+    destinationPos = route.value(toIdx).getPosition();
+  }
+  else
+  {
+    departurePos = route.getLastLegOfDepartureProcedure().getPosition();
+    destinationPos = route.getDestinationBeforeProcedure().getPosition();
+  }
+
+  // Build all combinations of track usage, cruise altitude and airway preference =====================
+  float cruiseAltitudeFt = routeCalcDialog->getCruisingAltitudeFt();
+  QVector<float> altitudes({cruiseAltitudeFt, cruiseAltitudeFt + ROUTE_COMPARE_ALT_STEP_FT});
+  if(cruiseAltitudeFt - ROUTE_COMPARE_ALT_STEP_FT >= ROUTE_COMPARE_ALT_MIN_FT)
+    altitudes.append(cruiseAltitudeFt - ROUTE_COMPARE_ALT_STEP_FT);
+
+  QVector<int> preferences = airway ? routeCalcDialog->getAirwayWaypointPreferenceCandidates() :
+                             QVector<int>({routeCalcDialog->getAirwayWaypointPreference()});
+
+  QVector<atools::routing::Modes> modes({mode});
+  if(airway && NavApp::hasTracks())
+    modes.append(mode ^ atools::routing::MODE_TRACK);
+
+  QVector<RouteCompareCandidate> candidates;
+  for(atools::routing::Modes candidateMode : qAsConst(modes))
+  {
+    for(float altitudeFt : qAsConst(altitudes))
+    {
+      for(int preference : qAsConst(preferences))
+      {
+        RouteCompareCandidate candidate;
+        candidate.mode = candidateMode;
+        candidate.altitudeFt = altitudeFt;
+        candidate.preference = preference;
+        candidates.append(candidate);
+      }
+    }
+  }
+
+  // Stop any background tasks
+  beforeRouteCalc();
+
+  // Distribute candidates to pool threads. Each pool thread uses its own network since the
+  // route finder keeps search state in the network. Networks are kept in the pool context for the next click.
+  QString networkKey = routeNetworkDatabaseKey() % "|" % QString::number(routeNetworkTrackGeneration);
+  int numTasks = std::min(candidates.size(), pool->getNumConnections());
+  QVector<QVector<RouteCompareCandidate> > taskCandidates(numTasks);
+  for(int i = 0; i < candidates.size(); i++)
+    taskCandidates[i % numTasks].append(candidates.at(i));
+
+  std::atomic_bool canceled(false);
+  std::atomic_int numCalculated(0);
+
+  QVector<QFuture<QVector<RouteCompareCandidate> > > futures;
+  for(const QVector<RouteCompareCandidate>& task : qAsConst(taskCandidates))
+  {
+    futures.append(pool->run([task, airway, networkKey, departurePos, destinationPos, &canceled, &numCalculated]
+                               (DatabasePoolContext& context) -> QVector<RouteCompareCandidate> {
+      QVector<RouteCompareCandidate> results(task);
+
+      // Drop networks of this thread if navdata or tracks have changed
+      if(context.routeNetworkKey != networkKey)
+      {
+        ATOOLS_DELETE(context.routeNetworkRadio);
+        ATOOLS_DELETE(context.routeNetworkAirway);
+        context.routeNetworkKey = networkKey;
+      }
+
+      atools::routing::RouteNetwork *& network = airway ? context.routeNetworkAirway : context.routeNetworkRadio;
+      if(network == nullptr)
+      {
+        network = new atools::routing::RouteNetwork(airway ? atools::routing::SOURCE_AIRWAY : atools::routing::SOURCE_RADIO);
+        atools::routing::RouteNetworkLoader(context.dbNav, context.dbTrack).load(network);
+      }
+
+      for(RouteCompareCandidate& candidate : results)
+      {
+        if(canceled)
+          break;
+
+        atools::routing::RouteFinder routeFinder(network);
+        routeFinder.setCostFactorForceAirways(RouteCalcDialog::getAirwayPreferenceCostFactor(candidate.preference));
+        routeFinder.setProgressCallback([&canceled](int, int) -> bool {
+          return !canceled;
+        });
+
+        candidate.found = routeFinder.calculateRoute(departurePos, destinationPos, atools::roundToInt(candidate.altitudeFt),
+                                                     candidate.mode);
+        if(candidate.found && !canceled)
+        {
+          RouteExtractor(&routeFinder).extractRoute(candidate.entries, candidate.distanceMeter);
+          candidate.found = !candidate.entries.isEmpty();
+        }
+        numCalculated++;
+      }
+      return results;
+    }));
+  }
+
+  // Show progress and wait for all tasks. Tasks have to finish since they use local variables. =================
+  QProgressDialog progress(tr("Calculating and comparing Flight Plans ..."), tr("Cancel"), 0, candidates.size(), routeCalcDialog);
+  progress.setWindowTitle(tr("Little Navmap - Comparing Flight Plans"));
+  progress.setWindowFlags(progress.windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  progress.setWindowModality(Qt::ApplicationModal);
+  progress.setMinimumDuration(500);
+
+  bool finished = false;
+  while(!finished)
+  {
+    progress.setValue(numCalculated);
+    QApplication::processEvents(QEventLoop::AllEvents, 50);
+    if(progress.wasCanceled())
+      canceled = true;
+
+    finished = std::all_of(futures.constBegin(), futures.constEnd(), [](const QFuture<QVector<RouteCompareCandidate> >& future) {
+      return future.isFinished();
+    });
+
+    if(!finished)
+      QThread::msleep(20);
+  }
+  progress.reset();
+
+  if(canceled)
+    return;
+
+  // Build a copy of the route for each result to get distance, legs and fuel from the profile =====================
+  // Procedures are not loaded for the copies since they are the same for all candidates
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+  float directDistance = departurePos.distanceMeterTo(destinationPos);
+  QVector<RouteCompareCandidate> results;
+  for(const QFuture<QVector<RouteCompareCandidate> >& future : qAsConst(futures))
+  {
+    for(RouteCompareCandidate candidate : future.result())
+    {
+      if(!candidate.found || candidate.distanceMeter / directDistance >= MAX_DISTANCE_DIRECT_RATIO)
+        continue;
+
+      Route candidateRoute(route);
+      Flightplan& flightplan = candidateRoute.getFlightplan();
+      insertCalculatedRoute(flightplan, candidateRoute.getNumAlternateLegs(), candidate.entries, airway, fromIdx, toIdx);
+      flightplan.removeProcedureEntries();
+      flightplan.setCruiseAltitudeFt(candidate.altitudeFt);
+
+      candidateRoute.createRouteLegsFromFlightplan();
+      candidateRoute.updateAll();
+      candidateRoute.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
+      candidateRoute.updateLegAltitudes();
+
+      candidate.distanceNm = candidateRoute.getTotalDistance();
+      candidate.numLegs = candidateRoute.getSizeWithoutAlternates();
+      candidate.validProfile = candidateRoute.isValidProfile() && !candidateRoute.getAltitudeLegs().hasErrors();
+      candidate.tripFuel = candidateRoute.getAltitudeLegs().getTripFuel();
+      results.append(candidate);
+    }
+  }
+  QGuiApplication::restoreOverrideCursor();
+
+  if(results.isEmpty())
+  {
+    atools::gui::Dialog(routeCalcDialog).showInfoMsgBox(lnm::ACTIONS_SHOW_ROUTE_ERROR,
+                                                        tr("Cannot calculate flight plan.\n\n"
+                                                           "Try another calculation type,\n"
+                                                           "change the cruise altitude or\n"
+                                                           "create the flight plan manually."),
+                                                        tr("Do not &show this dialog again."));
+    NavApp::setStatusMessage(tr("No route found."));
+    return;
+  }
+
+  // Rank by fuel if all profiles are valid - otherwise by distance =====================
+  bool rankByFuel = std::all_of(results.constBegin(), results.constEnd(), [](const RouteCompareCandidate& candidate) {
+    return candidate.validProfile && candidate.tripFuel > 0.f;
+  });
+
+  std::sort(results.begin(), results.end(), [rankByFuel](const RouteCompareCandidate& c1, const RouteCompareCandidate& c2) {
+    float value1 = rankByFuel ? c1.tripFuel : c1.distanceNm, value2 = rankByFuel ? c2.tripFuel : c2.distanceNm;
+    return atools::almostEqual(value1, value2) ? c1.numLegs < c2.numLegs : value1 < value2;
+  });
+
+  bool fuelAsVolume = NavApp::getAircraftPerformance().useFuelAsVolume();
+  QStringList items;
+  for(int i = 0; i < results.size(); i++)
+  {
+    const RouteCompareCandidate& candidate = results.at(i);
+    QStringList texts;
+    texts.append(Unit::distNm(candidate.distanceNm));
+    texts.append(tr("%1 legs").arg(candidate.numLegs));
+    if(candidate.validProfile)
+      texts.append(tr("%1 trip fuel").arg(Unit::fuelLbsGallon(candidate.tripFuel, true /* addUnit */, fuelAsVolume)));
+    texts.append(Unit::altFeet(candidate.altitudeFt));
+    if(airway)
+    {
+      if(modes.size() > 1)
+        texts.append(candidate.mode.testFlag(atools::routing::MODE_TRACK) ? tr("tracks") : tr("no tracks"));
+      texts.append(routeCalcDialog->getAirwayWaypointPreferenceText(candidate.preference));
+    }
+    items.append(tr("%1. %2").arg(i + 1).arg(texts.join(", ")));
+  }
+
+  bool ok = false;
+  QString item = QInputDialog::getItem(routeCalcDialog, QApplication::applicationName(),
+                                       rankByFuel ? tr("Calculated flight plans sorted by trip fuel.\nSelect one to apply:") :
+                                       tr("Calculated flight plans sorted by distance.\nSelect one to apply:"),
+                                       items, 0, false /* editable */, &ok);
+  int index = items.indexOf(item);
+  if(!ok || index == -1)
+    return;
+
+  // Apply selected result =====================
+  const RouteCompareCandidate& selected = results.at(index);
+  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+  // Cursor is restored in applyCalculatedRoute()
+  applyCalculatedRoute(selected.entries, command, airway /* fetchAirways */, selected.altitudeFt, fromIdx, toIdx, oldRouteSize);
+
+  routeCalcDialog->setCruisingAltitudeFt(selected.altitudeFt);
+  NavApp::setStatusMessage(tr("Calculated flight plan."));
+  routeCalcDialog->updateWidgets();
+}
+
 void RouteController::clearAirwayNetworkCache()
 {
+  waitForRouteNetworks();
   routeNetworkAirway->clear();
+
+  // Let the pool threads reload their networks for comparing
+  routeNetworkTrackGeneration++;
+
+  // Tracks are loaded into the airway network
+  warmupRouteNetworks();
+}
+
+void RouteController::prefetchProcedures()
+{
+  if(route.hasValidDeparture())
+    procedurePrefetcher->prefetch(route.getDepartureAirportLeg().getAirport());
+
+  if(route.hasValidDestination())
+    procedurePrefetcher->prefetch(route.getDestinationAirportLeg().getAirport());
+}
+
+void RouteController::warmupRouteNetworks()
+{
+  if(!routeNetworkWarmup || loadingDatabaseState || routeNetworkWatcher.isRunning() || !NavApp::getDatabasePool()->isOpen())
+    return;
+
+  atools::routing::RouteNetwork *radio = routeNetworkRadio->isLoaded() ? nullptr : routeNetworkRadio;
+  atools::routing::RouteNetwork *airway = routeNetworkAirway->isLoaded() ? nullptr : routeNetworkAirway;
+  if(radio == nullptr && airway == nullptr)
+    return;
+
+  // Networks are not accessed in the GUI thread until waitForRouteNetworks() is called
+  routeNetworkWatcher.setFuture(NavApp::getDatabasePool()->run([radio, airway](DatabasePoolContext& context) -> bool {
+    QElapsedTimer timer;
+    timer.start();
+
+    atools::routing::RouteNetworkLoader loader(context.dbNav, context.dbTrack);
+    if(airway != nullptr)
+      loader.load(airway);
+    if(radio != nullptr)
+      loader.load(radio);
+
+    qDebug() << Q_FUNC_INFO << "radio" << (radio != nullptr) << "airway" << (airway != nullptr) << timer.elapsed() << "ms";
+    return true;
+  }));
+}
+
+void RouteController::waitForRouteNetworks()
+{
+  if(routeNetworkWatcher.isRunning())
+  {
+    qDebug() << Q_FUNC_INFO << "Waiting for route network loading";
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    routeNetworkWatcher.waitForFinished();
+    QGuiApplication::restoreOverrideCursor();
+  }
+}
+
+QString RouteController::routeNetworkDatabaseKey() const
+{
+  const atools::sql::SqlDatabase *db = NavApp::getDatabaseNav();
+  if(db == nullptr || !db->isOpen())
+    return QString();
+
+  QFileInfo fileinfo(db->databaseName());
+  return fileinfo.canonicalFilePath() % "|" % QString::number(fileinfo.size()) % "|" %
+         QString::number(fileinfo.lastModified().toMSecsSinceEpoch());
 }
 
 /* Calculate a flight plan to all types */
@@ -1960,8 +2316,6 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   // Stop any background tasks
   beforeRouteCalc();
 
-  Flightplan& flightplan = route.getFlightplan();
-
   // Load network from database if not already done
   QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
@@ -2045,106 +2399,119 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
              << "direct distance" << QString::number(directDistance, 'f', 0) << "ratio" << ratio;
 
     if(ratio < MAX_DISTANCE_DIRECT_RATIO)
-    {
-      // Start undo
-      RouteCommand *undoCommand = preChange(commandName);
-      int numAlternateLegs = route.getNumAlternateLegs();
+      applyCalculatedRoute(calculatedRoute, commandName, fetchAirways, altitudeFt, fromIndex, toIndex, oldRouteSize);
+    else
+      // Too long
+      found = false;
+  }
 
-      if(calcRange)
-      {
-        flightplan[toIndex].setAirway(QString());
-        flightplan[toIndex].setFlag(atools::fs::pln::entry::TRACK, false);
-        flightplan.erase(flightplan.begin() + fromIndex + 1, flightplan.begin() + toIndex);
-      }
-      else
-        // Erase all but start and destination
-        flightplan.erase(flightplan.begin() + 1, flightplan.end() - numAlternateLegs - 1);
+  QGuiApplication::restoreOverrideCursor();
+  if(!found && !canceled)
+    // Use routeCalcDialog as parent to avoid main raising in front
+    atools::gui::Dialog(routeCalcDialog).showInfoMsgBox(lnm::ACTIONS_SHOW_ROUTE_ERROR,
+                                                        tr("Cannot calculate flight plan.\n\n"
+                                                           "Try another calculation type,\n"
+                                                           "change the cruise altitude or\n"
+                                                           "create the flight plan manually."),
+                                                        tr("Do not &show this dialog again."));
+#ifdef DEBUG_INFORMATION
+  qDebug() << Q_FUNC_INFO << route;
+#endif
 
-      int idx = 1;
-      // Create flight plan entries - will be copied later to the route map objects
-      for(const RouteEntry& routeEntry : qAsConst(calculatedRoute))
-      {
-        FlightplanEntry flightplanEntry;
-        entryBuilder->buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
-                                           flightplanEntry, fetchAirways);
-        if(fetchAirways && routeEntry.airwayId != -1)
-          // Get airway by id - needed to fetch the name first
-          updateFlightplanEntryAirway(routeEntry.airwayId, flightplanEntry);
-
-        if(calcRange)
-          flightplan.insert(flightplan.begin() + fromIndex + idx, flightplanEntry);
-        else
-          flightplan.insert(flightplan.end() - numAlternateLegs - 1, flightplanEntry);
-        idx++;
-      }
+  return found;
+}
 
-      // Remove procedure points from flight plan
-      flightplan.removeProcedureEntries();
+void RouteController::applyCalculatedRoute(const QVector<RouteEntry>& calculatedRoute, const QString& commandName,
+                                           bool fetchAirways, float altitudeFt, int fromIndex, int toIndex, int oldRouteSize)
+{
+  bool calcRange = fromIndex != -1 && toIndex != -1;
+  Flightplan& flightplan = route.getFlightplan();
 
-      // Copy flight plan to route object
-      route.createRouteLegsFromFlightplan();
+  // Start undo
+  RouteCommand *undoCommand = preChange(commandName);
+  insertCalculatedRoute(flightplan, route.getNumAlternateLegs(), calculatedRoute, fetchAirways, fromIndex, toIndex);
 
-      // Reload procedures from properties
-      loadProceduresFromFlightplan(true /* clearOldProcedureProperties */, false /* cleanupRoute */, false /* autoresolveTransition */);
-      QGuiApplication::restoreOverrideCursor();
+  // Remove procedure points from flight plan
+  flightplan.removeProcedureEntries();
 
-      // Remove duplicates in flight plan and route
-      route.updateAll();
+  // Copy flight plan to route object
+  route.createRouteLegsFromFlightplan();
 
-      // Set altitude in local units
-      flightplan.setCruiseAltitudeFt(altitudeFt);
+  // Reload procedures from properties
+  loadProceduresFromFlightplan(true /* clearOldProcedureProperties */, false /* cleanupRoute */, false /* autoresolveTransition */);
+  QGuiApplication::restoreOverrideCursor();
 
-      route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
+  // Remove duplicates in flight plan and route
+  route.updateAll();
 
-      updateActiveLeg();
+  // Set altitude in local units
+  flightplan.setCruiseAltitudeFt(altitudeFt);
 
-      route.updateLegAltitudes();
+  route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
 
-      // Remove all airways violation restrictions during climb or descent
-      clearAirwayViolations();
+  updateActiveLeg();
 
-      updateTableModelAndErrors();
-      updateActions();
+  route.updateLegAltitudes();
 
-      postChange(undoCommand);
-      NavApp::updateWindowTitle();
+  // Remove all airways violation restrictions during climb or descent
+  clearAirwayViolations();
+
+  updateTableModelAndErrors();
+  updateActions();
+
+  postChange(undoCommand);
+  NavApp::updateWindowTitle();
 
 #ifdef DEBUG_INFORMATION
-      qDebug() << flightplan;
+  qDebug() << flightplan;
 #endif
 
-      NavApp::updateErrorLabel();
+  NavApp::updateErrorLabel();
 
-      if(calcRange)
-      {
-        // will also update route window
-        int newToIndex = toIndex - (oldRouteSize - route.size());
-        selectRange(fromIndex, newToIndex);
-      }
+  if(calcRange)
+  {
+    // will also update route window
+    int newToIndex = toIndex - (oldRouteSize - route.size());
+    selectRange(fromIndex, newToIndex);
+  }
 
-      tableSelectionChanged(QItemSelection(), QItemSelection());
+  tableSelectionChanged(QItemSelection(), QItemSelection());
 
-      emit routeChanged(true /* geometryChanged */);
-    }
-    else
-      // Too long
-      found = false;
-  }
+  emit routeChanged(true /* geometryChanged */);
+}
 
-  QGuiApplication::restoreOverrideCursor();
-  if(!found && !canceled)
-    // Use routeCalcDialog as parent to avoid main raising in front
-    atools::gui::Dialog(routeCalcDialog).showInfoMsgBox(lnm::ACTIONS_SHOW_ROUTE_ERROR,
-                                                        tr("Cannot calculate flight plan.\n\n"
-                                                           "Try another calculation type,\n"
-                                                           "change the cruise altitude or\n"
-                                                           "create the flight plan manually."),
-                                                        tr("Do not &show this dialog again."));
-#ifdef DEBUG_INFORMATION
-  qDebug() << Q_FUNC_INFO << route;
-#endif
+void RouteController::insertCalculatedRoute(Flightplan& flightplan, int numAlternateLegs,
+                                            const QVector<RouteEntry>& calculatedRoute, bool fetchAirways,
+                                            int fromIndex, int toIndex)
+{
+  bool calcRange = fromIndex != -1 && toIndex != -1;
+  if(calcRange)
+  {
+    flightplan[toIndex].setAirway(QString());
+    flightplan[toIndex].setFlag(atools::fs::pln::entry::TRACK, false);
+    flightplan.erase(flightplan.begin() + fromIndex + 1, flightplan.begin() + toIndex);
+  }
+  else
+    // Erase all but start and destination
+    flightplan.erase(flightplan.begin() + 1, flightplan.end() - numAlternateLegs - 1);
 
-  return found;
+  int idx = 1;
+  // Create flight plan entries - will be copied later to the route map objects
+  for(const RouteEntry& routeEntry : qAsConst(calculatedRoute))
+  {
+    FlightplanEntry flightplanEntry;
+    entryBuilder->buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
+                                       flightplanEntry, fetchAirways);
+    if(fetchAirways && routeEntry.airwayId != -1)
+      // Get airway by id - needed to fetch the name first
+      updateFlightplanEntryAirway(routeEntry.airwayId, flightplanEntry);
+
+    if(calcRange)
+      flightplan.insert(flightplan.begin() + fromIndex + idx, flightplanEntry);
+    else
+      flightplan.insert(flightplan.end() - numAlternateLegs - 1, flightplanEntry);
+    idx++;
+  }
 }
 
 void RouteController::adjustFlightplanAltitude()
@@ -2250,6 +2617,10 @@ void RouteController::preDatabaseLoad()
   loadingDatabaseState = true;
   routeAltDelayTimer.stop();
 
+  // Database pool is closed next
+  waitForRouteNetworks();
+  procedurePrefetcher->preDatabaseLoad();
+
   // Reset active to avoid crash when indexes change
   route.resetActive();
   highlightNextWaypoint(route.getActiveLegIndex());
@@ -2267,9 +2638,14 @@ void RouteController::preDatabaseLoad()
 
 void RouteController::postDatabaseLoad()
 {
-  // Clear routing caches
-  routeNetworkRadio->clear();
-  routeNetworkAirway->clear();
+  // Clear routing caches only if navdata has changed
+  QString key = routeNetworkDatabaseKey();
+  if(key.isEmpty() || key != routeNetworkKey)
+  {
+    routeNetworkRadio->clear();
+    routeNetworkAirway->clear();
+    routeNetworkKey = key;
+  }
   clearAllErrors();
 
   Flightplan flightplan;
@@ -2305,6 +2681,12 @@ void RouteController::postDatabaseLoad()
 
   NavApp::updateWindowTitle();
   loadingDatabaseState = false;
+
+  // Load networks for flight plan calculation in background
+  warmupRouteNetworks();
+
+  procedurePrefetcher->postDatabaseLoad();
+  prefetchProcedures();
 }
 
 /* Double click into table view */
@@ -3241,6 +3623,7 @@ void RouteController::changeRouteUndo(const atools::fs::pln::Flightplan& newFlig
 {
   // Keep our own index as a workaround
   undoIndex--;
+  undoFlightplan = newFlightplan;
 
   qDebug() << "changeRouteUndo undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
   changeRouteUndoRedo(newFlightplan);
@@ -3250,6 +3633,7 @@ void RouteController::changeRouteRedo(const atools::fs::pln::Flightplan& newFlig
 {
   // Keep our own index as a workaround
   undoIndex++;
+  undoFlightplan = newFlightplan;
   qDebug() << "changeRouteRedo undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
   changeRouteUndoRedo(newFlightplan);
 }
@@ -5560,6 +5944,7 @@ void RouteController::clearRouteAndUndo()
   fileIfrVfr = pln::VFR;
   fileCruiseAltFt = 0.f;
   undoStack->clear();
+  undoFlightplan = Flightplan();
   undoIndex = 0;
   undoIndexClean = 0;
   entryBuilder->setCurUserpointNumber(1);
@@ -5593,6 +5978,7 @@ void RouteController::postChange(RouteCommand *undoCommand)
   Flightplan flightplan = route.getFlightplanConst();
   flightplan.removeProcedureEntries();
   undoCommand->setFlightplanAfter(flightplan);
+  undoFlightplan = flightplan;
 
   if(undoIndex < undoIndexClean)
     undoIndexClean = -1;
@@ -5603,6 +5989,45 @@ void RouteController::postChange(RouteCommand *undoCommand)
   qDebug() << "postChange undoIndex" << undoIndex << "undoIndexClean" << undoIndexClean;
 #endif
   undoStack->push(undoCommand);
+  trimUndoStack();
+}
+
+void RouteController::trimUndoStack()
+{
+  // Trim only if nothing can be redone since rebuilding the stack removes all commands above the index
+  if(undoBudgetBytes <= 0L || undoStack->index() != undoStack->count())
+    return;
+
+  qint64 sizeBytes = 0L;
+  for(int i = 0; i < undoStack->count(); i++)
+    sizeBytes += static_cast<const RouteCommand *>(undoStack->command(i))->getSizeBytes();
+
+  if(sizeBytes <= undoBudgetBytes)
+    return;
+
+  // Keep newest commands up to three quarters of the budget to avoid rebuilding the stack on each change
+  // Always keep the last command
+  int first = undoStack->count() - 1;
+  sizeBytes = static_cast<const RouteCommand *>(undoStack->command(first))->getSizeBytes();
+  while(first > 0)
+  {
+    qint64 size = static_cast<const RouteCommand *>(undoStack->command(first - 1))->getSizeBytes();
+    if(sizeBytes + size > undoBudgetBytes * 3L / 4L)
+      break;
+    sizeBytes += size;
+    first--;
+  }
+
+  // QUndoStack cannot remove single commands - rebuild it from copies which skip the first redo
+  QList<RouteCommand *> commands;
+  for(int i = first; i < undoStack->count(); i++)
+    commands.append(static_cast<const RouteCommand *>(undoStack->command(i))->clone());
+
+  qDebug() << Q_FUNC_INFO << "removing" << first << "of" << undoStack->count() << "commands. Keeping" << sizeBytes << "bytes";
+
+  undoStack->clear();
+  for(RouteCommand *command : qAsConst(commands))
+    undoStack->push(command);
 }
 
 proc::MapProcedureTypes RouteController::affectedProcedures(const QList<int>& indexes)
@@ -5813,6 +6238,7 @@ void RouteController::debugNetworkClick(const atools::geo::Pos& pos)
   {
     qDebug() << Q_FUNC_INFO << pos;
 
+    waitForRouteNetworks();
     atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
     if(!routeNetworkAirway->isLoaded())
       loader.load(routeNetworkAirway);
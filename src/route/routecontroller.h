@@ -22,6 +22,7 @@
 #include "route/route.h"
 #include "route/routecommandflags.h"
 
+#include <QFutureWatcher>
 #include <QTimer>
 
 class QUndoStack;
@@ -60,9 +61,11 @@ class QMainWindow;
 class QStandardItemModel;
 class QTableView;
 class QTextCursor;
+class ProcedurePrefetcher;
 class RouteCalcDialog;
 class RouteCommand;
 class RouteLabel;
+struct RouteEntry;
 class SymbolPainter;
 class UnitStringTool;
 
@@ -299,7 +302,7 @@ public:
     return tabHandlerRoute;
   }
 
-  /* Clear network, so it will be reloaded before next flight plan calculation. */
+  /* Clear airway network and load it again in background */
   void clearAirwayNetworkCache();
 
 #ifdef DEBUG_NETWORK_INFORMATION
@@ -390,6 +393,9 @@ private:
   RouteCommand *preChange(const QString& text = QString(), rctype::RouteCmdType rcType = rctype::EDIT);
   void postChange(RouteCommand *undoCommand);
 
+  /* Drop oldest undo commands if the stack exceeds the memory budget */
+  void trimUndoStack();
+
   void routeSetStartPosition(map::MapStart start);
 
   void doubleClick(const QModelIndex& index);
@@ -439,11 +445,39 @@ private:
 
   /* Calculate flight plan pressed in dock window */
   void calculateRoute();
+
+  /* Calculate several flight plans with varied airway preference, cruise altitude and track usage concurrently
+   * and let the user select one from a list ranked by fuel or distance */
+  void calculateRouteCompare();
+
+  /* Get route finder mode, undo command name, network type and range from the calculation dialog */
+  atools::routing::Modes calculateRouteMode(QString& command, bool& airway, int& fromIdx, int& toIdx) const;
+
+  /* Load all route networks which are not loaded yet in a thread of the database pool */
+  void warmupRouteNetworks();
+
+  /* Wait until background loading of the route networks is finished. Networks must not be accessed before. */
+  void waitForRouteNetworks();
+
+  /* Build all procedures of departure and destination in background to fill the procedure caches */
+  void prefetchProcedures();
+
+  /* Navdata file name, size and modification time. Networks are kept across database switches if this did not change. */
+  QString routeNetworkDatabaseKey() const;
+
   bool calculateRouteInternal(atools::routing::RouteFinder *routeFinder,
                               const QString& commandName,
                               bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
                               atools::routing::Modes mode);
 
+  /* Replace flight plan or range with calculated route and update all. Creates an undo command. */
+  void applyCalculatedRoute(const QVector<RouteEntry>& calculatedRoute, const QString& commandName,
+                            bool fetchAirways, float altitudeFt, int fromIndex, int toIndex, int oldRouteSize);
+
+  /* Replace entries in flight plan or between from and to index with calculated route */
+  void insertCalculatedRoute(atools::fs::pln::Flightplan& flightplan, int numAlternateLegs,
+                             const QVector<RouteEntry>& calculatedRoute, bool fetchAirways, int fromIndex, int toIndex);
+
   /* Assign type and altitude from GUI */
   void updateFlightplanFromWidgets(atools::fs::pln::Flightplan& flightplan);
   void updateFlightplanFromWidgets();
@@ -552,7 +586,8 @@ private:
   /* If route distance / direct distance if bigger than this value fail routing */
   static Q_DECL_CONSTEXPR float MAX_DISTANCE_DIRECT_RATIO = 2.0f;
 
-  static Q_DECL_CONSTEXPR int ROUTE_UNDO_LIMIT = 50;
+  static Q_DECL_CONSTEXPR int ROUTE_UNDO_LIMIT = 200;
+  static Q_DECL_CONSTEXPR int ROUTE_UNDO_BUDGET_KB = 4096;
 
   atools::gui::ItemViewZoomHandler *zoomHandler = nullptr;
 
@@ -561,9 +596,27 @@ private:
   /* Clean index of the undo stack or -1 if no clean state exists */
   int undoIndexClean = 0;
 
+  /* Flight plan without procedures at the current undo stack index. Undo commands apply their differences to this. */
+  atools::fs::pln::Flightplan undoFlightplan;
+
+  /* Maximum estimated size of all undo commands */
+  qint64 undoBudgetBytes = 0L;
+
   /* Network cache for flight plan calculation */
   atools::routing::RouteNetwork *routeNetworkRadio = nullptr, *routeNetworkAirway = nullptr;
 
+  /* Running while networks are loaded in background */
+  QFutureWatcher<bool> routeNetworkWatcher;
+
+  /* Database key the networks were loaded for */
+  QString routeNetworkKey;
+
+  /* Incremented when tracks change. Part of the key for the networks in the database pool threads. */
+  int routeNetworkTrackGeneration = 0;
+  bool routeNetworkWarmup = true;
+
+  ProcedurePrefetcher *procedurePrefetcher = nullptr;
+
   /* Flightplan and route objects */
   Route route; /* real route containing all segments */
 
@@ -22,7 +22,6 @@
 #include "common/maptypesfactory.h"
 #include "common/symbolpainter.h"
 #include "search/sqlmodel.h"
-#include "search/sqlproxymodel.h"
 #include "sql/sqlrecord.h"
 
 #include <QPainter>
@@ -42,21 +41,12 @@ AirportIconDelegate::~AirportIconDelegate()
 
 void AirportIconDelegate::paint(QPainter *painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
 {
-  QModelIndex idx(index);
   const SqlModel *sqlModel = dynamic_cast<const SqlModel *>(index.model());
-  if(sqlModel == nullptr)
-  {
-    // Convert index to source if distance search proxy is used
-    const SqlProxyModel *sqlProxyModel = dynamic_cast<const SqlProxyModel *>(index.model());
-    Q_ASSERT(sqlProxyModel != nullptr);
-    sqlModel = dynamic_cast<const SqlModel *>(sqlProxyModel->sourceModel());
-    idx = sqlProxyModel->mapToSource(index);
-  }
   Q_ASSERT(sqlModel != nullptr);
 
   // Get airport from the SQL model
   map::MapAirport ap;
-  mapTypesFactory->fillAirport(sqlModel->getSqlRecord(idx.row()), ap, true /* complete */, false /* nav */,
+  mapTypesFactory->fillAirport(sqlModel->getSqlRecord(index.row()), ap, true /* complete */, false /* nav */,
                                NavApp::isAirportDatabaseXPlane(false /* navdata */));
 
   // Create a style copy
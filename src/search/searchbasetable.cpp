@@ -40,6 +40,7 @@
 #include "search/searchcontroller.h"
 #include "search/sqlcontroller.h"
 #include "search/sqlmodel.h"
+#include "search/textsearchindex.h"
 #include "sql/sqlrecord.h"
 #include "ui_mainwindow.h"
 
@@ -228,6 +229,7 @@ SearchBaseTable::SearchBaseTable(QMainWindow *parent, QTableView *tableView, Col
 SearchBaseTable::~SearchBaseTable()
 {
   view->removeEventFilter(viewEventFilter);
+  delete textIndex;
   delete controller;
   delete csvExporter;
   delete updateTimer;
@@ -355,11 +357,22 @@ QueryBuilderResult SearchBaseTable::queryBuilderFunc(const QueryWidget& queryWid
 
         // Cannot use "arg" to build string since percent confuses QString
         QStringList clauses;
-        for(const QString& col: queryWidget.getColumns())
-          if(exclude)
-            clauses.append("coalesce(" % col % ", '') not like \''" % text % '\'');
-          else
-            clauses.append(col % " like " % '\'' % text % '\'');
+
+        // Use full text index for all columns if possible
+        QString indexClause;
+        if(!exclude && textIndex != nullptr)
+          indexClause = textIndex->buildWhere(queryWidget.getColumns(), text);
+
+        if(!indexClause.isEmpty())
+          clauses.append(indexClause);
+        else
+        {
+          for(const QString& col: queryWidget.getColumns())
+            if(exclude)
+              clauses.append("coalesce(" % col % ", '') not like \''" % text % '\'');
+            else
+              clauses.append(col % " like " % '\'' % text % '\'');
+        }
         clauses.removeAll(QString());
         clauses.removeDuplicates();
 
@@ -410,6 +423,15 @@ void SearchBaseTable::initViewAndController(atools::sql::SqlDatabase *db)
   controller->prepareModel();
 
   csvExporter = new CsvExporter(mainWindow, controller);
+
+  if(columns->getQueryBuilder().isValid())
+  {
+    // Index all text columns used by the query builder widgets
+    delete textIndex;
+    textIndex = new TextSearchIndex(this, controller->getSqlModel(), columns->getTablename(), columns->getIdColumnName(),
+                                    columns->getQueryBuilder().getColumns());
+    textIndex->build();
+  }
 }
 
 void SearchBaseTable::showInSearch(const atools::sql::SqlRecord& record, bool ignoreQueryBuilder)
@@ -479,7 +501,7 @@ void SearchBaseTable::updateDistanceSearch()
                                  Unit::rev(minDistanceWidget->value(), Unit::distNmF),
                                  Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
 
-    controller->loadAllRowsForDistanceSearch();
+    controller->updateDistanceSearch();
   }
 }
 
@@ -704,9 +726,9 @@ void SearchBaseTable::distanceSearchChanged(bool changeViewState)
                                  Unit::rev(minDistanceWidget->value(), Unit::distNmF),
                                  Unit::rev(maxDistanceWidget->value(), Unit::distNmF));
 
-    // Need to load all rows for distance search due to proxy model which needs all for proper sorting
+    // Run delayed distance search query
     if(viewStateDistSearch)
-      controller->loadAllRowsForDistanceSearch();
+      controller->updateDistanceSearch();
 
     // Restore view for new state
     if(changeViewState)
@@ -738,7 +760,7 @@ void SearchBaseTable::editStartTimer()
 void SearchBaseTable::editTimeout()
 {
   qDebug() << "editTimeout";
-  controller->loadAllRowsForDistanceSearch();
+  controller->updateDistanceSearch();
 }
 
 void SearchBaseTable::connectSearchSlots()
@@ -827,10 +849,17 @@ void SearchBaseTable::preDatabaseLoad()
 {
   saveViewState(columns->isDistanceCheckBoxActive());
   controller->preDatabaseLoad();
+
+  // Detach after the model released its query
+  if(textIndex != nullptr)
+    textIndex->clear();
 }
 
 void SearchBaseTable::postDatabaseLoad()
 {
+  if(textIndex != nullptr)
+    textIndex->build();
+
   controller->postDatabaseLoad();
   restoreViewState(columns->isDistanceCheckBoxActive());
 }
@@ -965,6 +994,8 @@ void SearchBaseTable::loadAllRowsIntoView()
 
 void SearchBaseTable::showFirstEntry()
 {
+  // First page might still be loading
+  controller->waitForRows(1);
   showRow(0, true /* show info */);
 }
 
@@ -34,6 +34,7 @@ class CsvExporter;
 class Column;
 class ViewEventFilter;
 class SearchWidgetEventFilter;
+class TextSearchIndex;
 class QLineEdit;
 class QAction;
 class QComboBox;
@@ -280,6 +281,9 @@ private:
   /* Used to delay search when using the time intensive distance search */
   QTimer *updateTimer;
 
+  /* Full text index for query builder columns. null if search has no query builder. */
+  TextSearchIndex *textIndex = nullptr;
+
   ViewEventFilter *viewEventFilter = nullptr;
   SearchWidgetEventFilter *widgetEventFilter = nullptr;
 
@@ -21,7 +21,6 @@
 #include "search/column.h"
 #include "search/columnlist.h"
 #include "search/sqlmodel.h"
-#include "search/sqlproxymodel.h"
 #include "sql/sqlrecord.h"
 #include "sql/sqldatabase.h"
 #include "gui/tools.h"
@@ -43,11 +42,6 @@ SqlController::~SqlController()
 {
   viewSetModel(nullptr);
 
-  if(proxyModel != nullptr)
-    proxyModel->invalidate();
-  delete proxyModel;
-  proxyModel = nullptr;
-
   if(model != nullptr)
     model->clear();
   delete model;
@@ -71,10 +65,7 @@ void SqlController::rebuildQuery()
 {
   if(!model->isUpdatingWidgets())
   {
-    if(proxyModel != nullptr)
-      viewSetModel(proxyModel);
-    else
-      viewSetModel(model);
+    viewSetModel(model);
 
     model->updateSqlQuery();
     model->resetSqlQuery(false /* force */);
@@ -100,36 +91,27 @@ void SqlController::refreshData(bool loadAll, bool keepSelection, bool force)
     }
   }
 
-  // Reload query model
+  // Reload query model - rows are loaded in background
   model->refreshData(force);
 
   if(loadAll)
-  {
-    while(model->canFetchMore())
-      model->fetchMore(QModelIndex());
-  }
+    model->fetchRows(-1);
 
   // Selection changes when updating model
   sm = view->selectionModel();
 
   if(sm != nullptr && keepSelection)
   {
-    int visibleRowCount = getVisibleRowCount();
-
-    // Check if selected rows have to be loaded
-    if(maxRow >= visibleRowCount)
-    {
-      // Load until done or highest selected row is covered
-      while(model->canFetchMore() && getVisibleRowCount() < maxRow)
-        model->fetchMore(QModelIndex());
-    }
+    // Wait until highest selected row is loaded
+    if(!rows.isEmpty())
+      model->fetchRows(maxRow + 1);
 
     // Update selection in new data result set
-    int totalRowCount = getTotalRowCount();
+    int visibleRowCount = getVisibleRowCount();
     sm->blockSignals(true);
     for(int row : rows)
     {
-      if(row < totalRowCount)
+      if(row < visibleRowCount)
         sm->select(model->index(row, 0), QItemSelectionModel::Select | QItemSelectionModel::Rows);
     }
     sm->blockSignals(false);
@@ -172,7 +154,7 @@ void SqlController::filterIncluding(const QModelIndex& index, bool forceQueryBui
   qDebug() << Q_FUNC_INFO;
 #endif
   view->clearSelection();
-  model->filterIncluding(toSource(index), forceQueryBuilder, exact);
+  model->filterIncluding(index, forceQueryBuilder, exact);
   searchParamsChanged = true;
 }
 
@@ -182,7 +164,7 @@ void SqlController::filterExcluding(const QModelIndex& index, bool builder, bool
   qDebug() << Q_FUNC_INFO;
 #endif
   view->clearSelection();
-  model->filterExcluding(toSource(index), builder, exact);
+  model->filterExcluding(index, builder, exact);
   searchParamsChanged = true;
 }
 
@@ -315,31 +297,15 @@ void SqlController::filterByDistance(const atools::geo::Pos& center, sqlmodeltyp
     // Start or update distance search
     view->clearSelection();
 
+    bool distanceSearchStarted = !currentDistanceCenter.isValid();
     currentDistanceCenter = center;
-    atools::geo::Rect rect(center, atools::geo::nmToMeter(maxDistance), true /* fast */);
-
-    bool proxyWasNull = false;
-    if(proxyModel == nullptr)
-    {
-      // No proxy - create a new one and assign it to the model
-      proxyWasNull = true;
-      // Controller takes ownership
-      proxyModel = new SqlProxyModel(nullptr, model);
-      proxyModel->setDynamicSortFilter(true);
-      proxyModel->setSourceModel(model);
-
-      viewSetModel(proxyModel);
-    }
 
-    // Update distances in proxy to get precise radius filtering (second filter stage)
-    proxyModel->setDistanceFilter(center, dir, minDistance, maxDistance);
+    // Update rectangle and ring filter in query model
+    model->filterByDistance(center, dir, minDistance, maxDistance);
 
-    // Update rectangle filter in query model (first coarse filter stage)
-    model->filterByBoundingRect(rect);
-
-    if(proxyWasNull)
+    if(distanceSearchStarted)
     {
-      // New proxy created so set ordering and more
+      // Distance search started so set ordering and more
       model->fillHeaderData();
       view->reset();
       processViewColumns();
@@ -351,17 +317,7 @@ void SqlController::filterByDistance(const atools::geo::Pos& center, sqlmodeltyp
     view->clearSelection();
     currentDistanceCenter = atools::geo::Pos();
 
-    // Set sql model back into view
-    viewSetModel(model);
-
-    if(proxyModel != nullptr)
-    {
-      proxyModel->invalidate();
-      delete proxyModel;
-      proxyModel = nullptr;
-    }
-
-    model->filterByBoundingRect(atools::geo::Rect());
+    model->filterByDistance(atools::geo::Pos(), dir, minDistance, maxDistance);
     model->fillHeaderData();
     processViewColumns();
   }
@@ -373,16 +329,10 @@ void SqlController::filterByDistanceUpdate(sqlmodeltypes::SearchDirection dir, f
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO;
 #endif
-  if(proxyModel != nullptr)
+  if(isDistanceSearch())
   {
     view->clearSelection();
-    // Create new bounding rectangle for first stage search
-    atools::geo::Rect rect(currentDistanceCenter, atools::geo::nmToMeter(maxDistance), true /* fast */);
-
-    // Update proxy second stage filter
-    proxyModel->setDistanceFilter(currentDistanceCenter, dir, minDistance, maxDistance);
-    // Update SQL model coarse first stage filter
-    model->filterByBoundingRect(rect);
+    model->filterByDistance(currentDistanceCenter, dir, minDistance, maxDistance);
     searchParamsChanged = true;
   }
 }
@@ -426,10 +376,7 @@ QList<int> SqlController::getSelectedRows(bool reverse) const
 
 int SqlController::getVisibleRowCount() const
 {
-  if(proxyModel != nullptr)
-    // Proxy fine second stage filter knows precise count
-    return proxyModel->rowCount();
-  else if(model != nullptr)
+  if(model != nullptr)
     return model->rowCount();
 
   return 0;
@@ -437,10 +384,7 @@ int SqlController::getVisibleRowCount() const
 
 int SqlController::getTotalRowCount() const
 {
-  if(proxyModel != nullptr)
-    // Proxy fine second stage filter knows precise count
-    return proxyModel->rowCount();
-  else if(model != nullptr)
+  if(model != nullptr)
     return model->getTotalRowCount();
   else
     return 0;
@@ -479,12 +423,12 @@ void SqlController::resetView()
   for(int i = 0; i < header->count(); i++)
     header->moveSection(header->visualIndex(i), i);
 
-  if(proxyModel != nullptr)
+  if(isDistanceSearch())
   {
-    // For distance search switch back to distance column sort - tell proxy ...
-    proxyModel->sort(0, Qt::DescendingOrder);
-    // ... and adjust query
-    model->setSort("distance", Qt::DescendingOrder);
+    // For distance search switch back to distance column sort with nearest first
+    model->setSort("distance", Qt::AscendingOrder);
+    model->updateSqlQuery();
+    model->resetSqlQuery(false /* force */);
   }
   else
     model->resetSort();
@@ -497,7 +441,7 @@ void SqlController::resetView()
 void SqlController::resetSearch()
 {
   if(columns != nullptr)
-    // Will also delete proxy by check box message
+    // Will also end distance search by check box message
     columns->resetWidgets();
 
   if(model != nullptr)
@@ -521,29 +465,13 @@ QModelIndex SqlController::getModelIndexFor(int row, int column) const
 
 QString SqlController::getFieldDataAt(const QModelIndex& index) const
 {
-  return model->getFormattedFieldData(toSource(index)).toString();
-}
-
-QModelIndex SqlController::toSource(const QModelIndex& index) const
-{
-  if(proxyModel != nullptr)
-    return proxyModel->mapToSource(index);
-  else
-    return index;
-}
-
-QModelIndex SqlController::fromSource(const QModelIndex& index) const
-{
-  if(proxyModel != nullptr)
-    return proxyModel->mapFromSource(index);
-  else
-    return index;
+  return model->getFormattedFieldData(index).toString();
 }
 
 int SqlController::getIdForRow(const QModelIndex& index)
 {
   if(index.isValid())
-    return model->getRawData(toSource(index).row(), columns->getIdColumnName()).toInt();
+    return model->getRawData(index.row(), columns->getIdColumnName()).toInt();
   else
     return -1;
 }
@@ -619,23 +547,12 @@ void SqlController::prepareModel()
   processViewColumns();
 }
 
-void SqlController::loadAllRowsForDistanceSearch()
+void SqlController::updateDistanceSearch()
 {
-  if(searchParamsChanged && proxyModel != nullptr)
+  if(searchParamsChanged && isDistanceSearch())
   {
-    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-
-    // Run query again
+    // Run query again - rows are fetched on demand
     model->resetSqlQuery(false /* force */);
-
-    // Let proxy know that filter parameters have changed
-    proxyModel->invalidate();
-
-    while(model->canFetchMore())
-      // Fetch as long as we can
-      model->fetchMore(QModelIndex());
-
-    QGuiApplication::restoreOverrideCursor();
     searchParamsChanged = false;
   }
 }
@@ -649,17 +566,11 @@ void SqlController::loadAllRows()
 {
   QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-  if(proxyModel != nullptr)
-  {
+  if(isDistanceSearch())
     // Run query again
     model->resetSqlQuery(false /* force */);
 
-    // Let proxy know that filter parameters have changed
-    proxyModel->invalidate();
-  }
-
-  while(model->canFetchMore())
-    model->fetchMore(QModelIndex());
+  model->fetchRows(-1);
 
   QGuiApplication::restoreOverrideCursor();
 }
@@ -681,23 +592,20 @@ void SqlController::initRecord(atools::sql::SqlRecord& rec)
     rec.appendField(from.fieldName(i), from.fieldType(i));
 }
 
-bool SqlController::hasRow(int row) const
+void SqlController::waitForRows(int rowCount)
 {
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
+  model->fetchRows(rowCount);
+}
 
-  return model->hasIndex(srow, 0);
+bool SqlController::hasRow(int row) const
+{
+  return model->hasIndex(row, 0);
 }
 
 void SqlController::fillRecord(int row, atools::sql::SqlRecord& rec)
 {
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
-
   for(int i = 0; i < rec.count(); i++)
-    rec.setValue(i, model->getRawData(srow, i));
+    rec.setValue(i, model->getRawData(row, i));
 }
 
 QVariant SqlController::getRawData(int row, const QString& colname) const
@@ -706,19 +614,6 @@ QVariant SqlController::getRawData(int row, const QString& colname) const
 }
 
 QVariant SqlController::getRawData(int row, int col) const
-{
-  int srow = row;
-  if(proxyModel != nullptr)
-    srow = toSource(proxyModel->index(row, 0)).row();
-  return model->getRawData(srow, col);
-}
-
-QVariant SqlController::getRawDataLocal(int row, const QString& colname) const
-{
-  return getRawDataLocal(row, model->getSqlRecord().indexOf(colname));
-}
-
-QVariant SqlController::getRawDataLocal(int row, int col) const
 {
   return model->getRawData(row, col);
 }
@@ -44,7 +44,6 @@ class QVariant;
 class QWidget;
 class QueryBuilder;
 class SqlModel;
-class SqlProxyModel;
 
 /*
  * Combines all functionality around the table SQL model, view, view header and
@@ -124,10 +123,6 @@ public:
   QVariant getRawData(int row, const QString& colname) const;
   QVariant getRawData(int row, int col) const;
 
-  /* Same without row translation */
-  QVariant getRawDataLocal(int row, const QString& colname) const;
-  QVariant getRawDataLocal(int row, int col) const;
-
   /* Column name for sorted column */
   QString getSortColumn() const;
   int getSortColumnIndex() const;
@@ -164,13 +159,14 @@ public:
   /* Update distance search for changed values from spin box widgets */
   void filterByDistanceUpdate(sqlmodeltypes::SearchDirection dir, float minDistance, float maxDistance);
 
-  /* Load all rows if a distance search is active. */
-  void loadAllRowsForDistanceSearch();
+  /* Run the delayed query if a distance search is active and search parameters have changed.
+   * Rows are fetched on demand as for all other searches. */
+  void updateDistanceSearch();
 
   /* True if distance search is active */
   bool isDistanceSearch()
   {
-    return proxyModel != nullptr;
+    return currentDistanceCenter.isValid();
   }
 
   /* Set the callback that will handle data rows and values, i.e. format values to strings.
@@ -211,6 +207,9 @@ public:
   /* Update view only */
   void refreshView();
 
+  /* Wait for the background query and load rows until rowCount rows are available */
+  void waitForRows(int rowCount);
+
   /* True if the row exists in the model */
   bool hasRow(int row) const;
 
@@ -229,17 +228,6 @@ private:
   /* Adapt columns to query change */
   void processViewColumns();
 
-  /* Convert indexes if proxy model for distance search is used */
-  QModelIndex toSource(const QModelIndex& index) const;
-  QModelIndex fromSource(const QModelIndex& index) const;
-
-  /* Proxy model used to distance search. null if distance search is not active.
-   * While the normal SQL model acts as a primary (rectangle based) filter the proxy
-   * model will do proper min/max radius filtering at a secondary stage.
-   * To get correct results all rows have to be loaded from the SQL model and have to be piped through the
-   * proxy model. */
-  SqlProxyModel *proxyModel = nullptr;
-
   SqlModel *model = nullptr;
   QWidget *parentWidget = nullptr;
   atools::sql::SqlDatabase *db = nullptr;
@@ -17,6 +17,10 @@
 
 #include "search/sqlmodel.h"
 
+#include "common/mapflags.h"
+#include "common/unit.h"
+#include "db/dbtools.h"
+#include "geo/calculations.h"
 #include "gui/application.h"
 #include "gui/errorhandler.h"
 #include "sql/sqldatabase.h"
@@ -29,6 +33,7 @@
 #include <QLineEdit>
 #include <QCheckBox>
 #include <QSqlError>
+#include <QSqlQuery>
 #include <QRegularExpression>
 #include <QComboBox>
 #include <QStringBuilder>
@@ -38,9 +43,49 @@ using atools::sql::SqlDatabase;
 using atools::gui::ErrorHandler;
 using atools::sql::SqlRecord;
 
+/* Direction sector is decreased by this value on each side */
+static const double DIR_RANGE_DEG = 22.5;
+
+/* SQLite has no trigonometric functions. Sine and cosine are calculated using the Taylor series which
+ * is precise enough for distance search for the range -PI/2 to PI/2 */
+static QString sqlSin(const QString& x)
+{
+  return QString("(%1*(1-%1*%1/6*(1-%1*%1/20*(1-%1*%1/42*(1-%1*%1/72*(1-%1*%1/110))))))").arg(x);
+}
+
+static QString sqlCos(const QString& x)
+{
+  return QString("(1-%1*%1/2*(1-%1*%1/12*(1-%1*%1/30*(1-%1*%1/56*(1-%1*%1/90*(1-%1*%1/132))))))").arg(x);
+}
+
+static QString sqlNum(double value)
+{
+  return QString::number(value, 'g', 17);
+}
+
+/* Number of rows fetched in background for each page */
+static const int PAGE_SIZE = 256;
+
+/* Haversine of the central angle for the given distance */
+static double distanceHav(float distanceNm)
+{
+  // Use the same earth radius as atools::geo::Pos to match displayed distances
+  static const double METER_PER_RAD = atools::geo::Pos(0.f, 0.f).distanceMeterTo(atools::geo::Pos(1.f, 0.f)) * 180. / M_PI;
+
+  double halfAngle = atools::geo::nmToMeter(distanceNm) / METER_PER_RAD / 2.;
+  return std::sin(halfAngle) * std::sin(halfAngle);
+}
+
 SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *columnList)
-  : QSqlQueryModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
+  : QAbstractTableModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
 {
+  // Own connection for each model since searches can run in parallel
+  static int connectionNumber = 0;
+  worker = new SqlQueryWorker(dbtools::DATABASE_NAME_SEARCH + columns->getTablename() +
+                              QString::number(connectionNumber++));
+
+  connect(&watcher, &QFutureWatcher<SqlQueryPage>::finished, this, &SqlModel::pageFetched);
+
   // Set default handler
   setDataCallback(nullptr, QSet<Qt::ItemDataRole>());
 
@@ -49,6 +94,8 @@ SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *column
 
 SqlModel::~SqlModel()
 {
+  watcher.waitForFinished();
+  ATOOLS_DELETE(worker);
 }
 
 void SqlModel::filterByBuilder(const QWidget *widget)
@@ -69,9 +116,23 @@ void SqlModel::filterExcluding(QModelIndex index, bool forceQueryBuilder, bool e
   buildQuery();
 }
 
-void SqlModel::filterByBoundingRect(const atools::geo::Rect& boundingRectangle)
+void SqlModel::filterByDistance(const atools::geo::Pos& center, sqlmodeltypes::SearchDirection dir, float minDistanceNm,
+                                float maxDistanceNm)
 {
-  boundingRect = boundingRectangle;
+  if(center.isValid())
+  {
+    // Rectangle for the coarse first stage which can use the coordinate indexes
+    boundingRect = atools::geo::Rect(center, atools::geo::nmToMeter(maxDistanceNm), true /* fast */);
+    distanceCenter = center;
+    distanceDirection = dir;
+    minDistanceHav = distanceHav(minDistanceNm);
+    maxDistanceHav = distanceHav(maxDistanceNm);
+  }
+  else
+  {
+    boundingRect = atools::geo::Rect();
+    distanceCenter = atools::geo::Pos();
+  }
   buildQuery();
 }
 
@@ -85,7 +146,7 @@ void SqlModel::filterByRecord(const atools::sql::SqlRecord& record, bool ignoreQ
 
 void SqlModel::filterBy(QModelIndex index, bool exclude, bool forceQueryBuilder, bool exact)
 {
-  filterBy(exclude, getSqlRecord().fieldName(index.column()), QSqlQueryModel::data(index), forceQueryBuilder,
+  filterBy(exclude, getSqlRecord().fieldName(index.column()), rawData(index), forceQueryBuilder,
            false /* ignoreQueryBuilder */, exact);
 }
 
@@ -391,6 +452,7 @@ void SqlModel::clearWhereConditions()
 {
   whereConditionMap.clear();
   boundingRect = atools::geo::Rect();
+  distanceCenter = atools::geo::Pos();
 }
 
 /* Set header captions */
@@ -442,6 +504,10 @@ void SqlModel::sort(int column, Qt::SortOrder order)
   orderByOrder = sortOrderToSql(order);
 
   buildQuery();
+
+  if(isDistanceSearchActive())
+    // Query is not run by buildQuery() for distance search
+    resetSqlQuery(false /* force */);
 }
 
 /* Build full list of columns to query */
@@ -453,6 +519,15 @@ QString SqlModel::buildColumnList(const atools::sql::SqlRecord& tableCols)
     if(!col->getSqlFunc().isEmpty())
       // Use SQL function as column if defined
       colNames.append(QString("(%1) as %2").arg(col->getSqlFunc()).arg(col->getColumnName()));
+    else if(col->isDistance() && isDistanceSearchActive() && col->getColumnName() == "distance")
+      // Haversine is sufficient for sorting - value is formatted in data()
+      colNames.append("lnm_hav as distance");
+    else if(col->isDistance() && isDistanceSearchActive() && col->getColumnName() == "heading")
+      // Pseudo angle from 0 (north) to 4 clockwise which has the same order as the true course
+      colNames.append("(case when lnm_y >= 0 and lnm_x >= 0 then lnm_y / (lnm_x + lnm_y) "
+                      "when lnm_y >= 0 then 1 - lnm_x / (lnm_y - lnm_x) "
+                      "when lnm_x <= 0 then 2 - lnm_y / (-lnm_x - lnm_y) "
+                      "else 3 + lnm_x / (lnm_x - lnm_y) end) as heading");
     else if(col->isDistance() || !tableCols.contains(col->getColumnName()))
       // Add null for special distance columns
       // Null for columns which do not exist in the database
@@ -475,6 +550,71 @@ QString SqlModel::buildColumnList(const atools::sql::SqlRecord& tableCols)
   return queryCols;
 }
 
+/* Build a nested table expression which adds the columns lnm_hav (haversine of the central angle to the center)
+ * as well as lnm_x and lnm_y (north and east components of the direction from center) to all table columns.
+ * Inner query calculates sine and cosine of the row coordinates once. SQLite flattens the nested queries which
+ * allows to use the coordinate indexes for the bounding rectangle condition. */
+QString SqlModel::buildDistanceTable(const QString& tablename) const
+{
+  const QString D2R = sqlNum(M_PI / 180.);
+  const double lat1 = atools::geo::toRadians(static_cast<double>(distanceCenter.getLatY()));
+  const QString sinLat1 = sqlNum(std::sin(lat1)), cosLat1 = sqlNum(std::cos(lat1));
+
+  // Half latitude and quarter longitude difference are always within -PI/2 and PI/2
+  const QString lat = "(laty*" % D2R % ')';
+  const QString dlat2 = "((laty-" % sqlNum(distanceCenter.getLatY()) % ")*" % D2R % "/2)";
+  const QString dlon4 = "((lonx-" % sqlNum(distanceCenter.getLonX()) % ")*" % D2R % "/4)";
+
+  QString inner = "select *, " % sqlSin(lat) % " as lnm_slat, " % sqlCos(lat) % " as lnm_clat, " %
+                  sqlSin(dlat2) % " as lnm_sdlat2, " % sqlSin(dlon4) % " as lnm_sdlon4, " %
+                  sqlCos(dlon4) % " as lnm_cdlon4 from " % tablename;
+
+  // Sine and cosine of half longitude difference by double angle formulas
+  const QString sdlon2 = "(2*lnm_sdlon4*lnm_cdlon4)", cdlon2 = "(1-2*lnm_sdlon4*lnm_sdlon4)";
+
+  return "(select *, " %
+         // hav = sin²(Δφ/2) + cos φ1 ⋅ cos φ2 ⋅ sin²(Δλ/2)
+         "lnm_sdlat2*lnm_sdlat2+" % cosLat1 % "*lnm_clat*" % sdlon2 % '*' % sdlon2 % " as lnm_hav, " %
+         // y = sin Δλ ⋅ cos φ2
+         "2*" % sdlon2 % '*' % cdlon2 % "*lnm_clat as lnm_y, " %
+         // x = cos φ1 ⋅ sin φ2 − sin φ1 ⋅ cos φ2 ⋅ cos Δλ
+         cosLat1 % "*lnm_slat-" % sinLat1 % "*lnm_clat*(1-2*" % sdlon2 % '*' % sdlon2 % ") as lnm_x " %
+         "from (" % inner % "))";
+}
+
+/* Second stage distance search filter for ring and direction sector using the columns from buildDistanceTable() */
+QString SqlModel::buildDistanceWhere() const
+{
+  QString where = "lnm_hav <= " % sqlNum(maxDistanceHav);
+  if(minDistanceHav > 0.)
+    where += " and lnm_hav >= " % sqlNum(minDistanceHav);
+
+  // Course is within sector if the angle to the axis is less than the given value
+  const QString tanRange = sqlNum(std::tan(atools::geo::toRadians(90. - DIR_RANGE_DEG)));
+  switch(distanceDirection)
+  {
+    case sqlmodeltypes::ALL:
+      break;
+
+    case sqlmodeltypes::NORTH:
+      where += " and lnm_x > 0 and abs(lnm_y) <= " % tanRange % " * lnm_x";
+      break;
+
+    case sqlmodeltypes::EAST:
+      where += " and lnm_y > 0 and abs(lnm_x) <= " % tanRange % " * lnm_y";
+      break;
+
+    case sqlmodeltypes::SOUTH:
+      where += " and lnm_x < 0 and abs(lnm_y) <= -" % tanRange % " * lnm_x";
+      break;
+
+    case sqlmodeltypes::WEST:
+      where += " and lnm_y < 0 and abs(lnm_x) <= -" % tanRange % " * lnm_y";
+      break;
+  }
+  return where;
+}
+
 /* Create SQL query and set it into the model */
 void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
 {
@@ -489,17 +629,22 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
   atools::sql::SqlRecord tableCols = db->record(tablename);
   QString queryCols = buildColumnList(tableCols);
 
+  // Add calculated distance and direction columns for distance search
+  QString queryTable = isDistanceSearchActive() ? buildDistanceTable(tablename) : tablename;
+
   QVector<const Column *> overrideColumns;
   QString queryWhere = buildWhere(tableCols, overrideColumns);
 
   QString queryOrder;
   const Column *col = columns->getColumn(orderByCol);
-  // Distance columns are no search criteria
-  if(!orderByCol.isEmpty() && !orderByOrder.isEmpty() && !col->isDistance())
+  // Distance columns can only be sorted when calculated in distance search
+  if(!orderByCol.isEmpty() && !orderByOrder.isEmpty() && (!col->isDistance() || isDistanceSearchActive()))
   {
     Q_ASSERT(col != nullptr);
 
-    if(!col->getSqlFunc().isEmpty())
+    if(col->isDistance())
+      queryOrder += "order by " % orderByCol % ' ' % orderByOrder;
+    else if(!col->getSqlFunc().isEmpty())
       queryOrder += "order by (" % col->getSqlFunc() % ") " % orderByOrder;
     else if(!tableCols.contains(orderByCol))
     {
@@ -520,29 +665,22 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
       queryOrder += "order by " % orderByCol % ' ' % orderByOrder;
   }
 
-  currentSqlQuery = "select " % queryCols % " from " % tablename % ' ' % queryWhere % ' ' % queryOrder;
+  currentSqlQuery = "select " % queryCols % " from " % queryTable % ' ' % queryWhere % ' ' % queryOrder;
 
   // Build a query to find the total row count of the result ==================
-  totalRowCount = 0;
-  currentSqlCountQuery = "select count(1) from " % tablename % ' ' % queryWhere;
+  currentSqlCountQuery = "select count(1) from " % queryTable % ' ' % queryWhere;
 
   // Build a query to fetch the whole result set in getFullResultSet() ==================
-  if(!isDistanceSearchActive())
-  {
-    QStringList colList(columns->getIdColumnName());
+  QStringList colList(columns->getIdColumnName());
 
-    // Add coordinates if available
-    if(columns->hasColumn("lonx") && columns->hasColumn("laty"))
-    {
-      colList.append("lonx");
-      colList.append("laty");
-    }
-
-    currentSqlFetchQuery = "select " % colList.join(", ") % " from " % tablename % ' ' % queryWhere;
+  // Add coordinates if available
+  if(columns->hasColumn("lonx") && columns->hasColumn("laty"))
+  {
+    colList.append("lonx");
+    colList.append("laty");
   }
-  else
-    // No result set for distance searches since the result is not filtered by precise distance
-    currentSqlFetchQuery.clear();
+
+  currentSqlFetchQuery = "select " % colList.join(", ") % " from " % queryTable % ' ' % queryWhere;
 
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << currentSqlQuery;
@@ -557,38 +695,9 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
   }
   emit overrideMode(overrideColumnTitles);
 
-  try
-  {
-    // Count total rows
-    updateTotalCount();
-
-    if(!isDistanceSearchActive())
-      // Delay query for bounding rectangle query with proxy model
-      resetSqlQuery(false /* force */);
-  }
-  catch(atools::Exception& e)
-  {
-    ATOOLS_HANDLE_EXCEPTION(e);
-  }
-  catch(...)
-  {
-    ATOOLS_HANDLE_UNKNOWN_EXCEPTION;
-  }
-}
-
-void SqlModel::updateTotalCount()
-{
-  if(!currentSqlCountQuery.isEmpty())
-  {
-    SqlQuery countStmt(db);
-    countStmt.exec(currentSqlCountQuery);
-    if(countStmt.next())
-      totalRowCount = countStmt.value(0).toInt();
-    else
-      totalRowCount = 0;
-  }
-  else
-    totalRowCount = 0;
+  if(!isDistanceSearchActive())
+    // Distance search query is delayed until editing of search parameters is finished
+    resetSqlQuery(false /* force */);
 }
 
 /* Build where statement */
@@ -692,7 +801,7 @@ QString SqlModel::buildWhere(const atools::sql::SqlRecord& tableCols, QVector<co
 
     if(!queryWhere.isEmpty())
       queryWhere += WHERE_OPERATOR;
-    queryWhere += rectCond;
+    queryWhere += rectCond % WHERE_OPERATOR % buildDistanceWhere();
   }
 
   if(!queryWhere.isEmpty())
@@ -723,19 +832,168 @@ QString SqlModel::buildWhereValue(const WhereCondition& cond)
 void SqlModel::refreshData(bool force)
 {
   resetSqlQuery(force);
-  updateTotalCount();
 }
 
 void SqlModel::resetSqlQuery(bool force)
 {
   // Update can be forced when changing database rows, for distance search or if the query differs
-  if(force || isDistanceSearchActive() || QSqlQueryModel::query().lastQuery() != currentSqlQuery)
+  if(!(force || isDistanceSearchActive() || executedSqlQuery != currentSqlQuery))
+    return;
+
+  // Drop results of older queries still running or queued in the worker
+  worker->cancel();
+
+  if(db == nullptr || !db->isOpen() || currentSqlQuery.isEmpty())
+    return;
+
+  // Get field information without fetching rows - returns immediately
+  QSqlQuery query(db->getQSqlDatabase());
+  if(!query.exec(currentSqlQuery % " limit 0"))
   {
-    QSqlQueryModel::setQuery(currentSqlQuery, db->getQSqlDatabase());
+    atools::gui::ErrorHandler(parentWidget).handleSqlError(query.lastError());
+    return;
+  }
+
+  beginResetModel();
+  queryRecord = query.record();
+  rows.clear();
+  totalRowCount = 0;
+  executedSqlQuery = currentSqlQuery;
+  executedSqlCountQuery = currentSqlCountQuery;
+  endResetModel();
 
-    if(lastError().isValid())
-      atools::gui::ErrorHandler(parentWidget).handleSqlError(lastError());
+  // Load first page and total count in background
+  startFetch(0, PAGE_SIZE, true /* count */);
+}
+
+void SqlModel::startFetch(int offset, int limit, bool count)
+{
+  worker->open(db->databaseName(), db->isReadonly());
+  fetching = true;
+  watcher.setFuture(worker->fetch(executedSqlQuery, count ? executedSqlCountQuery : QString(), offset, limit));
+}
+
+void SqlModel::pageFetched()
+{
+  // Result was already consumed by fetchRows() or query was cleared
+  if(!fetching)
+    return;
+  fetching = false;
+
+  const SqlQueryPage page = watcher.result();
+  if(page.cancelled)
+    return;
+
+  if(page.error.isValid())
+  {
+    totalRowCount = rows.size();
+    atools::gui::ErrorHandler(parentWidget).handleSqlError(page.error);
+    return;
+  }
+
+  if(page.totalRowCount >= 0)
+    totalRowCount = page.totalRowCount;
+
+  // Drop page if rows were changed meanwhile
+  if(page.offset != rows.size())
+    return;
+
+  if(!page.rows.isEmpty())
+  {
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + page.rows.size() - 1);
+    rows.append(page.rows);
+    endInsertRows();
+  }
+
+  // Avoid endless fetching if table was changed between count and fetch
+  if(page.atEnd || rows.size() > totalRowCount)
+    totalRowCount = rows.size();
+
+  emit fetchedMore();
+}
+
+void SqlModel::fetchRows(int rowCount)
+{
+  // Take over running query
+  if(fetching)
+  {
+    watcher.waitForFinished();
+    pageFetched();
+  }
+
+  while(canFetchMore() && (rowCount < 0 || rows.size() < rowCount))
+  {
+    int numRows = rows.size();
+    startFetch(numRows, rowCount < 0 ? -1 : std::max(rowCount - numRows, PAGE_SIZE), false /* count */);
+    watcher.waitForFinished();
+    pageFetched();
+
+    // Error or cancelled
+    if(rows.size() == numRows)
+      break;
+  }
+}
+
+void SqlModel::clear()
+{
+  fetching = false;
+  watcher.waitForFinished();
+  worker->close();
+
+  beginResetModel();
+  rows.clear();
+  queryRecord.clear();
+  headerTexts.clear();
+  executedSqlQuery.clear();
+  executedSqlCountQuery.clear();
+  totalRowCount = 0;
+  endResetModel();
+}
+
+void SqlModel::attachDatabase(const QString& name, const QString& file)
+{
+  SqlQuery(db).exec("attach database '" % QString(file).replace('\'', "''") % "' as " % name);
+  worker->setAttachedDatabase(name, file);
+}
+
+void SqlModel::detachDatabase(const QString& name)
+{
+  worker->setAttachedDatabase(name, QString());
+  SqlQuery(db).exec("detach database " % name);
+}
+
+int SqlModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : rows.size();
+}
+
+int SqlModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : queryRecord.count();
+}
+
+QVariant SqlModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if(orientation == Qt::Horizontal && role == Qt::DisplayRole)
+  {
+    if(headerTexts.contains(section))
+      return headerTexts.value(section);
+
+    // Use field name as default like QSqlQueryModel
+    if(section >= 0 && section < queryRecord.count())
+      return queryRecord.fieldName(section);
   }
+  return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool SqlModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant& value, int role)
+{
+  if(orientation != Qt::Horizontal || section < 0 || (role != Qt::DisplayRole && role != Qt::EditRole))
+    return false;
+
+  headerTexts.insert(section, value);
+  emit headerDataChanged(orientation, section, section);
+  return true;
 }
 
 Qt::SortOrder SqlModel::getSortOrder() const
@@ -755,7 +1013,7 @@ QVariant SqlModel::defaultDataHandler(int, int, const Column *, const QVariant&,
 
 QVariant SqlModel::rawData(const QModelIndex& index) const
 {
-  return index.isValid() ? QSqlQueryModel::data(index, Qt::DisplayRole) : QVariant();
+  return index.isValid() ? getRawData(index.row(), index.column()) : QVariant();
 }
 
 QVariant SqlModel::data(const QModelIndex& index, int role) const
@@ -765,24 +1023,40 @@ QVariant SqlModel::data(const QModelIndex& index, int role) const
 
   Qt::ItemDataRole dataRole = static_cast<Qt::ItemDataRole>(role);
 
+  if(isDistanceSearchActive() && (role == Qt::DisplayRole || role == Qt::TextAlignmentRole))
+  {
+    // Query contains only values for sorting - calculate distance and heading for display
+    const Column *column = columns->getColumn(getSqlRecord().fieldName(index.column()));
+    if(column->isDistance())
+    {
+      if(role == Qt::TextAlignmentRole)
+        return Qt::AlignRight;
+      else if(column->getColumnName() == "distance")
+        return Unit::distMeter(buildPos(index.row()).distanceMeterTo(distanceCenter), false);
+      else if(column->getColumnName() == "heading")
+      {
+        float heading = atools::geo::normalizeCourse(distanceCenter.angleDegTo(buildPos(index.row())));
+        if(heading < map::INVALID_COURSE_VALUE)
+          return QLocale().toString(heading, 'f', 0);
+        else
+          return QVariant();
+      }
+    }
+  }
+
   // Get the default value for this role. Can be a font, color, etc.
-  QVariant roleValue = QSqlQueryModel::data(index, role);
+  QVariant roleValue = role == Qt::DisplayRole || role == Qt::EditRole ? rawData(index) : QVariant();
 
   if(handlerRoles.contains(dataRole))
   {
     // Callback wants to be called for this role
 
     // Get data to display
-    QVariant dataValue = QSqlQueryModel::data(index, Qt::DisplayRole);
+    QVariant dataValue = rawData(index);
     QString col = getSqlRecord().fieldName(index.column());
     const Column *column = columns->getColumn(col);
 
-    int row = -1;
-    if(!isDistanceSearchActive())
-      // no reliable row information with proxy
-      row = index.row();
-
-    QVariant retval = dataFunction(index.column(), row, column, roleValue, dataValue, dataRole);
+    QVariant retval = dataFunction(index.column(), index.row(), column, roleValue, dataValue, dataRole);
     if(retval.isValid())
       return retval;
   }
@@ -791,8 +1065,13 @@ QVariant SqlModel::data(const QModelIndex& index, int role) const
 
 void SqlModel::fetchMore(const QModelIndex& parent)
 {
-  QSqlQueryModel::fetchMore(parent);
-  emit fetchedMore();
+  if(!parent.isValid() && canFetchMore())
+    startFetch(rows.size(), PAGE_SIZE, false /* count */);
+}
+
+bool SqlModel::canFetchMore(const QModelIndex& parent) const
+{
+  return !parent.isValid() && !fetching && rows.size() < totalRowCount;
 }
 
 QVariant SqlModel::getRawData(int row, const QString& colname) const
@@ -807,7 +1086,15 @@ void SqlModel::updateSqlQuery()
 
 QVariant SqlModel::getRawData(int row, int col) const
 {
-  return QSqlQueryModel::data(createIndex(row, col));
+  if(row >= 0 && row < rows.size() && col >= 0 && col < rows.at(row).size())
+    return rows.at(row).at(col);
+  else
+    return QVariant();
+}
+
+atools::geo::Pos SqlModel::buildPos(int row) const
+{
+  return atools::geo::Pos(getRawData(row, "lonx").toFloat(), getRawData(row, "laty").toFloat());
 }
 
 QString SqlModel::getColumnName(int col) const
@@ -851,10 +1138,13 @@ void SqlModel::getFullResultSet(QVector<std::pair<int, atools::geo::Pos> >& resu
 
 atools::sql::SqlRecord SqlModel::getSqlRecord() const
 {
-  return atools::sql::SqlRecord(record(), currentSqlQuery);
+  return atools::sql::SqlRecord(queryRecord, currentSqlQuery);
 }
 
 atools::sql::SqlRecord SqlModel::getSqlRecord(int row) const
 {
-  return atools::sql::SqlRecord(record(row), currentSqlQuery);
+  QSqlRecord rec(queryRecord);
+  for(int i = 0; i < rec.count(); i++)
+    rec.setValue(i, getRawData(row, i));
+  return atools::sql::SqlRecord(rec, currentSqlQuery);
 }
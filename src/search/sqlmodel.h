@@ -18,11 +18,15 @@
 #ifndef LITTLENAVMAP_SQLMODEL_H
 #define LITTLENAVMAP_SQLMODEL_H
 
+#include "geo/pos.h"
 #include "geo/rect.h"
 #include "search/querybuilder.h"
 #include "search/sqlmodeltypes.h"
+#include "search/sqlqueryworker.h"
 
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QSqlRecord>
 
 namespace atools {
 namespace sql {
@@ -36,10 +40,14 @@ class Column;
 class ColumnList;
 
 /*
- * Extends the QSqlQueryModel and adds query building based on filters and ordering.
+ * Table model which adds query building based on filters and ordering.
+ *
+ * Queries are executed in a background thread by SqlQueryWorker which uses its own database connection.
+ * Rows are appended in pages when they arrive. Results of queries which were replaced by a newer
+ * one are dropped.
  */
 class SqlModel :
-  public QSqlQueryModel
+  public QAbstractTableModel
 {
   Q_OBJECT
 
@@ -86,8 +94,7 @@ public:
   /* Get field data formatted for display as seen in the table view */
   QVariant getFormattedFieldData(const QModelIndex& index) const;
 
-  /* Query the full result set into a vector of pairs with id and optional coordinates.
-   * This does not work when using distance search. */
+  /* Query the full result set into a vector of pairs with id and optional coordinates */
   void getFullResultSet(QVector<std::pair<int, atools::geo::Pos> >& result);
 
   Qt::SortOrder getSortOrder() const;
@@ -112,8 +119,37 @@ public:
     return currentSqlQuery;
   }
 
-  /* Fetch more data and emit signal fetchedMore */
+  /* Start fetching the next page in background. Signal fetchedMore is emitted when the rows arrive. */
   virtual void fetchMore(const QModelIndex& parent) override;
+  virtual bool canFetchMore(const QModelIndex& parent = QModelIndex()) const override;
+
+  virtual int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+  virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+  virtual bool setHeaderData(int section, Qt::Orientation orientation, const QVariant& value,
+                             int role = Qt::EditRole) override;
+
+  /* Wait for running query and fetch rows until rowCount rows are loaded or all if -1. Blocks the GUI. */
+  void fetchRows(int rowCount);
+
+  /* Cancel queries, close worker connection and remove all rows */
+  void clear();
+
+  /* true if a page is currently loaded in background */
+  bool isFetching() const
+  {
+    return fetching;
+  }
+
+  atools::sql::SqlDatabase *getDatabase() const
+  {
+    return db;
+  }
+
+  /* Attach a database to the GUI connection and the worker connection. Throws exception on error. */
+  void attachDatabase(const QString& name, const QString& file);
+  void detachDatabase(const QString& name);
 
   /* Get unformatted data from the model */
   QVariant getRawData(int row, int col) const;
@@ -125,8 +161,15 @@ public:
   /* Set query to model causing a refresh. Unless force is set the query is compared to the current query and skipped if equal */
   void resetSqlQuery(bool force);
 
-  /* Set a filter for objects within the given bounding rectangle */
-  void filterByBoundingRect(const atools::geo::Rect& boundingRectangle);
+  /*
+   * Set a filter for objects within the given distance ring and direction sector around center.
+   * Distance and heading are calculated in the query which also allows sorting by these columns.
+   * Ends distance search if center is not valid.
+   * @param minDistanceNm minimum distance to center point in nautical miles
+   * @param maxDistanceNm maximum distance to center point in nautical miles
+   */
+  void filterByDistance(const atools::geo::Pos& center, sqlmodeltypes::SearchDirection dir, float minDistanceNm,
+                        float maxDistanceNm);
 
   QString getColumnName(int col) const;
 
@@ -162,7 +205,7 @@ public:
     return overrideModeActive;
   }
 
-  /* Update model after data change */
+  /* Update model after data change. Rows are loaded in background. */
   void refreshData(bool force);
 
   void setQueryBuilder(const QueryBuilder& builder)
@@ -195,9 +238,6 @@ signals:
   void overrideMode(const QStringList& overrideColumnTitles);
 
 private:
-  // Hide the record method
-  using QSqlQueryModel::record;
-
   struct WhereCondition
   {
     QString oper; /* operator (like, not like) */
@@ -210,6 +250,9 @@ private:
 
   void filterBy(bool exclude, QString whereCol, QVariant whereValue, bool forceQueryBuilder, bool ignoreQueryBuilder, bool exact);
   QString buildColumnList(const atools::sql::SqlRecord& tableCols);
+  QString buildDistanceTable(const QString& tablename) const;
+  QString buildDistanceWhere() const;
+  atools::geo::Pos buildPos(int row) const;
   QString buildWhere(const atools::sql::SqlRecord& tableCols, QVector<const Column *>& overridingColumns);
   QString buildWhereValue(const WhereCondition& cond);
   void buildQuery(const QWidget *widgetFromBuilder = nullptr);
@@ -220,7 +263,11 @@ private:
   QString  sortOrderToSql(Qt::SortOrder order);
   QVariant defaultDataHandler(int, int, const Column *, const QVariant&,
                               const QVariant& displayRoleValue, Qt::ItemDataRole role) const;
-  void updateTotalCount();
+  /* Start loading rows in worker thread. Count query is run too if count is true. */
+  void startFetch(int offset, int limit, bool count);
+
+  /* Called by watcher when a page was loaded or directly after waiting for the future */
+  void pageFetched();
   void buildSqlWhereValue(QVariant& whereValue, bool exact) const;
   void buildSqlWhereValue(QString& whereValue, bool exact) const;
   bool isDistanceSearchActive() const;
@@ -233,14 +280,31 @@ private:
 
   QString currentSqlQuery, currentSqlCountQuery, currentSqlFetchQuery;
 
+  /* Queries currently set in the model and loaded by the worker */
+  QString executedSqlQuery, executedSqlCountQuery;
+
+  /* Loaded rows and field information of the executed query */
+  QVector<QVector<QVariant> > rows;
+  QSqlRecord queryRecord;
+  QHash<int, QVariant> headerTexts;
+
+  SqlQueryWorker *worker;
+  QFutureWatcher<SqlQueryPage> watcher;
+  bool fetching = false;
+
   /* Data callback */
   sqlmodeltypes::DataFunctionType dataFunction = nullptr;
   /* Roles for the data callback */
   QSet<Qt::ItemDataRole> handlerRoles;
 
-  /* A bounding rectangle query is used if this is valid */
+  /* A bounding rectangle query is used as first index based stage if this is valid */
   atools::geo::Rect boundingRect;
 
+  /* Distance search parameters for the second stage. Ring as haversine of the central angle. */
+  atools::geo::Pos distanceCenter;
+  sqlmodeltypes::SearchDirection distanceDirection = sqlmodeltypes::ALL;
+  double minDistanceHav = 0., maxDistanceHav = 0.;
+
   QueryBuilder queryBuilder;
 
   /* Maps column name to where condition struct */
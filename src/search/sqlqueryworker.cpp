@@ -0,0 +1,273 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "search/sqlqueryworker.h"
+
+#include "db/dbtools.h"
+#include "exception.h"
+#include "sql/sqldatabase.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::sql::SqlDatabase;
+
+SqlQueryWorker::SqlQueryWorker(const QString& connectionNameParam)
+  : connectionName(connectionNameParam), generation(0)
+{
+  // Queries of one search have to run one after the other. Keep thread alive to avoid restarting it.
+  threadPool.setMaxThreadCount(1);
+  threadPool.setExpiryTimeout(-1);
+}
+
+SqlQueryWorker::~SqlQueryWorker()
+{
+  close();
+}
+
+void SqlQueryWorker::open(const QString& file, bool readonly)
+{
+  databaseFile = file;
+  databaseReadonly = readonly;
+}
+
+void SqlQueryWorker::close()
+{
+  // Let queued tasks return and close connection in the worker thread after these
+  cancel();
+  QtConcurrent::run(&threadPool, [this]() {
+    closeDatabase();
+  }).waitForFinished();
+}
+
+QSqlError SqlQueryWorker::openDatabase(const QString& file)
+{
+  if(db != nullptr && db->isOpen() && db->databaseName() == file)
+    return QSqlError();
+
+  closeDatabase();
+
+  if(file.isEmpty())
+    return QSqlError(QObject::tr("No database file for search."), QString(), QSqlError::ConnectionError);
+
+  try
+  {
+    SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, connectionName);
+    db = new SqlDatabase(connectionName);
+    db->setReadonly();
+    dbtools::openDatabaseFileExt(db, file, true /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open search connection" << connectionName << e.what();
+    closeDatabase();
+    return QSqlError(QObject::tr("Cannot open database \"%1\" for search.").arg(file),
+                     QString::fromUtf8(e.what()), QSqlError::ConnectionError);
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open search connection" << connectionName;
+    closeDatabase();
+    return QSqlError(QObject::tr("Cannot open database \"%1\" for search.").arg(file),
+                     QString(), QSqlError::ConnectionError);
+  }
+  return QSqlError();
+}
+
+void SqlQueryWorker::finishPagedQuery()
+{
+  delete pagedQuery;
+  pagedQuery = nullptr;
+  pagedQueryText.clear();
+  pagedQueryOffset = 0;
+}
+
+void SqlQueryWorker::closeDatabase()
+{
+  // Statement has to be finished before the connection is closed
+  finishPagedQuery();
+
+  if(db != nullptr)
+  {
+    dbtools::closeDatabaseFile(db);
+    delete db;
+    db = nullptr;
+    SqlDatabase::removeDatabase(connectionName);
+  }
+  workerAttachedDatabases.clear();
+}
+
+void SqlQueryWorker::setAttachedDatabase(const QString& name, const QString& file)
+{
+  if(file.isEmpty())
+    attachedDatabases.remove(name);
+  else
+    attachedDatabases.insert(name, file);
+}
+
+void SqlQueryWorker::cancel()
+{
+  generation++;
+}
+
+QFuture<SqlQueryPage> SqlQueryWorker::fetch(const QString& query, const QString& countQuery, int offset, int limit)
+{
+  quint32 taskGeneration = generation.load();
+  QString file = databaseFile;
+  bool keepOpen = databaseReadonly;
+  QMap<QString, QString> attach = attachedDatabases;
+
+  return QtConcurrent::run(&threadPool, [ = ]() -> SqlQueryPage {
+    return fetchPage(taskGeneration, file, keepOpen, attach, query, countQuery, offset, limit);
+  });
+}
+
+void SqlQueryWorker::updateAttached(const QMap<QString, QString>& attach)
+{
+  QSqlDatabase sqlDb = db->getQSqlDatabase();
+
+  // Detach removed or changed databases first
+  for(auto it = workerAttachedDatabases.begin(); it != workerAttachedDatabases.end();)
+  {
+    if(attach.value(it.key()) != it.value())
+    {
+      QSqlQuery query(sqlDb);
+      if(!query.exec("detach database " % it.key()))
+        qWarning() << Q_FUNC_INFO << "Detach failed" << it.key() << query.lastError().text();
+      it = workerAttachedDatabases.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  for(auto it = attach.constBegin(); it != attach.constEnd(); ++it)
+  {
+    if(!workerAttachedDatabases.contains(it.key()))
+    {
+      QSqlQuery query(sqlDb);
+      if(query.exec("attach database '" % QString(it.value()).replace('\'', "''") % "' as " % it.key()))
+        workerAttachedDatabases.insert(it.key(), it.value());
+      else
+        qWarning() << Q_FUNC_INFO << "Attach failed" << it.value() << query.lastError().text();
+    }
+  }
+}
+
+SqlQueryPage SqlQueryWorker::fetchPage(quint32 taskGeneration, const QString& file, bool keepOpen,
+                                       const QMap<QString, QString>& attach, const QString& query,
+                                       const QString& countQuery, int offset, int limit)
+{
+  SqlQueryPage page;
+  page.offset = offset;
+
+  if(isCancelled(taskGeneration))
+  {
+    page.cancelled = true;
+    return page;
+  }
+
+  // Continue with the statement of the last page if this is the following page of the same query
+  bool continueQuery = keepOpen && pagedQuery != nullptr && pagedQueryGeneration == taskGeneration &&
+                       pagedQueryText == query && pagedQueryOffset == offset &&
+                       db != nullptr && db->databaseName() == file && workerAttachedDatabases == attach;
+  if(!continueQuery)
+    // Finish before attaching and detaching which fails with running statements
+    finishPagedQuery();
+
+  // Connection has to be created in this thread
+  page.error = openDatabase(file);
+  if(page.error.isValid())
+    return page;
+
+  updateAttached(attach);
+  QSqlDatabase sqlDb = db->getQSqlDatabase();
+
+  if(!countQuery.isEmpty())
+  {
+    QSqlQuery count(sqlDb);
+    count.setForwardOnly(true);
+    if(!count.exec(countQuery))
+    {
+      page.error = count.lastError();
+      return page;
+    }
+
+    if(count.next())
+      page.totalRowCount = count.value(0).toInt();
+  }
+
+  if(isCancelled(taskGeneration))
+  {
+    page.cancelled = true;
+    return page;
+  }
+
+  if(!continueQuery)
+  {
+    pagedQuery = new QSqlQuery(sqlDb);
+    pagedQuery->setForwardOnly(true);
+
+    // Limit -1 means no limit in SQLite - read all rows of an open statement page by page
+    int sqlLimit = keepOpen ? -1 : limit;
+    if(!pagedQuery->exec(query % " limit " % QString::number(sqlLimit) % " offset " % QString::number(offset)))
+    {
+      page.error = pagedQuery->lastError();
+      finishPagedQuery();
+      return page;
+    }
+    pagedQueryText = query;
+    pagedQueryGeneration = taskGeneration;
+  }
+
+  int numColumns = pagedQuery->record().count();
+
+  bool atEnd = false;
+  while(limit < 0 || page.rows.size() < limit)
+  {
+    if(!pagedQuery->next())
+    {
+      atEnd = true;
+      break;
+    }
+
+    // Stop reading rows if a new query was started meanwhile
+    if(isCancelled(taskGeneration))
+    {
+      finishPagedQuery();
+      page.cancelled = true;
+      return page;
+    }
+
+    QVector<QVariant> row(numColumns);
+    for(int i = 0; i < numColumns; i++)
+      row[i] = pagedQuery->value(i);
+    page.rows.append(row);
+  }
+
+  page.atEnd = atEnd;
+  if(atEnd || !keepOpen)
+    // Statements of writable databases are finished after each page to avoid blocking writers
+    finishPagedQuery();
+  else
+    pagedQueryOffset = offset + page.rows.size();
+
+  return page;
+}
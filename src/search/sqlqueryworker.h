@@ -0,0 +1,136 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_SQLQUERYWORKER_H
+#define LNM_SQLQUERYWORKER_H
+
+#include <QFuture>
+#include <QMap>
+#include <QSqlError>
+#include <QThreadPool>
+#include <QVariant>
+#include <QVector>
+
+#include <atomic>
+
+class QSqlQuery;
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+/* Rows of a query passed from the worker thread to the model */
+struct SqlQueryPage
+{
+  QVector<QVector<QVariant> > rows;
+  int offset = 0; /* Row number of the first row in the result */
+  int totalRowCount = -1; /* Result of count query or -1 if not requested */
+  bool cancelled = false, /* Superseded by a newer query. Rows are incomplete. */
+       atEnd = false; /* Last row of result was read */
+  QSqlError error;
+};
+
+/*
+ * Runs search queries in a background thread using an own read only connection to the database file
+ * of a search. Tasks are executed one after the other in a pool having a single thread.
+ *
+ * Rows are fetched in pages. The statement is kept open between pages for read only databases like the
+ * simulator and navigation databases and the next page continues reading from it. For the writable userpoint,
+ * logbook and online databases statements are finished after each page using limit and offset to avoid
+ * blocking writers by open read transactions.
+ *
+ * Running and queued tasks are cancelled by cancel(). Queued tasks return immediately and a running task
+ * stops reading rows. A running SQLite statement cannot be interrupted before it delivers its first row.
+ *
+ * The connection is opened lazily by the first task and closed by a final task since it can only be used
+ * in the thread which created it. The pool thread is kept alive in between.
+ */
+class SqlQueryWorker
+{
+public:
+  explicit SqlQueryWorker(const QString& connectionNameParam);
+  ~SqlQueryWorker();
+
+  SqlQueryWorker(const SqlQueryWorker& other) = delete;
+  SqlQueryWorker& operator=(const SqlQueryWorker& other) = delete;
+
+  /* Set database file for the following tasks. Connection is opened, or closed and reopened if the file
+   * differs, in the worker thread by the next task. Statements are kept open between pages if readonly is true. */
+  void open(const QString& file, bool readonly);
+
+  /* Cancel all tasks and close connection in the worker thread. Waits until done. */
+  void close();
+
+  /* Attach a database file or detach if file is empty. Applied in the worker thread before the next task. */
+  void setAttachedDatabase(const QString& name, const QString& file);
+
+  /* Cancel all queued and running tasks. Results of these are flagged as cancelled. */
+  void cancel();
+
+  /* Fetch limit rows (all if -1) of query starting at offset and count all rows if countQuery is not empty */
+  QFuture<SqlQueryPage> fetch(const QString& query, const QString& countQuery, int offset, int limit);
+
+private:
+  /* Runs in worker thread */
+  SqlQueryPage fetchPage(quint32 taskGeneration, const QString& file, bool keepOpen,
+                         const QMap<QString, QString>& attach, const QString& query, const QString& countQuery,
+                         int offset, int limit);
+  void updateAttached(const QMap<QString, QString>& attach);
+
+  /* Open connection to file in worker thread if not already done. Closes and reopens if file differs.
+   * Returns an invalid error on success. */
+  QSqlError openDatabase(const QString& file);
+  void closeDatabase();
+
+  /* Finish statement kept open from the last page */
+  void finishPagedQuery();
+
+  bool isCancelled(quint32 taskGeneration) const
+  {
+    return generation.load() != taskGeneration;
+  }
+
+  QString connectionName;
+  QThreadPool threadPool;
+
+  /* Database file as requested in GUI thread */
+  QString databaseFile;
+  bool databaseReadonly = false;
+
+  /* Connection created and used by tasks only */
+  atools::sql::SqlDatabase *db = nullptr;
+
+  /* Incremented on cancel. Tasks having a different value are cancelled. */
+  std::atomic<quint32> generation;
+
+  /* Attached databases as requested in GUI thread. Name to file. */
+  QMap<QString, QString> attachedDatabases;
+
+  /* Databases currently attached to the connection. Only accessed by tasks. */
+  QMap<QString, QString> workerAttachedDatabases;
+
+  /* Statement kept open after reading a page from a read only database. Only accessed by tasks. */
+  QSqlQuery *pagedQuery = nullptr;
+  QString pagedQueryText;
+  int pagedQueryOffset = 0; /* Row number of the next row to read */
+  quint32 pagedQueryGeneration = 0;
+};
+
+#endif // LNM_SQLQUERYWORKER_H
@@ -0,0 +1,268 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "search/textsearchindex.h"
+
+#include "app/navapp.h"
+#include "common/constants.h"
+#include "db/databasemanager.h"
+#include "db/dbtools.h"
+#include "exception.h"
+#include "search/sqlmodel.h"
+#include "settings/settings.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlrecord.h"
+#include "sql/sqltransaction.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+
+/* Increment to force rebuilding of existing index files */
+static const int TEXT_INDEX_VERSION = 1;
+
+/* Trigram index needs at least three consecutive characters to be used */
+static const int MIN_TRIGRAM_LENGTH = 3;
+
+/* Builds index if source key differs and returns indexed columns or empty list on error. */
+static QStringList buildTextIndexTable(SqlDatabase *indexDb, const QString& sourceFile, const QString& sourceKey,
+                                       const QString& table, const QString& idColumn, const QStringList& columns)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  const QString indexTable = table % "_text";
+  const QString columnList = columns.join(", ");
+
+  try
+  {
+    SqlQuery(indexDb).exec("create table if not exists text_index_metadata (source_key varchar(1024) not null)");
+
+    SqlQuery query(indexDb);
+    query.exec("select source_key from text_index_metadata");
+    bool current = query.next() && query.valueStr("source_key") == sourceKey;
+    query.finish();
+
+    if(current)
+    {
+      qDebug() << Q_FUNC_INFO << indexTable << "is up to date";
+      return columns;
+    }
+
+    // Cannot attach within a transaction
+    SqlQuery(indexDb).exec("attach database '" % QString(sourceFile).replace('\'', "''") % "' as src");
+
+    atools::sql::SqlTransaction transaction(indexDb);
+    SqlQuery(indexDb).exec("drop table if exists " % indexTable);
+    SqlQuery(indexDb).exec("delete from text_index_metadata");
+
+    // Throws an exception if FTS5 or the trigram tokenizer (SQLite 3.34 and later) is not available
+    SqlQuery(indexDb).exec("create virtual table " % indexTable % " using fts5(" % columnList % ", tokenize = 'trigram')");
+    SqlQuery(indexDb).exec("insert into " % indexTable % " (rowid, " % columnList % ") select " % idColumn % ", " %
+                           columnList % " from src." % table);
+
+    SqlQuery insert(indexDb);
+    insert.prepare("insert into text_index_metadata (source_key) values(:key)");
+    insert.bindValue(":key", sourceKey);
+    insert.exec();
+    transaction.commit();
+
+    SqlQuery(indexDb).exec("detach database src");
+
+    qDebug() << Q_FUNC_INFO << indexTable << "built in" << timer.elapsed() << "ms";
+    return columns;
+  }
+  catch(std::exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot build text search index" << indexTable << e.what();
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot build text search index" << indexTable;
+  }
+  return QStringList();
+}
+
+/* Runs in background thread. Opens an own writeable connection to the index file which is closed and removed
+ * in the same thread. Returns indexed columns or empty list on error. */
+static QStringList buildTextIndex(const QString& connectionName, const QString& indexFile, const QString& sourceFile,
+                                  const QString& sourceKey, const QString& table, const QString& idColumn,
+                                  const QStringList& columns)
+{
+  QStringList result;
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, connectionName);
+
+  {
+    SqlDatabase indexDb(connectionName);
+    try
+    {
+      dbtools::openDatabaseFileExt(&indexDb, indexFile, false /* readonly */, false /* createSchema */,
+                                   false /* exclusive */, false /* auto transactions */);
+      result = buildTextIndexTable(&indexDb, sourceFile, sourceKey, table, idColumn, columns);
+    }
+    catch(std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot open text search index" << indexFile << e.what();
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot open text search index" << indexFile;
+    }
+    dbtools::closeDatabaseFile(&indexDb);
+  }
+
+  SqlDatabase::removeDatabase(connectionName);
+  return result;
+}
+
+TextSearchIndex::TextSearchIndex(QObject *parent, SqlModel *sqlModel, const QString& tablename,
+                                 const QString& idColumnName, const QStringList& textColumns)
+  : QObject(parent), model(sqlModel), db(sqlModel->getDatabase()), table(tablename), idColumn(idColumnName), columns(textColumns)
+{
+  enabled = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_SEARCH_TEXT_INDEX, true).toBool();
+
+  indexFile = NavApp::getDatabaseManager()->getDatabaseDirectory() % QDir::separator() % lnm::DATABASE_PREFIX %
+              "textindex_" % table % lnm::DATABASE_SUFFIX;
+  attachName = "lnm_text_" % table;
+  columns.removeDuplicates();
+
+  connect(&watcher, &QFutureWatcher<QStringList>::finished, this, &TextSearchIndex::buildFinished);
+
+  qDebug() << Q_FUNC_INFO << "enabled" << enabled << indexFile;
+}
+
+TextSearchIndex::~TextSearchIndex()
+{
+  watcher.waitForFinished();
+}
+
+void TextSearchIndex::build()
+{
+  if(!enabled || building || attached || db == nullptr || !db->isOpen())
+    return;
+
+  // Index only columns existing in the current database
+  const atools::sql::SqlRecord record = db->record(table);
+  if(!record.contains(idColumn))
+    return;
+
+  QStringList cols;
+  for(const QString& col : qAsConst(columns))
+  {
+    if(record.contains(col))
+      cols.append(col);
+  }
+
+  if(cols.isEmpty())
+    return;
+
+  // Rebuild if any of these change
+  QFileInfo sourceInfo(db->databaseName());
+  QString sourceKey = QString("%1;%2;%3;%4;%5").arg(sourceInfo.canonicalFilePath()).arg(sourceInfo.size()).
+                      arg(sourceInfo.lastModified().toMSecsSinceEpoch()).arg(cols.join(',')).arg(TEXT_INDEX_VERSION);
+
+  // Connection to the index file is opened and closed in the thread
+  building = true;
+  QString connectionName = dbtools::DATABASE_NAME_TEXT_INDEX + table, file = indexFile, sourceFile = db->databaseName(),
+          tableName = table, idCol = idColumn;
+  watcher.setFuture(QtConcurrent::run([connectionName, file, sourceFile, sourceKey, tableName, idCol, cols]() -> QStringList {
+    return buildTextIndex(connectionName, file, sourceFile, sourceKey, tableName, idCol, cols);
+  }));
+}
+
+void TextSearchIndex::buildFinished()
+{
+  if(!building)
+    return;
+
+  building = false;
+
+  QStringList result = watcher.result();
+  if(result.isEmpty() || db == nullptr || !db->isOpen())
+    return;
+
+  try
+  {
+    // Attached read only like the search database connections
+    model->attachDatabase(attachName, indexFile);
+    indexedColumns = result;
+    attached = true;
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot attach text search index" << e.what();
+  }
+}
+
+void TextSearchIndex::clear()
+{
+  // Drop result
+  building = false;
+  watcher.waitForFinished();
+
+  if(attached && db != nullptr && db->isOpen())
+  {
+    try
+    {
+      model->detachDatabase(attachName);
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot detach text search index" << e.what();
+    }
+  }
+
+  attached = false;
+  indexedColumns.clear();
+}
+
+QString TextSearchIndex::buildWhere(const QStringList& textColumns, const QString& pattern) const
+{
+  if(!attached || textColumns.isEmpty())
+    return QString();
+
+  // Check for three characters without placeholders
+  int length = 0, maxLength = 0;
+  for(QChar c : pattern)
+  {
+    length = c == '%' || c == '_' ? 0 : length + 1;
+    maxLength = std::max(maxLength, length);
+  }
+
+  if(maxLength < MIN_TRIGRAM_LENGTH)
+    return QString();
+
+  // Union allows to use the index for each column
+  QStringList queries;
+  for(const QString& col : textColumns)
+  {
+    if(!indexedColumns.contains(col))
+      return QString();
+
+    queries.append("select rowid from " % attachName % '.' % table % "_text where " % col % " like '" % pattern % '\'');
+  }
+
+  return idColumn % " in (" % queries.join(" union ") % ')';
+}
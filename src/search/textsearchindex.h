@@ -0,0 +1,90 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_TEXTSEARCHINDEX_H
+#define LNM_TEXTSEARCHINDEX_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QStringList>
+
+namespace atools {
+namespace sql {
+class SqlDatabase;
+}
+}
+
+class SqlModel;
+
+/*
+ * FTS5 full text index using the trigram tokenizer for the text columns of a search table.
+ * Allows to use an index for "like '%TEXT%'" queries where the leading wildcard defeats normal indexes.
+ *
+ * The index is built in a background thread into a separate database file after loading a database.
+ * It is rebuilt only if the source database file changes. The file is attached read only
+ * to the database connections of the search model and is used in a subquery.
+ *
+ * Searches fall back to plain "like" queries while the index is built or if the SQLite library does not
+ * support FTS5 with the trigram tokenizer.
+ */
+class TextSearchIndex :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  /*
+   * @param sqlModel model of the search. Index is attached to its connections.
+   * @param tablename table to index like "airport"
+   * @param idColumnName primary key of the table which is used as rowid in the index
+   * @param textColumns columns to add to the index. Columns not existing in the table are ignored.
+   */
+  explicit TextSearchIndex(QObject *parent, SqlModel *sqlModel, const QString& tablename,
+                           const QString& idColumnName, const QStringList& textColumns);
+  virtual ~TextSearchIndex() override;
+
+  TextSearchIndex(const TextSearchIndex& other) = delete;
+  TextSearchIndex& operator=(const TextSearchIndex& other) = delete;
+
+  /* Update index in background if needed and attach it when done. Call after opening the database. */
+  void build();
+
+  /* Wait for background thread and detach index. Call before closing the database. */
+  void clear();
+
+  /* Get a condition like "airport_id in (select ...)" for an escaped "like" pattern on all given columns
+   * combined with "or". Returns an empty string if the index is not available, does not contain all
+   * columns or if the pattern has no three consecutive characters which are needed for the trigram index. */
+  QString buildWhere(const QStringList& textColumns, const QString& pattern) const;
+
+private:
+  /* Called by watcher in the GUI thread. Attaches the index. */
+  void buildFinished();
+
+  SqlModel *model;
+  atools::sql::SqlDatabase *db;
+  QString table, idColumn, indexFile, attachName;
+  QStringList columns, indexedColumns;
+
+  /* Result contains the indexed columns or is empty if building failed */
+  QFutureWatcher<QStringList> watcher;
+
+  bool enabled = true, building = false, attached = false;
+};
+
+#endif // LNM_TEXTSEARCHINDEX_H
@@ -26,6 +26,7 @@
 #include "info/infocontroller.h"
 #include "route/routecontroller.h"
 #include "web/webmapcontroller.h"
+#include "web/webmapcache.h"
 #include "webapi/webapicontroller.h"
 #include "web/webtools.h"
 #include "web/webapp.h"
@@ -38,6 +39,7 @@
 
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QHostAddress>
 #include <QDir>
 #include <QUrl>
 #include <QPainter>
@@ -47,7 +49,8 @@ using namespace stefanfrings;
 
 RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapController,WebApiController *webApiController,
                                HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam)
-  : HttpRequestHandler(parent), webApiController(webApiController), htmlInfoBuilder(htmlInfoBuilderParam), verbose(verboseParam)
+  : HttpRequestHandler(parent), webApiController(webApiController), htmlInfoBuilder(htmlInfoBuilderParam),
+  mapCache(webMapController->getMapCache()), verbose(verboseParam)
 {
   if(verbose)
     qDebug() << Q_FUNC_INFO;
@@ -196,7 +199,10 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
   int width = params.asInt(QStringLiteral(u"width"), 0);
   int height = params.asInt(QStringLiteral(u"height"), 0);
 
-  MapPixmap mapPixmap;
+  // Used to select a map widget from the pool
+  QString clientId = request.getPeerAddress().toString();
+
+  MapImage mapImage;
 
   if(params.has("session"))
   {
@@ -220,21 +226,32 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
 
     QString mapcmd = params.asStr(QStringLiteral(u"mapcmd"), QLatin1String(""));
 
+    // A plain reload at the session position is cacheable since it does not change the session
+    QString cacheKey;
+    if(mapcmd.isEmpty() && !params.has(QStringLiteral(u"distance")) && session.contains("lon") && session.contains("lat"))
+      cacheKey = mapImageCacheKey(QStringLiteral(u"session=%1,%2,%3&").
+                                  arg(session.get("lon").toFloat()).arg(session.get("lat").toFloat()).arg(requestedDistanceKm) +
+                                  params.toKey({QStringLiteral(u"session"), QStringLiteral(u"reload"), QStringLiteral(u"cmd")}));
+
+    if(!cacheKey.isEmpty() && getCachedMapImage(cacheKey, mapImage))
+      return writeMapImage(request, response, width, height, mapImage);
+
+    MapPixmap mapPixmap;
     if(mapcmd == QLatin1String("user"))
       // Show user aircraft
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      mapPixmap = emit getPixmapObject(clientId, width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
     else if(mapcmd == QLatin1String("route"))
       // Center flight plan
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      mapPixmap = emit getPixmapObject(clientId, width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
     else if(mapcmd == QLatin1String("airport"))
       // Show an airport by ident
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr(
+      mapPixmap = emit getPixmapObject(clientId, width, height, web::AIRPORT, params.asStr(
                                          QStringLiteral(u"airport")).toUpper(), requestedDistanceKm);
     else
     {
         // When zooming in or out use the last corrected distance (i.e. actual distance) as a base
         // Zoom or move map
-        mapPixmap = emit getPixmapPosDistance(width, height,
+        mapPixmap = emit getPixmapPosDistance(clientId, width, height,
                                               atools::geo::Pos(session.get("lon").toFloat(),
                                                                session.get("lat").toFloat()),
                                               (mapcmd == QLatin1String("in") || mapcmd == QLatin1String("out")) ?
@@ -249,59 +266,181 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
       session.set("lon", mapPixmap.pos.getLonX());
       session.set("lat", mapPixmap.pos.getLatY());
     }
-    else
-      return showErrorPixmap(response, width, height, 404, mapPixmap.error);
+
+    encodeMapImage(request, mapPixmap, mapImage);
+
+    if(!cacheKey.isEmpty())
+      insertCachedMapImage(cacheKey, mapImage);
   }
   else
-  {
-    // Distance as KM
-    float requestedDistanceKm = atools::geo::nmToKm(params.asFloat(QStringLiteral(u"distance"), 32.0f));     // set default as value which JS delivers as default on opening from default HTML value
-
-    // ============================================================================
     // Session-less / state-less calls ============================================
-    if(params.has(QStringLiteral(u"user")))
-      // User aircraft =======================
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"route")))
-      // Center flight plan =======================
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"airport")))
-      // Show airport =======================
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr("airport"), requestedDistanceKm);
-    else if(params.has(QStringLiteral(u"leftlon")) && params.has(QStringLiteral(u"toplat")) && params.has(QStringLiteral(u"rightlon")) && params.has(QStringLiteral(u"bottomlat")))
-    {
-      // Show rectangle =======================
-      atools::geo::Rect rect(params.asFloat(QStringLiteral(u"leftlon")), params.asFloat(QStringLiteral(u"toplat")),
-                             params.asFloat(QStringLiteral(u"rightlon")), params.asFloat(QStringLiteral(u"bottomlat")));
-      mapPixmap = emit getPixmapRect(width, height, rect);
-    }
-    else if(params.has(QStringLiteral(u"distance")) || (params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat"))))
+    fetchMapImageStateless(request, mapImage);
+
+  writeMapImage(request, response, width, height, mapImage);
+}
+
+void RequestHandler::writeMapImage(const HttpRequest& request, HttpResponse& response, int width, int height,
+                                   const MapImage& mapImage)
+{
+  if(mapImage.error.isEmpty())
+  {
+    if(!mapImage.eTag.isEmpty())
     {
-      // Show position =======================
-      atools::geo::Pos pos;
-      if(params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat")))
+      // Client has to revalidate each time but can use its copy if the tag matches
+      response.setHeader("ETag", mapImage.eTag);
+      response.setHeader("Cache-Control", "no-cache");
+
+      if(request.getHeader("If-None-Match") == mapImage.eTag)
       {
-        pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
-        pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
+        response.setStatus(304, "Not Modified");
+        response.write(QByteArray(), true);
+        return;
       }
+    }
+
+    response.setHeader("Content-Type", mapImage.contentType);
+    response.write(mapImage.bytes);
+  }
+  else
+    // Show error message as image
+    showErrorPixmap(response, width, height, 404, mapImage.error);
+}
+
+QString RequestHandler::mapImageCacheKey(const QString& key, bool currentView) const
+{
+  QString cacheKey = key + QStringLiteral(u"generation=") + QString::number(mapCache->getGeneration());
+  if(currentView)
+    cacheKey += QStringLiteral(u"&viewgeneration=") + QString::number(mapCache->getViewGeneration());
+  return cacheKey;
+}
+
+bool RequestHandler::getCachedMapImage(const QString& cacheKey, MapImage& mapImage) const
+{
+  if(mapCache->get(cacheKey, mapImage.bytes, mapImage.contentType))
+  {
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "Cache hit" << cacheKey;
+
+    mapImage.eTag = WebMapCache::eTag(cacheKey);
+    mapImage.error.clear();
+    return true;
+  }
+  return false;
+}
+
+void RequestHandler::insertCachedMapImage(const QString& cacheKey, MapImage& mapImage) const
+{
+  // Do not cache error messages
+  if(mapImage.error.isEmpty() && !mapImage.bytes.isEmpty())
+  {
+    mapCache->insert(cacheKey, mapImage.bytes, mapImage.contentType);
+    mapImage.eTag = WebMapCache::eTag(cacheKey);
+  }
+}
+
+void RequestHandler::fetchMapImageStateless(const HttpRequest& request, MapImage& mapImage)
+{
+  Parameter params(request, verbose);
+
+  // Request shows the current map view of the main window if no object, position or rectangle is given
+  // Distance without position is centered on the main window map and depends on the view too
+  bool hasRect = params.has(QStringLiteral(u"leftlon")) && params.has(QStringLiteral(u"toplat")) &&
+                 params.has(QStringLiteral(u"rightlon")) && params.has(QStringLiteral(u"bottomlat"));
+  bool hasPos = params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat"));
+  bool currentView = !params.has(QStringLiteral(u"user")) && !params.has(QStringLiteral(u"route")) &&
+                     !params.has(QStringLiteral(u"airport")) && !hasRect && !hasPos;
+
+  // Ignore random values used by clients to bypass browser caches
+  QString key = mapImageCacheKey(params.toKey({QStringLiteral(u"reload"), QStringLiteral(u"cmd")}), currentView);
+
+  // Image might be available from an earlier request with the same parameters and generation
+  if(getCachedMapImage(key, mapImage))
+    return;
 
-      mapPixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
+  QSharedPointer<MapImage> pending;
+  {
+    QMutexLocker locker(&pendingMapImagesMutex);
+    pending = pendingMapImages.value(key);
+
+    if(!pending.isNull())
+    {
+      // Same request is already running in another thread - wait for result
+      if(verbose)
+        qDebug() << Q_FUNC_INFO << "Waiting for" << key;
+
+      while(!pending->done)
+        pendingMapImagesCondition.wait(&pendingMapImagesMutex);
+      mapImage = *pending;
+      return;
+    }
+
+    pending = QSharedPointer<MapImage>(new MapImage);
+    pendingMapImages.insert(key, pending);
+  }
+
+  int width = params.asInt(QStringLiteral(u"width"), 0);
+  int height = params.asInt(QStringLiteral(u"height"), 0);
+  QString clientId = request.getPeerAddress().toString();
+
+  // Distance as KM
+  float requestedDistanceKm = atools::geo::nmToKm(params.asFloat(QStringLiteral(u"distance"), 32.0f));     // set default as value which JS delivers as default on opening from default HTML value
+
+  MapPixmap mapPixmap;
+  if(params.has(QStringLiteral(u"user")))
+    // User aircraft =======================
+    mapPixmap = emit getPixmapObject(clientId, width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+  else if(params.has(QStringLiteral(u"route")))
+    // Center flight plan =======================
+    mapPixmap = emit getPixmapObject(clientId, width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+  else if(params.has(QStringLiteral(u"airport")))
+    // Show airport =======================
+    mapPixmap = emit getPixmapObject(clientId, width, height, web::AIRPORT, params.asStr("airport"), requestedDistanceKm);
+  else if(hasRect)
+  {
+    // Show rectangle =======================
+    atools::geo::Rect rect(params.asFloat(QStringLiteral(u"leftlon")), params.asFloat(QStringLiteral(u"toplat")),
+                           params.asFloat(QStringLiteral(u"rightlon")), params.asFloat(QStringLiteral(u"bottomlat")));
+    mapPixmap = emit getPixmapRect(clientId, width, height, rect);
+  }
+  else if(hasPos)
+  {
+    // Show position =======================
+    atools::geo::Pos pos;
+    if(params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat")))
+    {
+      pos.setLonX(params.asFloat(QStringLiteral(u"lon")));
+      pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
     }
-    else
-      // Show current map view =======================
-      mapPixmap = emit getPixmap(width, height);
 
-    if(mapPixmap.hasError())
-      // Show error message as image
-      return showErrorPixmap(response, width, height, 404, mapPixmap.error);
+    mapPixmap = emit getPixmapPosDistance(clientId, width, height, pos, requestedDistanceKm, QLatin1String(""));
   }
+  else
+    // Show current map view =======================
+    mapPixmap = emit getPixmap(clientId, width, height);
+
+  // Encode outside of any lock
+  encodeMapImage(request, mapPixmap, mapImage);
+  insertCachedMapImage(key, mapImage);
+  mapImage.done = true;
+
+  // Publish result to waiting threads and remove from list of pending requests
+  QMutexLocker locker(&pendingMapImagesMutex);
+  *pending = mapImage;
+  pendingMapImages.remove(key);
+  pendingMapImagesCondition.wakeAll();
+}
 
-  if(mapPixmap.isValid())
+void RequestHandler::encodeMapImage(const HttpRequest& request, const MapPixmap& mapPixmap, MapImage& mapImage) const
+{
+  if(mapPixmap.hasError())
+    mapImage.error = mapPixmap.error;
+  else if(mapPixmap.isValid())
   {
+    Parameter params(request, verbose);
+
     // ===========================================================================
-    // Write pixmap as image
-    QByteArray bytes;
-    QBuffer buffer(&bytes);
+    // Write image
+    QBuffer buffer(&mapImage.bytes);
     buffer.open(QIODevice::WriteOnly);
 
     int quality = params.asInt(QStringLiteral(u"quality"), -1);
@@ -311,26 +450,22 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
 
     if(format == QLatin1String("jpg"))
     {
-      response.setHeader("Content-Type", "image/jpeg");
-      mapPixmap.pixmap.save(&buffer, "JPG", quality);
+      mapImage.contentType = "image/jpeg";
+      mapPixmap.image.save(&buffer, "JPG", quality);
     }
     else if(format == QLatin1String("png"))
     {
-      response.setHeader("Content-Type", "image/png");
-      mapPixmap.pixmap.save(&buffer, "PNG", quality);
+      mapImage.contentType = "image/png";
+      mapPixmap.image.save(&buffer, "PNG", quality);
     }
     else
       // Should never happen
       qWarning() << Q_FUNC_INFO << "invalid format";
-
-    response.write(bytes);
   }
   else
-    // Show error message as image
-    showErrorPixmap(response, width, height, 404, QStringLiteral(u"invalid pixmap"));
+    mapImage.error = QStringLiteral(u"invalid pixmap");
 }
 
-
 inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpResponse& response)
 {
   // Map API request
@@ -26,7 +26,10 @@
 #include "webapi/webapirequest.h"
 #include "webapi/webapiresponse.h"
 
+#include <QMutex>
 #include <QPixmap>
+#include <QSharedPointer>
+#include <QWaitCondition>
 
 #include "geo/pos.h"
 #include "geo/rect.h"
@@ -39,6 +42,7 @@ class HttpSession;
 }
 
 class HtmlInfoBuilder;
+class WebMapCache;
 
 /*
  * Handles all HTTP server requests including stateless and stateful. Maintains a session for the stateful page.
@@ -65,10 +69,13 @@ signals:
   /* Calls to the MapPaintWidget have to run in the main event queue and thread.
    * Therefore, it is necessary to use queued signals to separate
    * a thread from the HTTP server.*/
-  MapPixmap getPixmap(int width, int height);
-  MapPixmap getPixmapObject(int width, int height, web::ObjectType type, const QString& ident, float distanceKm);
-  MapPixmap getPixmapPosDistance(int width, int height, atools::geo::Pos pos, float distanceKm, const QString& mapCommand, const QString& errorCase = QLatin1String(""));
-  MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
+  MapPixmap getPixmap(const QString& clientId, int width, int height);
+  MapPixmap getPixmapObject(const QString& clientId, int width, int height, web::ObjectType type, const QString& ident,
+                            float distanceKm);
+  MapPixmap getPixmapPosDistance(const QString& clientId, int width, int height, atools::geo::Pos pos, float distanceKm,
+                                 const QString& mapCommand, const QString& errorCase = QLatin1String(""));
+  MapPixmap getPixmapRect(const QString& clientId, int width, int height, atools::geo::Rect rect,
+                          const QString& errorCase = tr("Invalid rectangle"));
 
   atools::fs::sc::SimConnectUserAircraft getUserAircraft();
   Route getRoute();
@@ -80,6 +87,14 @@ signals:
   WebApiResponse serviceWebApi(WebApiRequest& request);
 
 private:
+  /* Encoded map image or error message. Shared between all requests having the same parameters. */
+  struct MapImage
+  {
+    QByteArray bytes, contentType, eTag /* Empty if not cached */;
+    QString error;
+    bool done = false;
+  };
+
   /* fetch parameters as a string map from request */
   QHash<QString, QString> parameters(stefanfrings::HttpRequest& request) const;
 
@@ -93,6 +108,27 @@ private:
   /* Handle stateful and stateless map image requests. */
   void handleMapImage(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
+  /* Get map image for stateless requests. Concurrent requests with the same parameters wait for
+   * the first one and share its result instead of rendering again. */
+  void fetchMapImageStateless(const stefanfrings::HttpRequest& request, MapImage& mapImage);
+
+  /* Encode image in the calling server thread outside of the map widget lock */
+  void encodeMapImage(const stefanfrings::HttpRequest& request, const MapPixmap& mapPixmap, MapImage& mapImage) const;
+
+  /* Write image or error to response. Sends 304 if the client has a copy matching the ETag. */
+  void writeMapImage(const stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response, int width, int height,
+                     const MapImage& mapImage);
+
+  /* Append current data generation to key. Also appends the view generation if the image shows the current
+   * map view of the main window. */
+  QString mapImageCacheKey(const QString& key, bool currentView = false) const;
+
+  /* Get image from cache and set ETag. Returns false if not found. */
+  bool getCachedMapImage(const QString& cacheKey, MapImage& mapImage) const;
+
+  /* Add image to cache if it is not an error and set ETag */
+  void insertCachedMapImage(const QString& cacheKey, MapImage& mapImage) const;
+
   /* Handle stateful and stateless api requests. */
   void handleWebApiRequest(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
@@ -108,6 +144,14 @@ private:
   WebApiController *webApiController;
   HtmlInfoBuilder *htmlInfoBuilder;
 
+  /* Encoded images owned by WebMapController */
+  WebMapCache *mapCache;
+
+  /* Stateless image requests currently in progress keyed by parameters */
+  QHash<QString, QSharedPointer<MapImage> > pendingMapImages;
+  QMutex pendingMapImagesMutex;
+  QWaitCondition pendingMapImagesCondition;
+
   bool verbose = false;
 };
 
@@ -0,0 +1,72 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webmapcache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+
+WebMapCache::WebMapCache(int memoryLimitKb, bool verboseParam)
+  : generation(0), viewGeneration(0), verbose(verboseParam)
+{
+  // Cost is the size in kB
+  memoryCache.setMaxCost(std::max(memoryLimitKb, 0));
+
+  qDebug() << Q_FUNC_INFO << "memoryLimitKb" << memoryLimitKb;
+}
+
+WebMapCache::~WebMapCache()
+{
+  clear();
+}
+
+bool WebMapCache::get(const QString& key, QByteArray& bytes, QByteArray& contentType)
+{
+  QMutexLocker locker(&mutex);
+
+  const Entry *entry = memoryCache.object(key);
+  if(entry != nullptr)
+  {
+    bytes = entry->bytes;
+    contentType = entry->contentType;
+    return true;
+  }
+
+  return false;
+}
+
+void WebMapCache::insert(const QString& key, const QByteArray& bytes, const QByteArray& contentType)
+{
+  QMutexLocker locker(&mutex);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << key << "size" << bytes.size() << "total kB" << memoryCache.totalCost();
+
+  // Takes ownership and deletes entry if too big
+  memoryCache.insert(key, new Entry{bytes, contentType}, std::max(bytes.size() / 1024, 1));
+}
+
+void WebMapCache::clear()
+{
+  QMutexLocker locker(&mutex);
+  memoryCache.clear();
+}
+
+QByteArray WebMapCache::eTag(const QString& key)
+{
+  return '"' + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex() + '"';
+}
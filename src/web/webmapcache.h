@@ -0,0 +1,92 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBMAPCACHE_H
+#define LNM_WEBMAPCACHE_H
+
+#include <QCache>
+#include <QMutex>
+
+#include <atomic>
+
+/*
+ * Thread safe memory cache for encoded web map images with a bounded size.
+ *
+ * Keys have to contain all request parameters and the generations the request depends on.
+ * The data generation is incremented by WebMapController on any change which affects all map images like route,
+ * aircraft position, weather or database. The view generation is incremented if the visible map of the main
+ * window changes and is only used for requests of the current map view. Entries of older generations are never
+ * matched again and are dropped when the cache overflows.
+ */
+class WebMapCache
+{
+public:
+  /* Limit in kB */
+  WebMapCache(int memoryLimitKb, bool verboseParam);
+  ~WebMapCache();
+
+  WebMapCache(const WebMapCache& other) = delete;
+  WebMapCache& operator=(const WebMapCache& other) = delete;
+
+  /* Get encoded image and content type. Returns false if not found. */
+  bool get(const QString& key, QByteArray& bytes, QByteArray& contentType);
+
+  /* Add encoded image and content type */
+  void insert(const QString& key, const QByteArray& bytes, const QByteArray& contentType);
+
+  /* Remove all entries */
+  void clear();
+
+  /* Invalidate all entries by using a new generation in keys */
+  void incrementGeneration()
+  {
+    generation++;
+  }
+
+  quint64 getGeneration() const
+  {
+    return generation.load();
+  }
+
+  /* Invalidate entries showing the current map view of the main window */
+  void incrementViewGeneration()
+  {
+    viewGeneration++;
+  }
+
+  quint64 getViewGeneration() const
+  {
+    return viewGeneration.load();
+  }
+
+  /* Entity tag for HTTP header including quotes for the given key */
+  static QByteArray eTag(const QString& key);
+
+private:
+  struct Entry
+  {
+    QByteArray bytes, contentType;
+  };
+
+  QCache<QString, Entry> memoryCache;
+
+  QMutex mutex;
+  std::atomic<quint64> generation, viewGeneration;
+  bool verbose = false;
+};
+
+#endif // LNM_WEBMAPCACHE_H
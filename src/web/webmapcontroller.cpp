@@ -17,23 +17,38 @@
 
 #include "web/webmapcontroller.h"
 
+#include "web/webmapcache.h"
+#include "fs/sc/simconnectdata.h"
+
 #include "mapgui/mappaintwidget.h"
 #include "mapgui/mapwidget.h"
 #include "app/navapp.h"
+#include "common/constants.h"
+#include "settings/settings.h"
+#include "atools.h"
 
 #include <QDebug>
 #include <QPixmap>
 
+/* Limit for client to widget assignments before starting over */
+const static int MAX_CLIENT_ASSIGNMENTS = 256;
+
 WebMapController::WebMapController(QWidget *parent, bool verboseParam)
   : QObject(parent), parentWidget(parent), verbose(verboseParam)
 {
   qDebug() << Q_FUNC_INFO;
+
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  mapCache = new WebMapCache(settings.getAndStoreValue(lnm::OPTIONS_WEB_MAP_CACHE_MEMORY_KB, 32768).toInt(), verbose);
 }
 
 WebMapController::~WebMapController()
 {
   qDebug() << Q_FUNC_INFO;
   deInit();
+
+  delete mapCache;
+  mapCache = nullptr;
 }
 
 void WebMapController::init()
@@ -42,63 +57,98 @@ void WebMapController::init()
 
   deInit();
 
-  // Create a map widget clone with the desired resolution
-  mapPaintWidget = new MapPaintWidget(parentWidget, false /* no real widget - hidden */);
+  int poolSize = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_WEB_MAP_RENDER_POOL_SIZE, 2).toInt();
+  poolSize = std::min(std::max(poolSize, 1), 8);
+
+  qDebug() << Q_FUNC_INFO << "poolSize" << poolSize;
 
-  // Activate painting
-  mapPaintWidget->setActive();
+  for(int i = 0; i < poolSize; i++)
+  {
+    // Create a map widget clone with the desired resolution
+    MapPaintWidget *mapPaintWidget = new MapPaintWidget(parentWidget, false /* no real widget - hidden */);
+
+    // Activate painting
+    mapPaintWidget->setActive();
+    mapPaintWidgets.append(mapPaintWidget);
+  }
 }
 
 void WebMapController::deInit()
 {
   qDebug() << Q_FUNC_INFO;
 
-  delete mapPaintWidget;
-  mapPaintWidget = nullptr;
+  QMutexLocker locker(&mapPaintWidgetMutex);
+  qDeleteAll(mapPaintWidgets);
+  mapPaintWidgets.clear();
+  clientWidgetIndex.clear();
+  nextWidgetIndex = 0;
+}
+
+MapPaintWidget *WebMapController::widgetForClient(const QString& clientId)
+{
+  if(mapPaintWidgets.isEmpty())
+    return nullptr;
+
+  int index = clientWidgetIndex.value(clientId, -1);
+  if(index == -1 || index >= mapPaintWidgets.size())
+  {
+    if(clientWidgetIndex.size() > MAX_CLIENT_ASSIGNMENTS)
+      clientWidgetIndex.clear();
+
+    // Assign clients round robin to widgets
+    index = nextWidgetIndex;
+    nextWidgetIndex = (nextWidgetIndex + 1) % mapPaintWidgets.size();
+    clientWidgetIndex.insert(clientId, index);
+
+    if(verbose)
+      qDebug() << Q_FUNC_INFO << "client" << clientId << "widget" << index;
+  }
+
+  return mapPaintWidgets.at(index);
 }
 
-MapPixmap WebMapController::getPixmap(int width, int height)
+MapPixmap WebMapController::getPixmap(const QString& clientId, int width, int height)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << width << "x" << height;
+    qDebug() << Q_FUNC_INFO << clientId << width << "x" << height;
 
-  return getPixmapPosDistance(width, height, atools::geo::EMPTY_POS,
+  return getPixmapPosDistance(clientId, width, height, atools::geo::EMPTY_POS,
                               static_cast<float>(NavApp::getMapWidgetGui()->distance()), QLatin1String(""));
 }
 
-MapPixmap WebMapController::getPixmapObject(int width, int height, web::ObjectType type, const QString& ident,
-                                            float distanceKm)
+MapPixmap WebMapController::getPixmapObject(const QString& clientId, int width, int height, web::ObjectType type,
+                                            const QString& ident, float distanceKm)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << width << "x" << height << "type" << type << "ident" << ident << "distanceKm" <<
+    qDebug() << Q_FUNC_INFO << clientId << width << "x" << height << "type" << type << "ident" << ident << "distanceKm" <<
       distanceKm;
 
   MapPixmap mapPixmap;
   switch(type)
   {
     case web::USER_AIRCRAFT: {
-      mapPixmap = getPixmapPosDistance(width, height, NavApp::getUserAircraftPos(), distanceKm, QLatin1String(""), tr("No user aircraft"));
+      mapPixmap = getPixmapPosDistance(clientId, width, height, NavApp::getUserAircraftPos(), distanceKm, QLatin1String(""), tr("No user aircraft"));
       break;
     }
 
     case web::ROUTE: {
-      mapPixmap = getPixmapRect(width, height, NavApp::getRouteRect(), tr("No flight plan"));
+      mapPixmap = getPixmapRect(clientId, width, height, NavApp::getRouteRect(), tr("No flight plan"));
       break;
     }
 
     case web::AIRPORT: {
-      mapPixmap = getPixmapPosDistance(width, height, NavApp::getAirportPos(ident), distanceKm, QLatin1String(""), tr("Airport %1 not found").arg(ident));
+      mapPixmap = getPixmapPosDistance(clientId, width, height, NavApp::getAirportPos(ident), distanceKm, QLatin1String(""), tr("Airport %1 not found").arg(ident));
       break;
     }
   }
   return mapPixmap;
 }
 
-MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::geo::Pos pos, float distanceKm,
-                                                 const QString& mapCommand, const QString& errorCase)
+MapPixmap WebMapController::getPixmapPosDistance(const QString& clientId, int width, int height, atools::geo::Pos pos,
+                                                 float distanceKm, const QString& mapCommand, const QString& errorCase)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << width << "x" << height << pos << "distanceKm" << distanceKm << "cmd" << mapCommand;
+    qDebug() << Q_FUNC_INFO << clientId << width << "x" << height << pos << "distanceKm" << distanceKm << "cmd" << mapCommand;
 
   if(!pos.isValid())
   {
@@ -117,10 +167,10 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
     }
   }
 
+  QMutexLocker locker(&mapPaintWidgetMutex);
+  MapPaintWidget *mapPaintWidget = widgetForClient(clientId);
   if(mapPaintWidget != nullptr)
   {
-    QMutexLocker locker(&mapPaintWidgetMutex);
-
     // Copy all map settings
     mapPaintWidget->copySettings(*NavApp::getMapWidgetGui());
 
@@ -168,8 +218,8 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
       // What was requested
       mappixmap.requestedDistanceKm = distanceKm;
 
-    // Fill result object
-    mappixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+    // Fill result object - convert to image to allow encoding in the server thread
+    mappixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
     mappixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
     return mappixmap;
@@ -181,17 +231,18 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
   }
 }
 
-MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase)
+MapPixmap WebMapController::getPixmapRect(const QString& clientId, int width, int height, atools::geo::Rect rect,
+                                          const QString& errorCase)
 {
   if(verbose)
-    qDebug() << Q_FUNC_INFO << width << "x" << height << rect;
+    qDebug() << Q_FUNC_INFO << clientId << width << "x" << height << rect;
 
   if(rect.isValid())
   {
+    QMutexLocker locker(&mapPaintWidgetMutex);
+    MapPaintWidget *mapPaintWidget = widgetForClient(clientId);
     if(mapPaintWidget != nullptr)
     {
-      QMutexLocker locker(&mapPaintWidgetMutex);
-
       // Copy all map settings
       mapPaintWidget->copySettings(*NavApp::getMapWidgetGui());
 
@@ -204,7 +255,7 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
 
       // No distance requested. Therefore requested is equal to actual
       mapPixmap.correctedDistanceKm = mapPixmap.requestedDistanceKm = static_cast<float>(mapPaintWidget->distance());
-      mapPixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+      mapPixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
       mapPixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
       return mapPixmap;
@@ -226,17 +277,54 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
 
 MapPaintWidget *WebMapController::getMapPaintWidget() const
 {
-  return mapPaintWidget;
+  return mapPaintWidgets.isEmpty() ? nullptr : mapPaintWidgets.constFirst();
+}
+
+void WebMapController::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
+{
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = simulatorData.getUserAircraftConst();
+
+  // Simple sum of coordinates is sufficient to detect moving AI
+  double aiChecksum = 0.;
+  for(const atools::fs::sc::SimConnectAircraft& ai : simulatorData.getAiAircraftConst())
+    aiChecksum += static_cast<double>(ai.getPosition().getLonX()) + static_cast<double>(ai.getPosition().getLatY()) +
+                  static_cast<double>(ai.getHeadingDegTrue());
+
+  // Data packets continue to arrive while simulator is paused - increment only on changes
+  if(!userAircraft.getPosition().almostEqual(lastUserPos, atools::geo::Pos::POS_EPSILON_1M) ||
+     !atools::almostEqual(userAircraft.getHeadingDegTrue(), lastUserHeading) ||
+     !atools::almostEqual(aiChecksum, lastAiChecksum))
+  {
+    lastUserPos = userAircraft.getPosition();
+    lastUserHeading = userAircraft.getHeadingDegTrue();
+    lastAiChecksum = aiChecksum;
+    mapCache->incrementGeneration();
+  }
+}
+
+void WebMapController::mapChanged()
+{
+  mapCache->incrementGeneration();
+}
+
+void WebMapController::visibleMapChanged()
+{
+  // Only images of the current map view are affected
+  mapCache->incrementViewGeneration();
 }
 
 void WebMapController::preDatabaseLoad()
 {
-  if(mapPaintWidget != nullptr)
+  mapCache->incrementGeneration();
+
+  for(MapPaintWidget *mapPaintWidget : qAsConst(mapPaintWidgets))
     mapPaintWidget->preDatabaseLoad();
 }
 
 void WebMapController::postDatabaseLoad()
 {
-  if(mapPaintWidget != nullptr)
+  mapCache->incrementGeneration();
+
+  for(MapPaintWidget *mapPaintWidget : qAsConst(mapPaintWidgets))
     mapPaintWidget->postDatabaseLoad();
 }
@@ -22,18 +22,29 @@
 
 #include "geo/rect.h"
 
+#include <QHash>
+#include <QImage>
 #include <QMutex>
-#include <QPixmap>
+#include <QVector>
 
-class QPixmap;
 class MapPaintWidget;
+class WebMapCache;
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectData;
+}
+}
+}
 
 /*
  * Result of a map image creating also covering error messages, center position, zoom distance and shown rectangle.
+ * Uses a QImage which can be safely encoded outside of the main thread.
  */
 struct MapPixmap
 {
-  QPixmap pixmap;
+  QImage image;
   atools::geo::Pos pos; /* Map center */
   float requestedDistanceKm, /* Requested zoom distance */
         correctedDistanceKm; /* Actual zoom distance which can differ from above due to blur avoidance. */
@@ -53,27 +64,33 @@ struct MapPixmap
 
   bool isValid() const
   {
-    return !pixmap.isNull();
+    return !image.isNull();
   }
 
   bool isInvalid() const
   {
-    return pixmap.isNull();
+    return image.isNull();
   }
 
 };
 
 /*
- * Wraps the MapPaintWidget and provides methods to retreive map images.
+ * Wraps a pool of MapPaintWidgets and provides methods to retreive map images.
  *
- * The map widget has a state, i.e. it remains in the last shown position and zoom value.
+ * Each map widget has a state, i.e. it remains in the last shown position and zoom value.
  * Settings are copied from normal visible map window before rendering.
  *
+ * Clients are assigned to a widget of the pool by the client id. This keeps position and query caches
+ * of each widget close to the area a client is looking at. Pool size is given by the setting
+ * lnm::OPTIONS_WEB_MAP_RENDER_POOL_SIZE.
+ *
  * This has to run in the main thread and event queue. Therefore, it is necessary to use queued signals to separate
  * a thread from the HTTP server.
  *
  * All methods avoid a blurry map by zoomin out to the next best level. This can result in different distances
  * than expected.
+ *
+ * Also owns the cache for encoded images and increments its generation on all changes affecting the map.
  */
 class WebMapController :
   public QObject
@@ -91,32 +108,73 @@ public:
   void init();
   void deInit();
 
+  /* All methods below take a client id which is used to select the map widget from the pool. */
+
   /* Get pixmap with given width and height from current position. */
-  MapPixmap getPixmap(int width, int height);
+  MapPixmap getPixmap(const QString& clientId, int width, int height);
 
   /* Get pixmap with given width and height for a map object like an airport, the user aircraft or a route. */
-  MapPixmap getPixmapObject(int width, int height, web::ObjectType type, const QString& ident, float distanceKm);
+  MapPixmap getPixmapObject(const QString& clientId, int width, int height, web::ObjectType type, const QString& ident,
+                            float distanceKm);
 
   /* Get map at given position and distance. Command can be used to zoom in/out or scroll from the given position:
    * "in", "out", "left", "right", "up" and "down".  */
-  MapPixmap getPixmapPosDistance(int width, int height, atools::geo::Pos pos, float distanceKm, const QString& mapCommand, const QString& errorCase = QLatin1String(""));
+  MapPixmap getPixmapPosDistance(const QString& clientId, int width, int height, atools::geo::Pos pos, float distanceKm,
+                                 const QString& mapCommand, const QString& errorCase = QLatin1String(""));
 
   /* Zoom to rectangel on map. */
-  MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
+  MapPixmap getPixmapRect(const QString& clientId, int width, int height, atools::geo::Rect rect,
+                          const QString& errorCase = tr("Invalid rectangle"));
 
-  /* Get the map paint widget */
+  /* Get the first map paint widget of the pool */
   MapPaintWidget* getMapPaintWidget() const;
 
+  /* Get all map paint widgets of the pool */
+  const QVector<MapPaintWidget *>& getMapPaintWidgets() const
+  {
+    return mapPaintWidgets;
+  }
+
   /* Need to clear caches and tear down queries before switching database */
   void preDatabaseLoad();
 
   /* Initialize queries again after a database change */
   void postDatabaseLoad();
 
+  /* Thread safe cache for encoded images used by the request handler */
+  WebMapCache *getMapCache() const
+  {
+    return mapCache;
+  }
+
+  /* Invalidates cached images if user or AI aircraft moved */
+  void simDataChanged(const atools::fs::sc::SimConnectData& simulatorData);
+
+  /* Invalidates cached images. Called on route, weather, online network, options and map object changes. */
+  void mapChanged();
+
+  /* Invalidates cached images of the current map view only. Called when the main map is moved or zoomed. */
+  void visibleMapChanged();
+
 private:
-  MapPaintWidget *mapPaintWidget = nullptr;
+  /* Get widget assigned to client or assign the next one from the pool. Null if not initialized. */
+  MapPaintWidget *widgetForClient(const QString& clientId);
+
+  /* Pool of hidden map widgets */
+  QVector<MapPaintWidget *> mapPaintWidgets;
   QMutex mapPaintWidgetMutex;
 
+  /* Maps client id to index in mapPaintWidgets */
+  QHash<QString, int> clientWidgetIndex;
+  int nextWidgetIndex = 0;
+
+  WebMapCache *mapCache = nullptr;
+
+  /* Last aircraft values used to detect changes in simDataChanged() */
+  atools::geo::Pos lastUserPos;
+  float lastUserHeading = 0.f;
+  double lastAiChecksum = 0.;
+
   QWidget *parentWidget;
   bool verbose = false;
 };
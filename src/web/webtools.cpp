@@ -109,3 +109,16 @@ bool Parameter::has(const QString& key) const
 {
   return params.contains(key.toUtf8());
 }
+
+QString Parameter::toKey(const QStringList& ignoreKeys) const
+{
+  // QMultiMap is already sorted by key
+  QString key;
+  for(auto it = params.constBegin(); it != params.constEnd(); ++it)
+  {
+    QString name = QString::fromUtf8(it.key());
+    if(!ignoreKeys.contains(name))
+      key.append(name).append(QLatin1Char('=')).append(QString::fromUtf8(it.value())).append(QLatin1Char('&'));
+  }
+  return key;
+}
@@ -19,6 +19,7 @@
 #define LNM_WEBTOOLS_H
 
 #include <QMultiMap>
+#include <QStringList>
 
 namespace stefanfrings {
 class HttpRequest;
@@ -51,6 +52,9 @@ public:
   /* true if key is in the list */
   bool has(const QString& key) const;
 
+  /* Get all keys and values sorted by key as a single string usable as a hash key. Keys in ignoreKeys are skipped. */
+  QString toKey(const QStringList& ignoreKeys = QStringList()) const;
+
 private:
   QMultiMap<QByteArray, QByteArray> params;
   bool verbose = false;
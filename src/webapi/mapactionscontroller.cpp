@@ -77,12 +77,12 @@ WebApiResponse MapActionsController::imageAction(WebApiRequest request){
       if(format == QLatin1String("jpg"))
       {
           response.headers.replace("Content-Type", "image/jpg");
-          map.pixmap.save(&buffer, "PNG", quality);
+          map.image.save(&buffer, "PNG", quality);
       }
       else if(format == QLatin1String("png"))
       {
           response.headers.replace("Content-Type", "image/png");
-          map.pixmap.save(&buffer, "PNG", quality);
+          map.image.save(&buffer, "PNG", quality);
       }
       else
         // Should never happen
@@ -110,39 +110,13 @@ WebApiResponse MapActionsController::featuresAction(WebApiRequest request){
         request.parameters.value("bottomlat").toFloat()
     );
 
-    bool overflow = false;
-
-    // Init dummy image request
-    WebApiRequest *imageRequest = new WebApiRequest();
-    imageRequest->parameters = QMap<QByteArray,QByteArray>();
-    imageRequest->parameters.insert("leftlon",request.parameters.value("leftlon")),
-    imageRequest->parameters.insert("toplat",request.parameters.value("toplat")),
-    imageRequest->parameters.insert("rightlon",request.parameters.value("rightlon")),
-    imageRequest->parameters.insert("bottomlat",request.parameters.value("bottomlat")),
-    imageRequest->parameters.insert("detailfactor",request.parameters.value("detailfactor"));
-    imageRequest->parameters.insert("width","300");
-    imageRequest->parameters.insert("height","300");
-    imageRequest->parameters.insert("format","jpg");
-    imageRequest->parameters.insert("quality","1");
-
-    // Perform dummy image request
-    imageAction(*imageRequest);
-
-    // Extract results created during dummy image request
-    const QList<map::MapAirport> airports = *mapPaintWidget->getMapQuery()->getAirportsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,map::NONE,overflow);
-
-    const QList<map::MapNdb> ndbs = *mapPaintWidget->getMapQuery()->getNdbsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapVor> vors = *mapPaintWidget->getMapQuery()->getVorsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapMarker> markers = *mapPaintWidget->getMapQuery()->getMarkersByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapWaypoint> waypoints = mapPaintWidget->getWaypointTrackQuery()->getWaypointsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
+    // Default size is the same as used by the former dummy image request
+    int width = request.parameters.value("width", "300").toInt();
+    int height = request.parameters.value("height", "300").toInt();
+    int detailFactor = request.parameters.value("detailfactor").toInt();
 
-    MapFeaturesData data = {
-        airports,
-        ndbs,
-        vors,
-        markers,
-        waypoints
-    };
+    // Select map layer and query objects without painting
+    MapFeaturesData data = getFeaturesRect(width, height, rect, detailFactor);
 
     response.body = infoBuilder->features(data);
 
@@ -295,7 +269,7 @@ MapPixmap MapActionsController::getPixmapPosDistance(int width, int height, atoo
       mappixmap.requestedDistanceKm = distanceKm;
 
     // Fill result object
-    mappixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+    mappixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
     mappixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
     return mappixmap;
@@ -340,7 +314,7 @@ MapPixmap MapActionsController::getPixmapRect(int width, int height, atools::geo
 
       // No distance requested. Therefore requested is equal to actual
       mapPixmap.correctedDistanceKm = mapPixmap.requestedDistanceKm = static_cast<float>(mapPaintWidget->distance());
-      mapPixmap.pixmap = mapPaintWidget->getPixmap(width, height);
+      mapPixmap.image = mapPaintWidget->getPixmap(width, height).toImage();
       mapPixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
       return mapPixmap;
@@ -359,3 +333,61 @@ MapPixmap MapActionsController::getPixmapRect(int width, int height, atools::geo
     return mapPixmap;
   }
 }
+
+MapFeaturesData MapActionsController::getFeaturesRect(int width, int height, const atools::geo::Rect& rect, int detailFactor)
+{
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << width << "x" << height << rect;
+
+  if(!rect.isValid())
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid rectangle";
+    return MapFeaturesData();
+  }
+
+  if(mapPaintWidget == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "mapPaintWidget is null";
+    return MapFeaturesData();
+  }
+
+  QMutexLocker locker(&mapPaintWidgetMutex);
+
+  // Only projection is needed to get the same zoom distance as an image request
+  if(mapPaintWidget->projection() != Marble::Mercator)
+    mapPaintWidget->setProjection(Marble::Mercator);
+
+  // Do not center world rectangle when resizing
+  mapPaintWidget->setKeepWorldRect(false);
+
+  // Update viewport size without painting since showRectStreamlined() depends on it
+  mapPaintWidget->resizeNoPaint(width, height);
+  mapPaintWidget->showRectStreamlined(rect, false);
+
+  // Set detail factor which also updates the map layer for the new zoom distance
+  MapPaintLayer *paintLayer = mapPaintWidget->getMapPaintLayer();
+  paintLayer->setDetailLevel(detailFactor);
+
+  const MapLayer *mapLayer = paintLayer->getMapLayer();
+  if(mapLayer == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "mapLayer is null";
+    return MapFeaturesData();
+  }
+
+  bool overflow = false;
+  MapQuery *mapQuery = mapPaintWidget->getMapQuery();
+  const QList<map::MapAirport> *airports = mapQuery->getAirportsByRect(rect, mapLayer, false, map::NONE, overflow);
+  const QList<map::MapNdb> *ndbs = mapQuery->getNdbsByRect(rect, mapLayer, false, overflow);
+  const QList<map::MapVor> *vors = mapQuery->getVorsByRect(rect, mapLayer, false, overflow);
+  const QList<map::MapMarker> *markers = mapQuery->getMarkersByRect(rect, mapLayer, false, overflow);
+
+  // Queries return null if not initialized
+  return MapFeaturesData{
+    airports != nullptr ? *airports : QList<map::MapAirport>(),
+    ndbs != nullptr ? *ndbs : QList<map::MapNdb>(),
+    vors != nullptr ? *vors : QList<map::MapVor>(),
+    markers != nullptr ? *markers : QList<map::MapMarker>(),
+    mapPaintWidget->getWaypointTrackQuery()->getWaypointsByRect(rect, mapLayer, false, overflow)
+  };
+}
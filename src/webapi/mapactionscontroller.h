@@ -19,6 +19,7 @@
 #define MAPACTIONSCONTROLLER_H
 
 #include "webapi/abstractlnmactionscontroller.h"
+#include "common/infobuildertypes.h"
 #include <QMutex>
 #include <QPixmap>
 #include "mapgui/maplayersettings.h"
@@ -80,6 +81,10 @@ protected:
     /* Zoom to rectangel on map. */
     MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, int detailFactor = MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL, const QString& errorCase = tr("Invalid rectangle"));
 
+    /* Get navaids visible in rectangle for a map of the given size. Only zooms the hidden map widget
+     * to select the map layer and does not render or encode an image. */
+    InfoBuilderTypes::MapFeaturesData getFeaturesRect(int width, int height, const atools::geo::Rect& rect, int detailFactor = MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL);
+
     MapPaintWidget *mapPaintWidget = nullptr;
     QMutex mapPaintWidgetMutex;
 